@@ -0,0 +1,123 @@
+/*
+ * This file is part of Vlasiator.
+ * Copyright 2010-2016 Finnish Meteorological Institute
+ *
+ * For details of usage, see the COPYING file and read the "Rules of the Road"
+ * at http://www.physics.helsinki.fi/vlasiator/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef BLOCK_BITMAP_H
+#define BLOCK_BITMAP_H
+
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
+#include <vector>
+
+namespace vmesh {
+
+   /** Sparse bitset over the velocity block global ID space. The ID space is
+    * divided into pages of PAGE_BITS bits, and storage is only allocated for
+    * pages that have a bit set. Clearing the bitmap only touches the used pages,
+    * so the cost of using the bitmap scales with the number of set bits and not
+    * with the size of the velocity mesh. Page storage is kept between calls to
+    * clear(), so a bitmap that is reused does not allocate memory once it has
+    * grown to its working size.*/
+   class BlockBitmap {
+    public:
+      BlockBitmap(): nBits(0) { }
+
+      void clear(const size_t& nBits);
+      template<typename FUNCTION> void forEachSetBit(FUNCTION function);
+      void setRange(const size_t& begin,const size_t& end);
+      bool test(const size_t& bit) const;
+
+    private:
+      static const size_t PAGE_WORDS = 64;
+      static const size_t PAGE_BITS = 64*PAGE_WORDS;
+      static const uint32_t NO_PAGE = std::numeric_limits<uint32_t>::max();
+
+      uint64_t* getPage(const size_t& page);
+
+      size_t nBits;
+      std::vector<uint32_t> pageTable;      /**< Index of each page in pages, or NO_PAGE.*/
+      std::vector<uint64_t> pages;          /**< Storage of used pages, PAGE_WORDS words per page.*/
+      std::vector<uint32_t> usedPages;      /**< Page numbers of used pages.*/
+   };
+
+   /** Clear all bits and set the size of the bitmap.
+    * @param nBits Number of bits, i.e., the maximum global ID plus one.*/
+   inline void BlockBitmap::clear(const size_t& nBits) {
+      for (size_t p=0; p<usedPages.size(); ++p) pageTable[usedPages[p]] = NO_PAGE;
+      usedPages.clear();
+      pages.clear();
+      this->nBits = nBits;
+      pageTable.resize((nBits+PAGE_BITS-1)/PAGE_BITS,static_cast<uint32_t>(NO_PAGE));
+   }
+
+   /** Call function(bit) for every set bit in increasing order.*/
+   template<typename FUNCTION> inline
+   void BlockBitmap::forEachSetBit(FUNCTION function) {
+      std::sort(usedPages.begin(),usedPages.end());
+      for (size_t p=0; p<usedPages.size(); ++p) {
+         const uint64_t* page = &(pages[pageTable[usedPages[p]]*PAGE_WORDS]);
+         const size_t firstBit = usedPages[p]*PAGE_BITS;
+         for (size_t w=0; w<PAGE_WORDS; ++w) {
+            uint64_t word = page[w];
+            size_t bit = firstBit + w*64;
+            while (word != 0) {
+               if (word & 1) function(bit);
+               word >>= 1;
+               ++bit;
+            }
+         }
+      }
+   }
+
+   /** Get the storage of a page, allocating a cleared page if it is not in use.*/
+   inline uint64_t* BlockBitmap::getPage(const size_t& page) {
+      if (pageTable[page] == NO_PAGE) {
+         pageTable[page] = usedPages.size();
+         usedPages.push_back(page);
+         pages.resize(pages.size()+PAGE_WORDS,0);
+      }
+      return &(pages[pageTable[page]*PAGE_WORDS]);
+   }
+
+   /** Set bits begin...end-1. Bits at or beyond the size of the bitmap are ignored.*/
+   inline void BlockBitmap::setRange(const size_t& begin,const size_t& end) {
+      const size_t last = std::min(end,nBits);
+      size_t bit = begin;
+      while (bit < last) {
+         const size_t offset = bit % 64;
+         const size_t count = std::min(64-offset,last-bit);
+         const uint64_t mask = (count == 64) ? ~UINT64_C(0) : ((UINT64_C(1) << count) - 1) << offset;
+         getPage(bit/PAGE_BITS)[(bit%PAGE_BITS)/64] |= mask;
+         bit += count;
+      }
+   }
+
+   inline bool BlockBitmap::test(const size_t& bit) const {
+      if (bit >= nBits) return false;
+      const uint32_t index = pageTable[bit/PAGE_BITS];
+      if (index == NO_PAGE) return false;
+      return (pages[index*PAGE_WORDS + (bit%PAGE_BITS)/64] >> (bit%64)) & 1;
+   }
+
+} // namespace vmesh
+
+#endif
@@ -28,13 +28,17 @@
 #include "dro_populations.h"
 using namespace std;
 
-void initializeDataReducers(DataReducer * outputReducer, DataReducer * diagnosticReducer)
+/*! Add the operators of the given output variables into a data reducer.
+ * \param outputReducer Data reducer the operators are added to
+ * \param variableList Names of the output variables, as in variables.output
+ */
+static void addOutputOperators(DataReducer * outputReducer, const vector<string>& variableList)
 {
    typedef Parameters P;
 
    vector<string>::const_iterator it;
-   for (it = P::outputVariableList.begin();
-        it != P::outputVariableList.end();
+   for (it = variableList.begin();
+        it != variableList.end();
         it++) {
 
       /* Note: Each data reducer generation should be followed by a call to setUnitMetaData
@@ -359,6 +363,18 @@ void initializeDataReducers(DataReducer * outputReducer, DataReducer * diagnosti
 	 outputReducer->addMetadata(outputReducer->size()-1,"","","$\\mathrm{LB weight}$","");
          continue;
       }
+      if(lowercase == "vg_loadbalance_cost") {
+         // Measured compute time per cell in the step before the last load balance
+         outputReducer->addOperator(new DRO::DataReductionOperatorCellParams("vg_loadbalance_cost",CellParams::LBCOSTCOUNTER,1));
+	 outputReducer->addMetadata(outputReducer->size()-1,"s","$\\mathrm{s}$","$\\mathrm{LB cost}$","1.0");
+         continue;
+      }
+      if(lowercase == "vg_loadbalance_imbalance") {
+         // Predicted and measured load of each process relative to the mean, max over cells is the imbalance
+         outputReducer->addOperator(new DRO::LoadBalanceImbalance);
+	 outputReducer->addMetadata(outputReducer->size()-1,"","","$\\mathrm{LB load}$","");
+         continue;
+      }
       if(lowercase == "maxvdt" || lowercase == "vg_maxdt_acceleration") {
          // Overall maximum timestep constraint as calculated by the velocity space vlasov update
          outputReducer->addOperator(new DRO::DataReductionOperatorCellParams("vg_maxdt_acceleration",CellParams::MAXVDT,1));
@@ -968,7 +984,16 @@ void initializeDataReducers(DataReducer * outputReducer, DataReducer * diagnosti
       MPI_Finalize();
       exit(1);
    }
+}
+
+void initializeDataReducers(DataReducer * outputReducer, DataReducer * diagnosticReducer, DataReducer * cutReducer)
+{
+   typedef Parameters P;
 
+   addOutputOperators(outputReducer, P::outputVariableList);
+   addOutputOperators(cutReducer, P::cutVariableList);
+
+   vector<string>::const_iterator it;
    for (it = P::diagnosticVariableList.begin();
         it != P::diagnosticVariableList.end();
         it++) {
@@ -1006,6 +1031,10 @@ void initializeDataReducers(DataReducer * outputReducer, DataReducer * diagnosti
          diagnosticReducer->addOperator(new DRO::DataReductionOperatorCellParams("vg_loadbalance_weight",CellParams::LBWEIGHTCOUNTER,1));
          continue;
       }
+      if(lowercase == "vg_loadbalance_cost") {
+         diagnosticReducer->addOperator(new DRO::DataReductionOperatorCellParams("vg_loadbalance_cost",CellParams::LBCOSTCOUNTER,1));
+         continue;
+      }
       if(lowercase == "maxvdt" || lowercase == "maxdt_acceleration" || lowercase == "vg_maxdt_acceleration") {
          diagnosticReducer->addOperator(new DRO::DataReductionOperatorCellParams("vg_maxdt_acceleration",CellParams::MAXVDT,1));
          continue;
@@ -1151,6 +1180,14 @@ bool DataReducer::hasParameters(const unsigned int& operatorID) const {
    return dynamic_cast<DRO::DataReductionOperatorHasParameters*>(operators[operatorID]) != nullptr;
 }
 
+/** Ask a DataReductionOperator if reduceData can be called for several cells concurrently.
+ * @param operatorID ID number of the DataReductionOperator.
+ * @return If true, reduceData of the DataReductionOperator can be called from an OpenMP parallel loop over cells.*/
+bool DataReducer::isThreadSafe(const unsigned int& operatorID) const {
+   if (operatorID >= operators.size()) return false;
+   return operators[operatorID]->isThreadSafe();
+}
+
 /** Request a DataReductionOperator to calculate its output data and to write it to the given buffer.
  * @param cell Pointer to spatial cell whose data is to be reduced.
  * @param operatorID ID number of the applied DataReductionOperator.
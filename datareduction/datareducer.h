@@ -51,6 +51,7 @@ class DataReducer {
    std::string getName(const unsigned int& operatorID) const;
    bool handlesWriting(const unsigned int& operatorID) const;
    bool hasParameters(const unsigned int& operatorID) const;
+   bool isThreadSafe(const unsigned int& operatorID) const;
    bool reduceData(const SpatialCell* cell,const unsigned int& operatorID,char* buffer);
    bool reduceDiagnostic(const SpatialCell* cell,const unsigned int& operatorID,Real * result);
    unsigned int size() const;
@@ -83,6 +84,6 @@ class DataReducer {
    /**< A container for all DRO::DataReductionOperators stored in DataReducer.*/
 };
 
-void initializeDataReducers(DataReducer * outputReducer, DataReducer * diagnosticReducer);
+void initializeDataReducers(DataReducer * outputReducer, DataReducer * diagnosticReducer, DataReducer * cutReducer);
 
 #endif
@@ -88,7 +88,7 @@ namespace DRO {
    std::string DataReductionOperatorCellParams::getName() const {return variableName;}
    
    bool DataReductionOperatorCellParams::reduceData(const SpatialCell* cell,char* buffer) {
-      const char* ptr = reinterpret_cast<const char*>(data);
+      const char* ptr = reinterpret_cast<const char*>(getData(cell));
       for (uint i = 0; i < vectorSize*sizeof(Real); ++i){
          buffer[i] = ptr[i];
       }
@@ -97,18 +97,22 @@ namespace DRO {
    
    bool DataReductionOperatorCellParams::reduceDiagnostic(const SpatialCell* cell,Real* buffer){
       //If vectorSize is >1 it still works, we just give the first value and no other ones..
-      *buffer=data[0];
+      *buffer=getData(cell)[0];
       return true;
    }
    bool DataReductionOperatorCellParams::setSpatialCell(const SpatialCell* cell) {
+      return true;
+   }
+   /** Returns a pointer to the first component of the variable in the given cell. The data
+    * is read from the cell here instead of in setSpatialCell to keep the operator thread-safe.*/
+   const Real* DataReductionOperatorCellParams::getData(const SpatialCell* cell) const {
       for (uint i=0; i<vectorSize; i++) {
          if(std::isinf(cell->parameters[_parameterIndex+i]) || std::isnan(cell->parameters[_parameterIndex+i])) {
             string message = "The DataReductionOperator " + this->getName() + " returned a nan or an inf in its " + std::to_string(i) + "-component.";
             bailout(true, message, __FILE__, __LINE__);
          }
       }
-      data  = &(cell->parameters[_parameterIndex]);
-      return true;
+      return &(cell->parameters[_parameterIndex]);
    }
 
    std::string DataReductionOperatorFsGrid::getName() const {return variableName;}
@@ -184,9 +188,8 @@ namespace DRO {
       
    }
    //a version with derivatives, this is the only function that is different
-   bool DataReductionOperatorBVOLDerivatives::setSpatialCell(const SpatialCell* cell) {
-      data  = &(cell->derivativesBVOL[_parameterIndex]);
-      return true;
+   const Real* DataReductionOperatorBVOLDerivatives::getData(const SpatialCell* cell) const {
+      return &(cell->derivativesBVOL[_parameterIndex]);
    }
    
    
@@ -205,12 +208,7 @@ namespace DRO {
    std::string VariableBVol::getName() const {return "vg_b_vol";}
    
    bool VariableBVol::reduceData(const SpatialCell* cell,char* buffer) {
-      const char* ptr = reinterpret_cast<const char*>(B);
-      for (uint i = 0; i < 3*sizeof(Real); ++i) buffer[i] = ptr[i];
-      return true;
-   }
-   
-   bool VariableBVol::setSpatialCell(const SpatialCell* cell) {
+      Real B[3];
       B[0] = cell->parameters[CellParams::PERBXVOL] +  cell->parameters[CellParams::BGBXVOL];
       B[1] = cell->parameters[CellParams::PERBYVOL] +  cell->parameters[CellParams::BGBYVOL];
       B[2] = cell->parameters[CellParams::PERBZVOL] +  cell->parameters[CellParams::BGBZVOL];
@@ -221,11 +219,19 @@ namespace DRO {
          string message = "The DataReductionOperator " + this->getName() + " returned a nan or an inf.";
          bailout(true, message, __FILE__, __LINE__);
       }
+      const char* ptr = reinterpret_cast<const char*>(B);
+      for (uint i = 0; i < 3*sizeof(Real); ++i) buffer[i] = ptr[i];
+      return true;
+   }
+   
+   bool VariableBVol::setSpatialCell(const SpatialCell* cell) {
       return true;
    }
 
    //MPI rank
-   MPIrank::MPIrank(): DataReductionOperator() { }
+   MPIrank::MPIrank(): DataReductionOperator() {
+      MPI_Comm_rank(MPI_COMM_WORLD,&mpiRank);
+   }
    MPIrank::~MPIrank() { }
    
    bool MPIrank::getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const {
@@ -244,10 +250,31 @@ namespace DRO {
    }
    
    bool MPIrank::setSpatialCell(const SpatialCell* cell) {
-      int intRank;
-      MPI_Comm_rank(MPI_COMM_WORLD,&intRank);
-      rank = 1.0*intRank;
-      mpiRank = intRank;
+      return true;
+   }
+   
+   // LoadBalanceImbalance: load of the cell's process relative to the mean, predicted by the
+   // load balance weights of the current partition and measured before the last load balance.
+   LoadBalanceImbalance::LoadBalanceImbalance(): DataReductionOperator() { }
+   LoadBalanceImbalance::~LoadBalanceImbalance() { }
+   
+   bool LoadBalanceImbalance::getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const {
+      dataType = "float";
+      dataSize = sizeof(Real);
+      vectorSize = 2;
+      return true;
+   }
+   
+   std::string LoadBalanceImbalance::getName() const {return "vg_loadbalance_imbalance";}
+   
+   bool LoadBalanceImbalance::reduceData(const SpatialCell* cell,char* buffer) {
+      const Real loads[2] = {Parameters::loadBalancePredictedLoad, Parameters::loadBalanceMeasuredLoad};
+      const char* ptr = reinterpret_cast<const char*>(loads);
+      for (uint i = 0; i < 2*sizeof(Real); ++i) buffer[i] = ptr[i];
+      return true;
+   }
+   
+   bool LoadBalanceImbalance::setSpatialCell(const SpatialCell* cell) {
       return true;
    }
    
@@ -265,13 +292,13 @@ namespace DRO {
    std::string BoundaryType::getName() const {return "vg_boundarytype";}
    
    bool BoundaryType::reduceData(const SpatialCell* cell,char* buffer) {
+      const int boundaryType = (int)cell->sysBoundaryFlag;
       const char* ptr = reinterpret_cast<const char*>(&boundaryType);
       for (uint i = 0; i < sizeof(int); ++i) buffer[i] = ptr[i];
       return true;
    }
    
    bool BoundaryType::setSpatialCell(const SpatialCell* cell) {
-      boundaryType = (int)cell->sysBoundaryFlag;
       return true;
    }
 
@@ -290,13 +317,13 @@ namespace DRO {
    std::string BoundaryLayer::getName() const {return "vg_boundarylayer";}
    
    bool BoundaryLayer::reduceData(const SpatialCell* cell,char* buffer) {
+      const int boundaryLayer = (int)cell->sysBoundaryLayer;
       const char* ptr = reinterpret_cast<const char*>(&boundaryLayer);
       for (uint i = 0; i < sizeof(int); ++i) buffer[i] = ptr[i];
       return true;
    }
    
    bool BoundaryLayer::setSpatialCell(const SpatialCell* cell) {
-      boundaryLayer = (int)cell->sysBoundaryLayer;
       return true;
    }
    
@@ -316,18 +343,18 @@ namespace DRO {
    std::string Blocks::getName() const {return popName + "/vg_blocks";}
    
    bool Blocks::reduceData(const SpatialCell* cell,char* buffer) {
+      const uint nBlocks = cell->get_number_of_velocity_blocks(popID);
       const char* ptr = reinterpret_cast<const char*>(&nBlocks);
       for (uint i = 0; i < sizeof(int); ++i) buffer[i] = ptr[i];
       return true;
    }
    
    bool Blocks::reduceDiagnostic(const SpatialCell* cell,Real* buffer) {
-      *buffer = 1.0 * nBlocks;
+      *buffer = 1.0 * cell->get_number_of_velocity_blocks(popID);
       return true;
    }
   
    bool Blocks::setSpatialCell(const SpatialCell* cell) {
-      nBlocks = cell->get_number_of_velocity_blocks(popID);
       return true;
    }
    
@@ -345,13 +372,13 @@ namespace DRO {
    }
    
    bool VariablePressureSolver::reduceData(const SpatialCell* cell,char* buffer) {
+      const Real Pressure = 1.0/3.0 * (cell->parameters[CellParams::P_11] + cell->parameters[CellParams::P_22] + cell->parameters[CellParams::P_33]);
       const char* ptr = reinterpret_cast<const char*>(&Pressure);
       for (uint i = 0; i < sizeof(Real); ++i) buffer[i] = ptr[i];
       return true;
    }
    
    bool VariablePressureSolver::setSpatialCell(const SpatialCell* cell) {
-      Pressure = 1.0/3.0 * (cell->parameters[CellParams::P_11] + cell->parameters[CellParams::P_22] + cell->parameters[CellParams::P_33]);
       return true;
    }
    
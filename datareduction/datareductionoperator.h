@@ -48,7 +48,9 @@ namespace DRO {
     * If needed, a user can write his or her own DRO::DataReductionOperators, which 
     * are loaded when the simulation initializes.
     *
-    * Datareduction oeprators are not thread-safe, some of the more intensive ones are threaded within. 
+    * Datareduction oeprators are not thread-safe by default, some of the more intensive ones are threaded within.
+    * Operators whose isThreadSafe() returns true keep no per-cell state in setSpatialCell, so that
+    * setSpatialCell and reduceData can be called concurrently for different cells.
     */
 
    class DataReductionOperator {
@@ -73,6 +75,7 @@ namespace DRO {
       }
 
       virtual std::string getName() const = 0;
+      virtual bool isThreadSafe() const {return false;}
       virtual bool reduceData(const SpatialCell* cell,char* buffer);
       virtual bool reduceDiagnostic(const SpatialCell* cell,Real * result);
       virtual bool setSpatialCell(const SpatialCell* cell) = 0;
@@ -146,15 +149,17 @@ namespace DRO {
       
       virtual bool getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const;
       virtual std::string getName() const;
+      virtual bool isThreadSafe() const {return true;}
       virtual bool reduceData(const SpatialCell* cell,char* buffer);
       virtual bool reduceDiagnostic(const SpatialCell* cell,Real * result);
       virtual bool setSpatialCell(const SpatialCell* cell);
       
    protected:
+      virtual const Real* getData(const SpatialCell* cell) const;
+
       uint _parameterIndex;
       uint vectorSize;
       std::string variableName;
-      const Real *data;
    };
 
    class DataReductionOperatorDerivatives: public DataReductionOperatorCellParams {
@@ -166,7 +171,9 @@ namespace DRO {
    class DataReductionOperatorBVOLDerivatives: public DataReductionOperatorCellParams {
    public:
       DataReductionOperatorBVOLDerivatives(const std::string& name,const unsigned int parameterIndex,const unsigned int vectorSize);
-      virtual bool setSpatialCell(const SpatialCell* cell);
+
+   protected:
+      virtual const Real* getData(const SpatialCell* cell) const;
    };
    
    class MPIrank: public DataReductionOperator {
@@ -176,14 +183,26 @@ namespace DRO {
       
       virtual bool getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const;
       virtual std::string getName() const;
+      virtual bool isThreadSafe() const {return true;}
       virtual bool reduceData(const SpatialCell* cell,char* buffer);
       virtual bool setSpatialCell(const SpatialCell* cell);
       
    protected:
-      Real rank;
       int mpiRank;
    };
    
+   class LoadBalanceImbalance: public DataReductionOperator {
+   public:
+      LoadBalanceImbalance();
+      virtual ~LoadBalanceImbalance();
+      
+      virtual bool getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const;
+      virtual std::string getName() const;
+      virtual bool isThreadSafe() const {return true;}
+      virtual bool reduceData(const SpatialCell* cell,char* buffer);
+      virtual bool setSpatialCell(const SpatialCell* cell);
+   };
+   
    class BoundaryType: public DataReductionOperator {
    public:
       BoundaryType();
@@ -191,11 +210,9 @@ namespace DRO {
       
       virtual bool getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const;
       virtual std::string getName() const;
+      virtual bool isThreadSafe() const {return true;}
       virtual bool reduceData(const SpatialCell* cell,char* buffer);
       virtual bool setSpatialCell(const SpatialCell* cell);
-      
-   protected:
-      int boundaryType;
    };
 
    class BoundaryLayer: public DataReductionOperator {
@@ -205,11 +222,9 @@ namespace DRO {
       
       virtual bool getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const;
       virtual std::string getName() const;
+      virtual bool isThreadSafe() const {return true;}
       virtual bool reduceData(const SpatialCell* cell,char* buffer);
       virtual bool setSpatialCell(const SpatialCell* cell);
-      
-   protected:
-      int boundaryLayer;
    };
 
    class Blocks: public DataReductionOperator {
@@ -219,12 +234,12 @@ namespace DRO {
       
       virtual bool getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const;
       virtual std::string getName() const;
+      virtual bool isThreadSafe() const {return true;}
       virtual bool reduceData(const SpatialCell* cell,char* buffer);
       virtual bool reduceDiagnostic(const SpatialCell* cell,Real* buffer);
       virtual bool setSpatialCell(const SpatialCell* cell);
       
    protected:
-      uint nBlocks;
       uint popID;
       std::string popName;
    };
@@ -236,11 +251,9 @@ namespace DRO {
       
       virtual bool getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const;
       virtual std::string getName() const;
+      virtual bool isThreadSafe() const {return true;}
       virtual bool reduceData(const SpatialCell* cell,char* buffer);
       virtual bool setSpatialCell(const SpatialCell* cell);
-      
-   protected:
-      Real B[3];
    };
 
    
@@ -251,11 +264,9 @@ namespace DRO {
       
       virtual bool getDataVectorInfo(std::string& dataType,unsigned int& dataSize,unsigned int& vectorSize) const;
       virtual std::string getName() const;
+      virtual bool isThreadSafe() const {return true;}
       virtual bool reduceData(const SpatialCell* cell,char* buffer);
       virtual bool setSpatialCell(const SpatialCell* cell);
-      
-   protected:
-      Real Pressure;
    };
    
    class VariablePTensorDiagonal: public DataReductionOperator {
@@ -113,8 +113,11 @@ typedef Realf (*AmrVelRefinement)(const Realf* velBlock);
 #define SHIFT_M_Y_NEIGHBORHOOD_ID 18 //Shift in -y direction
 #define SHIFT_M_Z_NEIGHBORHOOD_ID 19 //Shift in -z direction
 
-//fieldsolver stencil.
-#define FS_STENCIL_WIDTH 2
+//fieldsolver stencil. A wider stencil lets the field solver compute more ghost layers
+//redundantly instead of exchanging them, see fieldsolver.ghostComputeDepth.
+#ifndef FS_STENCIL_WIDTH
+   #define FS_STENCIL_WIDTH 2
+#endif
 
 //Vlasov propagator stencils in ordinary space, velocity space may be
 //higher. Assume H4 (or H5) for PPM, H6 for PQM
@@ -362,16 +362,16 @@ void calculateDerivativesSimple(
    phiprof::start(timer);
 
    // Calculate derivatives
-   #pragma omp parallel for collapse(3)
-   for (int k=0; k<gridDims[2]; k++) {
-      for (int j=0; j<gridDims[1]; j++) {
-         for (int i=0; i<gridDims[0]; i++) {
-            if (technicalGrid.get(i,j,k)->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) continue;
-            if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
-               calculateDerivatives(i,j,k, perBGrid, momentsGrid, dPerBGrid, dMomentsGrid, technicalGrid, sysBoundaries, RKCase);
-            } else {
-               calculateDerivatives(i,j,k, perBDt2Grid, momentsDt2Grid, dPerBGrid, dMomentsGrid, technicalGrid, sysBoundaries, RKCase);
-            }
+   const std::vector<FsCellRun>& runs = getActiveCellRuns(technicalGrid);
+   #pragma omp parallel for schedule(dynamic,1)
+   for (uint r=0; r<runs.size(); r++) {
+      const int j = runs[r].j;
+      const int k = runs[r].k;
+      for (int i=runs[r].i0; i<runs[r].i1; i++) {
+         if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
+            calculateDerivatives(i,j,k, perBGrid, momentsGrid, dPerBGrid, dMomentsGrid, technicalGrid, sysBoundaries, RKCase);
+         } else {
+            calculateDerivatives(i,j,k, perBDt2Grid, momentsDt2Grid, dPerBGrid, dMomentsGrid, technicalGrid, sysBoundaries, RKCase);
          }
       }
    }
@@ -486,14 +486,11 @@ void calculateBVOLDerivativesSimple(
    timer=phiprof::initializeTimer("Compute cells");
    phiprof::start(timer);
    
-   #pragma omp parallel for collapse(3)
-   for (int k=0; k<gridDims[2]; k++) {
-      for (int j=0; j<gridDims[1]; j++) {
-         for (int i=0; i<gridDims[0]; i++) {
-            if (technicalGrid.get(i,j,k)->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) continue;
-            
-            calculateBVOLDerivatives(volGrid,technicalGrid,i,j,k,sysBoundaries);
-         }
+   const std::vector<FsCellRun>& runs = getActiveCellRuns(technicalGrid);
+   #pragma omp parallel for schedule(dynamic,1)
+   for (uint r=0; r<runs.size(); r++) {
+      for (int i=runs[r].i0; i<runs[r].i1; i++) {
+         calculateBVOLDerivatives(volGrid,technicalGrid,i,runs[r].j,runs[r].k,sysBoundaries);
       }
    }
 
@@ -20,6 +20,10 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#ifdef _OPENMP
+   #include <omp.h>
+#endif
+
 #include "fs_common.h"
 
 /*! \brief Helper function
@@ -198,3 +202,90 @@ void reconstructionCoefficients(
    perturbedResult[Rec::c_0 ] = HALF*(cep_i1j1k2->at(fsgrids::bfield::PERBZ) + cep_i1j1k1->at(fsgrids::bfield::PERBZ)) - SIXTH*perturbedResult[Rec::c_zz];
 }
 
+
+static std::vector<FsCellRun> activeCellRuns[FS_STENCIL_WIDTH]; /*!< Active cell runs per ghost margin.*/
+static bool activeCellRunsValid[FS_STENCIL_WIDTH] = {false};
+
+/*! \brief Returns the runs of cells along x on which the field solver computes.
+ * 
+ * Cells flagged DO_NOT_COMPUTE (e.g. deep inside the ionosphere) are left out, so the field solver
+ * loops do not visit them at all. Runs are split to at most a few times the average number of
+ * cells per thread, so they can be handed out to threads one by one for an even load. The index is
+ * built on first use after invalidateActiveCellRuns, it is not thread-safe and has to be called
+ * outside of parallel regions.
+ * 
+ * \param technicalGrid fsGrid holding technical information (such as boundary types)
+ * \param margin Number of ghost layers to include on each side, in non-flat dimensions only
+ * 
+ * \sa invalidateActiveCellRuns
+ */
+const std::vector<FsCellRun>& getActiveCellRuns(
+   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
+   cint margin
+) {
+   std::vector<FsCellRun>& runs = activeCellRuns[margin];
+   if (activeCellRunsValid[margin]) return runs;
+   
+   const std::array<int, 3>& localSize = technicalGrid.getLocalSize();
+   const std::array<int, 3>& globalSize = technicalGrid.getGlobalSize();
+   int start[3], end[3];
+   for (int d=0; d<3; d++) {
+      const int m = globalSize[d] > 1 ? margin : 0;
+      start[d] = -m;
+      end[d] = localSize[d] + m;
+   }
+   
+   std::vector<FsCellRun> rowRuns;
+   size_t nCells = 0;
+   for (int k=start[2]; k<end[2]; k++) {
+      for (int j=start[1]; j<end[1]; j++) {
+         int i = start[0];
+         while (i < end[0]) {
+            const fsgrids::technical* technical = technicalGrid.get(i,j,k);
+            if (technical == NULL || technical->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
+               ++i;
+               continue;
+            }
+            FsCellRun run = {i, i, j, k};
+            while (run.i1 < end[0]) {
+               technical = technicalGrid.get(run.i1,j,k);
+               if (technical == NULL || technical->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) break;
+               ++run.i1;
+            }
+            nCells += run.i1 - run.i0;
+            rowRuns.push_back(run);
+            i = run.i1;
+         }
+      }
+   }
+   
+   #ifdef _OPENMP
+   const size_t nThreads = omp_get_max_threads();
+   #else
+   const size_t nThreads = 1;
+   #endif
+   const int maxRunLength = max((size_t)1, nCells / (4*nThreads));
+   
+   runs.clear();
+   for (uint r=0; r<rowRuns.size(); r++) {
+      for (int i0=rowRuns[r].i0; i0<rowRuns[r].i1; i0+=maxRunLength) {
+         FsCellRun run = rowRuns[r];
+         run.i0 = i0;
+         run.i1 = min(i0 + maxRunLength, rowRuns[r].i1);
+         runs.push_back(run);
+      }
+   }
+   activeCellRunsValid[margin] = true;
+   return runs;
+}
+
+/*! \brief Discards the active cell runs, they are rebuilt from the technical grid on next use.
+ * 
+ * \sa getActiveCellRuns
+ */
+void invalidateActiveCellRuns() {
+   for (int margin=0; margin<FS_STENCIL_WIDTH; margin++) {
+      activeCellRuns[margin].clear();
+      activeCellRunsValid[margin] = false;
+   }
+}
@@ -125,4 +125,19 @@ void reconstructionCoefficients(
    creal& reconstructionOrder
 );
 
+/*! Run of consecutive fsGrid cells [i0,i1) along x at (j,k) on which the field solver computes.*/
+struct FsCellRun {
+   int i0;
+   int i1;
+   int j;
+   int k;
+};
+
+const std::vector<FsCellRun>& getActiveCellRuns(
+   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
+   cint margin = 0
+);
+
+void invalidateActiveCellRuns();
+
 #endif
@@ -92,6 +92,181 @@ template <typename T, int stencil> void computeCoupling(dccrg::Dccrg<SpatialCell
   }
 }
 
+/*Average of fsgrid field values over the fsgrid cells of one dccrg cell, as sent
+  from the fsgrid owners to the dccrg owners in getFieldsFromFsGrid*/
+const int fieldsToCommunicate = 21;
+struct FieldAverage {
+  Real sums[fieldsToCommunicate];
+  int cells;
+  FieldAverage()  {
+    clear();
+  }
+  void clear() {
+    cells = 0;
+    for(int i = 0; i < fieldsToCommunicate; i++){
+      sums[i] = 0;
+    }
+  }
+  FieldAverage operator+=(const FieldAverage& rhs) {
+    this->cells += rhs.cells;
+    for(int i = 0; i < fieldsToCommunicate; i++){
+      this->sums[i] += rhs.sums[i];
+    }
+    return *this;
+  }
+};
+
+/*Persistent coupling plan DCCRG <=> FSGRID. The coupling computed by computeCoupling
+  only changes when the dccrg grid is repartitioned, so it is flattened into
+  contiguous arrays together with the communication buffers and persistent MPI
+  requests, and reused until P::meshRepartitionEpoch or the list of cells changes.
+  The same plan serves both directions: moments are sent dccrg => fsgrid and
+  fields fsgrid => dccrg, with the roles of the two cell lists swapped.
+
+  dccrg side:  dccrgCells[dccrgOffsets[r]...dccrgOffsets[r+1]-1] are the local dccrg cells
+               mapping to fsgrid cells owned by dccrgRanks[r], sorted by cell id.
+               uniqueCells lists each of these cells once, its entries in dccrgCells
+               are uniqueSlots[uniqueOffsets[c]...uniqueOffsets[c+1]-1].
+  fsgrid side: fsgridCells[fsgridOffsets[r]...fsgridOffsets[r+1]-1] are the dccrg cells owned
+               by fsgridRanks[r] mapping to local fsgrid cells, sorted by cell id. Local
+               fsgrid ids of entry e are fsgridLids[fsgridLidOffsets[e]...fsgridLidOffsets[e+1]-1].
+*/
+struct FsGridCouplingPlan {
+  bool valid;
+  uint repartitionEpoch;                     /*!< Value of P::meshRepartitionEpoch when the plan was built.*/
+  std::vector<CellID> cells;                 /*!< Cells given to the coupling functions when the plan was built.*/
+
+  std::vector<int> dccrgRanks;
+  std::vector<size_t> dccrgOffsets;
+  std::vector<CellID> dccrgCells;
+  std::vector<CellID> uniqueCells;
+  std::vector<size_t> uniqueOffsets;
+  std::vector<size_t> uniqueSlots;
+
+  std::vector<int> fsgridRanks;
+  std::vector<size_t> fsgridOffsets;
+  std::vector<CellID> fsgridCells;
+  std::vector<size_t> fsgridLidOffsets;
+  std::vector<int64_t> fsgridLids;
+
+  std::vector<Real> momentsSendBuffer;       /*!< N_MOMENTS values per entry of dccrgCells.*/
+  std::vector<Real> momentsReceiveBuffer;    /*!< N_MOMENTS values per entry of fsgridCells.*/
+  std::vector<FieldAverage> fieldsSendBuffer;    /*!< One per entry of fsgridCells.*/
+  std::vector<FieldAverage> fieldsReceiveBuffer; /*!< One per entry of dccrgCells.*/
+
+  std::vector<MPI_Request> momentsSendRequests;
+  std::vector<MPI_Request> momentsReceiveRequests;
+  std::vector<MPI_Request> fieldsSendRequests;
+  std::vector<MPI_Request> fieldsReceiveRequests;
+
+  FsGridCouplingPlan(): valid(false),repartitionEpoch(0) { }
+};
+
+static FsGridCouplingPlan couplingPlan;
+
+static void freeRequests(std::vector<MPI_Request>& requests) {
+  for (size_t i=0; i<requests.size(); ++i) {
+    if (requests[i] != MPI_REQUEST_NULL) MPI_Request_free(&(requests[i]));
+  }
+  requests.clear();
+}
+
+/*Get the coupling plan for the given cells, rebuilding it if the grid has been
+  repartitioned since it was built. Any fsgrid can be given, all fsgrids share the
+  same domain decomposition.*/
+template <typename T, int stencil> FsGridCouplingPlan& getCouplingPlan(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                                                                        const std::vector<CellID>& cells,
+                                                                        FsGrid< T, stencil>& fsgrid) {
+  FsGridCouplingPlan& plan = couplingPlan;
+  if (plan.valid && plan.repartitionEpoch == P::meshRepartitionEpoch && plan.cells == cells) {
+    return plan;
+  }
+
+  phiprof::start("fsgrid-coupling-plan");
+  freeRequests(plan.momentsSendRequests);
+  freeRequests(plan.momentsReceiveRequests);
+  freeRequests(plan.fieldsSendRequests);
+  freeRequests(plan.fieldsReceiveRequests);
+
+  std::map<int, std::set<CellID> > onDccrgMapRemoteProcess;
+  std::map<int, std::set<CellID> > onFsgridMapRemoteProcess;
+  std::map<CellID, std::vector<int64_t> > onFsgridMapCells;
+  computeCoupling(mpiGrid, cells, fsgrid, onDccrgMapRemoteProcess, onFsgridMapRemoteProcess, onFsgridMapCells);
+
+  // Flatten dccrg side
+  plan.dccrgRanks.clear();
+  plan.dccrgOffsets.assign(1,0);
+  plan.dccrgCells.clear();
+  std::map<CellID, std::vector<size_t> > slotsOfCell;
+  for (auto const &snd : onDccrgMapRemoteProcess) {
+    plan.dccrgRanks.push_back(snd.first);
+    for (CellID cell : snd.second) {
+      slotsOfCell[cell].push_back(plan.dccrgCells.size());
+      plan.dccrgCells.push_back(cell);
+    }
+    plan.dccrgOffsets.push_back(plan.dccrgCells.size());
+  }
+  plan.uniqueCells.clear();
+  plan.uniqueOffsets.assign(1,0);
+  plan.uniqueSlots.clear();
+  for (auto const &cellSlots : slotsOfCell) {
+    plan.uniqueCells.push_back(cellSlots.first);
+    plan.uniqueSlots.insert(plan.uniqueSlots.end(), cellSlots.second.begin(), cellSlots.second.end());
+    plan.uniqueOffsets.push_back(plan.uniqueSlots.size());
+  }
+
+  // Flatten fsgrid side
+  plan.fsgridRanks.clear();
+  plan.fsgridOffsets.assign(1,0);
+  plan.fsgridCells.clear();
+  plan.fsgridLidOffsets.assign(1,0);
+  plan.fsgridLids.clear();
+  for (auto const &rcv : onFsgridMapRemoteProcess) {
+    plan.fsgridRanks.push_back(rcv.first);
+    for (CellID cell : rcv.second) {
+      const std::vector<int64_t>& lids = onFsgridMapCells[cell];
+      plan.fsgridCells.push_back(cell);
+      plan.fsgridLids.insert(plan.fsgridLids.end(), lids.begin(), lids.end());
+      plan.fsgridLidOffsets.push_back(plan.fsgridLids.size());
+    }
+    plan.fsgridOffsets.push_back(plan.fsgridCells.size());
+  }
+
+  // Buffers and persistent requests
+  const int nMoments = fsgrids::moments::N_MOMENTS;
+  plan.momentsSendBuffer.resize(plan.dccrgCells.size() * nMoments);
+  plan.momentsReceiveBuffer.resize(plan.fsgridCells.size() * nMoments);
+  plan.fieldsSendBuffer.resize(plan.fsgridCells.size());
+  plan.fieldsReceiveBuffer.resize(plan.dccrgCells.size());
+
+  plan.momentsSendRequests.resize(plan.dccrgRanks.size());
+  plan.fieldsReceiveRequests.resize(plan.dccrgRanks.size());
+  for (size_t r=0; r<plan.dccrgRanks.size(); ++r) {
+    const size_t offset = plan.dccrgOffsets[r];
+    const int count = plan.dccrgOffsets[r+1] - offset;
+    MPI_Send_init(&(plan.momentsSendBuffer[offset*nMoments]), count * nMoments * sizeof(Real),
+                  MPI_BYTE, plan.dccrgRanks[r], 1, MPI_COMM_WORLD, &(plan.momentsSendRequests[r]));
+    MPI_Recv_init(&(plan.fieldsReceiveBuffer[offset]), count * sizeof(FieldAverage),
+                  MPI_BYTE, plan.dccrgRanks[r], 1, MPI_COMM_WORLD, &(plan.fieldsReceiveRequests[r]));
+  }
+  plan.momentsReceiveRequests.resize(plan.fsgridRanks.size());
+  plan.fieldsSendRequests.resize(plan.fsgridRanks.size());
+  for (size_t r=0; r<plan.fsgridRanks.size(); ++r) {
+    const size_t offset = plan.fsgridOffsets[r];
+    const int count = plan.fsgridOffsets[r+1] - offset;
+    MPI_Recv_init(&(plan.momentsReceiveBuffer[offset*nMoments]), count * nMoments * sizeof(Real),
+                  MPI_BYTE, plan.fsgridRanks[r], 1, MPI_COMM_WORLD, &(plan.momentsReceiveRequests[r]));
+    MPI_Send_init(&(plan.fieldsSendBuffer[offset]), count * sizeof(FieldAverage),
+                  MPI_BYTE, plan.fsgridRanks[r], 1, MPI_COMM_WORLD, &(plan.fieldsSendRequests[r]));
+  }
+
+  plan.cells = cells;
+  plan.repartitionEpoch = P::meshRepartitionEpoch;
+  plan.valid = true;
+  phiprof::stop("fsgrid-coupling-plan");
+  return plan;
+}
+
 void feedMomentsIntoFsGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
                            const std::vector<CellID>& cells,
                            FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
@@ -99,95 +274,51 @@ void feedMomentsIntoFsGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
 
                            bool dt2 /*=false*/) {
 
-  int ii;
-  //sorted list of dccrg cells. cells is typicall already sorted, but just to make sure....
-  std::vector<CellID> dccrgCells = cells;
-  std::sort(dccrgCells.begin(), dccrgCells.end());
+  FsGridCouplingPlan& plan = getCouplingPlan(mpiGrid, cells, momentsGrid);
+  const int nMoments = fsgrids::moments::N_MOMENTS;
 
-  //Datastructure for coupling
-  std::map<int, std::set<CellID> > onDccrgMapRemoteProcess; 
-  std::map<int, std::set<CellID> > onFsgridMapRemoteProcess; 
-  std::map<CellID, std::vector<int64_t> >  onFsgridMapCells;
-    
-  // map receive process => receive buffers 
-  std::map<int, std::vector<Real> > receivedData; 
-
-  // send buffers  to each process
-  std::map<int, std::vector<Real> > sendData;
-
-  //list of requests
-  std::vector<MPI_Request> sendRequests;
-  std::vector<MPI_Request> receiveRequests;
- 
-  //computeCoupling
-  computeCoupling(mpiGrid, cells, momentsGrid, onDccrgMapRemoteProcess, onFsgridMapRemoteProcess, onFsgridMapCells);
- 
   // Post receives
-  receiveRequests.resize(onFsgridMapRemoteProcess.size());  
-  ii=0;
-  for(auto const &receives: onFsgridMapRemoteProcess){
-    int process = receives.first;
-    int count = receives.second.size();
-    receivedData[process].resize(count * fsgrids::moments::N_MOMENTS);
-    MPI_Irecv(receivedData[process].data(), count * fsgrids::moments::N_MOMENTS * sizeof(Real),
-	      MPI_BYTE, process, 1, MPI_COMM_WORLD,&(receiveRequests[ii++]));
+  if (plan.momentsReceiveRequests.size() > 0) {
+    MPI_Startall(plan.momentsReceiveRequests.size(), plan.momentsReceiveRequests.data());
   }
-  
+
+  // Pack send buffer, each dccrg cell has a fixed slot in it
+  const int momentsOffset = dt2 ? CellParams::RHOM_DT2 - CellParams::RHOM : 0;
+  const int pressureOffset = dt2 ? CellParams::P_11_DT2 - CellParams::P_11 : 0;
+  #pragma omp parallel for
+  for (size_t e=0; e<plan.dccrgCells.size(); ++e) {
+    const Real* cellParams = mpiGrid[plan.dccrgCells[e]]->get_cell_parameters();
+    Real* sendBuffer = &(plan.momentsSendBuffer[e*nMoments]);
+    sendBuffer[0] = cellParams[CellParams::RHOM + momentsOffset];
+    sendBuffer[1] = cellParams[CellParams::RHOQ + momentsOffset];
+    sendBuffer[2] = cellParams[CellParams::VX + momentsOffset];
+    sendBuffer[3] = cellParams[CellParams::VY + momentsOffset];
+    sendBuffer[4] = cellParams[CellParams::VZ + momentsOffset];
+    sendBuffer[5] = cellParams[CellParams::P_11 + pressureOffset];
+    sendBuffer[6] = cellParams[CellParams::P_22 + pressureOffset];
+    sendBuffer[7] = cellParams[CellParams::P_33 + pressureOffset];
+  }
+
   // Launch sends
-  ii=0;
-  sendRequests.resize(onDccrgMapRemoteProcess.size());
-  for (auto const &snd : onDccrgMapRemoteProcess){
-    int targetProc = snd.first; 
-    auto& sendBuffer=sendData[targetProc];
-    for(CellID sendCell: snd.second){
-      //Collect data to send for this dccrg cell
-      auto cellParams = mpiGrid[sendCell]->get_cell_parameters();
-      if(!dt2) {
-        sendBuffer.push_back(cellParams[CellParams::RHOM]);
-	sendBuffer.push_back(cellParams[CellParams::RHOQ]);
-	sendBuffer.push_back(cellParams[CellParams::VX]);
-	sendBuffer.push_back(cellParams[CellParams::VY]);
-        sendBuffer.push_back(cellParams[CellParams::VZ]);
-	sendBuffer.push_back(cellParams[CellParams::P_11]);
-	sendBuffer.push_back(cellParams[CellParams::P_22]);
-        sendBuffer.push_back(cellParams[CellParams::P_33]);
-      } else {
-        sendBuffer.push_back(cellParams[CellParams::RHOM_DT2]);
-	sendBuffer.push_back(cellParams[CellParams::RHOQ_DT2]);
-	sendBuffer.push_back(cellParams[CellParams::VX_DT2]);
-	sendBuffer.push_back(cellParams[CellParams::VY_DT2]);
-        sendBuffer.push_back(cellParams[CellParams::VZ_DT2]);
-	sendBuffer.push_back(cellParams[CellParams::P_11_DT2]);
-	sendBuffer.push_back(cellParams[CellParams::P_22_DT2]);
-        sendBuffer.push_back(cellParams[CellParams::P_33_DT2]);
-      }
-    }
-    int count = sendBuffer.size(); //note, compared to receive this includes all elements to be sent
-    MPI_Isend(sendBuffer.data(), sendBuffer.size() * sizeof(Real),
-	      MPI_BYTE, targetProc, 1, MPI_COMM_WORLD,&(sendRequests[ii]));
-    ii++;
+  if (plan.momentsSendRequests.size() > 0) {
+    MPI_Startall(plan.momentsSendRequests.size(), plan.momentsSendRequests.data());
   }
 
-  
-  MPI_Waitall(receiveRequests.size(), receiveRequests.data(), MPI_STATUSES_IGNORE);
-
-  for(auto const &receives: onFsgridMapRemoteProcess){
-    int process = receives.first; //data received from this process
-    Real* receiveBuffer = receivedData[process].data(); // data received from process
-    for(auto const &cell: receives.second){ //loop over cellids (dccrg) for receive
-      // this part heavily relies on both sender and receiver having cellids sorted!
-      for(auto lid: onFsgridMapCells[cell]){
-	std::array<Real, fsgrids::moments::N_MOMENTS> * fsgridData = momentsGrid.get(lid);
-	for(int l = 0; l < fsgrids::moments::N_MOMENTS; l++)   {
-	  fsgridData->at(l) = receiveBuffer[l];
-	}
+  MPI_Waitall(plan.momentsReceiveRequests.size(), plan.momentsReceiveRequests.data(), MPI_STATUSES_IGNORE);
+
+  // Unpack, this relies on both sender and receiver having cellids sorted!
+  #pragma omp parallel for
+  for (size_t e=0; e<plan.fsgridCells.size(); ++e) {
+    const Real* receiveBuffer = &(plan.momentsReceiveBuffer[e*nMoments]);
+    for (size_t l=plan.fsgridLidOffsets[e]; l<plan.fsgridLidOffsets[e+1]; ++l) {
+      std::array<Real, fsgrids::moments::N_MOMENTS> * fsgridData = momentsGrid.get(plan.fsgridLids[l]);
+      for(int m = 0; m < nMoments; m++) {
+        (*fsgridData)[m] = receiveBuffer[m];
       }
-      
-      receiveBuffer+=fsgrids::moments::N_MOMENTS;
     }
   }
 
-  MPI_Waitall(sendRequests.size(), sendRequests.data(), MPI_STATUSES_IGNORE);
+  MPI_Waitall(plan.momentsSendRequests.size(), plan.momentsSendRequests.data(), MPI_STATUSES_IGNORE);
 
 
 
@@ -311,170 +442,99 @@ void getFieldsFromFsGrid(
    const std::vector<CellID>& cells
 ) {
   // TODO: solver only needs bgb + PERB, we could combine them
-  
-  const int fieldsToCommunicate = 21;
-  struct Average {
-    Real sums[fieldsToCommunicate];
-    int cells;
-    Average()  {
-      cells = 0;
-      for(int i = 0; i < fieldsToCommunicate; i++){
-         sums[i] = 0;
-      }
-    }
-    Average operator+=(const Average& rhs) {
-      this->cells += rhs.cells;
-      for(int i = 0; i < fieldsToCommunicate; i++){
-         this->sums[i] += rhs.sums[i];
-      }
-    return *this;
-    }
-  };
-
-    
-  int ii;
-  //sorted list of dccrg cells. cells is typicall already sorted, but just to make sure....
-  std::vector<CellID> dccrgCells = cells;
-  std::sort(dccrgCells.begin(), dccrgCells.end());
-
-  //Datastructure for coupling
-  std::map<int, std::set<CellID> > onDccrgMapRemoteProcess; 
-  std::map<int, std::set<CellID> > onFsgridMapRemoteProcess; 
-  std::map<CellID, std::vector<int64_t> >  onFsgridMapCells;
-    
-  // map receive process => receive buffers 
-  std::map<int, std::vector<Average> > receivedData; 
-
-  // send buffers  to each process
-  std::map<int, std::vector<Average> > sendData;
-
-  // map where we finally aggregate result for each local dccrg cell
-  std::map<CellID, Average> aggregatedResult;
 
-  //list of requests
-  std::vector<MPI_Request> sendRequests;
-  std::vector<MPI_Request> receiveRequests;
-
-  
-  //computeCoupling
-  computeCoupling(mpiGrid, cells, volumeFieldsGrid, onDccrgMapRemoteProcess, onFsgridMapRemoteProcess, onFsgridMapCells);
+  FsGridCouplingPlan& plan = getCouplingPlan(mpiGrid, cells, volumeFieldsGrid);
 
   //post receives
-  ii=0;
-  receiveRequests.resize(onDccrgMapRemoteProcess.size());
-  for (auto const &rcv : onDccrgMapRemoteProcess){
-    int remoteRank = rcv.first; 
-    int count = rcv.second.size();
-    auto& receiveBuffer=receivedData[remoteRank];
-    
-    receiveBuffer.resize(count);
-    MPI_Irecv(receiveBuffer.data(), count * sizeof(Average),
-		 MPI_BYTE, remoteRank, 1, MPI_COMM_WORLD,&(receiveRequests[ii++]));
+  if (plan.fieldsReceiveRequests.size() > 0) {
+    MPI_Startall(plan.fieldsReceiveRequests.size(), plan.fieldsReceiveRequests.data());
   }
 
   //compute average and weight for each field that we want to send to dccrg grid
-  for(auto const &snd: onFsgridMapRemoteProcess){
-    int remoteRank = snd.first;
-    int count = snd.second.size();
-    auto& sendBuffer = sendData[remoteRank];
-    sendBuffer.resize(count);
-    
-    ii=0;
-    for(auto const dccrgCell: snd.second){
-      //loop over dccrg cells to which we shall send data for this remoteRank
-      auto const &fsgridCells = onFsgridMapCells[dccrgCell];
-      for (auto const fsgridCell: fsgridCells){
-        //loop over fsgrid cells for which we compute the average that is sent to dccrgCell on rank remoteRank
-        if(technicalGrid.get(fsgridCell)->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
-           continue;
-        }
-        std::array<Real, fsgrids::volfields::N_VOL> * volcell = volumeFieldsGrid.get(fsgridCell);
-	std::array<Real, fsgrids::bgbfield::N_BGB> * bgcell = BgBGrid.get(fsgridCell);
-	std::array<Real, fsgrids::egradpe::N_EGRADPE> * egradpecell = EGradPeGrid.get(fsgridCell);	
-	
-        sendBuffer[ii].sums[0 ] += volcell->at(fsgrids::volfields::PERBXVOL);
-        sendBuffer[ii].sums[1 ] += volcell->at(fsgrids::volfields::PERBYVOL);
-        sendBuffer[ii].sums[2 ] += volcell->at(fsgrids::volfields::PERBZVOL);
-        sendBuffer[ii].sums[6 ] += volcell->at(fsgrids::volfields::dPERBXVOLdy) / technicalGrid.DY;
-        sendBuffer[ii].sums[7 ] += volcell->at(fsgrids::volfields::dPERBXVOLdz) / technicalGrid.DZ;
-        sendBuffer[ii].sums[8 ] += volcell->at(fsgrids::volfields::dPERBYVOLdx) / technicalGrid.DX;
-        sendBuffer[ii].sums[9 ] += volcell->at(fsgrids::volfields::dPERBYVOLdz) / technicalGrid.DZ;
-        sendBuffer[ii].sums[10] += volcell->at(fsgrids::volfields::dPERBZVOLdx) / technicalGrid.DX;
-        sendBuffer[ii].sums[11] += volcell->at(fsgrids::volfields::dPERBZVOLdy) / technicalGrid.DY;
-        sendBuffer[ii].sums[12] += bgcell->at(fsgrids::bgbfield::BGBXVOL);
-        sendBuffer[ii].sums[13] += bgcell->at(fsgrids::bgbfield::BGBYVOL);
-        sendBuffer[ii].sums[14] += bgcell->at(fsgrids::bgbfield::BGBZVOL);
-        sendBuffer[ii].sums[15] += egradpecell->at(fsgrids::egradpe::EXGRADPE);
-        sendBuffer[ii].sums[16] += egradpecell->at(fsgrids::egradpe::EYGRADPE);
-        sendBuffer[ii].sums[17] += egradpecell->at(fsgrids::egradpe::EZGRADPE);
-	sendBuffer[ii].sums[18] += volcell->at(fsgrids::volfields::EXVOL);
-	sendBuffer[ii].sums[19] += volcell->at(fsgrids::volfields::EYVOL);
-	sendBuffer[ii].sums[20] += volcell->at(fsgrids::volfields::EZVOL);
-        sendBuffer[ii].cells++;
+  #pragma omp parallel for
+  for (size_t e=0; e<plan.fsgridCells.size(); ++e) {
+    FieldAverage& sendAverage = plan.fieldsSendBuffer[e];
+    sendAverage.clear();
+    for (size_t l=plan.fsgridLidOffsets[e]; l<plan.fsgridLidOffsets[e+1]; ++l) {
+      //loop over fsgrid cells for which we compute the average that is sent to the dccrg cell
+      const int64_t fsgridCell = plan.fsgridLids[l];
+      if(technicalGrid.get(fsgridCell)->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
+        continue;
       }
-      ii++;
+      std::array<Real, fsgrids::volfields::N_VOL> * volcell = volumeFieldsGrid.get(fsgridCell);
+      std::array<Real, fsgrids::bgbfield::N_BGB> * bgcell = BgBGrid.get(fsgridCell);
+      std::array<Real, fsgrids::egradpe::N_EGRADPE> * egradpecell = EGradPeGrid.get(fsgridCell);
+
+      sendAverage.sums[0 ] += volcell->at(fsgrids::volfields::PERBXVOL);
+      sendAverage.sums[1 ] += volcell->at(fsgrids::volfields::PERBYVOL);
+      sendAverage.sums[2 ] += volcell->at(fsgrids::volfields::PERBZVOL);
+      sendAverage.sums[6 ] += volcell->at(fsgrids::volfields::dPERBXVOLdy) / technicalGrid.DY;
+      sendAverage.sums[7 ] += volcell->at(fsgrids::volfields::dPERBXVOLdz) / technicalGrid.DZ;
+      sendAverage.sums[8 ] += volcell->at(fsgrids::volfields::dPERBYVOLdx) / technicalGrid.DX;
+      sendAverage.sums[9 ] += volcell->at(fsgrids::volfields::dPERBYVOLdz) / technicalGrid.DZ;
+      sendAverage.sums[10] += volcell->at(fsgrids::volfields::dPERBZVOLdx) / technicalGrid.DX;
+      sendAverage.sums[11] += volcell->at(fsgrids::volfields::dPERBZVOLdy) / technicalGrid.DY;
+      sendAverage.sums[12] += bgcell->at(fsgrids::bgbfield::BGBXVOL);
+      sendAverage.sums[13] += bgcell->at(fsgrids::bgbfield::BGBYVOL);
+      sendAverage.sums[14] += bgcell->at(fsgrids::bgbfield::BGBZVOL);
+      sendAverage.sums[15] += egradpecell->at(fsgrids::egradpe::EXGRADPE);
+      sendAverage.sums[16] += egradpecell->at(fsgrids::egradpe::EYGRADPE);
+      sendAverage.sums[17] += egradpecell->at(fsgrids::egradpe::EZGRADPE);
+      sendAverage.sums[18] += volcell->at(fsgrids::volfields::EXVOL);
+      sendAverage.sums[19] += volcell->at(fsgrids::volfields::EYVOL);
+      sendAverage.sums[20] += volcell->at(fsgrids::volfields::EZVOL);
+      sendAverage.cells++;
     }
   }
-  
+
   //post sends
-  sendRequests.resize(onFsgridMapRemoteProcess.size());
-  ii=0;
-  for(auto const &sends: onFsgridMapRemoteProcess){
-    int remoteRank = sends.first;
-    int count = sends.second.size();
-    MPI_Isend(sendData[remoteRank].data(), count * sizeof(Average),
-	     MPI_BYTE, remoteRank, 1, MPI_COMM_WORLD,&(sendRequests[ii++]));
+  if (plan.fieldsSendRequests.size() > 0) {
+    MPI_Startall(plan.fieldsSendRequests.size(), plan.fieldsSendRequests.data());
   }
-  
-  MPI_Waitall(receiveRequests.size(), receiveRequests.data(), MPI_STATUSES_IGNORE);
-
-
-  //Aggregate receives, compute the weighted average of these
-  ii=0;
-  for (auto const &rcv : onDccrgMapRemoteProcess){
-    int remoteRank = rcv.first; 
-    std::vector<Average>& receiveBuffer=receivedData[remoteRank];
-    ii=0;
-    for (CellID dccrgCell: rcv.second ) {
-      //aggregate result. Average strct has operator += and a constructor
-      aggregatedResult[dccrgCell] += receiveBuffer[ii++];
+
+  MPI_Waitall(plan.fieldsReceiveRequests.size(), plan.fieldsReceiveRequests.data(), MPI_STATUSES_IGNORE);
+
+  //Aggregate receives of each dccrg cell, compute the weighted average of these,
+  //and store data in dccrg
+  #pragma omp parallel for
+  for (size_t c=0; c<plan.uniqueCells.size(); ++c) {
+    FieldAverage cellAggregate;
+    for (size_t u=plan.uniqueOffsets[c]; u<plan.uniqueOffsets[c+1]; ++u) {
+      cellAggregate += plan.fieldsReceiveBuffer[plan.uniqueSlots[u]];
     }
-  }
-  
-  //Store data in dccrg
-  for (auto const &cellAggregate : aggregatedResult) {
-    auto cellParams = mpiGrid[cellAggregate.first]->get_cell_parameters();
-    if ( cellAggregate.second.cells > 0) {
-      cellParams[CellParams::PERBXVOL] = cellAggregate.second.sums[0] / cellAggregate.second.cells;
-      cellParams[CellParams::PERBYVOL] = cellAggregate.second.sums[1] / cellAggregate.second.cells;
-      cellParams[CellParams::PERBZVOL] = cellAggregate.second.sums[2] / cellAggregate.second.cells;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBXVOLdy] = cellAggregate.second.sums[6] / cellAggregate.second.cells;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBXVOLdz] = cellAggregate.second.sums[7] / cellAggregate.second.cells;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBYVOLdx] = cellAggregate.second.sums[8] / cellAggregate.second.cells;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBYVOLdz] = cellAggregate.second.sums[9] / cellAggregate.second.cells;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBZVOLdx] = cellAggregate.second.sums[10] / cellAggregate.second.cells;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBZVOLdy] = cellAggregate.second.sums[11] / cellAggregate.second.cells;
-      cellParams[CellParams::BGBXVOL]  = cellAggregate.second.sums[12] / cellAggregate.second.cells;
-      cellParams[CellParams::BGBYVOL]  = cellAggregate.second.sums[13] / cellAggregate.second.cells;
-      cellParams[CellParams::BGBZVOL]  = cellAggregate.second.sums[14] / cellAggregate.second.cells;
-      cellParams[CellParams::EXGRADPE] = cellAggregate.second.sums[15] / cellAggregate.second.cells;
-      cellParams[CellParams::EYGRADPE] = cellAggregate.second.sums[16] / cellAggregate.second.cells;
-      cellParams[CellParams::EZGRADPE] = cellAggregate.second.sums[17] / cellAggregate.second.cells;
-      cellParams[CellParams::EXVOL] = cellAggregate.second.sums[18] / cellAggregate.second.cells;
-      cellParams[CellParams::EYVOL] = cellAggregate.second.sums[19] / cellAggregate.second.cells;
-      cellParams[CellParams::EZVOL] = cellAggregate.second.sums[20] / cellAggregate.second.cells;
+    SpatialCell* cell = mpiGrid[plan.uniqueCells[c]];
+    auto cellParams = cell->get_cell_parameters();
+    if ( cellAggregate.cells > 0) {
+      cellParams[CellParams::PERBXVOL] = cellAggregate.sums[0] / cellAggregate.cells;
+      cellParams[CellParams::PERBYVOL] = cellAggregate.sums[1] / cellAggregate.cells;
+      cellParams[CellParams::PERBZVOL] = cellAggregate.sums[2] / cellAggregate.cells;
+      cell->derivativesBVOL[bvolderivatives::dPERBXVOLdy] = cellAggregate.sums[6] / cellAggregate.cells;
+      cell->derivativesBVOL[bvolderivatives::dPERBXVOLdz] = cellAggregate.sums[7] / cellAggregate.cells;
+      cell->derivativesBVOL[bvolderivatives::dPERBYVOLdx] = cellAggregate.sums[8] / cellAggregate.cells;
+      cell->derivativesBVOL[bvolderivatives::dPERBYVOLdz] = cellAggregate.sums[9] / cellAggregate.cells;
+      cell->derivativesBVOL[bvolderivatives::dPERBZVOLdx] = cellAggregate.sums[10] / cellAggregate.cells;
+      cell->derivativesBVOL[bvolderivatives::dPERBZVOLdy] = cellAggregate.sums[11] / cellAggregate.cells;
+      cellParams[CellParams::BGBXVOL]  = cellAggregate.sums[12] / cellAggregate.cells;
+      cellParams[CellParams::BGBYVOL]  = cellAggregate.sums[13] / cellAggregate.cells;
+      cellParams[CellParams::BGBZVOL]  = cellAggregate.sums[14] / cellAggregate.cells;
+      cellParams[CellParams::EXGRADPE] = cellAggregate.sums[15] / cellAggregate.cells;
+      cellParams[CellParams::EYGRADPE] = cellAggregate.sums[16] / cellAggregate.cells;
+      cellParams[CellParams::EZGRADPE] = cellAggregate.sums[17] / cellAggregate.cells;
+      cellParams[CellParams::EXVOL] = cellAggregate.sums[18] / cellAggregate.cells;
+      cellParams[CellParams::EYVOL] = cellAggregate.sums[19] / cellAggregate.cells;
+      cellParams[CellParams::EZVOL] = cellAggregate.sums[20] / cellAggregate.cells;
     }
     else{
       // This could happpen if all fsgrid cells are do not compute
       cellParams[CellParams::PERBXVOL] = 0;
       cellParams[CellParams::PERBYVOL] = 0;
       cellParams[CellParams::PERBZVOL] = 0;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBXVOLdy] = 0;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBXVOLdz] = 0;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBYVOLdx] = 0;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBYVOLdz] = 0;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBZVOLdx] = 0;
-      mpiGrid[cellAggregate.first]->derivativesBVOL[bvolderivatives::dPERBZVOLdy] = 0;
+      cell->derivativesBVOL[bvolderivatives::dPERBXVOLdy] = 0;
+      cell->derivativesBVOL[bvolderivatives::dPERBXVOLdz] = 0;
+      cell->derivativesBVOL[bvolderivatives::dPERBYVOLdx] = 0;
+      cell->derivativesBVOL[bvolderivatives::dPERBYVOLdz] = 0;
+      cell->derivativesBVOL[bvolderivatives::dPERBZVOLdx] = 0;
+      cell->derivativesBVOL[bvolderivatives::dPERBZVOLdy] = 0;
       cellParams[CellParams::BGBXVOL]  = 0;
       cellParams[CellParams::BGBYVOL]  = 0;
       cellParams[CellParams::BGBZVOL]  = 0;
@@ -486,8 +546,8 @@ void getFieldsFromFsGrid(
       cellParams[CellParams::EZVOL] = 0;
     }
   }
-  
-  MPI_Waitall(sendRequests.size(), sendRequests.data(), MPI_STATUSES_IGNORE);
+
+  MPI_Waitall(plan.fieldsSendRequests.size(), plan.fieldsSendRequests.data(), MPI_STATUSES_IGNORE);
 }
 
 /*
@@ -32,6 +32,86 @@
 namespace pc = physicalconstants;
 using namespace std;
 
+/*! \brief Pointers to the data of one cell in all fsGrids used by the electric field kernels.
+ *
+ * All field solver fsGrids have the same local size and stencil width, so a neighbour of a cell
+ * is found at the same element offset in every grid (see EFieldStencil). The kernels reach the
+ * neighbours by pointer arithmetic instead of a bounds-checked FsGrid::get per neighbour and grid.
+ */
+struct EFieldCell {
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb;
+   std::array<Real, fsgrids::efield::N_EFIELD> * efield;
+   std::array<Real, fsgrids::ehall::N_EHALL> * ehall;
+   std::array<Real, fsgrids::egradpe::N_EGRADPE> * egradpe;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb;
+   fsgrids::technical * technical;
+};
+
+/*! \brief Neighbour offsets and cell size shared by all field solver fsGrids.*/
+struct EFieldStencil {
+   int64_t x;  /*!< Element offset to the +x neighbour, zero if the grid is flat in x.*/
+   int64_t y;  /*!< Element offset to the +y neighbour, zero if the grid is flat in y.*/
+   int64_t z;  /*!< Element offset to the +z neighbour, zero if the grid is flat in z.*/
+   Real DX,DY,DZ;
+};
+
+static EFieldStencil getEFieldStencil(FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid) {
+   EFieldStencil stencil;
+   const int64_t origin = technicalGrid.LocalIDForCoords(0,0,0);
+   stencil.x = technicalGrid.LocalIDForCoords(1,0,0) - origin;
+   stencil.y = technicalGrid.LocalIDForCoords(0,1,0) - origin;
+   stencil.z = technicalGrid.LocalIDForCoords(0,0,1) - origin;
+   stencil.DX = technicalGrid.DX;
+   stencil.DY = technicalGrid.DY;
+   stencil.DZ = technicalGrid.DZ;
+   return stencil;
+}
+
+static EFieldCell getEFieldCell(
+   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
+   FsGrid< std::array<Real, fsgrids::efield::N_EFIELD>, FS_STENCIL_WIDTH> & EGrid,
+   FsGrid< std::array<Real, fsgrids::ehall::N_EHALL>, FS_STENCIL_WIDTH> & EHallGrid,
+   FsGrid< std::array<Real, fsgrids::egradpe::N_EGRADPE>, FS_STENCIL_WIDTH> & EGradPeGrid,
+   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
+   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
+   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
+   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
+   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
+   cint i,
+   cint j,
+   cint k
+) {
+   EFieldCell cell;
+   cell.perb = perBGrid.get(i,j,k);
+   cell.efield = EGrid.get(i,j,k);
+   cell.ehall = EHallGrid.get(i,j,k);
+   cell.egradpe = EGradPeGrid.get(i,j,k);
+   cell.moments = momentsGrid.get(i,j,k);
+   cell.dperb = dPerBGrid.get(i,j,k);
+   cell.dmoments = dMomentsGrid.get(i,j,k);
+   cell.bgb = BgBGrid.get(i,j,k);
+   cell.technical = technicalGrid.get(i,j,k);
+   return cell;
+}
+
+/*! \brief Returns the pointers of the cell at the given element offset from cell.*/
+static inline EFieldCell shiftCell(const EFieldCell& cell, const int64_t offset) {
+   EFieldCell shifted;
+   shifted.perb = cell.perb + offset;
+   shifted.efield = cell.efield + offset;
+   shifted.ehall = cell.ehall + offset;
+   shifted.egradpe = cell.egradpe + offset;
+   shifted.moments = cell.moments + offset;
+   shifted.dperb = cell.dperb + offset;
+   shifted.dmoments = cell.dmoments + offset;
+   shifted.bgb = cell.bgb + offset;
+   shifted.technical = cell.technical + offset;
+   return shifted;
+}
+
 /*! \brief Low-level helper function.
  *
  * Computes the correct combination of speeds to determine the CFL limits.
@@ -64,20 +144,16 @@ Real calculateCflSpeed(
 /*! \brief Low-level helper function.
  * 
  * Computes the magnetosonic speed in the YZ plane. Used in upwinding the electric field X component,
- * at the interface between cell (i,j,k) and (nbi,nbj,nbk).
+ * at the interface between the current and the adjacent cell.
  * 
  * Expects that the correct RHO and B fields are being passed, depending on the
  * stage of the Runge-Kutta time stepping method.
  * 
  * If fields are not propagated, returns 0.0 as there is no information propagating.
  * 
- * \param perBGrid fsGrid holding the perturbed B quantities
- * \param momentsGrid fsGrid holding the moment quantities
- * \param dPerBGrid fsGrid holding the derivatives of perturbed B
- * \param dMomentsGrid fsGrid holding the derviatives of moments
- * \param BgBGrid fsGrid holding the background B quantities
- * \param i,j,k fsGrid cell coordinates for the current cell
- * \param nbi,nbj,nbk fsGrid cell coordinates for the adjacent cell
+ * \param cell Pointers to the data of the current cell
+ * \param nbrOffset Element offset from the current cell to the adjacent cell
+ * \param stencil Neighbour offsets and cell size of the fsGrids
  * \param By Current cell's By
  * \param Bz Current cell's Bz
  * \param dBydx dBydx derivative
@@ -92,18 +168,10 @@ Real calculateCflSpeed(
  * \param ret_vS Sound speed returned
  * \param ret_vW Whistler speed returned
  */
-void calculateWaveSpeedYZ(
-   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
-   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
-   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
-   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
-   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
-   cint i,
-   cint j,
-   cint k,
-   cint nbi,
-   cint nbj,
-   cint nbk,
+static inline void calculateWaveSpeedYZ(
+   const EFieldCell& cell,
+   const int64_t nbrOffset,
+   const EFieldStencil& stencil,
    const Real& By,
    const Real& Bz,
    const Real& dBydx,
@@ -118,14 +186,14 @@ void calculateWaveSpeedYZ(
    Real& ret_vS,
    Real& ret_vW
 ) {
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb = perBGrid.get(i,j,k);
-   std::array<Real, fsgrids::bfield::N_BFIELD> * nbr_perb = perBGrid.get(nbi,nbj,nbk);
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments = momentsGrid.get(i,j,k);
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments = dMomentsGrid.get(i,j,k);
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb = dPerBGrid.get(i,j,k);
-   std::array<Real, fsgrids::dperb::N_DPERB> * nbr_dperb = dPerBGrid.get(nbi,nbj,nbk);
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb = BgBGrid.get(i,j,k);
-   std::array<Real, fsgrids::bgbfield::N_BGB> *  nbr_bgb = BgBGrid.get(nbi,nbj,nbk);
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb = cell.perb;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * nbr_perb = cell.perb + nbrOffset;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments = cell.moments;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments = cell.dmoments;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb = cell.dperb;
+   std::array<Real, fsgrids::dperb::N_DPERB> * nbr_dperb = cell.dperb + nbrOffset;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb = cell.bgb;
+   std::array<Real, fsgrids::bgbfield::N_BGB> *  nbr_bgb = cell.bgb + nbrOffset;
    
    Real A_0, A_X, rhom, p11, p22, p33;
    A_0  = HALF*(nbr_perb->at(fsgrids::bfield::PERBX) + nbr_bgb->at(fsgrids::bgbfield::BGBX) + perb->at(fsgrids::bfield::PERBX) + bgb->at(fsgrids::bgbfield::BGBX));
@@ -169,7 +237,7 @@ void calculateWaveSpeedYZ(
    // for details.
    const Real vA2 = divideIfNonZero(Bmag2, pc::MU_0*rhom); // Alfven speed
    const Real vS2 = divideIfNonZero(p11+p22+p33, 2.0*rhom); // sound speed, adiabatic coefficient 3/2, P=1/3*trace in sound speed
-   const Real vW = Parameters::ohmHallTerm > 0 ? divideIfNonZero(2.0*M_PI*vA2*pc::MASS_PROTON, perBGrid.DX*pc::CHARGE*sqrt(Bmag2)) : 0.0; // whistler speed
+   const Real vW = Parameters::ohmHallTerm > 0 ? divideIfNonZero(2.0*M_PI*vA2*pc::MASS_PROTON, stencil.DX*pc::CHARGE*sqrt(Bmag2)) : 0.0; // whistler speed
    
    ret_vA = sqrt(vA2);
    ret_vS = sqrt(vS2);
@@ -179,19 +247,15 @@ void calculateWaveSpeedYZ(
 /*! \brief Low-level helper function.
  * 
  * Computes the magnetosonic speed in the XZ plane. Used in upwinding the electric field Y component,
- * at the interface between cell (i,j,k) and (nbi,nbj,nbk).
+ * at the interface between the current and the adjacent cell.
  * 
  * Expects that the correct RHO and B fields are being passed, depending on the stage of the Runge-Kutta time stepping method.
  * 
  * If fields are not propagated, returns 0.0 as there is no information propagating.
  * 
- * \param perBGrid fsGrid holding the perturbed B quantities
- * \param momentsGrid fsGrid holding the moment quantities
- * \param dPerBGrid fsGrid holding the derivatives of perturbed B
- * \param dMomentsGrid fsGrid holding the derviatives of moments
- * \param BgBGrid fsGrid holding the background B quantities
- * \param i,j,k fsGrid cell coordinates for the current cell
- * \param nbi,nbj,nbk fsGrid cell coordinates for the adjacent cell
+ * \param cell Pointers to the data of the current cell
+ * \param nbrOffset Element offset from the current cell to the adjacent cell
+ * \param stencil Neighbour offsets and cell size of the fsGrids
  * \param Bx Current cell's Bx
  * \param Bz Current cell's Bz
  * \param dBxdy dBxdy derivative
@@ -206,18 +270,10 @@ void calculateWaveSpeedYZ(
  * \param ret_vS Sound speed returned
  * \param ret_vW Whistler speed returned
  */
-void calculateWaveSpeedXZ(
-   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
-   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
-   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
-   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
-   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
-   cint i,
-   cint j,
-   cint k,
-   cint nbi,
-   cint nbj,
-   cint nbk,
+static inline void calculateWaveSpeedXZ(
+   const EFieldCell& cell,
+   const int64_t nbrOffset,
+   const EFieldStencil& stencil,
    const Real& Bx,
    const Real& Bz,
    const Real& dBxdy,
@@ -232,14 +288,14 @@ void calculateWaveSpeedXZ(
    Real& ret_vS,
    Real& ret_vW
 ) {
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb = perBGrid.get(i,j,k);
-   std::array<Real, fsgrids::bfield::N_BFIELD> * nbr_perb = perBGrid.get(nbi,nbj,nbk);
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments = momentsGrid.get(i,j,k);
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments = dMomentsGrid.get(i,j,k);
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb = dPerBGrid.get(i,j,k);
-   std::array<Real, fsgrids::dperb::N_DPERB> * nbr_dperb = dPerBGrid.get(nbi,nbj,nbk);
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb = BgBGrid.get(i,j,k);
-   std::array<Real, fsgrids::bgbfield::N_BGB> *  nbr_bgb = BgBGrid.get(nbi,nbj,nbk);
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb = cell.perb;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * nbr_perb = cell.perb + nbrOffset;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments = cell.moments;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments = cell.dmoments;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb = cell.dperb;
+   std::array<Real, fsgrids::dperb::N_DPERB> * nbr_dperb = cell.dperb + nbrOffset;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb = cell.bgb;
+   std::array<Real, fsgrids::bgbfield::N_BGB> *  nbr_bgb = cell.bgb + nbrOffset;
    
    Real B_0, B_Y, rhom, p11, p22, p33;
    B_0  = HALF*(nbr_perb->at(fsgrids::bfield::PERBY) + nbr_bgb->at(fsgrids::bgbfield::BGBY) + perb->at(fsgrids::bfield::PERBY) + bgb->at(fsgrids::bgbfield::BGBY));
@@ -283,7 +339,7 @@ void calculateWaveSpeedXZ(
    // for details.
    const Real vA2 = divideIfNonZero(Bmag2, pc::MU_0*rhom); // Alfven speed
    const Real vS2 = divideIfNonZero(p11+p22+p33, 2.0*rhom); // sound speed, adiabatic coefficient 3/2, P=1/3*trace in sound speed
-   const Real vW = Parameters::ohmHallTerm > 0 ? divideIfNonZero(2.0*M_PI*vA2*pc::MASS_PROTON, perBGrid.DX*pc::CHARGE*sqrt(Bmag2)) : 0.0; // whistler speed
+   const Real vW = Parameters::ohmHallTerm > 0 ? divideIfNonZero(2.0*M_PI*vA2*pc::MASS_PROTON, stencil.DX*pc::CHARGE*sqrt(Bmag2)) : 0.0; // whistler speed
    
    ret_vA = sqrt(vA2);
    ret_vS = sqrt(vS2);
@@ -293,19 +349,15 @@ void calculateWaveSpeedXZ(
 /*! \brief Low-level helper function.
  * 
  * Computes the magnetosonic speed in the XY plane. Used in upwinding the electric field Z component,
- * at the interface between cell (i,j,k) and (nbi,nbj,nbk).
+ * at the interface between the current and the adjacent cell.
  * 
  * Expects that the correct RHO and B fields are being passed, depending on the stage of the Runge-Kutta time stepping method.
  * 
  * If fields are not propagated, returns 0.0 as there is no information propagating.
  * 
- * \param perBGrid fsGrid holding the perturbed B quantities
- * \param momentsGrid fsGrid holding the moment quantities
- * \param dPerBGrid fsGrid holding the derivatives of perturbed B
- * \param dMomentsGrid fsGrid holding the derviatives of moments
- * \param BgBGrid fsGrid holding the background B quantities
- * \param i,j,k fsGrid cell coordinates for the current cell
- * \param nbi,nbj,nbk fsGrid cell coordinates for the adjacent cell
+ * \param cell Pointers to the data of the current cell
+ * \param nbrOffset Element offset from the current cell to the adjacent cell
+ * \param stencil Neighbour offsets and cell size of the fsGrids
  * \param Bx Current cell's Bx
  * \param By Current cell's By
  * \param dBxdy dBxdy derivative
@@ -320,18 +372,10 @@ void calculateWaveSpeedXZ(
  * \param ret_vS Sound speed returned
  * \param ret_vW Whistler speed returned
  */
-void calculateWaveSpeedXY(
-   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
-   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
-   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
-   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
-   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
-   cint i,
-   cint j,
-   cint k,
-   cint nbi,
-   cint nbj,
-   cint nbk,
+static inline void calculateWaveSpeedXY(
+   const EFieldCell& cell,
+   const int64_t nbrOffset,
+   const EFieldStencil& stencil,
    const Real& Bx,
    const Real& By,
    const Real& dBxdy,
@@ -346,14 +390,14 @@ void calculateWaveSpeedXY(
    Real& ret_vS,
    Real& ret_vW
 ) {
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb = perBGrid.get(i,j,k);
-   std::array<Real, fsgrids::bfield::N_BFIELD> * nbr_perb = perBGrid.get(nbi,nbj,nbk);
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments = momentsGrid.get(i,j,k);
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments = dMomentsGrid.get(i,j,k);
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb = dPerBGrid.get(i,j,k);
-   std::array<Real, fsgrids::dperb::N_DPERB> * nbr_dperb = dPerBGrid.get(nbi,nbj,nbk);
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb = BgBGrid.get(i,j,k);
-   std::array<Real, fsgrids::bgbfield::N_BGB> *  nbr_bgb = BgBGrid.get(nbi,nbj,nbk);
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb = cell.perb;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * nbr_perb = cell.perb + nbrOffset;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments = cell.moments;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments = cell.dmoments;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb = cell.dperb;
+   std::array<Real, fsgrids::dperb::N_DPERB> * nbr_dperb = cell.dperb + nbrOffset;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb = cell.bgb;
+   std::array<Real, fsgrids::bgbfield::N_BGB> *  nbr_bgb = cell.bgb + nbrOffset;
    
    Real C_0, C_Z, rhom, p11, p22, p33;
    C_0  = HALF*(nbr_perb->at(fsgrids::bfield::PERBZ) + nbr_bgb->at(fsgrids::bgbfield::BGBZ) + perb->at(fsgrids::bfield::PERBZ) + bgb->at(fsgrids::bgbfield::BGBZ));
@@ -397,7 +441,7 @@ void calculateWaveSpeedXY(
    // for details.
    const Real vA2 = divideIfNonZero(Bmag2, pc::MU_0*rhom); // Alfven speed
    const Real vS2 = divideIfNonZero(p11+p22+p33, 2.0*rhom); // sound speed, adiabatic coefficient 3/2, P=1/3*trace in sound speed
-   const Real vW = Parameters::ohmHallTerm > 0 ? divideIfNonZero(2.0*M_PI*vA2*pc::MASS_PROTON, perBGrid.DX*pc::CHARGE*sqrt(Bmag2)) : 0.0; // whistler speed
+   const Real vW = Parameters::ohmHallTerm > 0 ? divideIfNonZero(2.0*M_PI*vA2*pc::MASS_PROTON, stencil.DX*pc::CHARGE*sqrt(Bmag2)) : 0.0; // whistler speed
    
    ret_vA = sqrt(vA2);
    ret_vS = sqrt(vS2);
@@ -412,45 +456,15 @@ void calculateWaveSpeedXY(
  * 
  * Note that the background B field is excluded from the diffusive term calculations because they are equivalent to a current term and the background field is curl-free.
  * 
- * \param perBGrid fsGrid holding the perturbed B quantities
- * \param EGrid fsGrid holding the electric field
- * \param EHallGrid fsGrid holding the Hall contributions to the electric field
- * \param EGradPeGrid fsGrid holding the electron pressure gradient E field
- * \param momentsGrid fsGrid holding the moment quantities
- * \param dPerBGrid fsGrid holding the derivatives of perturbed B
- * \param dMomentsGrid fsGrid holding the derviatives of moments
- * \param BgBGrid fsGrid holding the background B quantities
- * \param technicalGrid fsGrid holding technical information (such as boundary types)
- * \param i,j,k fsGrid cell coordinates for the current cell
+ * \param cell Pointers to the data of the current cell
+ * \param stencil Neighbour offsets and cell size of the fsGrids
  * \param RKCase Element in the enum defining the Runge-Kutta method steps
  */
-void calculateEdgeElectricFieldX(
-   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
-   FsGrid< std::array<Real, fsgrids::efield::N_EFIELD>, FS_STENCIL_WIDTH> & EGrid,
-   FsGrid< std::array<Real, fsgrids::ehall::N_EHALL>, FS_STENCIL_WIDTH> & EHallGrid,
-   FsGrid< std::array<Real, fsgrids::egradpe::N_EGRADPE>, FS_STENCIL_WIDTH> & EGradPeGrid,
-   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
-   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
-   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
-   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
-   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
-   cint i,
-   cint j,
-   cint k,
+static inline void calculateEdgeElectricFieldX(
+   const EFieldCell& cell,
+   const EFieldStencil& stencil,
    cint& RKCase
 ) {
-   #ifdef DEBUG_FSOLVER
-   bool ok = true;
-   if (technicalGrid.get(i,j,k) == NULL) ok = false;
-   if (technicalGrid.get(i,j-1,k) == NULL) ok = false;
-   if (technicalGrid.get(i,j-1,k-1) == NULL) ok = false;
-   if (technicalGrid.get(i,j,k-1) == NULL) ok = false;
-   if (ok == false) {
-      cerr << "NULL pointer in " << __FILE__ << ":" << __LINE__ << std::endl;
-      exit(1);
-   }
-   #endif
-
    // An edge has four neighbouring spatial cells. Calculate
    // electric field in each of the four cells per edge.
    Real ay_pos,ay_neg;              // Max. characteristic velocities to y-direction
@@ -461,28 +475,28 @@ void calculateEdgeElectricFieldX(
    Real c_y, c_z;                   // Wave speeds to yz-directions
 
    // Get values at all four neighbours, result is written to SW.
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SW = perBGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SE = perBGrid.get(i  ,j-1,k  );
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NE = perBGrid.get(i  ,j-1,k-1);
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NW = perBGrid.get(i  ,j  ,k-1);
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SW = BgBGrid.get(i,j  ,k  );
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SE = BgBGrid.get(i,j-1,k  );
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NE = BgBGrid.get(i,j-1,k-1);
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NW = BgBGrid.get(i,j  ,k-1);
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SW = momentsGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SE = momentsGrid.get(i  ,j-1,k  );
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NE = momentsGrid.get(i  ,j-1,k-1);
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NW = momentsGrid.get(i  ,j  ,k-1);
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SW = dMomentsGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SE = dMomentsGrid.get(i  ,j-1,k  );
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NE = dMomentsGrid.get(i  ,j-1,k-1);
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NW = dMomentsGrid.get(i  ,j  ,k-1);
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SW = dPerBGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SE = dPerBGrid.get(i  ,j-1,k  );
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NE = dPerBGrid.get(i  ,j-1,k-1);
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NW = dPerBGrid.get(i  ,j  ,k-1);
-   
-   std::array<Real, fsgrids::efield::N_EFIELD> * efield_SW = EGrid.get(i,j,k);
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SW = cell.perb;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SE = cell.perb - stencil.y;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NE = cell.perb - stencil.y - stencil.z;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NW = cell.perb - stencil.z;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SW = cell.bgb;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SE = cell.bgb - stencil.y;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NE = cell.bgb - stencil.y - stencil.z;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NW = cell.bgb - stencil.z;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SW = cell.moments;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SE = cell.moments - stencil.y;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NE = cell.moments - stencil.y - stencil.z;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NW = cell.moments - stencil.z;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SW = cell.dmoments;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SE = cell.dmoments - stencil.y;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NE = cell.dmoments - stencil.y - stencil.z;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NW = cell.dmoments - stencil.z;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SW = cell.dperb;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SE = cell.dperb - stencil.y;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NE = cell.dperb - stencil.y - stencil.z;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NW = cell.dperb - stencil.z;
+   
+   std::array<Real, fsgrids::efield::N_EFIELD> * efield_SW = cell.efield;
    
    Real By_S, Bz_W, Bz_E, By_N, perBy_S, perBz_W, perBz_E, perBy_N;
    Real minRhom = std::numeric_limits<Real>::max();
@@ -544,17 +558,17 @@ void calculateEdgeElectricFieldX(
            ) /
        moments_SW->at(fsgrids::moments::RHOQ) /
        physicalconstants::MU_0 *
-       (dperb_SW->at(fsgrids::dperb::dPERBzdy)/technicalGrid.DY - dperb_SW->at(fsgrids::dperb::dPERBydz)/technicalGrid.DZ);
+       (dperb_SW->at(fsgrids::dperb::dPERBzdy)/stencil.DY - dperb_SW->at(fsgrids::dperb::dPERBydz)/stencil.DZ);
    }
    
    // Hall term
    if(Parameters::ohmHallTerm > 0) {
-      Ex_SW += EHallGrid.get(i,j,k)->at(fsgrids::ehall::EXHALL_000_100);
+      Ex_SW += cell.ehall->at(fsgrids::ehall::EXHALL_000_100);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ex_SW += EGradPeGrid.get(i,j,k)->at(fsgrids::egradpe::EXGRADPE);
+      Ex_SW += cell.egradpe->at(fsgrids::egradpe::EXGRADPE);
    }
 
    #ifndef FS_1ST_ORDER_SPACE
@@ -563,13 +577,9 @@ void calculateEdgeElectricFieldX(
       Ex_SW += -HALF*((Bz_W - HALF*dBzdy_W)*(-dmoments_SW->at(fsgrids::dmoments::dVydy) - dmoments_SW->at(fsgrids::dmoments::dVydz)) - dBzdy_W*Vy0 + SIXTH*dBzdx_W*dmoments_SW->at(fsgrids::dmoments::dVydx));
    #endif
    calculateWaveSpeedYZ(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i  , j, k,
-      i+1, j, k,
+      cell,
+      stencil.x,
+      stencil,
       By_S, Bz_W, dBydx_S, dBydz_S, dBzdx_W, dBzdy_W, MINUS, MINUS, minRhom, maxRhom, vA, vS, vW
    );
    c_y = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -599,17 +609,17 @@ void calculateEdgeElectricFieldX(
            ) /
        moments_SE->at(fsgrids::moments::RHOQ) /
        physicalconstants::MU_0 *
-       (dperb_SE->at(fsgrids::dperb::dPERBzdy)/technicalGrid.DY - dperb_SE->at(fsgrids::dperb::dPERBydz)/technicalGrid.DZ);
+       (dperb_SE->at(fsgrids::dperb::dPERBzdy)/stencil.DY - dperb_SE->at(fsgrids::dperb::dPERBydz)/stencil.DZ);
    }
 
    // Hall term
    if(Parameters::ohmHallTerm > 0) {
-      Ex_SE += EHallGrid.get(i,j-1,k)->at(fsgrids::ehall::EXHALL_010_110);
+      Ex_SE += (cell.ehall - stencil.y)->at(fsgrids::ehall::EXHALL_010_110);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ex_SE += EGradPeGrid.get(i,j-1,k)->at(fsgrids::egradpe::EXGRADPE);
+      Ex_SE += (cell.egradpe - stencil.y)->at(fsgrids::egradpe::EXGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -619,13 +629,9 @@ void calculateEdgeElectricFieldX(
    #endif
    
    calculateWaveSpeedYZ(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i  , j-1, k,
-      i+1, j-1, k,
+      shiftCell(cell, -stencil.y),
+      stencil.x,
+      stencil,
       By_S, Bz_E, dBydx_S, dBydz_S, dBzdx_E, dBzdy_E, PLUS, MINUS, minRhom, maxRhom, vA, vS, vW
    );
    c_y = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -655,17 +661,17 @@ void calculateEdgeElectricFieldX(
            ) /
        moments_NW->at(fsgrids::moments::RHOQ) /
        physicalconstants::MU_0 *
-       (dperb_NW->at(fsgrids::dperb::dPERBzdy)/technicalGrid.DY - dperb_NW->at(fsgrids::dperb::dPERBydz)/technicalGrid.DZ);
+       (dperb_NW->at(fsgrids::dperb::dPERBzdy)/stencil.DY - dperb_NW->at(fsgrids::dperb::dPERBydz)/stencil.DZ);
    }
    
    // Hall term
    if(Parameters::ohmHallTerm > 0) {
-      Ex_NW += EHallGrid.get(i,j,k-1)->at(fsgrids::ehall::EXHALL_001_101);
+      Ex_NW += (cell.ehall - stencil.z)->at(fsgrids::ehall::EXHALL_001_101);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ex_NW += EGradPeGrid.get(i,j,k-1)->at(fsgrids::egradpe::EXGRADPE);
+      Ex_NW += (cell.egradpe - stencil.z)->at(fsgrids::egradpe::EXGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -675,13 +681,9 @@ void calculateEdgeElectricFieldX(
    #endif
    
    calculateWaveSpeedYZ(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i  , j, k-1,
-      i+1, j, k-1,
+      shiftCell(cell, -stencil.z),
+      stencil.x,
+      stencil,
       By_N, Bz_W, dBydx_N, dBydz_N, dBzdx_W, dBzdy_W, MINUS, PLUS, minRhom, maxRhom, vA, vS, vW
    );
    c_y = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -711,17 +713,17 @@ void calculateEdgeElectricFieldX(
                    ) /
                moments_NE->at(fsgrids::moments::RHOQ) /
                physicalconstants::MU_0 *
-               (dperb_NE->at(fsgrids::dperb::dPERBzdy)/technicalGrid.DY - dperb_NE->at(fsgrids::dperb::dPERBydz)/technicalGrid.DZ);
+               (dperb_NE->at(fsgrids::dperb::dPERBzdy)/stencil.DY - dperb_NE->at(fsgrids::dperb::dPERBydz)/stencil.DZ);
    }
 
    // Hall term
    if(Parameters::ohmHallTerm > 0) {
-      Ex_NE += EHallGrid.get(i,j-1,k-1)->at(fsgrids::ehall::EXHALL_011_111);
+      Ex_NE += (cell.ehall - stencil.y - stencil.z)->at(fsgrids::ehall::EXHALL_011_111);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ex_NE += EGradPeGrid.get(i,j-1,k-1)->at(fsgrids::egradpe::EXGRADPE);
+      Ex_NE += (cell.egradpe - stencil.y - stencil.z)->at(fsgrids::egradpe::EXGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -731,13 +733,9 @@ void calculateEdgeElectricFieldX(
    #endif
    
    calculateWaveSpeedYZ(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i  ,j-1,k-1,
-      i+1,j-1,k-1,
+      shiftCell(cell, -stencil.y - stencil.z),
+      stencil.x,
+      stencil,
       By_N, Bz_E, dBydx_N, dBydz_N, dBzdx_E, dBzdy_E, PLUS, PLUS, minRhom, maxRhom, vA, vS, vW
    );
    c_y = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -765,10 +763,10 @@ void calculateEdgeElectricFieldX(
    if ((RKCase == RK_ORDER1) || (RKCase == RK_ORDER2_STEP2)) {
       //compute maximum timestep for fieldsolver in this cell (CFL=1)
       Real min_dx=std::numeric_limits<Real>::max();
-      min_dx=min(min_dx,technicalGrid.DY);
-      min_dx=min(min_dx,technicalGrid.DZ);
+      min_dx=min(min_dx,stencil.DY);
+      min_dx=min(min_dx,stencil.DZ);
       //update max allowed timestep for field propagation in this cell, which is the minimum of CFL=1 timesteps
-      if (maxV != ZERO) technicalGrid.get(i,j,k)->maxFsDt = min(technicalGrid.get(i,j,k)->maxFsDt,min_dx/maxV);
+      if (maxV != ZERO) cell.technical->maxFsDt = min(cell.technical->maxFsDt,min_dx/maxV);
    }
 }
 
@@ -782,33 +780,11 @@ void calculateEdgeElectricFieldX(
  * 
  * \param RKCase Element in the enum defining the Runge-Kutta method steps
  */
-void calculateEdgeElectricFieldY(
-   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
-   FsGrid< std::array<Real, fsgrids::efield::N_EFIELD>, FS_STENCIL_WIDTH> & EGrid,
-   FsGrid< std::array<Real, fsgrids::ehall::N_EHALL>, FS_STENCIL_WIDTH> & EHallGrid,
-   FsGrid< std::array<Real, fsgrids::egradpe::N_EGRADPE>, FS_STENCIL_WIDTH> & EGradPeGrid,
-   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
-   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
-   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
-   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
-   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
-   cint i,
-   cint j,
-   cint k,
+static inline void calculateEdgeElectricFieldY(
+   const EFieldCell& cell,
+   const EFieldStencil& stencil,
    cint& RKCase
 ) {
-   #ifdef DEBUG_FSOLVER
-   bool ok = true;
-   if (technicalGrid.get(i,j,k) == NULL) ok = false;
-   if (technicalGrid.get(i,j,k-1) == NULL) ok = false;
-   if (technicalGrid.get(i-1,j,k) == NULL) ok = false;
-   if (technicalGrid.get(i-1,j,k-1) == NULL) ok = false;
-   if (ok == false) {
-      cerr << "NULL pointer in " << __FILE__ << ":" << __LINE__ << std::endl;
-      exit(1);
-   }
-   #endif
-   
    // An edge has four neighbouring spatial cells. Calculate
    // electric field in each of the four cells per edge.
    Real ax_pos,ax_neg;              // Max. characteristic velocities to x-direction
@@ -818,28 +794,28 @@ void calculateEdgeElectricFieldY(
    Real maxV = 0.0;                 // Max velocity for CFL purposes
    Real c_x,c_z;                    // Wave speeds to xz-directions
    
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SW = perBGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SE = perBGrid.get(i  ,j  ,k-1);
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NW = perBGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NE = perBGrid.get(i-1,j  ,k-1);
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SW = BgBGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SE = BgBGrid.get(i  ,j  ,k-1);
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NW = BgBGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NE = BgBGrid.get(i-1,j  ,k-1);
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SW = momentsGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SE = momentsGrid.get(i  ,j  ,k-1);
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NW = momentsGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NE = momentsGrid.get(i-1,j  ,k-1);
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SW = dMomentsGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SE = dMomentsGrid.get(i  ,j  ,k-1);
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NW = dMomentsGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NE = dMomentsGrid.get(i-1,j  ,k-1);
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SW = dPerBGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SE = dPerBGrid.get(i  ,j  ,k-1);
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NW = dPerBGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NE = dPerBGrid.get(i-1,j  ,k-1);
-   
-   std::array<Real, fsgrids::efield::N_EFIELD> * efield_SW = EGrid.get(i,j,k);
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SW = cell.perb;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SE = cell.perb - stencil.z;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NW = cell.perb - stencil.x;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NE = cell.perb - stencil.x - stencil.z;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SW = cell.bgb;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SE = cell.bgb - stencil.z;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NW = cell.bgb - stencil.x;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NE = cell.bgb - stencil.x - stencil.z;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SW = cell.moments;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SE = cell.moments - stencil.z;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NW = cell.moments - stencil.x;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NE = cell.moments - stencil.x - stencil.z;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SW = cell.dmoments;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SE = cell.dmoments - stencil.z;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NW = cell.dmoments - stencil.x;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NE = cell.dmoments - stencil.x - stencil.z;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SW = cell.dperb;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SE = cell.dperb - stencil.z;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NW = cell.dperb - stencil.x;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NE = cell.dperb - stencil.x - stencil.z;
+   
+   std::array<Real, fsgrids::efield::N_EFIELD> * efield_SW = cell.efield;
    
    // Fetch required plasma parameters:
    Real Bz_S, Bx_W, Bx_E, Bz_N, perBz_S, perBx_W, perBx_E, perBz_N;
@@ -901,17 +877,17 @@ void calculateEdgeElectricFieldY(
             ) /
         moments_SW->at(fsgrids::moments::RHOQ) /
         physicalconstants::MU_0 *
-        (dperb_SW->at(fsgrids::dperb::dPERBxdz)/technicalGrid.DZ - dperb_SW->at(fsgrids::dperb::dPERBzdx)/technicalGrid.DX);
+        (dperb_SW->at(fsgrids::dperb::dPERBxdz)/stencil.DZ - dperb_SW->at(fsgrids::dperb::dPERBzdx)/stencil.DX);
    }
 
    // Hall term
    if (Parameters::ohmHallTerm > 0) {
-      Ey_SW += EHallGrid.get(i,j,k)->at(fsgrids::ehall::EYHALL_000_010);
+      Ey_SW += cell.ehall->at(fsgrids::ehall::EYHALL_000_010);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ey_SW += EGradPeGrid.get(i,j,k)->at(fsgrids::egradpe::EYGRADPE);
+      Ey_SW += cell.egradpe->at(fsgrids::egradpe::EYGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -921,13 +897,9 @@ void calculateEdgeElectricFieldY(
    #endif
    
    calculateWaveSpeedXZ(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i, j, k,
-      i, j+1, k,
+      cell,
+      stencil.y,
+      stencil,
       Bx_W, Bz_S, dBxdy_W, dBxdz_W, dBzdx_S, dBzdy_S, MINUS, MINUS, minRhom, maxRhom, vA, vS, vW
    );
    c_z = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -957,17 +929,17 @@ void calculateEdgeElectricFieldY(
             ) /
         moments_SE->at(fsgrids::moments::RHOQ) /
         physicalconstants::MU_0 *
-        (dperb_SE->at(fsgrids::dperb::dPERBxdz)/technicalGrid.DZ - dperb_SE->at(fsgrids::dperb::dPERBzdx)/technicalGrid.DX);
+        (dperb_SE->at(fsgrids::dperb::dPERBxdz)/stencil.DZ - dperb_SE->at(fsgrids::dperb::dPERBzdx)/stencil.DX);
    }
 
    // Hall term
    if (Parameters::ohmHallTerm > 0) {
-      Ey_SE += EHallGrid.get(i,j,k-1)->at(fsgrids::ehall::EYHALL_001_011);
+      Ey_SE += (cell.ehall - stencil.z)->at(fsgrids::ehall::EYHALL_001_011);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ey_SE += EGradPeGrid.get(i,j,k-1)->at(fsgrids::egradpe::EYGRADPE);
+      Ey_SE += (cell.egradpe - stencil.z)->at(fsgrids::egradpe::EYGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -977,13 +949,9 @@ void calculateEdgeElectricFieldY(
    #endif
    
    calculateWaveSpeedXZ(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i, j  , k-1,
-      i, j+1, k-1,
+      shiftCell(cell, -stencil.z),
+      stencil.y,
+      stencil,
       Bx_E, Bz_S, dBxdy_E, dBxdz_E, dBzdx_S, dBzdy_S, MINUS, PLUS, minRhom, maxRhom, vA, vS, vW
    );
    c_z = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -1013,17 +981,17 @@ void calculateEdgeElectricFieldY(
             ) /
         moments_NW->at(fsgrids::moments::RHOQ) /
         physicalconstants::MU_0 *
-        (dperb_NW->at(fsgrids::dperb::dPERBxdz)/technicalGrid.DZ - dperb_NW->at(fsgrids::dperb::dPERBzdx)/technicalGrid.DX);
+        (dperb_NW->at(fsgrids::dperb::dPERBxdz)/stencil.DZ - dperb_NW->at(fsgrids::dperb::dPERBzdx)/stencil.DX);
    }
 
    // Hall term
    if(Parameters::ohmHallTerm > 0) {
-      Ey_NW += EHallGrid.get(i-1,j,k)->at(fsgrids::ehall::EYHALL_100_110);
+      Ey_NW += (cell.ehall - stencil.x)->at(fsgrids::ehall::EYHALL_100_110);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ey_NW += EGradPeGrid.get(i-1,j,k)->at(fsgrids::egradpe::EYGRADPE);
+      Ey_NW += (cell.egradpe - stencil.x)->at(fsgrids::egradpe::EYGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -1033,13 +1001,9 @@ void calculateEdgeElectricFieldY(
    #endif
    
    calculateWaveSpeedXZ(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i-1,j  ,k,
-      i-1,j+1,k,
+      shiftCell(cell, -stencil.x),
+      stencil.y,
+      stencil,
       Bx_W, Bz_N, dBxdy_W, dBxdz_W, dBzdx_N, dBzdy_N, PLUS, MINUS, minRhom, maxRhom, vA, vS, vW
    );
    c_z = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -1069,17 +1033,17 @@ void calculateEdgeElectricFieldY(
             ) /
         moments_NE->at(fsgrids::moments::RHOQ) /
         physicalconstants::MU_0 *
-        (dperb_NE->at(fsgrids::dperb::dPERBxdz)/technicalGrid.DZ - dperb_NE->at(fsgrids::dperb::dPERBzdx)/technicalGrid.DX);
+        (dperb_NE->at(fsgrids::dperb::dPERBxdz)/stencil.DZ - dperb_NE->at(fsgrids::dperb::dPERBzdx)/stencil.DX);
    }
 
    // Hall term
    if(Parameters::ohmHallTerm > 0) {
-      Ey_NE += EHallGrid.get(i-1,j,k-1)->at(fsgrids::ehall::EYHALL_101_111);
+      Ey_NE += (cell.ehall - stencil.x - stencil.z)->at(fsgrids::ehall::EYHALL_101_111);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ey_NE += EGradPeGrid.get(i-1,j,k-1)->at(fsgrids::egradpe::EYGRADPE);
+      Ey_NE += (cell.egradpe - stencil.x - stencil.z)->at(fsgrids::egradpe::EYGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -1089,13 +1053,9 @@ void calculateEdgeElectricFieldY(
    #endif
    
    calculateWaveSpeedXZ(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i-1,j  ,k-1,
-      i-1,j+1,k-1,
+      shiftCell(cell, -stencil.x - stencil.z),
+      stencil.y,
+      stencil,
       Bx_E, Bz_N, dBxdy_E, dBxdz_E, dBzdx_N, dBzdy_N, PLUS, PLUS, minRhom, maxRhom, vA, vS, vW
    );
    c_z = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -1122,10 +1082,10 @@ void calculateEdgeElectricFieldY(
    if ((RKCase == RK_ORDER1) || (RKCase == RK_ORDER2_STEP2)) {
       //compute maximum timestep for fieldsolver in this cell (CFL=1)      
       Real min_dx=std::numeric_limits<Real>::max();;
-      min_dx=min(min_dx,technicalGrid.DX);
-      min_dx=min(min_dx,technicalGrid.DZ);
+      min_dx=min(min_dx,stencil.DX);
+      min_dx=min(min_dx,stencil.DZ);
       //update max allowed timestep for field propagation in this cell, which is the minimum of CFL=1 timesteps
-      if (maxV!=ZERO) technicalGrid.get(i,j,k)->maxFsDt=min(technicalGrid.get(i,j,k)->maxFsDt,min_dx/maxV);
+      if (maxV!=ZERO) cell.technical->maxFsDt=min(cell.technical->maxFsDt,min_dx/maxV);
    }
 }
 
@@ -1139,33 +1099,11 @@ void calculateEdgeElectricFieldY(
  * 
  * \param RKCase Element in the enum defining the Runge-Kutta method steps
  */
-void calculateEdgeElectricFieldZ(
-   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
-   FsGrid< std::array<Real, fsgrids::efield::N_EFIELD>, FS_STENCIL_WIDTH> & EGrid,
-   FsGrid< std::array<Real, fsgrids::ehall::N_EHALL>, FS_STENCIL_WIDTH> & EHallGrid,
-   FsGrid< std::array<Real, fsgrids::egradpe::N_EGRADPE>, FS_STENCIL_WIDTH> & EGradPeGrid,
-   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
-   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
-   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
-   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
-   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
-   cint i,
-   cint j,
-   cint k,
+static inline void calculateEdgeElectricFieldZ(
+   const EFieldCell& cell,
+   const EFieldStencil& stencil,
    cint& RKCase
 ) {
-   #ifdef DEBUG_FSOLVER
-   bool ok = true;
-   if (technicalGrid.get(i,j,k) == NULL) ok = false;
-   if (technicalGrid.get(i-1,j,k) == NULL) ok = false;
-   if (technicalGrid.get(i-1,j-1,k) == NULL) ok = false;
-   if (technicalGrid.get(i,j-1,k) == NULL) ok = false;
-   if (ok == false) {
-      cerr << "NULL pointer in " << __FILE__ << ":" << __LINE__ << std::endl;
-      exit(1);
-   }
-   #endif
-
    // An edge has four neighbouring spatial cells. Calculate 
    // electric field in each of the four cells per edge.
    Real ax_pos,ax_neg;              // Max. characteristic velocities to x-direction
@@ -1176,28 +1114,28 @@ void calculateEdgeElectricFieldZ(
    Real c_x,c_y;                    // Characteristic speeds to xy-directions
    
    // Get read-only pointers to NE,NW,SE,SW states (SW is rw, result is written there):
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SW = perBGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SE = perBGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NE = perBGrid.get(i-1,j-1,k  );
-   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NW = perBGrid.get(i  ,j-1,k  );
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SW = BgBGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SE = BgBGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NE = BgBGrid.get(i-1,j-1,k  );
-   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NW = BgBGrid.get(i  ,j-1,k  );
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SW = momentsGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SE = momentsGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NE = momentsGrid.get(i-1,j-1,k  );
-   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NW = momentsGrid.get(i  ,j-1,k  );
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SW = dMomentsGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SE = dMomentsGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NE = dMomentsGrid.get(i-1,j-1,k  );
-   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NW = dMomentsGrid.get(i  ,j-1,k  );
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SW = dPerBGrid.get(i  ,j  ,k  );
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SE = dPerBGrid.get(i-1,j  ,k  );
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NE = dPerBGrid.get(i-1,j-1,k  );
-   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NW = dPerBGrid.get(i  ,j-1,k  );
-   
-   std::array<Real, fsgrids::efield::N_EFIELD> * efield_SW = EGrid.get(i,j,k);
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SW = cell.perb;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_SE = cell.perb - stencil.x;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NE = cell.perb - stencil.x - stencil.y;
+   std::array<Real, fsgrids::bfield::N_BFIELD> * perb_NW = cell.perb - stencil.y;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SW = cell.bgb;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_SE = cell.bgb - stencil.x;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NE = cell.bgb - stencil.x - stencil.y;
+   std::array<Real, fsgrids::bgbfield::N_BGB> * bgb_NW = cell.bgb - stencil.y;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SW = cell.moments;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_SE = cell.moments - stencil.x;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NE = cell.moments - stencil.x - stencil.y;
+   std::array<Real, fsgrids::moments::N_MOMENTS> * moments_NW = cell.moments - stencil.y;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SW = cell.dmoments;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_SE = cell.dmoments - stencil.x;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NE = cell.dmoments - stencil.x - stencil.y;
+   std::array<Real, fsgrids::dmoments::N_DMOMENTS> * dmoments_NW = cell.dmoments - stencil.y;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SW = cell.dperb;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_SE = cell.dperb - stencil.x;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NE = cell.dperb - stencil.x - stencil.y;
+   std::array<Real, fsgrids::dperb::N_DPERB> * dperb_NW = cell.dperb - stencil.y;
+   
+   std::array<Real, fsgrids::efield::N_EFIELD> * efield_SW = cell.efield;
    
    // Fetch needed plasma parameters/derivatives from the four cells:
    Real Bx_S, By_W, By_E, Bx_N, perBx_S, perBy_W, perBy_E, perBx_N;
@@ -1260,17 +1198,17 @@ void calculateEdgeElectricFieldZ(
            ) /
        moments_SW->at(fsgrids::moments::RHOQ) /
        physicalconstants::MU_0 *
-       (dperb_SW->at(fsgrids::dperb::dPERBydx)/technicalGrid.DX - dperb_SW->at(fsgrids::dperb::dPERBxdy)/technicalGrid.DY);
+       (dperb_SW->at(fsgrids::dperb::dPERBydx)/stencil.DX - dperb_SW->at(fsgrids::dperb::dPERBxdy)/stencil.DY);
    }
    
    // Hall term
    if (Parameters::ohmHallTerm > 0) {
-      Ez_SW += EHallGrid.get(i,j,k)->at(fsgrids::ehall::EZHALL_000_001);
+      Ez_SW += cell.ehall->at(fsgrids::ehall::EZHALL_000_001);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ez_SW += EGradPeGrid.get(i,j,k)->at(fsgrids::egradpe::EZGRADPE);
+      Ez_SW += cell.egradpe->at(fsgrids::egradpe::EZGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -1282,13 +1220,9 @@ void calculateEdgeElectricFieldZ(
    // Calculate maximum wave speed (fast magnetosonic speed) on SW cell. In order 
    // to get Alfven speed we need to calculate some reconstruction coeff. for Bz:
    calculateWaveSpeedXY(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i, j, k,
-      i, j, k+1,
+      cell,
+      stencil.z,
+      stencil,
       Bx_S, By_W, dBxdy_S, dBxdz_S, dBydx_W, dBydz_W, MINUS, MINUS, minRhom, maxRhom, vA, vS, vW
    );
    c_x = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -1318,17 +1252,17 @@ void calculateEdgeElectricFieldZ(
             ) /
         moments_SE->at(fsgrids::moments::RHOQ) /
         physicalconstants::MU_0 *
-        (dperb_SE->at(fsgrids::dperb::dPERBydx)/technicalGrid.DX - dperb_SE->at(fsgrids::dperb::dPERBxdy)/technicalGrid.DY);
+        (dperb_SE->at(fsgrids::dperb::dPERBydx)/stencil.DX - dperb_SE->at(fsgrids::dperb::dPERBxdy)/stencil.DY);
    }
    
    // Hall term
    if (Parameters::ohmHallTerm > 0) {
-      Ez_SE += EHallGrid.get(i-1,j,k)->at(fsgrids::ehall::EZHALL_100_101);
+      Ez_SE += (cell.ehall - stencil.x)->at(fsgrids::ehall::EZHALL_100_101);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ez_SE += EGradPeGrid.get(i-1,j,k)->at(fsgrids::egradpe::EZGRADPE);
+      Ez_SE += (cell.egradpe - stencil.x)->at(fsgrids::egradpe::EZGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -1338,13 +1272,9 @@ void calculateEdgeElectricFieldZ(
    #endif
    
    calculateWaveSpeedXY(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i-1,j  ,k,
-      i-1,j  ,k+1,
+      shiftCell(cell, -stencil.x),
+      stencil.z,
+      stencil,
       Bx_S, By_E, dBxdy_S, dBxdz_S, dBydx_E, dBydz_E, PLUS, MINUS, minRhom, maxRhom, vA, vS, vW
    );
    c_x = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -1374,17 +1304,17 @@ void calculateEdgeElectricFieldZ(
             ) /
         moments_NW->at(fsgrids::moments::RHOQ) /
         physicalconstants::MU_0 *
-        (dperb_NW->at(fsgrids::dperb::dPERBydx)/technicalGrid.DX - dperb_NW->at(fsgrids::dperb::dPERBxdy)/technicalGrid.DY);
+        (dperb_NW->at(fsgrids::dperb::dPERBydx)/stencil.DX - dperb_NW->at(fsgrids::dperb::dPERBxdy)/stencil.DY);
    }
    
    // Hall term
    if(Parameters::ohmHallTerm > 0) {
-      Ez_NW += EHallGrid.get(i,j-1,k)->at(fsgrids::ehall::EZHALL_010_011);
+      Ez_NW += (cell.ehall - stencil.y)->at(fsgrids::ehall::EZHALL_010_011);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ez_NW += EGradPeGrid.get(i,j-1,k)->at(fsgrids::egradpe::EZGRADPE);
+      Ez_NW += (cell.egradpe - stencil.y)->at(fsgrids::egradpe::EZGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -1394,13 +1324,9 @@ void calculateEdgeElectricFieldZ(
    #endif
    
    calculateWaveSpeedXY(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i, j-1, k,
-      i, j-1, k+1,
+      shiftCell(cell, -stencil.y),
+      stencil.z,
+      stencil,
       Bx_N, By_W, dBxdy_N, dBxdz_N, dBydx_W, dBydz_W, MINUS, PLUS, minRhom, maxRhom, vA, vS, vW
    );
    c_x = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -1430,17 +1356,17 @@ void calculateEdgeElectricFieldZ(
             ) /
         moments_NE->at(fsgrids::moments::RHOQ) /
         physicalconstants::MU_0 *
-        (dperb_NE->at(fsgrids::dperb::dPERBydx)/technicalGrid.DX - dperb_NE->at(fsgrids::dperb::dPERBxdy)/technicalGrid.DY);
+        (dperb_NE->at(fsgrids::dperb::dPERBydx)/stencil.DX - dperb_NE->at(fsgrids::dperb::dPERBxdy)/stencil.DY);
    }
    
    // Hall term
    if(Parameters::ohmHallTerm > 0) {
-      Ez_NE += EHallGrid.get(i-1,j-1,k)->at(fsgrids::ehall::EZHALL_110_111);
+      Ez_NE += (cell.ehall - stencil.x - stencil.y)->at(fsgrids::ehall::EZHALL_110_111);
    }
    
    // Electron pressure gradient term
    if(Parameters::ohmGradPeTerm > 0) {
-      Ez_NE += EGradPeGrid.get(i-1,j-1,k)->at(fsgrids::egradpe::EZGRADPE);
+      Ez_NE += (cell.egradpe - stencil.x - stencil.y)->at(fsgrids::egradpe::EZGRADPE);
    }
    
    #ifndef FS_1ST_ORDER_SPACE
@@ -1450,13 +1376,9 @@ void calculateEdgeElectricFieldZ(
    #endif
    
    calculateWaveSpeedXY(
-      perBGrid,
-      momentsGrid,
-      dPerBGrid,
-      dMomentsGrid,
-      BgBGrid,
-      i-1,j-1,k,
-      i-1,j-1,k+1,
+      shiftCell(cell, -stencil.x - stencil.y),
+      stencil.z,
+      stencil,
       Bx_N, By_E, dBxdy_N, dBxdz_N, dBydx_E, dBydz_E, PLUS, PLUS, minRhom, maxRhom, vA, vS, vW
    );
    c_x = min(Parameters::maxWaveVelocity,sqrt(vA*vA + vS*vS) + vW);
@@ -1484,10 +1406,10 @@ void calculateEdgeElectricFieldZ(
    if ((RKCase == RK_ORDER1) || (RKCase == RK_ORDER2_STEP2)) {
       //compute maximum timestep for fieldsolver in this cell (CFL=1)
       Real min_dx=std::numeric_limits<Real>::max();;
-      min_dx=min(min_dx,technicalGrid.DX);
-      min_dx=min(min_dx,technicalGrid.DY);
+      min_dx=min(min_dx,stencil.DX);
+      min_dx=min(min_dx,stencil.DY);
       //update max allowed timestep for field propagation in this cell, which is the minimum of CFL=1 timesteps
-      if(maxV!=ZERO) technicalGrid.get(i,j,k)->maxFsDt=min(technicalGrid.get(i,j,k)->maxFsDt,min_dx/maxV);
+      if(maxV!=ZERO) cell.technical->maxFsDt=min(cell.technical->maxFsDt,min_dx/maxV);
    }
 }
 
@@ -1504,6 +1426,7 @@ void calculateEdgeElectricFieldZ(
  * \param dMomentsGrid fsGrid holding the derviatives of moments
  * \param BgBGrid fsGrid holding the background B quantities
  * \param technicalGrid fsGrid holding technical information (such as boundary types)
+ * \param stencil Neighbour offsets and cell size of the fsGrids
  * \param i,j,k fsGrid cell coordinates for the current cell
  * \param sysBoundaries System boundary conditions existing
  * \param RKCase Element in the enum defining the Runge-Kutta method steps
@@ -1521,6 +1444,7 @@ void calculateElectricField(
    FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
    FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
    FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
+   const EFieldStencil& stencil,
    cint i,
    cint j,
    cint k,
@@ -1533,67 +1457,139 @@ void calculateElectricField(
    
    cuint bitfield = technicalGrid.get(i,j,k)->SOLVE;
    
+   #ifdef DEBUG_FSOLVER
+   if ((bitfield & (compute::EX | compute::EY | compute::EZ)) != 0) {
+      bool ok = true;
+      for (int dk=-1; dk<=1; dk++) for (int dj=-1; dj<=1; dj++) for (int di=-1; di<=1; di++) {
+         if (technicalGrid.get(i+di,j+dj,k+dk) == NULL) ok = false;
+      }
+      if (ok == false) {
+         cerr << "NULL pointer in " << __FILE__ << ":" << __LINE__ << std::endl;
+         exit(1);
+      }
+   }
+   #endif
+   
+   const EFieldCell cell = getEFieldCell(
+      perBGrid,
+      EGrid,
+      EHallGrid,
+      EGradPeGrid,
+      momentsGrid,
+      dPerBGrid,
+      dMomentsGrid,
+      BgBGrid,
+      technicalGrid,
+      i,
+      j,
+      k
+   );
+   
    if ((bitfield & compute::EX) == compute::EX) {
-      calculateEdgeElectricFieldX(
-         perBGrid,
-         EGrid,
-         EHallGrid,
-         EGradPeGrid,
-         momentsGrid,
-         dPerBGrid,
-         dMomentsGrid,
-         BgBGrid,
-         technicalGrid,
-         i,
-         j,
-         k,
-         RKCase
-      );
+      calculateEdgeElectricFieldX(cell, stencil, RKCase);
    } else {
       sysBoundaries.getSysBoundary(cellSysBoundaryFlag)->fieldSolverBoundaryCondElectricField(EGrid, i, j, k, 0);
    }
    
    if ((bitfield & compute::EY) == compute::EY) {
-      calculateEdgeElectricFieldY(
-         perBGrid,
-         EGrid,
-         EHallGrid,
-         EGradPeGrid,
-         momentsGrid,
-         dPerBGrid,
-         dMomentsGrid,
-         BgBGrid,
-         technicalGrid,
-         i,
-         j,
-         k,
-         RKCase
-      );
+      calculateEdgeElectricFieldY(cell, stencil, RKCase);
    } else {
       sysBoundaries.getSysBoundary(cellSysBoundaryFlag)->fieldSolverBoundaryCondElectricField(EGrid, i, j, k, 1);
    }
    
    if ((bitfield & compute::EZ) == compute::EZ) {
-      calculateEdgeElectricFieldZ(
-         perBGrid,
-         EGrid,
-         EHallGrid,
-         EGradPeGrid,
-         momentsGrid,
-         dPerBGrid,
-         dMomentsGrid,
-         BgBGrid,
-         technicalGrid,
-         i,
-         j,
-         k,
-         RKCase
-      );
+      calculateEdgeElectricFieldZ(cell, stencil, RKCase);
    } else {
       sysBoundaries.getSysBoundary(cellSysBoundaryFlag)->fieldSolverBoundaryCondElectricField(EGrid, i, j, k, 2);
    }
 }
 
+/*! \brief Electric field propagation function for a run of cells along x of the local fsGrid domain.
+ * 
+ * Cells in which all three edge electric field components are solved are processed in runs of
+ * consecutive cells along x: the cell pointers are looked up once per row and advanced by the x
+ * offset. All other cells, i.e. those where at least one
+ * component comes from a system boundary condition, go through calculateElectricField.
+ * 
+ * \param run Cells of the row to compute
+ * 
+ * \sa calculateElectricField
+ */
+void calculateElectricFieldRow(
+   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
+   FsGrid< std::array<Real, fsgrids::efield::N_EFIELD>, FS_STENCIL_WIDTH> & EGrid,
+   FsGrid< std::array<Real, fsgrids::ehall::N_EHALL>, FS_STENCIL_WIDTH> & EHallGrid,
+   FsGrid< std::array<Real, fsgrids::egradpe::N_EGRADPE>, FS_STENCIL_WIDTH> & EGradPeGrid,
+   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
+   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
+   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
+   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
+   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
+   const EFieldStencil& stencil,
+   const FsCellRun& run,
+   SysBoundary& sysBoundaries,
+   cint& RKCase
+) {
+   cint j = run.j;
+   cint k = run.k;
+   cuint allComponents = compute::EX | compute::EY | compute::EZ;
+   const EFieldCell rowStart = getEFieldCell(
+      perBGrid,
+      EGrid,
+      EHallGrid,
+      EGradPeGrid,
+      momentsGrid,
+      dPerBGrid,
+      dMomentsGrid,
+      BgBGrid,
+      technicalGrid,
+      0,
+      j,
+      k
+   );
+   
+   int i = run.i0;
+   while (i < run.i1) {
+      int runEnd = i;
+      while (runEnd < run.i1) {
+         const fsgrids::technical* technical = rowStart.technical + runEnd*stencil.x;
+         if (technical->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) break;
+         if ((technical->SOLVE & allComponents) != allComponents) break;
+         ++runEnd;
+      }
+      
+      if (runEnd == i) {
+         calculateElectricField(
+            perBGrid,
+            EGrid,
+            EHallGrid,
+            EGradPeGrid,
+            momentsGrid,
+            dPerBGrid,
+            dMomentsGrid,
+            BgBGrid,
+            technicalGrid,
+            stencil,
+            i,
+            j,
+            k,
+            sysBoundaries,
+            RKCase
+         );
+         ++i;
+         continue;
+      }
+      
+      for (int ii=i; ii<runEnd; ii++) {
+         const EFieldCell cell = shiftCell(rowStart, ii*stencil.x);
+         calculateEdgeElectricFieldX(cell, stencil, RKCase);
+         calculateEdgeElectricFieldY(cell, stencil, RKCase);
+         calculateEdgeElectricFieldZ(cell, stencil, RKCase);
+      }
+      i = runEnd;
+   }
+}
+
 /*! \brief High-level electric field computation function.
  * 
  * Transfers the derivatives, calculates the edge electric fields and transfers the new electric fields.
@@ -1651,49 +1647,45 @@ void calculateUpwindedElectricFieldSimple(
    }
    phiprof::stop(timer);
    
-   // Calculate upwinded electric field on inner cells
+   // Calculate upwinded electric field on inner cells, run by run along x
+   const EFieldStencil stencil = getEFieldStencil(technicalGrid);
    timer=phiprof::initializeTimer("Compute cells");
    phiprof::start(timer);
-   #pragma omp parallel for collapse(3)
-   for (int k=0; k<gridDims[2]; k++) {
-      for (int j=0; j<gridDims[1]; j++) {
-         for (int i=0; i<gridDims[0]; i++) {
-            if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
-               calculateElectricField(
-                  perBGrid,
-                  EGrid,
-                  EHallGrid,
-                  EGradPeGrid,
-                  momentsGrid,
-                  dPerBGrid,
-                  dMomentsGrid,
-                  BgBGrid,
-                  technicalGrid,
-                  i,
-                  j,
-                  k,
-                  sysBoundaries,
-                  RKCase
-               );
-            } else { // RKCase == RK_ORDER2_STEP1
-               calculateElectricField(
-                  perBDt2Grid,
-                  EDt2Grid,
-                  EHallGrid,
-                  EGradPeGrid,
-                  momentsDt2Grid,
-                  dPerBGrid,
-                  dMomentsGrid,
-                  BgBGrid,
-                  technicalGrid,
-                  i,
-                  j,
-                  k,
-                  sysBoundaries,
-                  RKCase
-               );
-            }
-         }
+   const std::vector<FsCellRun>& runs = getActiveCellRuns(technicalGrid);
+   #pragma omp parallel for schedule(dynamic,1)
+   for (uint r=0; r<runs.size(); r++) {
+      if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
+         calculateElectricFieldRow(
+            perBGrid,
+            EGrid,
+            EHallGrid,
+            EGradPeGrid,
+            momentsGrid,
+            dPerBGrid,
+            dMomentsGrid,
+            BgBGrid,
+            technicalGrid,
+            stencil,
+            runs[r],
+            sysBoundaries,
+            RKCase
+         );
+      } else { // RKCase == RK_ORDER2_STEP1
+         calculateElectricFieldRow(
+            perBDt2Grid,
+            EDt2Grid,
+            EHallGrid,
+            EGradPeGrid,
+            momentsDt2Grid,
+            dPerBGrid,
+            dMomentsGrid,
+            BgBGrid,
+            technicalGrid,
+            stencil,
+            runs[r],
+            sysBoundaries,
+            RKCase
+         );
       }
    }
    phiprof::stop(timer,N_cells,"Spatial Cells");
@@ -173,15 +173,16 @@ void calculateGradPeTermSimple(
    // Calculate GradPe term
    timer=phiprof::initializeTimer("Compute cells");
    phiprof::start(timer);
-   #pragma omp parallel for collapse(3)
-   for (int k=0; k<gridDims[2]; k++) {
-      for (int j=0; j<gridDims[1]; j++) {
-         for (int i=0; i<gridDims[0]; i++) {
-            if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
-               calculateGradPeTerm(EGradPeGrid, momentsGrid, dMomentsGrid, technicalGrid, i, j, k, sysBoundaries);
-            } else {
-               calculateGradPeTerm(EGradPeGrid, momentsDt2Grid, dMomentsGrid, technicalGrid, i, j, k, sysBoundaries);
-            }
+   const std::vector<FsCellRun>& runs = getActiveCellRuns(technicalGrid);
+   #pragma omp parallel for schedule(dynamic,1)
+   for (uint r=0; r<runs.size(); r++) {
+      const int j = runs[r].j;
+      const int k = runs[r].k;
+      for (int i=runs[r].i0; i<runs[r].i1; i++) {
+         if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
+            calculateGradPeTerm(EGradPeGrid, momentsGrid, dMomentsGrid, technicalGrid, i, j, k, sysBoundaries);
+         } else {
+            calculateGradPeTerm(EGradPeGrid, momentsDt2Grid, dMomentsGrid, technicalGrid, i, j, k, sysBoundaries);
          }
       }
    }
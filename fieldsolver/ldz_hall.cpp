@@ -23,12 +23,52 @@
 #include "fs_common.h"
 #include "ldz_hall.hpp"
 
+#include <limits>
+
 #ifndef NDEBUG
    #define DEBUG_FSOLVER
 #endif
+#ifdef DEBUG_FSOLVER
+   #define DEBUG_HALL_ROWS
+#endif
 
 using namespace std;
 
+/*! Element offsets between neighbouring cells of the fsGrids, zero in flat dimensions.*/
+struct HallStencil {
+   int64_t x;
+   int64_t y;
+   int64_t z;
+};
+
+static HallStencil getHallStencil(FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid) {
+   HallStencil stencil;
+   const int64_t origin = technicalGrid.LocalIDForCoords(0,0,0);
+   stencil.x = technicalGrid.LocalIDForCoords(1,0,0) - origin;
+   stencil.y = technicalGrid.LocalIDForCoords(0,1,0) - origin;
+   stencil.z = technicalGrid.LocalIDForCoords(0,0,1) - origin;
+   return stencil;
+}
+
+/*! \brief Average charge density of the four cells sharing an edge, bounded below by Parameters::hallMinimumRhoq.
+ * 
+ * \param moments Moments of the current cell
+ * \param offsetA,offsetB Element offsets to the two other cells touching the edge
+ */
+static inline Real edgeHallRhoq(
+   const std::array<Real, fsgrids::moments::N_MOMENTS>* const moments,
+   const int64_t offsetA,
+   const int64_t offsetB
+) {
+   const Real hallRhoq = FOURTH * (
+      moments[0][fsgrids::moments::RHOQ] +
+      moments[offsetA][fsgrids::moments::RHOQ] +
+      moments[offsetB][fsgrids::moments::RHOQ] +
+      moments[offsetA+offsetB][fsgrids::moments::RHOQ]
+   );
+   return (hallRhoq <= Parameters::hallMinimumRhoq ) ? Parameters::hallMinimumRhoq : hallRhoq;
+}
+
 /*! \brief Low-level Hall component computation
  * 
  * Hall term computation following Balsara reconstruction, edge-averaged.
@@ -774,6 +814,142 @@ void calculateHallTerm(
 
 }
 
+/*! \brief Whether the Hall term of the cell is computed from the reconstruction, not set by a boundary condition.*/
+static inline bool isHallTermComputedCell(const fsgrids::technical* const technical) {
+   return technical->sysBoundaryFlag != sysboundarytype::DO_NOT_COMPUTE &&
+      (technical->sysBoundaryFlag == sysboundarytype::NOT_SYSBOUNDARY || technical->sysBoundaryLayer == 1);
+}
+
+#ifdef DEBUG_HALL_ROWS
+/*! \brief Checks the Hall term of a run of cells against the cell-by-cell implementation.
+ * 
+ * Recomputes the edges of cells i0..i1-1 with calculateEdgeHallTerm{X,Y,Z}Components, which read
+ * the grids through FsGrid::get, and exits if they differ from the values written by
+ * calculateHallTermRow by more than rounding. Enabled in debug builds, or with -DDEBUG_HALL_ROWS
+ * in optimized builds.
+ * 
+ * \sa calculateHallTermRow
+ */
+static void checkHallTermRun(
+   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
+   FsGrid< std::array<Real, fsgrids::ehall::N_EHALL>, FS_STENCIL_WIDTH> & EHallGrid,
+   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
+   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
+   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
+   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
+   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
+   cint i0,
+   cint i1,
+   cint j,
+   cint k
+) {
+   const Real tolerance = 1000 * numeric_limits<Real>::epsilon();
+   Real perturbedCoefficients[Rec::N_REC_COEFFICIENTS];
+   for (int i=i0; i<i1; i++) {
+      const std::array<Real, fsgrids::ehall::N_EHALL> rowResult = *EHallGrid.get(i,j,k);
+      reconstructionCoefficients(perBGrid, dPerBGrid, perturbedCoefficients, i, j, k, 3);
+      calculateEdgeHallTermXComponents(perBGrid, EHallGrid, momentsGrid, dPerBGrid, dMomentsGrid, BgBGrid, technicalGrid, perturbedCoefficients, i, j, k);
+      calculateEdgeHallTermYComponents(perBGrid, EHallGrid, momentsGrid, dPerBGrid, dMomentsGrid, BgBGrid, technicalGrid, perturbedCoefficients, i, j, k);
+      calculateEdgeHallTermZComponents(perBGrid, EHallGrid, momentsGrid, dPerBGrid, dMomentsGrid, BgBGrid, technicalGrid, perturbedCoefficients, i, j, k);
+      for (uint c=0; c<fsgrids::ehall::N_EHALL; c++) {
+         creal reference = EHallGrid.get(i,j,k)->at(c);
+         if (fabs(rowResult[c] - reference) > tolerance * max(fabs(reference), fabs(rowResult[c]))) {
+            cerr << "Hall term mismatch in " << __FILE__ << ":" << __LINE__ << " cell " << i << " " << j << " " << k << " component " << c << ": " << rowResult[c] << " vs " << reference << endl;
+            exit(1);
+         }
+      }
+   }
+}
+#endif
+
+/*! \brief Computes the second-order Hall term numerators on a run of cells along x.
+ * 
+ * The twelve edges of each stretch of computed cells are evaluated cell by cell as in
+ * calculateHallTerm, but with the grid pointers looked up once per row and the neighbour
+ * densities read at fixed offsets. Boundary cells are handed to calculateHallTerm. Only
+ * valid for Parameters::ohmHallTerm == 2.
+ * 
+ * \param perBGrid fsGrid holding the perturbed B quantities 
+ * \param EHallGrid fsGrid holding the Hall contributions to the electric field
+ * \param momentsGrid fsGrid holding the moment quantities
+ * \param dPerBGrid fsGrid holding the derivatives of perturbed B
+ * \param dMomentsGrid fsGrid holding the derviatives of moments
+ * \param BgBGrid fsGrid holding the background B quantities
+ * \param technicalGrid fsGrid holding technical information (such as boundary types)
+ * \param sysBoundaries System boundary condition functions.
+ * \param stencil Element offsets between neighbouring cells
+ * \param run Cells of the row to compute
+ * 
+ * \sa calculateHallTermSimple calculateHallTerm
+ */
+static void calculateHallTermRow(
+   FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
+   FsGrid< std::array<Real, fsgrids::ehall::N_EHALL>, FS_STENCIL_WIDTH> & EHallGrid,
+   FsGrid< std::array<Real, fsgrids::moments::N_MOMENTS>, FS_STENCIL_WIDTH> & momentsGrid,
+   FsGrid< std::array<Real, fsgrids::dperb::N_DPERB>, FS_STENCIL_WIDTH> & dPerBGrid,
+   FsGrid< std::array<Real, fsgrids::dmoments::N_DMOMENTS>, FS_STENCIL_WIDTH> & dMomentsGrid,
+   FsGrid< std::array<Real, fsgrids::bgbfield::N_BGB>, FS_STENCIL_WIDTH> & BgBGrid,
+   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
+   SysBoundary& sysBoundaries,
+   const HallStencil& stencil,
+   const FsCellRun& run
+) {
+   cint j = run.j;
+   cint k = run.k;
+   const fsgrids::technical* const technical = technicalGrid.get(0,j,k);
+   const std::array<Real, fsgrids::moments::N_MOMENTS>* const moments = momentsGrid.get(0,j,k);
+   const std::array<Real, fsgrids::bgbfield::N_BGB>* const bgb = BgBGrid.get(0,j,k);
+   std::array<Real, fsgrids::ehall::N_EHALL>* const ehall = EHallGrid.get(0,j,k);
+   creal dx = technicalGrid.DX;
+   creal dy = technicalGrid.DY;
+   creal dz = technicalGrid.DZ;
+   creal mu0 = physicalconstants::MU_0;
+   Real pC[Rec::N_REC_COEFFICIENTS];
+   
+   int i = run.i0;
+   while (i < run.i1) {
+      int runEnd = i;
+      while (runEnd < run.i1 && isHallTermComputedCell(technical + runEnd*stencil.x)) {
+         ++runEnd;
+      }
+      
+      if (runEnd == i) {
+         calculateHallTerm(perBGrid, EHallGrid, momentsGrid, dPerBGrid, dMomentsGrid, BgBGrid, technicalGrid, sysBoundaries, i, j, k);
+         ++i;
+         continue;
+      }
+      
+      for (int ii=i; ii<runEnd; ii++) {
+         reconstructionCoefficients(perBGrid, dPerBGrid, pC, ii, j, k, 3);
+         const std::array<Real, fsgrids::moments::N_MOMENTS>* const m = moments + ii*stencil.x;
+         creal bgbx = bgb[ii*stencil.x][fsgrids::bgbfield::BGBX];
+         creal bgby = bgb[ii*stencil.x][fsgrids::bgbfield::BGBY];
+         creal bgbz = bgb[ii*stencil.x][fsgrids::bgbfield::BGBZ];
+         std::array<Real, fsgrids::ehall::N_EHALL>& e = ehall[ii*stencil.x];
+         
+         e[fsgrids::ehall::EXHALL_000_100] = JXBX_000_100(pC, bgby, bgbz, dx, dy, dz) / (mu0 * edgeHallRhoq(m, -stencil.y, -stencil.z));
+         e[fsgrids::ehall::EXHALL_010_110] = JXBX_010_110(pC, bgby, bgbz, dx, dy, dz) / (mu0 * edgeHallRhoq(m,  stencil.y, -stencil.z));
+         e[fsgrids::ehall::EXHALL_001_101] = JXBX_001_101(pC, bgby, bgbz, dx, dy, dz) / (mu0 * edgeHallRhoq(m, -stencil.y,  stencil.z));
+         e[fsgrids::ehall::EXHALL_011_111] = JXBX_011_111(pC, bgby, bgbz, dx, dy, dz) / (mu0 * edgeHallRhoq(m,  stencil.y,  stencil.z));
+         
+         e[fsgrids::ehall::EYHALL_000_010] = JXBY_000_010(pC, bgbx, bgbz, dx, dy, dz) / (mu0 * edgeHallRhoq(m, -stencil.x, -stencil.z));
+         e[fsgrids::ehall::EYHALL_100_110] = JXBY_100_110(pC, bgbx, bgbz, dx, dy, dz) / (mu0 * edgeHallRhoq(m,  stencil.x, -stencil.z));
+         e[fsgrids::ehall::EYHALL_001_011] = JXBY_001_011(pC, bgbx, bgbz, dx, dy, dz) / (mu0 * edgeHallRhoq(m, -stencil.x,  stencil.z));
+         e[fsgrids::ehall::EYHALL_101_111] = JXBY_101_111(pC, bgbx, bgbz, dx, dy, dz) / (mu0 * edgeHallRhoq(m,  stencil.x,  stencil.z));
+         
+         e[fsgrids::ehall::EZHALL_000_001] = JXBZ_000_001(pC, bgbx, bgby, dx, dy, dz) / (mu0 * edgeHallRhoq(m, -stencil.x, -stencil.y));
+         e[fsgrids::ehall::EZHALL_100_101] = JXBZ_100_101(pC, bgbx, bgby, dx, dy, dz) / (mu0 * edgeHallRhoq(m,  stencil.x, -stencil.y));
+         e[fsgrids::ehall::EZHALL_010_011] = JXBZ_010_011(pC, bgbx, bgby, dx, dy, dz) / (mu0 * edgeHallRhoq(m, -stencil.x,  stencil.y));
+         e[fsgrids::ehall::EZHALL_110_111] = JXBZ_110_111(pC, bgbx, bgby, dx, dy, dz) / (mu0 * edgeHallRhoq(m,  stencil.x,  stencil.y));
+      }
+      
+      #ifdef DEBUG_HALL_ROWS
+      checkHallTermRun(perBGrid, EHallGrid, momentsGrid, dPerBGrid, dMomentsGrid, BgBGrid, technicalGrid, i, runEnd, j, k);
+      #endif
+      i = runEnd;
+   }
+}
+
 /*! \brief High-level function computing the Hall term.
  * 
  * Performs the communication before and after the computation as well as the computation of all Hall term numerator components.
@@ -791,7 +967,7 @@ void calculateHallTerm(
  * \param RKCase Element in the enum defining the Runge-Kutta method steps
  * \param communicateMomentsDerivatives whether to communicate derivatves with the neighbour CPUs
  * 
- * \sa calculateHallTerm
+ * \sa calculateHallTerm calculateHallTermRow
  */
 void calculateHallTermSimple(
    FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
@@ -822,10 +998,23 @@ void calculateHallTermSimple(
    phiprof::stop(timer);
    
    phiprof::start("Compute cells");
-   #pragma omp parallel for collapse(3)
-   for (int k=0; k<gridDims[2]; k++) {
-      for (int j=0; j<gridDims[1]; j++) {
-         for (int i=0; i<gridDims[0]; i++) {
+   const std::vector<FsCellRun>& runs = getActiveCellRuns(technicalGrid);
+   if (Parameters::ohmHallTerm == 2) {
+      const HallStencil stencil = getHallStencil(technicalGrid);
+      #pragma omp parallel for schedule(dynamic,1)
+      for (uint r=0; r<runs.size(); r++) {
+         if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
+            calculateHallTermRow(perBGrid, EHallGrid, momentsGrid, dPerBGrid, dMomentsGrid, BgBGrid, technicalGrid, sysBoundaries, stencil, runs[r]);
+         } else {
+            calculateHallTermRow(perBDt2Grid, EHallGrid, momentsDt2Grid, dPerBGrid, dMomentsGrid, BgBGrid, technicalGrid, sysBoundaries, stencil, runs[r]);
+         }
+      }
+   } else {
+      #pragma omp parallel for schedule(dynamic,1)
+      for (uint r=0; r<runs.size(); r++) {
+         const int j = runs[r].j;
+         const int k = runs[r].k;
+         for (int i=runs[r].i0; i<runs[r].i1; i++) {
             if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
                calculateHallTerm(perBGrid, EHallGrid, momentsGrid, dPerBGrid, dMomentsGrid, BgBGrid, technicalGrid,sysBoundaries, i, j, k);
             } else {
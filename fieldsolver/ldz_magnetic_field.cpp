@@ -192,6 +192,103 @@ void propagateSysBoundaryMagneticField(
    }
 }
 
+/*! Number of propagateMagneticFieldSimple calls over which the exchange and compute times are
+ * measured before the ghost compute depth is chosen automatically.
+ */
+static const uint GHOST_DEPTH_MEASUREMENT_CALLS = 10;
+
+static int ghostComputeDepth = -1;             /*!< Ghost compute depth in use, -1 while it is being measured.*/
+static uint ghostDepthMeasuredCalls = 0;
+static double ghostDepthBulkTime = 0.0;
+static double ghostDepthL1Time = 0.0;
+static double ghostDepthExchangeTime[2] = {0.0, 0.0};
+
+/*! \brief Discards the ghost compute depth so that it is chosen again on the next call.
+ * 
+ * Load balancing changes the vlasov load and the communication pattern of each process, so the
+ * automatically chosen depth is measured again.
+ * 
+ * \sa getGhostComputeDepth
+ */
+void resetGhostComputeDepth() {
+   ghostComputeDepth = -1;
+   ghostDepthMeasuredCalls = 0;
+   ghostDepthBulkTime = 0.0;
+   ghostDepthL1Time = 0.0;
+   ghostDepthExchangeTime[0] = 0.0;
+   ghostDepthExchangeTime[1] = 0.0;
+}
+
+/*! \brief Counts the active cells within margin ghost layers.*/
+static double countComputeCells(
+   FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid,
+   cint margin
+) {
+   const std::vector<FsCellRun>& runs = getActiveCellRuns(technicalGrid, margin);
+   double count = 0;
+   for (uint r=0; r<runs.size(); r++) {
+      count += runs[r].i1 - runs[r].i0;
+   }
+   return count;
+}
+
+/*! \brief Returns the number of ghost layers on which the magnetic field is propagated redundantly.
+ * 
+ * Depth 1 computes the bulk magnetic field on one ghost layer, which is all the L1 boundary
+ * conditions read, so the exchange before the L1 pass is skipped. Depth 2 computes the bulk field on
+ * two and the L1 boundary cells on one ghost layer, so the exchange before the L2 pass is skipped
+ * as well. The bulk field on layer n needs E on layer n+1, so the depth is limited to
+ * FS_STENCIL_WIDTH-1. Ghost values are computed from the same inputs and by the same run loops as
+ * on the owning process, so results are expected to match depth 0 bitwise; compare against a
+ * fieldsolver.ghostComputeDepth = 0 run when changing the kernels.
+ * 
+ * With fieldsolver.ghostComputeDepth = -1 the first calls are run with depth 0 while the exchange
+ * and compute times are measured. The depth giving the largest saving on the slowest process is
+ * then chosen; all processes take the same decision, as the exchanges are collective. The
+ * measurement is repeated after each load balance, see resetGhostComputeDepth.
+ * 
+ * \param technicalGrid fsGrid holding technical information (such as boundary types)
+ */
+static int getGhostComputeDepth(FsGrid< fsgrids::technical, FS_STENCIL_WIDTH> & technicalGrid) {
+   if (ghostComputeDepth >= 0) return ghostComputeDepth;
+   
+   const int maxDepth = min(2, FS_STENCIL_WIDTH-1);
+   if (P::fieldSolverGhostComputeDepth >= 0) {
+      ghostComputeDepth = min(P::fieldSolverGhostComputeDepth, maxDepth);
+      if (ghostComputeDepth != P::fieldSolverGhostComputeDepth && technicalGrid.getRank() == MASTER_RANK) {
+         logFile << "(FSOLVER) fieldsolver.ghostComputeDepth " << P::fieldSolverGhostComputeDepth << " needs a wider FS_STENCIL_WIDTH, using " << ghostComputeDepth << endl;
+      }
+      return ghostComputeDepth;
+   }
+   
+   if (ghostDepthMeasuredCalls < GHOST_DEPTH_MEASUREMENT_CALLS) return 0;
+   
+   // Estimated redundant compute and saved exchange time per call for depths 1 and 2
+   const double localCells = countComputeCells(technicalGrid, 0);
+   const double calls = ghostDepthMeasuredCalls;
+   double local[4], global[4];
+   local[0] = ghostDepthBulkTime/calls * (countComputeCells(technicalGrid, 1) - localCells)/localCells;
+   local[1] = ghostDepthBulkTime/calls * (countComputeCells(technicalGrid, maxDepth) - localCells)/localCells
+      + ghostDepthL1Time/calls * (countComputeCells(technicalGrid, maxDepth-1) - localCells)/localCells;
+   local[2] = ghostDepthExchangeTime[0]/calls;
+   local[3] = (ghostDepthExchangeTime[0] + ghostDepthExchangeTime[1])/calls;
+   technicalGrid.Allreduce(local, global, 4, MPI_DOUBLE, MPI_MAX);
+   
+   ghostComputeDepth = 0;
+   double bestGain = 0.0;
+   for (int depth=1; depth<=maxDepth; depth++) {
+      const double gain = global[depth+1] - global[depth-1];
+      if (gain > bestGain) {
+         bestGain = gain;
+         ghostComputeDepth = depth;
+      }
+   }
+   if (technicalGrid.getRank() == MASTER_RANK) {
+      logFile << "(FSOLVER) Magnetic field ghost compute depth " << ghostComputeDepth << ", measured exchange time per call " << global[2] << " + " << global[3]-global[2] << " s" << endl;
+   }
+   return ghostComputeDepth;
+}
+
 /*! \brief High-level magnetic field propagation function.
  * 
  * Propagates the magnetic field and applies the field boundary conditions defined in project.h where needed.
@@ -205,7 +302,7 @@ void propagateSysBoundaryMagneticField(
  * \param dt Length of the time step
  * \param RKCase Element in the enum defining the Runge-Kutta method steps
  * 
- * \sa propagateMagneticField propagateSysBoundaryMagneticField
+ * \sa propagateMagneticField propagateSysBoundaryMagneticField getGhostComputeDepth
  */
 void propagateMagneticFieldSimple(
    FsGrid< std::array<Real, fsgrids::bfield::N_BFIELD>, FS_STENCIL_WIDTH> & perBGrid,
@@ -224,87 +321,116 @@ void propagateMagneticFieldSimple(
    
    phiprof::start("Propagate magnetic field");
    
+   const int depth = getGhostComputeDepth(technicalGrid);
+   const bool measure = (ghostComputeDepth < 0);
+   double t0 = MPI_Wtime();
+   
    timer=phiprof::initializeTimer("Compute cells");
    phiprof::start(timer);
    
-   #pragma omp parallel for collapse(3) schedule(dynamic,1)
-   for (int k=0; k<gridDims[2]; k++) {
-      for (int j=0; j<gridDims[1]; j++) {
-         for (int i=0; i<gridDims[0]; i++) {
-            cuint bitfield = technicalGrid.get(i,j,k)->SOLVE;
-            propagateMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, i, j, k, dt, RKCase, ((bitfield & compute::BX) == compute::BX), ((bitfield & compute::BY) == compute::BY), ((bitfield & compute::BZ) == compute::BZ));
-         }
+   // Bulk pass, on depth ghost layers as well
+   const std::vector<FsCellRun>& bulkRuns = getActiveCellRuns(technicalGrid, depth);
+   #pragma omp parallel for schedule(dynamic,1)
+   for (uint r=0; r<bulkRuns.size(); r++) {
+      const int j = bulkRuns[r].j;
+      const int k = bulkRuns[r].k;
+      for (int i=bulkRuns[r].i0; i<bulkRuns[r].i1; i++) {
+         cuint bitfield = technicalGrid.get(i,j,k)->SOLVE;
+         propagateMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, i, j, k, dt, RKCase, ((bitfield & compute::BX) == compute::BX), ((bitfield & compute::BY) == compute::BY), ((bitfield & compute::BZ) == compute::BZ));
       }
    }
    
    //phiprof::stop("propagate not sysbound",localCells.size(),"Spatial Cells");
    phiprof::stop(timer,N_cells,"Spatial Cells");
+   if (measure) {
+      ghostDepthBulkTime += MPI_Wtime() - t0;
+   }
    
    //This communication is needed for boundary conditions, in practice almost all
    //of the communication is going to be redone in calculateDerivativesSimple
    //TODO: do not transfer if there are no field boundaryconditions
-   timer=phiprof::initializeTimer("MPI","MPI");
-   phiprof::start(timer);
-   if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
-      // Exchange PERBX,PERBY,PERBZ with neighbours
-      perBGrid.updateGhostCells();
-   } else { // RKCase == RK_ORDER2_STEP1
-      // Exchange PERBX_DT2,PERBY_DT2,PERBZ_DT2 with neighbours
-      perBDt2Grid.updateGhostCells();
+   if (depth < 1) {
+      t0 = MPI_Wtime();
+      timer=phiprof::initializeTimer("MPI","MPI");
+      phiprof::start(timer);
+      if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
+         // Exchange PERBX,PERBY,PERBZ with neighbours
+         perBGrid.updateGhostCells();
+      } else { // RKCase == RK_ORDER2_STEP1
+         // Exchange PERBX_DT2,PERBY_DT2,PERBZ_DT2 with neighbours
+         perBDt2Grid.updateGhostCells();
+      }
+      phiprof::stop(timer);
+      if (measure) {
+         ghostDepthExchangeTime[0] += MPI_Wtime() - t0;
+      }
    }
    
-   phiprof::stop(timer);
-   
    // Propagate B on system boundary/process inner cells
+   t0 = MPI_Wtime();
    timer=phiprof::initializeTimer("Compute system boundary cells");
    phiprof::start(timer);
-   // L1 pass
-   #pragma omp parallel for collapse(3)
-   for (int k=0; k<gridDims[2]; k++) {
-      for (int j=0; j<gridDims[1]; j++) {
-         for (int i=0; i<gridDims[0]; i++) {
-            cuint bitfield = technicalGrid.get(i,j,k)->SOLVE;
-            // L1 pass
-            if (technicalGrid.get(i,j,k)->sysBoundaryLayer == 1) {
-               if ((bitfield & compute::BX) != compute::BX) {
-                  propagateSysBoundaryMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, technicalGrid, i, j, k, sysBoundaries, dt, RKCase, 0);
-               }
-               if ((bitfield & compute::BY) != compute::BY) {
-                  propagateSysBoundaryMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, technicalGrid, i, j, k, sysBoundaries, dt, RKCase, 1);
-               }
-               if ((bitfield & compute::BZ) != compute::BZ) {
-                  propagateSysBoundaryMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, technicalGrid, i, j, k, sysBoundaries, dt, RKCase, 2);
-               }
+   // L1 pass, on depth-1 ghost layers as well
+   const std::vector<FsCellRun>& L1Runs = getActiveCellRuns(technicalGrid, max(depth-1, 0));
+   #pragma omp parallel for schedule(dynamic,1)
+   for (uint r=0; r<L1Runs.size(); r++) {
+      const int j = L1Runs[r].j;
+      const int k = L1Runs[r].k;
+      for (int i=L1Runs[r].i0; i<L1Runs[r].i1; i++) {
+         const fsgrids::technical* technical = technicalGrid.get(i,j,k);
+         cuint bitfield = technical->SOLVE;
+         if (technical->sysBoundaryLayer == 1) {
+            if ((bitfield & compute::BX) != compute::BX) {
+               propagateSysBoundaryMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, technicalGrid, i, j, k, sysBoundaries, dt, RKCase, 0);
+            }
+            if ((bitfield & compute::BY) != compute::BY) {
+               propagateSysBoundaryMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, technicalGrid, i, j, k, sysBoundaries, dt, RKCase, 1);
+            }
+            if ((bitfield & compute::BZ) != compute::BZ) {
+               propagateSysBoundaryMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, technicalGrid, i, j, k, sysBoundaries, dt, RKCase, 2);
             }
          }
       }
    }
    phiprof::stop(timer);
+   if (measure) {
+      ghostDepthL1Time += MPI_Wtime() - t0;
+   }
    
-   timer=phiprof::initializeTimer("MPI","MPI");
-   phiprof::start(timer);
-   if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
-      // Exchange PERBX,PERBY,PERBZ with neighbours
-      perBGrid.updateGhostCells();
-   } else { // RKCase == RK_ORDER2_STEP1
-      // Exchange PERBX_DT2,PERBY_DT2,PERBZ_DT2 with neighbours
-      perBDt2Grid.updateGhostCells();
+   if (depth < 2) {
+      t0 = MPI_Wtime();
+      timer=phiprof::initializeTimer("MPI","MPI");
+      phiprof::start(timer);
+      if (RKCase == RK_ORDER1 || RKCase == RK_ORDER2_STEP2) {
+         // Exchange PERBX,PERBY,PERBZ with neighbours
+         perBGrid.updateGhostCells();
+      } else { // RKCase == RK_ORDER2_STEP1
+         // Exchange PERBX_DT2,PERBY_DT2,PERBZ_DT2 with neighbours
+         perBDt2Grid.updateGhostCells();
+      }
+      phiprof::stop(timer);
+      if (measure) {
+         ghostDepthExchangeTime[1] += MPI_Wtime() - t0;
+      }
+   }
+   if (measure) {
+      ghostDepthMeasuredCalls++;
    }
-   phiprof::stop(timer);
 
    timer=phiprof::initializeTimer("Compute system boundary cells");
    phiprof::start(timer);
    // L2 pass
-   #pragma omp parallel for collapse(3)
-   for (int k=0; k<gridDims[2]; k++) {
-      for (int j=0; j<gridDims[1]; j++) {
-         for (int i=0; i<gridDims[0]; i++) {
-            if(technicalGrid.get(i,j,k)->sysBoundaryFlag != sysboundarytype::NOT_SYSBOUNDARY &&
-               technicalGrid.get(i,j,k)->sysBoundaryLayer == 2
-            ) {
-               for (uint component = 0; component < 3; component++) {
-                  propagateSysBoundaryMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, technicalGrid, i, j, k, sysBoundaries, dt, RKCase, component);
-               }
+   const std::vector<FsCellRun>& L2Runs = getActiveCellRuns(technicalGrid);
+   #pragma omp parallel for schedule(dynamic,1)
+   for (uint r=0; r<L2Runs.size(); r++) {
+      const int j = L2Runs[r].j;
+      const int k = L2Runs[r].k;
+      for (int i=L2Runs[r].i0; i<L2Runs[r].i1; i++) {
+         if(technicalGrid.get(i,j,k)->sysBoundaryFlag != sysboundarytype::NOT_SYSBOUNDARY &&
+            technicalGrid.get(i,j,k)->sysBoundaryLayer == 2
+         ) {
+            for (uint component = 0; component < 3; component++) {
+               propagateSysBoundaryMagneticField(perBGrid, perBDt2Grid, EGrid, EDt2Grid, technicalGrid, i, j, k, sysBoundaries, dt, RKCase, component);
             }
          }
       }
@@ -54,4 +54,6 @@ void propagateMagneticFieldSimple(
    cint& RKCase
 );
 
+void resetGhostComputeDepth();
+
 #endif
@@ -62,6 +62,11 @@ bool initializeFieldPropagatorAfterRebalance() {
    // but are assumed to be ok after each load balance as that
    // communicates all spatial data
    
+   // Rebuild the active cell runs from the current technical grid on next use
+   invalidateActiveCellRuns();
+   // and choose the magnetic field ghost compute depth again
+   resetGhostComputeDepth();
+   
    return true;
 }
 
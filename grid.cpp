@@ -27,6 +27,7 @@
 #include <vector>
 #include <sstream>
 #include <ctime>
+#include <algorithm>
 #include <omp.h>
 #include "grid.h"
 #include "vlasovmover.h"
@@ -42,6 +43,7 @@
 #include "iowrite.h"
 #include "ioread.h"
 #include "object_wrapper.h"
+#include "memoryallocation.h"
 
 #ifdef PAPI_MEM
 #include "papi.h" 
@@ -101,6 +103,8 @@ void initializeGrids(
    int myRank;
    MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
    
+   block_pool::setMaxCachedBytes(P::blockPoolCachedBytes);
+   
    // Init Zoltan:
    float zoltanVersion;
    if (Zoltan_Initialize(argn,argc,&zoltanVersion) != ZOLTAN_OK) {
@@ -318,8 +322,9 @@ void initializeGrids(
       exit(1);
    }
    
-   //Balance load before we transfer all data below
-   balanceLoad(mpiGrid, sysBoundaries);
+   //Balance load before we transfer all data below. A restart was already read
+   //into the partition computed from the weights in the restart file.
+   balanceLoad(mpiGrid, sysBoundaries, !P::isRestart);
    
    phiprof::initializeTimer("Fetch Neighbour data","MPI");
    phiprof::start("Fetch Neighbour data");
@@ -446,9 +451,196 @@ void setFaceNeighborRanks( dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
    }
 }
 
-void balanceLoad(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, SysBoundary& sysBoundaries){
+/*! Returns the given load of this process relative to the mean over all processes.
+ * \param localLoad Load of this process
+ * \param imbalance Returns the maximum load over the mean load
+ */
+static Real getRelativeLoad(const Real localLoad, Real& imbalance) {
+   Real sum, max;
+   int nProcesses;
+   MPI_Comm_size(MPI_COMM_WORLD, &nProcesses);
+   MPI_Allreduce(&localLoad, &sum, 1, MPI_Type<Real>(), MPI_SUM, MPI_COMM_WORLD);
+   MPI_Allreduce(&localLoad, &max, 1, MPI_Type<Real>(), MPI_MAX, MPI_COMM_WORLD);
+   const Real mean = sum / nProcesses;
+   if (mean <= 0) {
+      imbalance = 1;
+      return 1;
+   }
+   imbalance = max / mean;
+   return localLoad / mean;
+}
+
+/*! Records the measured load of the current partition and, with loadBalance.weight = time, sets
+ * CellParams::LBWEIGHTCOUNTER to the exponential average of the measured cell costs. Cells keep
+ * their block count weights until a first measurement is available.
+ * \param mpiGrid Spatial grid
+ * \param cells Local cells
+ */
+static void updateLoadBalanceWeights(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, const vector<CellID>& cells) {
+   static bool haveMeasuredWeights = false;
+   
+   Real measuredLoad = 0;
+   for (size_t i=0; i<cells.size(); ++i) {
+      measuredLoad += mpiGrid[cells[i]]->parameters[CellParams::LBCOSTCOUNTER];
+   }
+   Real totalMeasuredLoad;
+   MPI_Allreduce(&measuredLoad, &totalMeasuredLoad, 1, MPI_Type<Real>(), MPI_SUM, MPI_COMM_WORLD);
+   if (totalMeasuredLoad <= 0) {
+      // Initial balance or restart, nothing has been measured yet
+      return;
+   }
+   
+   Real measuredImbalance;
+   P::loadBalanceMeasuredLoad = getRelativeLoad(measuredLoad, measuredImbalance);
+   int myRank;
+   MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
+   if (myRank == MASTER_RANK) {
+      logFile << "(LB): Measured imbalance (max/mean) " << measuredImbalance << endl << writeVerbose;
+   }
+   
+   if (P::loadBalanceWeight != "time") return;
+   
+   const Real alpha = haveMeasuredWeights ? P::loadBalanceWeightSmoothing : 1.0;
+   for (size_t i=0; i<cells.size(); ++i) {
+      Real* parameters = mpiGrid[cells[i]]->parameters.data();
+      parameters[CellParams::LBWEIGHTCOUNTER] = alpha * parameters[CellParams::LBCOSTCOUNTER]
+         + (1.0 - alpha) * parameters[CellParams::LBWEIGHTCOUNTER];
+   }
+   haveMeasuredWeights = true;
+}
+
+/*! Sets the partitioning options for balancing the cell weights and the resident memory of the
+ * cells as two constraints. With loadBalance.memoryCap, the imbalance tolerance of the memory
+ * constraint is lowered so that no process is assigned more than the cap of the memory available
+ * to it, i.e. its current cell data and its share of the free memory of the node.
+ * \param mpiGrid Spatial grid
+ * \param localBytes Resident memory of the local cells
+ */
+static void setMemoryConstraintOptions(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, const Real localBytes) {
+   // Below this the partitioner cannot be expected to converge
+   const Real MIN_MEMORY_TOLERANCE = 1.01;
+   
+   mpiGrid.set_partitioning_option("OBJ_WEIGHT_DIM", "2");
+   mpiGrid.set_partitioning_option("RCB_MULTICRITERIA", "1");
+   mpiGrid.set_partitioning_option("IMBALANCE_TOL[0]", P::loadBalanceTolerance);
+   if (P::loadBalanceMemoryCap <= 0) {
+      mpiGrid.set_partitioning_option("IMBALANCE_TOL[1]", P::loadBalanceTolerance);
+      return;
+   }
+   
+   MPI_Comm nodeComm;
+   int nodeProcesses;
+   MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm);
+   MPI_Comm_size(nodeComm, &nodeProcesses);
+   MPI_Comm_free(&nodeComm);
+   const Real budget = P::loadBalanceMemoryCap * (localBytes + (Real)get_node_free_memory() / nodeProcesses);
+   
+   Real minBudget, totalBytes;
+   int nProcesses, myRank;
+   MPI_Comm_size(MPI_COMM_WORLD, &nProcesses);
+   MPI_Comm_rank(MPI_COMM_WORLD, &myRank);
+   MPI_Allreduce(&budget, &minBudget, 1, MPI_Type<Real>(), MPI_MIN, MPI_COMM_WORLD);
+   MPI_Allreduce(&localBytes, &totalBytes, 1, MPI_Type<Real>(), MPI_SUM, MPI_COMM_WORLD);
+   const Real meanBytes = totalBytes / nProcesses;
+   
+   Real tolerance = meanBytes > 0 ? minBudget / meanBytes : MIN_MEMORY_TOLERANCE;
+   if (tolerance < MIN_MEMORY_TOLERANCE) {
+      if (myRank == MASTER_RANK) {
+         logFile << "(LB): WARNING the memory cap " << P::loadBalanceMemoryCap << " allows only " << tolerance;
+         logFile << " times the mean memory per process, using memory imbalance tolerance " << MIN_MEMORY_TOLERANCE << endl << writeVerbose;
+      }
+      tolerance = MIN_MEMORY_TOLERANCE;
+   } else if (myRank == MASTER_RANK) {
+      logFile << "(LB): Memory imbalance tolerance " << tolerance << " from memory cap " << P::loadBalanceMemoryCap << endl << writeVerbose;
+   }
+   stringstream ss;
+   ss << tolerance;
+   mpiGrid.set_partitioning_option("IMBALANCE_TOL[1]", ss.str());
+}
+
+/*! Assigns the outgoing cells of this process to rounds of cell migration, so that in one round
+ * a process sends at most P::loadBalanceTransferBudget bytes of cell data and receives at most as much.
+ * Each receiver splits its budget between the processes sending to it, and each sender splits its
+ * budget between its destinations, both in proportion to the bytes exchanged. A cell exceeding its
+ * share is sent in a round of its own. The round is stored in CellParams::LBTRANSFERROUND, which
+ * reaches the receiving process with the cell parameters.
+ * \param mpiGrid Spatial grid
+ * \param outgoingCells Cells leaving this process
+ * \return Number of rounds, maximum over all processes
+ */
+static uint64_t assignTransferRounds(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, const vector<CellID>& outgoingCells) {
+   int myRank,nProcesses;
+   MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
+   MPI_Comm_size(MPI_COMM_WORLD,&nProcesses);
+   const uint64_t blockBytes = WID3*sizeof(Realf) + BlockParams::N_VELOCITY_BLOCK_PARAMS*sizeof(Real) + sizeof(vmesh::GlobalID);
+   const std::unordered_map<uint64_t, std::pair<uint64_t,int> > destinations = mpiGrid.get_balance_removed_cells();
+   
+   vector<uint64_t> cellBytes(outgoingCells.size());
+   vector<int> cellDestination(outgoingCells.size());
+   vector<uint64_t> sendBytes(nProcesses, 0);
+   uint64_t totalSendBytes = 0;
+   for (size_t i=0; i<outgoingCells.size(); ++i) {
+      SpatialCell* cell = mpiGrid[outgoingCells[i]];
+      cellBytes[i] = sizeof(Real) * CellParams::N_SPATIAL_CELL_PARAMS;
+      for (size_t p=0; p<getObjectWrapper().particleSpecies.size(); ++p) {
+         cellBytes[i] += cell->get_number_of_velocity_blocks(p) * blockBytes;
+      }
+      cellDestination[i] = destinations.at(outgoingCells[i]).first;
+      sendBytes[cellDestination[i]] += cellBytes[i];
+      totalSendBytes += cellBytes[i];
+   }
+   
+   // Receivers split their budget between the processes sending to them
+   vector<uint64_t> recvBytes(nProcesses);
+   MPI_Alltoall(sendBytes.data(), 1, MPI_Type<uint64_t>(), recvBytes.data(), 1, MPI_Type<uint64_t>(), MPI_COMM_WORLD);
+   uint64_t totalRecvBytes = 0;
+   for (int p=0; p<nProcesses; ++p) totalRecvBytes += recvBytes[p];
+   vector<uint64_t> recvShares(nProcesses, 0);
+   for (int p=0; p<nProcesses; ++p) {
+      if (recvBytes[p] > 0) recvShares[p] = (uint64_t)((double)P::loadBalanceTransferBudget * recvBytes[p] / totalRecvBytes);
+   }
+   vector<uint64_t> sendShares(nProcesses);
+   MPI_Alltoall(recvShares.data(), 1, MPI_Type<uint64_t>(), sendShares.data(), 1, MPI_Type<uint64_t>(), MPI_COMM_WORLD);
+   
+   // Bytes per round to each destination, within the shares of both this process and the destination
+   vector<uint64_t> budget(nProcesses, 0);
+   for (int p=0; p<nProcesses; ++p) {
+      if (sendBytes[p] > 0) {
+         const uint64_t sendShare = (uint64_t)((double)P::loadBalanceTransferBudget * sendBytes[p] / totalSendBytes);
+         budget[p] = min(sendShare, sendShares[p]);
+      }
+   }
+   
+   vector<uint64_t> rounds(nProcesses, 1);
+   vector<uint64_t> roundBytes(nProcesses, 0);
+   for (size_t i=0; i<outgoingCells.size(); ++i) {
+      const int p = cellDestination[i];
+      if (roundBytes[p] > 0 && roundBytes[p] + cellBytes[i] > budget[p]) {
+         ++rounds[p];
+         roundBytes[p] = 0;
+      }
+      roundBytes[p] += cellBytes[i];
+      mpiGrid[outgoingCells[i]]->parameters[CellParams::LBTRANSFERROUND] = rounds[p] - 1;
+   }
+   
+   const uint64_t localRounds = *max_element(rounds.begin(), rounds.end());
+   uint64_t maxRounds;
+   MPI_Allreduce(&localRounds, &maxRounds, 1, MPI_Type<uint64_t>(), MPI_MAX, MPI_COMM_WORLD);
+   if (myRank == MASTER_RANK) {
+      logFile << "(LB): Migrating cells in " << maxRounds << " rounds" << endl << writeVerbose;
+   }
+   return maxRounds;
+}
+
+/*! Returns the round of cell migration in which the given cell is transferred.*/
+static inline uint64_t getTransferRound(const SpatialCell* cell) {
+   return (uint64_t)cell->parameters[CellParams::LBTRANSFERROUND];
+}
+
+void balanceLoad(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, SysBoundary& sysBoundaries, const bool repartition){
    // Invalidate cached cell lists
    Parameters::meshRepartitioned = true;
+   ++Parameters::meshRepartitionEpoch;
 
    // tell other processes which velocity blocks exist in remote spatial cells
    phiprof::initializeTimer("Balancing load", "Load balance");
@@ -461,19 +653,26 @@ void balanceLoad(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, S
    phiprof::stop("deallocate boundary data");
    //set weights based on each cells LB weight counter
    vector<CellID> cells = mpiGrid.get_cells();
-   for (size_t i=0; i<cells.size(); ++i){
-      //Set weight. If acceleration is enabled then we use the weight
-      //counter which is updated in acceleration, otherwise we just
-      //use the number of blocks.
-//      if (P::propagateVlasovAcceleration) 
-      mpiGrid.set_cell_weight(cells[i], mpiGrid[cells[i]]->parameters[CellParams::LBWEIGHTCOUNTER]);
-//      else
-//         mpiGrid.set_cell_weight(cells[i], mpiGrid[cells[i]]->get_number_of_all_velocity_blocks());
-      //reset counter
-      //mpiGrid[cells[i]]->parameters[CellParams::LBWEIGHTCOUNTER] = 0.0;
+   updateLoadBalanceWeights(mpiGrid, cells);
+   if (P::loadBalanceMultiConstraint) {
+      // Second constraint is the resident memory of the cell
+      vector<double> weights(2);
+      Real localBytes = 0;
+      for (size_t i=0; i<cells.size(); ++i){
+         SpatialCell* cell = mpiGrid[cells[i]];
+         weights[0] = cell->parameters[CellParams::LBWEIGHTCOUNTER];
+         weights[1] = cell->get_cell_memory_size();
+         localBytes += weights[1];
+         mpiGrid.set_cell_weight(cells[i], weights);
+      }
+      setMemoryConstraintOptions(mpiGrid, localBytes);
+   } else {
+      for (size_t i=0; i<cells.size(); ++i){
+         mpiGrid.set_cell_weight(cells[i], mpiGrid[cells[i]]->parameters[CellParams::LBWEIGHTCOUNTER]);
+      }
    }
    phiprof::start("dccrg.initialize_balance_load");
-   mpiGrid.initialize_balance_load(true);
+   mpiGrid.initialize_balance_load(repartition);
    phiprof::stop("dccrg.initialize_balance_load");
 
    const std::unordered_set<CellID>& incoming_cells = mpiGrid.get_cells_added_by_balance_load();
@@ -482,47 +681,50 @@ void balanceLoad(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, S
    const std::unordered_set<CellID>& outgoing_cells = mpiGrid.get_cells_removed_by_balance_load();
    std::vector<CellID> outgoing_cells_list (outgoing_cells.begin(),outgoing_cells.end()); 
    
-   /*transfer cells in parts to preserve memory*/
+   /*transfer cells in rounds limited by the amount of sent data to preserve memory*/
    phiprof::start("Data transfers");
-   const uint64_t num_part_transfers=5;
+   const uint64_t num_part_transfers = assignTransferRounds(mpiGrid, outgoing_cells_list);
+   
+   // Transfer the velocity block lists of all migrating cells first, the cell parameters
+   // carry the transfer round of each cell to the receiving process. The block lists are
+   // small compared to the block data, so the rounds below only move block data.
+   phiprof::start("Transfer block lists");
+   for (unsigned int i=0; i<incoming_cells_list.size(); i++) mpiGrid[incoming_cells_list[i]]->set_mpi_transfer_enabled(true);
+   for (unsigned int i=0; i<outgoing_cells_list.size(); i++) mpiGrid[outgoing_cells_list[i]]->set_mpi_transfer_enabled(true);
+   for (size_t p=0; p<getObjectWrapper().particleSpecies.size(); ++p) {
+      SpatialCell::setCommunicatedSpecies(p);
+      if (p == 0) {
+         SpatialCell::set_mpi_transfer_type(Transfer::CELL_PARAMETERS | Transfer::VEL_BLOCK_LIST_STAGE1);
+      } else {
+         SpatialCell::set_mpi_transfer_type(Transfer::VEL_BLOCK_LIST_STAGE1);
+      }
+      mpiGrid.continue_balance_load();
+      SpatialCell::set_mpi_transfer_type(Transfer::VEL_BLOCK_LIST_STAGE2);
+      mpiGrid.continue_balance_load();
+   }
+   phiprof::stop("Transfer block lists");
+   
    for (uint64_t transfer_part=0; transfer_part<num_part_transfers; transfer_part++) {
       //Set transfers on/off for the incoming cells in this transfer set and prepare for receive
       for (unsigned int i=0;i<incoming_cells_list.size();i++){
-         CellID cell_id=incoming_cells_list[i];
-         SpatialCell* cell = mpiGrid[cell_id];
-         if (cell_id%num_part_transfers!=transfer_part) {
-            cell->set_mpi_transfer_enabled(false);
-         } else {
-            cell->set_mpi_transfer_enabled(true);
-         }
+         SpatialCell* cell = mpiGrid[incoming_cells_list[i]];
+         cell->set_mpi_transfer_enabled(getTransferRound(cell) == transfer_part);
       }
       
       //Set transfers on/off for the outgoing cells in this transfer set
       for (unsigned int i=0; i<outgoing_cells_list.size(); i++) {
-         CellID cell_id=outgoing_cells_list[i];
-         SpatialCell* cell = mpiGrid[cell_id];
-         if (cell_id%num_part_transfers!=transfer_part) {
-            cell->set_mpi_transfer_enabled(false);
-         } else {
-            cell->set_mpi_transfer_enabled(true);
-         }
+         SpatialCell* cell = mpiGrid[outgoing_cells_list[i]];
+         cell->set_mpi_transfer_enabled(getTransferRound(cell) == transfer_part);
       }
 
       for (size_t p=0; p<getObjectWrapper().particleSpecies.size(); ++p) {
          // Set active population
          SpatialCell::setCommunicatedSpecies(p);
 
-         //Transfer velocity block list
-         SpatialCell::set_mpi_transfer_type(Transfer::VEL_BLOCK_LIST_STAGE1);
-         mpiGrid.continue_balance_load();
-         SpatialCell::set_mpi_transfer_type(Transfer::VEL_BLOCK_LIST_STAGE2);
-         mpiGrid.continue_balance_load();
-      
          int receives = 0;
          for (unsigned int i=0; i<incoming_cells_list.size(); i++) {
-            CellID cell_id=incoming_cells_list[i];
-            SpatialCell* cell = mpiGrid[cell_id];
-            if (cell_id % num_part_transfers == transfer_part) {
+            SpatialCell* cell = mpiGrid[incoming_cells_list[i]];
+            if (getTransferRound(cell) == transfer_part) {
                receives++;
                phiprof::start("Preparing receives");
                // reserve space for velocity block data in arriving remote cells
@@ -545,13 +747,12 @@ void balanceLoad(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, S
 
          // Free memory for cells that have been sent (the block data)
          for (unsigned int i=0;i<outgoing_cells_list.size();i++){
-            CellID cell_id=outgoing_cells_list[i];
-            SpatialCell* cell = mpiGrid[cell_id];
+            SpatialCell* cell = mpiGrid[outgoing_cells_list[i]];
             
             // Free memory of this cell as it has already been transferred, 
             // it will not be used anymore. NOTE: Only clears memory allocated 
             // to the active population.
-            if (cell_id % num_part_transfers == transfer_part) cell->clear(p);
+            if (getTransferRound(cell) == transfer_part) cell->clear(p);
          }
       } // for-loop over populations
    } // for-loop over transfer parts
@@ -568,6 +769,23 @@ void balanceLoad(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, S
    cells = mpiGrid.get_cells();
    for (uint i=0; i<cells.size(); ++i) mpiGrid[cells[i]]->set_mpi_transfer_enabled(true);
 
+   // Load of the new partition as predicted by the weights, which moved along with the cells
+   Real predictedLoad = 0;
+   Real localBytes = 0;
+   for (uint i=0; i<cells.size(); ++i) {
+      predictedLoad += mpiGrid[cells[i]]->parameters[CellParams::LBWEIGHTCOUNTER];
+      localBytes += mpiGrid[cells[i]]->get_cell_memory_size();
+   }
+   Real predictedImbalance, memoryImbalance;
+   P::loadBalancePredictedLoad = getRelativeLoad(predictedLoad, predictedImbalance);
+   getRelativeLoad(localBytes, memoryImbalance);
+   int myRank;
+   MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
+   if (myRank == MASTER_RANK) {
+      logFile << "(LB): Imbalance (max/mean) of the new partition, predicted compute " << predictedImbalance;
+      logFile << ", memory " << memoryImbalance << endl << writeVerbose;
+   }
+
    // Communicate all spatial data for FULL neighborhood, which
    // includes all data with the exception of dist function data
    SpatialCell::set_mpi_transfer_type(Transfer::ALL_SPATIAL_DATA);
@@ -601,10 +819,56 @@ void balanceLoad(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, S
       phiprof::stop("set face neighbor ranks");
    }
    
+   // Migration freed block storage of the cells sent away, return it to the system
+   block_pool::releaseCachedMemory();
    
    phiprof::stop("Balancing load");
 }
 
+/*
+  Adjust sparse velocity space of one local cell.
+
+  Further documentation in grid.h
+*/
+void adjustCellVelocityBlocks(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                              const CellID cell_id,
+                              const uint popID) {
+   Real density_pre_adjust=0.0;
+   Real density_post_adjust=0.0;
+   SpatialCell* cell = mpiGrid[cell_id];
+   
+   // gather spatial neighbor list and create vector with pointers to neighbor spatial cells
+   const auto* neighbors = mpiGrid.get_neighbors_of(cell_id, NEAREST_NEIGHBORHOOD_ID);
+   // Note: at AMR refinement boundaries this can cause blocks to propagate further than absolutely required
+   vector<SpatialCell*> neighbor_ptrs;
+   neighbor_ptrs.reserve(neighbors->size());
+
+   for ( const auto& nbrPair : *neighbors) {
+      CellID neighbor_id = nbrPair.first;
+      if (neighbor_id == 0 || neighbor_id == cell_id) {
+         continue;
+      }
+      neighbor_ptrs.push_back(mpiGrid[neighbor_id]);
+   }
+   if (getObjectWrapper().particleSpecies[popID].sparse_conserve_mass) {
+      for (size_t i=0; i<cell->get_number_of_velocity_blocks(popID)*WID3; ++i) {
+         density_pre_adjust += cell->get_data(popID)[i];
+      }
+   }
+   cell->adjust_velocity_blocks(neighbor_ptrs,popID);
+
+   if (getObjectWrapper().particleSpecies[popID].sparse_conserve_mass) {
+      for (size_t i=0; i<cell->get_number_of_velocity_blocks(popID)*WID3; ++i) {
+         density_post_adjust += cell->get_data(popID)[i];
+      }
+      if (density_post_adjust != 0.0) {
+         for (size_t i=0; i<cell->get_number_of_velocity_blocks(popID)*WID3; ++i) {
+            cell->get_data(popID)[i] *= density_pre_adjust/density_post_adjust;
+         }
+      }
+   }
+}
+
 /*
   Adjust sparse velocity space to make it consistent in all 6 dimensions.
 
@@ -640,41 +904,7 @@ bool adjustVelocityBlocks(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& m
    phiprof::start("Adjusting blocks");
    #pragma omp parallel for schedule(dynamic)
    for (size_t i=0; i<cellsToAdjust.size(); ++i) {
-      Real density_pre_adjust=0.0;
-      Real density_post_adjust=0.0;
-      CellID cell_id=cellsToAdjust[i];
-      SpatialCell* cell = mpiGrid[cell_id];
-      
-      // gather spatial neighbor list and create vector with pointers to neighbor spatial cells
-      const auto* neighbors = mpiGrid.get_neighbors_of(cell_id, NEAREST_NEIGHBORHOOD_ID);
-      // Note: at AMR refinement boundaries this can cause blocks to propagate further than absolutely required
-      vector<SpatialCell*> neighbor_ptrs;
-      neighbor_ptrs.reserve(neighbors->size());
-
-      for ( const auto& nbrPair : *neighbors) {
-         CellID neighbor_id = nbrPair.first;
-         if (neighbor_id == 0 || neighbor_id == cell_id) {
-            continue;
-         }
-         neighbor_ptrs.push_back(mpiGrid[neighbor_id]);
-      }
-      if (getObjectWrapper().particleSpecies[popID].sparse_conserve_mass) {
-         for (size_t i=0; i<cell->get_number_of_velocity_blocks(popID)*WID3; ++i) {
-            density_pre_adjust += cell->get_data(popID)[i];
-         }
-      }
-      cell->adjust_velocity_blocks(neighbor_ptrs,popID);
-
-      if (getObjectWrapper().particleSpecies[popID].sparse_conserve_mass) {
-         for (size_t i=0; i<cell->get_number_of_velocity_blocks(popID)*WID3; ++i) {
-            density_post_adjust += cell->get_data(popID)[i];
-         }
-         if (density_post_adjust != 0.0) {
-            for (size_t i=0; i<cell->get_number_of_velocity_blocks(popID)*WID3; ++i) {
-               cell->get_data(popID)[i] *= density_pre_adjust/density_post_adjust;
-            }
-         }
-      }
+      adjustCellVelocityBlocks(mpiGrid, cellsToAdjust[i], popID);
    }
    phiprof::stop("Adjusting blocks");
 
@@ -756,6 +986,20 @@ void report_grid_memory_consumption(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Ge
    logFile << "(MEM)   Average capacity: " << sum_mem[5]/n_procs << " local cells " << sum_mem[3]/n_procs << " remote cells " << sum_mem[4]/n_procs << endl;
    logFile << "(MEM)   Max capacity:     " << max_mem[2].val   << " on  process " << max_mem[2].rank << endl;
    logFile << "(MEM)   Min capacity:     " << min_mem[2].val   << " on  process " << min_mem[2].rank << endl;
+
+   /*report statistics of the velocity block memory pool*/
+   const block_pool::Statistics poolStats = block_pool::getStatistics();
+   double pool[4] = {(double)poolStats.bytesInUse, (double)poolStats.bytesCached,
+                     (double)poolStats.allocations, (double)poolStats.systemAllocations};
+   double sum_pool[4];
+   double max_pool[4];
+   MPI_Reduce(pool, sum_pool, 4, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+   MPI_Reduce(pool, max_pool, 4, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+   logFile << "(MEM) Block pool in use (avg, max): " << sum_pool[0]/n_procs << " " << max_pool[0] << endl;
+   logFile << "(MEM) Block pool cached (avg, max): " << sum_pool[1]/n_procs << " " << max_pool[1] << endl;
+   logFile << "(MEM) Block pool reallocations (total, max): " << sum_pool[2] << " " << max_pool[2]
+           << ", not served from cache: " << sum_pool[3] << endl;
    logFile << writeVerbose;
 }
 
@@ -53,8 +53,9 @@ void initializeGrids(
   \brief Balance load
 
     \param[in,out] mpiGrid The DCCRG grid with spatial cells
+    \param repartition If false, the current partition is kept and only the data depending on it is initialized
 */
-void balanceLoad(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, SysBoundary& sysBoundaries);
+void balanceLoad(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid, SysBoundary& sysBoundaries, const bool repartition=true);
 
 /*!
 
@@ -95,6 +96,18 @@ bool adjustVelocityBlocks(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& m
                           bool doPrepareToReceiveBlocks,
                             const uint popID);
 
+/*! Adjust the velocity blocks of one local cell, step 2) of adjustVelocityBlocks. Blocks are
+ added or removed based on the content lists of the cell and of its nearest spatial neighbors,
+ which have to be up-to-date. Does no communication.
+
+ \param mpiGrid  Parallel grid with spatial cells
+ \param cell_id  Local cell whose blocks are added or removed.
+ \param popID  Particle population.
+*/
+void adjustCellVelocityBlocks(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                              const CellID cell_id,
+                              const uint popID);
+
 /*! Estimates memory consumption and writes it into logfile. Collective operation on MPI_COMM_WORLD
  * \param mpiGrid Spatial grid
  */
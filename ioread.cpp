@@ -28,6 +28,7 @@
 #include <sstream>
 #include <ctime>
 #include <array>
+#include <algorithm>
 #include <sys/types.h>
 #include <sys/stat.h>
 
@@ -38,6 +39,7 @@
 #include "vlsv_reader_parallel.h"
 #include "vlasovmover.h"
 #include "object_wrapper.h"
+#include "velocity_block_codec.h"
 
 using namespace std;
 using namespace phiprof;
@@ -302,56 +304,452 @@ bool readNBlocks(vlsv::ParallelReader& file,const std::string& meshName,
    return success;
 }
 
+/** Offset of this process' data in an array where processes store their data in rank order.
+ * @param localCount Number of elements this process stores.
+ * @return Sum of localCount over processes with a lower rank.*/
+static uint64_t getRankOffset(const uint64_t localCount) {
+   int myRank;
+   MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
+   uint64_t offset = 0;
+   MPI_Exscan(&localCount,&offset,1,MPI_Type<uint64_t>(),MPI_SUM,MPI_COMM_WORLD);
+   if (myRank == 0) offset = 0; // MPI_Exscan leaves the result of rank 0 undefined
+   return offset;
+}
+
+/** Ranges of an array read by this process, as (first element, number of elements).*/
+typedef vector<pair<uint64_t,uint64_t> > ReadRanges;
+
+/** Find the ranges of an array that contain the data of local cells. Local cells
+ * that are consecutive in the file are merged into one range.
+ * @param localIndices Indices of local cells in the file cell list, in increasing order.
+ * @param cellOffsets If NULL, the array has one element per cell. Otherwise the data of cell i
+ * is in elements [cellOffsets[i],cellOffsets[i+1]).
+ * @param ranges The ranges, in the order of localIndices.*/
+static void getReadRanges(const vector<uint64_t>& localIndices,const vector<uint64_t>* cellOffsets,ReadRanges& ranges) {
+   ranges.clear();
+   for (size_t i=0; i<localIndices.size(); ) {
+      size_t j = i+1;
+      while (j < localIndices.size() && localIndices[j] == localIndices[j-1]+1) ++j;
+      uint64_t first = localIndices[i];
+      uint64_t end = localIndices[j-1]+1;
+      if (cellOffsets != NULL) {
+         first = (*cellOffsets)[first];
+         end = (*cellOffsets)[end];
+      }
+      if (end > first) ranges.push_back(make_pair(first,end-first));
+      i = j;
+   }
+}
+
+/** Read ranges of an array into a buffer, one after another. A range is read in pieces of
+ * at most P::restartReadChunkSize bytes. Ranges separated by small gaps are read in one
+ * piece, the gaps are discarded. Each read is collective, processes that run out of pieces
+ * make empty reads until all processes are done.
+ * This function must be called simultaneously by all processes.
+ * @param file VLSV reader with input file open.
+ * @param tagName Name of the array's XML tag.
+ * @param attribs Attributes identifying the array.
+ * @param ranges Ranges to read.
+ * @param elementBytes Size of one array element, i.e. vector size times data size.
+ * @param buffer Buffer for the data of all ranges.
+ * @return If true, the ranges were read successfully.*/
+static bool readRanges(vlsv::ParallelReader& file,const string& tagName,const list<pair<string,string> >& attribs,
+                       const ReadRanges& ranges,const uint64_t elementBytes,char* buffer) {
+   const uint64_t chunkElements = max((uint64_t)1,P::restartReadChunkSize/elementBytes);
+   const uint64_t maxGap = chunkElements/64;
+
+   // Split ranges into parts that fit into a chunk, as (first element, number of elements, position in buffer)
+   vector<array<uint64_t,3> > parts;
+   uint64_t position = 0;
+   for (size_t r=0; r<ranges.size(); ++r) {
+      for (uint64_t done=0; done<ranges[r].second; done+=chunkElements) {
+         parts.push_back({{ranges[r].first+done,min(chunkElements,ranges[r].second-done),position+done}});
+      }
+      position += ranges[r].second;
+   }
+
+   // Pieces read with one call, as [first part, end part)
+   vector<pair<size_t,size_t> > pieces;
+   for (size_t p=0; p<parts.size(); ) {
+      size_t q = p+1;
+      while (q < parts.size()
+             && parts[q][0] <= parts[q-1][0] + parts[q-1][1] + maxGap
+             && parts[q][0] + parts[q][1] - parts[p][0] <= chunkElements) ++q;
+      pieces.push_back(make_pair(p,q));
+      p = q;
+   }
+   uint64_t N_reads = pieces.size();
+   MPI_Allreduce(MPI_IN_PLACE,&N_reads,1,MPI_Type<uint64_t>(),MPI_MAX,MPI_COMM_WORLD);
+
+   bool success = true;
+   char dummy;
+   vector<char> pieceBuffer;
+   for (uint64_t r=0; r<N_reads; ++r) {
+      if (r >= pieces.size()) {
+         if (file.readArray(tagName,attribs,0,0,&dummy) == false) success = false;
+         continue;
+      }
+      const array<uint64_t,3>& first = parts[pieces[r].first];
+      const array<uint64_t,3>& last = parts[pieces[r].second-1];
+      const uint64_t N_elements = last[0] + last[1] - first[0];
+      if (pieces[r].second - pieces[r].first == 1) {
+         if (file.readArray(tagName,attribs,first[0],N_elements,buffer + first[2]*elementBytes) == false) success = false;
+         continue;
+      }
+      pieceBuffer.resize(N_elements*elementBytes);
+      if (file.readArray(tagName,attribs,first[0],N_elements,pieceBuffer.data()) == false) success = false;
+      for (size_t p=pieces[r].first; p<pieces[r].second; ++p) {
+         memcpy(buffer + parts[p][2]*elementBytes,pieceBuffer.data() + (parts[p][0]-first[0])*elementBytes,parts[p][1]*elementBytes);
+      }
+   }
+   return success;
+}
+
+/** Read an array containing the amount of data per spatial cell, and compute where the
+ * data of each cell starts. The array is read to all processes.
+ * This function must be called simultaneously by all processes.
+ * @param file VLSV reader with input file open.
+ * @param tagName Name of the array's XML tag, e.g. BLOCKSPERCELL.
+ * @param attribs Attributes identifying the array.
+ * @param cellOffsets The data of cell i is in elements [cellOffsets[i],cellOffsets[i+1]).
+ * @return If true, the array was read successfully.*/
+static bool readCellOffsets(vlsv::ParallelReader& file,const string& tagName,const list<pair<string,string> >& attribs,
+                            vector<uint64_t>& cellOffsets) {
+   uint64_t arraySize;
+   uint64_t vectorSize;
+   vlsv::datatype::type dataType;
+   uint64_t byteSize;
+   if (file.getArrayInfo(tagName,attribs,arraySize,vectorSize,dataType,byteSize) == false) {
+      logFile << "(RESTART) ERROR: Failed to read " << tagName << " array info at " << __FILE__ << ":" << __LINE__ << endl << write;
+      return false;
+   }
+   uint64_t* counts = NULL;
+   if (file.read(tagName,attribs,0,arraySize,counts,true) == false) {
+      logFile << "(RESTART) ERROR: Failed to read " << tagName << " at " << __FILE__ << ":" << __LINE__ << endl << write;
+      delete [] counts;
+      return false;
+   }
+   cellOffsets.resize(arraySize+1);
+   cellOffsets[0] = 0;
+   for (uint64_t i=0; i<arraySize; ++i) cellOffsets[i+1] = cellOffsets[i] + counts[i];
+   delete [] counts; counts = NULL;
+   return true;
+}
+
+/** Compute where the block ID literals of each cell start in a differential restart written
+ * without LITERALSPERCELL. Each process reads the segments of an equal share of the cells in
+ * the file and counts their literals, the counts are then gathered to all processes.
+ * This function must be called simultaneously by all processes.
+ * @param file VLSV reader with input file open.
+ * @param attribs Attributes identifying the BLOCKIDSEGMENTS array.
+ * @param segmentOffsets The segments of cell i are in elements [segmentOffsets[i],segmentOffsets[i+1]).
+ * @param literalOffsets The literals of cell i are in elements [literalOffsets[i],literalOffsets[i+1]).
+ * @return If true, the segments were read successfully.*/
+static bool countLiteralOffsets(vlsv::ParallelReader& file,const list<pair<string,string> >& attribs,
+                                const vector<uint64_t>& segmentOffsets,vector<uint64_t>& literalOffsets) {
+   int myRank,N_processes;
+   MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
+   MPI_Comm_size(MPI_COMM_WORLD,&N_processes);
+   const uint64_t N_cells = segmentOffsets.size()-1;
+   vector<int> cellCounts(N_processes),cellDisplacements(N_processes);
+   for (int p=0; p<N_processes; ++p) {
+      cellDisplacements[p] = (N_cells*p)/N_processes;
+      cellCounts[p] = (N_cells*(p+1))/N_processes - cellDisplacements[p];
+   }
+   const uint64_t cellStart = cellDisplacements[myRank];
+   const uint64_t cellEnd = cellStart + cellCounts[myRank];
+
+   const uint64_t firstSegment = segmentOffsets[cellStart];
+   const uint64_t N_segments = segmentOffsets[cellEnd] - firstSegment;
+   ReadRanges ranges;
+   if (N_segments > 0) ranges.push_back(make_pair(firstSegment,N_segments));
+   vector<vmesh::GlobalID> segments(2*N_segments);
+   bool success = readRanges(file,"BLOCKIDSEGMENTS",attribs,ranges,2*sizeof(vmesh::GlobalID),(char*)segments.data());
+
+   vector<uint64_t> literalCounts(cellEnd-cellStart,0);
+   for (uint64_t c=cellStart; c<cellEnd && success; ++c) {
+      for (uint64_t s=segmentOffsets[c]-firstSegment; s<segmentOffsets[c+1]-firstSegment; ++s) {
+         if (segments[2*s] == vmesh::INVALID_GLOBALID) literalCounts[c-cellStart] += segments[2*s+1];
+      }
+   }
+   vector<uint64_t> allLiteralCounts(N_cells);
+   MPI_Allgatherv(literalCounts.data(),literalCounts.size(),MPI_Type<uint64_t>(),
+                  allLiteralCounts.data(),cellCounts.data(),cellDisplacements.data(),MPI_Type<uint64_t>(),MPI_COMM_WORLD);
+   literalOffsets.resize(N_cells+1);
+   literalOffsets[0] = 0;
+   for (uint64_t i=0; i<N_cells; ++i) literalOffsets[i+1] = literalOffsets[i] + allLiteralCounts[i];
+
+   int globalSuccess = success;
+   MPI_Allreduce(MPI_IN_PLACE,&globalSuccess,1,MPI_INT,MPI_MIN,MPI_COMM_WORLD);
+   return globalSuccess == 1;
+}
+
+bool readBaseBlockIds(const string& fileName,const uint popID,
+                      dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                      BlockIdMap& baseBlockIds) {
+   int myRank,N_processes;
+   MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
+   MPI_Comm_size(MPI_COMM_WORLD,&N_processes);
+   baseBlockIds.clear();
+
+   vlsv::ParallelReader file;
+   if (file.open(fileName,MPI_COMM_WORLD,MASTER_RANK,MPI_INFO_NULL) == false) {
+      logFile << "(RESTART) ERROR: Failed to open full restart " << fileName << endl << write;
+      return false;
+   }
+
+   uint64_t arraySize;
+   uint64_t vectorSize;
+   vlsv::datatype::type dataType;
+   uint64_t byteSize;
+   list<pair<string,string> > attribs;
+   attribs.push_back(make_pair("mesh","SpatialGrid"));
+   attribs.push_back(make_pair("name",getObjectWrapper().particleSpecies[popID].name));
+   if (file.getArrayInfo("BLOCKIDS",attribs,arraySize,vectorSize,dataType,byteSize) == false
+       || byteSize != sizeof(vmesh::GlobalID)) {
+      logFile << "(RESTART) ERROR: " << fileName << " is not a full restart with BLOCKIDS" << endl << write;
+      file.close();
+      return false;
+   }
+   if (file.getArrayInfo("CELLSWITHBLOCKS",attribs,arraySize,vectorSize,dataType,byteSize) == false) {
+      logFile << "(RESTART) ERROR: Failed to read CELLSWITHBLOCKS array info of " << fileName << endl << write;
+      file.close();
+      return false;
+   }
+
+   // Each process reads an equal share of the cells in the file, in file order
+   const uint64_t cellStart = (arraySize*myRank)/N_processes;
+   const uint64_t cellCount = (arraySize*(myRank+1))/N_processes - cellStart;
+   bool success = true;
+   uint64_t* cellIds = NULL;
+   vmesh::LocalID* blocksPerCell = NULL;
+   if (file.read("CELLSWITHBLOCKS",attribs,cellStart,cellCount,cellIds,true) == false) success = false;
+   if (file.read("BLOCKSPERCELL",attribs,cellStart,cellCount,blocksPerCell,true) == false) success = false;
+   uint64_t blockSum = 0;
+   for (uint64_t i=0; i<cellCount && success; ++i) blockSum += blocksPerCell[i];
+   const uint64_t blockStart = getRankOffset(blockSum);
+   vector<vmesh::GlobalID> blockIds(blockSum);
+   if (file.readArray("BLOCKIDS",attribs,blockStart,blockSum,(char*)blockIds.data()) == false) success = false;
+   file.close();
+
+   // Send the lists to the processes owning the cells. Each list is sent as
+   // cell ID, number of blocks and block IDs.
+   vector<vector<uint64_t> > sendData(N_processes);
+   uint64_t blockOffset = 0;
+   for (uint64_t i=0; i<cellCount && success; ++i) {
+      const uint64_t process = mpiGrid.get_process(cellIds[i]);
+      if (process < (uint64_t)N_processes) {
+         vector<uint64_t>& data = sendData[process];
+         data.push_back(cellIds[i]);
+         data.push_back(blocksPerCell[i]);
+         data.insert(data.end(),blockIds.begin()+blockOffset,blockIds.begin()+blockOffset+blocksPerCell[i]);
+      }
+      blockOffset += blocksPerCell[i];
+   }
+   delete [] cellIds; cellIds = NULL;
+   delete [] blocksPerCell; blocksPerCell = NULL;
+   vector<vmesh::GlobalID>().swap(blockIds);
+
+   vector<int> sendCounts(N_processes),sendOffsets(N_processes),recvCounts(N_processes),recvOffsets(N_processes);
+   for (int p=0; p<N_processes; ++p) sendCounts[p] = sendData[p].size();
+   MPI_Alltoall(sendCounts.data(),1,MPI_INT,recvCounts.data(),1,MPI_INT,MPI_COMM_WORLD);
+   vector<uint64_t> sendBuffer;
+   uint64_t recvSize = 0;
+   for (int p=0; p<N_processes; ++p) {
+      sendOffsets[p] = sendBuffer.size();
+      sendBuffer.insert(sendBuffer.end(),sendData[p].begin(),sendData[p].end());
+      vector<uint64_t>().swap(sendData[p]);
+      recvOffsets[p] = recvSize;
+      recvSize += recvCounts[p];
+   }
+   vector<uint64_t> recvBuffer(recvSize);
+   MPI_Alltoallv(sendBuffer.data(),sendCounts.data(),sendOffsets.data(),MPI_Type<uint64_t>(),
+                 recvBuffer.data(),recvCounts.data(),recvOffsets.data(),MPI_Type<uint64_t>(),MPI_COMM_WORLD);
+
+   for (uint64_t i=0; i<recvSize; ) {
+      vector<vmesh::GlobalID>& cellBlockIds = baseBlockIds[recvBuffer[i]];
+      const uint64_t N_blocks = recvBuffer[i+1];
+      cellBlockIds.assign(recvBuffer.begin()+i+2,recvBuffer.begin()+i+2+N_blocks);
+      i += 2 + N_blocks;
+   }
+
+   int globalSuccess = success;
+   MPI_Allreduce(MPI_IN_PLACE,&globalSuccess,1,MPI_INT,MPI_MIN,MPI_COMM_WORLD);
+   if (globalSuccess == 0) {
+      logFile << "(RESTART) ERROR: Failed to read velocity block lists of " << fileName << endl << write;
+      return false;
+   }
+   return true;
+}
+
+/** Read velocity block IDs of the local cells. Full restarts store the block IDs in BLOCKIDS.
+ * Differential restarts store the block list of each cell as segments: a segment either copies
+ * consecutive block IDs of the cell in the full restart, or takes them from BLOCKIDLITERALS.
+ * This function must be called simultaneously by all processes.
+ * @param file VLSV reader with input file open.
+ * @param restartDir Directory of the restart file, full restarts are searched for here.
+ * @param spatMeshName Name of the spatial mesh.
+ * @param fileCells List of all spatial cell IDs.
+ * @param localIndices Indices of the cells belonging to this process in fileCells, in increasing order.
+ * @param blockOffsets Velocity blocks of file cell i are in elements [blockOffsets[i],blockOffsets[i+1]) of block arrays.
+ * @param mpiGrid Parallel grid library.
+ * @param popID ID of the particle species who's data is to be read.
+ * @param blockIds Block IDs of local cells, in the order of the block data.
+ * @return If true, block IDs were read successfully.*/
+static bool readLocalBlockIds(
+   vlsv::ParallelReader & file,
+   const std::string& restartDir,
+   const std::string& spatMeshName,
+   const std::vector<uint64_t>& fileCells,
+   const std::vector<uint64_t>& localIndices,
+   const std::vector<uint64_t>& blockOffsets,
+   dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+   const uint popID,
+   std::vector<vmesh::GlobalID>& blockIds
+) {
+   uint64_t arraySize;
+   uint64_t vectorSize;
+   vlsv::datatype::type dataType;
+   uint64_t byteSize;
+   list<pair<string,string> > attribs;
+   attribs.push_back(make_pair("mesh",spatMeshName));
+   attribs.push_back(make_pair("name",getObjectWrapper().particleSpecies[popID].name));
+
+   ReadRanges blockRanges;
+   getReadRanges(localIndices,&blockOffsets,blockRanges);
+   uint64_t localBlocks = 0;
+   for (size_t r=0; r<blockRanges.size(); ++r) localBlocks += blockRanges[r].second;
+   blockIds.resize(localBlocks);
+
+   if (file.getArrayInfo("BLOCKIDS",attribs,arraySize,vectorSize,dataType,byteSize) == true) {
+      if (byteSize != sizeof(vmesh::GlobalID)) {
+         logFile << "(RESTART) ERROR: BlockID data size does not match " << __FILE__ << " " << __LINE__ << endl << write;
+         return false;
+      }
+      if (readRanges(file,"BLOCKIDS",attribs,blockRanges,sizeof(vmesh::GlobalID),(char*)blockIds.data()) == false) {
+         cerr << "ERROR, failed to read BLOCKIDS in " << __FILE__ << ":" << __LINE__ << endl;
+         return false;
+      }
+      return true;
+   }
+
+   // Differential restart
+   if (file.getArrayInfo("BLOCKIDSEGMENTS",attribs,arraySize,vectorSize,dataType,byteSize) == false) {
+      logFile << "(RESTART) ERROR: Failed to read BLOCKIDS array info " << endl << write;
+      return false;
+   }
+   if (vectorSize != 2 || byteSize != sizeof(vmesh::GlobalID)) {
+      logFile << "(RESTART) ERROR: BLOCKIDSEGMENTS data size does not match " << __FILE__ << " " << __LINE__ << endl << write;
+      return false;
+   }
+   map<string,string> segmentAttribs;
+   file.getArrayAttributes("BLOCKIDSEGMENTS",attribs,segmentAttribs);
+   const string baseName = restartDir + "/" + segmentAttribs["base"];
+   logFile << "(RESTART) Differential restart, reading velocity block lists of " << baseName << endl << writeVerbose;
+   BlockIdMap baseBlockIds;
+   if (readBaseBlockIds(baseName,popID,mpiGrid,baseBlockIds) == false) return false;
+
+   bool success = true;
+   vector<uint64_t> segmentOffsets;
+   vector<uint64_t> literalOffsets;
+   if (readCellOffsets(file,"SEGMENTSPERCELL",attribs,segmentOffsets) == false) return false;
+   if (file.getArrayInfo("LITERALSPERCELL",attribs,arraySize,vectorSize,dataType,byteSize) == true) {
+      if (readCellOffsets(file,"LITERALSPERCELL",attribs,literalOffsets) == false) return false;
+   } else {
+      // Differential restarts written before LITERALSPERCELL was added
+      logFile << "(RESTART) LITERALSPERCELL not found, counting block ID literals from BLOCKIDSEGMENTS" << endl << writeVerbose;
+      if (countLiteralOffsets(file,attribs,segmentOffsets,literalOffsets) == false) return false;
+   }
+
+   ReadRanges segmentRanges,literalRanges;
+   getReadRanges(localIndices,&segmentOffsets,segmentRanges);
+   getReadRanges(localIndices,&literalOffsets,literalRanges);
+   uint64_t segmentSum = 0;
+   uint64_t literalSum = 0;
+   for (size_t r=0; r<segmentRanges.size(); ++r) segmentSum += segmentRanges[r].second;
+   for (size_t r=0; r<literalRanges.size(); ++r) literalSum += literalRanges[r].second;
+   vector<vmesh::GlobalID> segments(2*segmentSum);
+   vector<vmesh::GlobalID> literals(literalSum);
+   if (readRanges(file,"BLOCKIDSEGMENTS",attribs,segmentRanges,2*sizeof(vmesh::GlobalID),(char*)segments.data()) == false) {
+      cerr << "ERROR, failed to read BLOCKIDSEGMENTS in " << __FILE__ << ":" << __LINE__ << endl;
+      success = false;
+   }
+   if (readRanges(file,"BLOCKIDLITERALS",attribs,literalRanges,sizeof(vmesh::GlobalID),(char*)literals.data()) == false) {
+      cerr << "ERROR, failed to read BLOCKIDLITERALS in " << __FILE__ << ":" << __LINE__ << endl;
+      success = false;
+   }
+
+   // Reconstruct the block lists
+   const vector<vmesh::GlobalID> noBlocks;
+   uint64_t segment = 0;
+   uint64_t literal = 0;
+   uint64_t block = 0;
+   for (size_t i=0; i<localIndices.size() && success; ++i) {
+      const uint64_t index = localIndices[i];
+      const CellID cell = fileCells[index];
+      BlockIdMap::const_iterator it = baseBlockIds.find(cell);
+      const vector<vmesh::GlobalID>& base = (it == baseBlockIds.end()) ? noBlocks : it->second;
+      const uint64_t cellBlockEnd = block + blockOffsets[index+1] - blockOffsets[index];
+      const uint64_t cellLiteralEnd = literal + literalOffsets[index+1] - literalOffsets[index];
+      for (uint64_t s=segmentOffsets[index]; s<segmentOffsets[index+1]; ++s,++segment) {
+         const vmesh::GlobalID start  = segments[2*segment];
+         const vmesh::GlobalID length = segments[2*segment+1];
+         if (block + length > cellBlockEnd
+             || (start == vmesh::INVALID_GLOBALID && literal + length > cellLiteralEnd)
+             || (start != vmesh::INVALID_GLOBALID && (uint64_t)start + length > base.size())) {
+            success = false;
+            break;
+         }
+         if (start == vmesh::INVALID_GLOBALID) {
+            copy(literals.begin()+literal,literals.begin()+literal+length,blockIds.begin()+block);
+            literal += length;
+         } else {
+            copy(base.begin()+start,base.begin()+start+length,blockIds.begin()+block);
+         }
+         block += length;
+      }
+      if (block != cellBlockEnd || literal != cellLiteralEnd) success = false;
+   }
+   if (success == false) {
+      cerr << "ERROR, velocity block list segments do not match the full restart in " << __FILE__ << ":" << __LINE__ << endl;
+   }
+   return success;
+}
+
 /** Read velocity block mesh data and distribution function data belonging to this process 
  * for the given particle species. This function must be called simultaneously by all processes.
  * @param file VLSV reader with input file open.
+ * @param restartDir Directory of the restart file.
  * @param spatMeshName Name of the spatial mesh.
  * @param fileCells List of all spatial cell IDs.
- * @param localCellStartOffset The offset from which to start reading cells.
- * @param localCells How many spatial cells after the offset to read.
- * @param blocksPerCell Number of velocity blocks for this particle species in each spatial cell belonging to this process.
- * @param localBlockStartOffset Offset into velocity block data arrays from which to start reading data.
- * @param localBlocks Number of velocity blocks for this species assigned to this process.
+ * @param localIndices Indices of the cells belonging to this process in fileCells, in increasing order.
+ * @param blockOffsets Velocity blocks of file cell i are in elements [blockOffsets[i],blockOffsets[i+1]) of block arrays.
  * @param mpiGrid Parallel grid library.
  * @param popID ID of the particle species who's data is to be read.
  * @return If true, velocity block data was read successfully.*/
 template <typename fileReal>
 bool _readBlockData(
    vlsv::ParallelReader & file,
+   const std::string& restartDir,
    const std::string& spatMeshName,
    const std::vector<uint64_t>& fileCells,
-   const uint64_t localCellStartOffset,
-   const uint64_t localCells,
-   const vmesh::LocalID* blocksPerCell,
-   const uint64_t localBlockStartOffset,
-   const uint64_t localBlocks,
+   const std::vector<uint64_t>& localIndices,
+   const std::vector<uint64_t>& blockOffsets,
    dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    std::function<vmesh::GlobalID(vmesh::GlobalID)> blockIDremapper,
    const uint popID
 ) {   
    uint64_t arraySize;
    uint64_t avgVectorSize;
-   uint64_t cellParamsVectorSize;
    vlsv::datatype::type dataType;
    uint64_t byteSize;
    list<pair<string,string> > avgAttribs;
    bool success=true;
    const string popName = getObjectWrapper().particleSpecies[popID].name;
-   const string tagName = "BLOCKIDS";
    
    avgAttribs.push_back(make_pair("mesh",spatMeshName));
    avgAttribs.push_back(make_pair("name",popName));
    
-    //Get block id array info and store them into blockIdAttribs, lockIdByteSize, blockIdDataType, blockIdVectorSize
-  list<pair<string,string> > blockIdAttribs;
-  uint64_t blockIdVectorSize, blockIdByteSize;
-  vlsv::datatype::type blockIdDataType;
-  blockIdAttribs.push_back( make_pair("mesh", spatMeshName));
-  blockIdAttribs.push_back( make_pair("name", popName));
-  if (file.getArrayInfo("BLOCKIDS",blockIdAttribs,arraySize,blockIdVectorSize,blockIdDataType,blockIdByteSize) == false ){
-    logFile << "(RESTART) ERROR: Failed to read BLOCKCOORDINATES array info " << endl << write;
-    return false;
-  }
   if(file.getArrayInfo("BLOCKVARIABLE",avgAttribs,arraySize,avgVectorSize,dataType,byteSize) == false ){
     logFile << "(RESTART) ERROR: Failed to read BLOCKVARIABLE array info " << endl << write;
     return false;
@@ -366,21 +764,20 @@ bool _readBlockData(
       logFile << "(RESTART) ERROR: Bad avgs bytesize at " << __FILE__ << " " << __LINE__ << endl << write;
       return false;
    }
-   
-   if( blockIdByteSize != sizeof(vmesh::GlobalID)) {
-      logFile << "(RESTART) ERROR: BlockID data size does not match " << __FILE__ << " " << __LINE__ << endl << write;
-      return false;
-   }
 
+   ReadRanges blockRanges;
+   getReadRanges(localIndices,&blockOffsets,blockRanges);
+   uint64_t localBlocks = 0;
+   for (size_t r=0; r<blockRanges.size(); ++r) localBlocks += blockRanges[r].second;
+   
    fileReal* avgBuffer = new fileReal[avgVectorSize * localBlocks]; //avgs data for all cells
-   vmesh::GlobalID * blockIdBuffer = new vmesh::GlobalID[blockIdVectorSize * localBlocks]; //blockids of all cells
+   vector<vmesh::GlobalID> blockIdBuffer; //blockids of all cells
 
    //Read block ids and data
-   if (file.readArray("BLOCKIDS", blockIdAttribs, localBlockStartOffset, localBlocks, (char*)blockIdBuffer ) == false) {
-      cerr << "ERROR, failed to read BLOCKIDS in " << __FILE__ << ":" << __LINE__ << endl;
+   if (readLocalBlockIds(file,restartDir,spatMeshName,fileCells,localIndices,blockOffsets,mpiGrid,popID,blockIdBuffer) == false) {
       success = false;
    }
-   if (file.readArray("BLOCKVARIABLE", avgAttribs, localBlockStartOffset, localBlocks, (char*)avgBuffer) == false) {
+   if (readRanges(file,"BLOCKVARIABLE",avgAttribs,blockRanges,avgVectorSize*sizeof(fileReal),(char*)avgBuffer) == false) {
       cerr << "ERROR, failed to read BLOCKVARIABLE in " << __FILE__ << ":" << __LINE__ << endl;
       success = false;
    }
@@ -388,12 +785,12 @@ bool _readBlockData(
    uint64_t blockBufferOffset=0;
    //Go through all spatial cells     
    vector<vmesh::GlobalID> blockIdsInCell; //blockIds in a particular cell, temporary usage
-   for(uint64_t i=0; i<localCells; i++) {
-      CellID cell = fileCells[localCellStartOffset + i]; //spatial cell id 
-      vmesh::LocalID nBlocksInCell = blocksPerCell[i];
+   for(size_t i=0; i<localIndices.size() && success; i++) {
+      CellID cell = fileCells[localIndices[i]]; //spatial cell id 
+      vmesh::LocalID nBlocksInCell = blockOffsets[localIndices[i]+1] - blockOffsets[localIndices[i]];
       //copy blocks in this cell to vector blockIdsInCell, size of read in data has been checked earlier
       blockIdsInCell.reserve(nBlocksInCell);
-      blockIdsInCell.assign(blockIdBuffer + blockBufferOffset, blockIdBuffer + blockBufferOffset + nBlocksInCell);
+      blockIdsInCell.assign(blockIdBuffer.begin() + blockBufferOffset, blockIdBuffer.begin() + blockBufferOffset + nBlocksInCell);
       for(auto& id : blockIdsInCell) {
          id = blockIDremapper(id);
       }
@@ -407,7 +804,125 @@ bool _readBlockData(
    }
 
    delete[] avgBuffer;
-   delete[] blockIdBuffer;
+   return success;
+}
+
+/** Read velocity block mesh data and compressed distribution function data belonging to this
+ * process for the given particle species. This function must be called simultaneously by all processes.
+ * @param file VLSV reader with input file open.
+ * @param spatMeshName Name of the spatial mesh.
+ * @param fileCells List of all spatial cell IDs.
+ * @param localIndices Indices of the cells belonging to this process in fileCells, in increasing order.
+ * @param blockOffsets Velocity blocks of file cell i are in elements [blockOffsets[i],blockOffsets[i+1]) of block arrays.
+ * @param mpiGrid Parallel grid library.
+ * @param popID ID of the particle species who's data is to be read.
+ * @param restartDir Directory of the restart file.
+ * @return If true, velocity block data was read successfully.
+ * @sa writeCompressedBlockData in iowrite.cpp.*/
+bool _readCompressedBlockData(
+   vlsv::ParallelReader & file,
+   const std::string& restartDir,
+   const std::string& spatMeshName,
+   const std::vector<uint64_t>& fileCells,
+   const std::vector<uint64_t>& localIndices,
+   const std::vector<uint64_t>& blockOffsets,
+   dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+   std::function<vmesh::GlobalID(vmesh::GlobalID)> blockIDremapper,
+   const uint popID
+) {
+   bool success=true;
+   const string popName = getObjectWrapper().particleSpecies[popID].name;
+
+   list<pair<string,string> > attribs;
+   attribs.push_back(make_pair("mesh",spatMeshName));
+   attribs.push_back(make_pair("name",popName));
+
+   // Size of the values before compression
+   map<string,string> codecAttribs;
+   file.getArrayAttributes(vcodec::ARRAY_NAME,attribs,codecAttribs);
+   if (codecAttribs["original_datatype"] != "float" || atoi(codecAttribs["original_vectorsize"].c_str()) != WID3) {
+      logFile << "(RESTART) ERROR: Unsupported compressed velocity block data in restart file " << endl << write;
+      return false;
+   }
+   const uint32_t fileDataSize = atoi(codecAttribs["original_datasize"].c_str());
+   if (fileDataSize != sizeof(float) && fileDataSize != sizeof(double)) {
+      logFile << "(RESTART) ERROR: Bad compressed avgs bytesize at " << __FILE__ << " " << __LINE__ << endl << write;
+      return false;
+   }
+
+   // Each process reads the compressed streams of its cells, located in the
+   // byte array in the same way as velocity blocks in block arrays
+   vector<uint64_t> byteOffsets;
+   if (readCellOffsets(file,vcodec::BYTES_ARRAY_NAME,attribs,byteOffsets) == false) return false;
+   ReadRanges byteRanges;
+   getReadRanges(localIndices,&byteOffsets,byteRanges);
+   uint64_t byteSum = 0;
+   for (size_t r=0; r<byteRanges.size(); ++r) byteSum += byteRanges[r].second;
+
+   vector<vmesh::GlobalID> blockIdBuffer;
+   vector<unsigned char> byteBuffer(byteSum);
+   if (readLocalBlockIds(file,restartDir,spatMeshName,fileCells,localIndices,blockOffsets,mpiGrid,popID,blockIdBuffer) == false) {
+      success = false;
+   }
+   if (readRanges(file,vcodec::ARRAY_NAME,attribs,byteRanges,1,(char*)byteBuffer.data()) == false) {
+      cerr << "ERROR, failed to read " << vcodec::ARRAY_NAME << " in " << __FILE__ << ":" << __LINE__ << endl;
+      success = false;
+   }
+
+   if (success == false) return false;
+
+   // Create blocks serially, decompression of cells is independent
+   const uint64_t localCells = localIndices.size();
+   vector<uint64_t> streamOffsets(localCells);
+   uint64_t blockBufferOffset = 0;
+   uint64_t byteBufferOffset = 0;
+   vector<vmesh::GlobalID> blockIdsInCell;
+   for (uint64_t i=0; i<localCells; i++) {
+      const CellID cell = fileCells[localIndices[i]];
+      const vmesh::LocalID nBlocksInCell = blockOffsets[localIndices[i]+1] - blockOffsets[localIndices[i]];
+      blockIdsInCell.assign(blockIdBuffer.begin() + blockBufferOffset, blockIdBuffer.begin() + blockBufferOffset + nBlocksInCell);
+      for (auto& id : blockIdsInCell) {
+         id = blockIDremapper(id);
+      }
+      mpiGrid[cell]->add_velocity_blocks(blockIdsInCell,popID);
+      streamOffsets[i] = byteBufferOffset;
+      blockBufferOffset += nBlocksInCell;
+      byteBufferOffset += byteOffsets[localIndices[i]+1] - byteOffsets[localIndices[i]];
+   }
+
+   bool decodeSuccess = true;
+   #pragma omp parallel
+   {
+      vector<char> decoded;
+      #pragma omp for schedule(dynamic,1)
+      for (uint64_t i=0; i<localCells; i++) {
+         const uint64_t index = localIndices[i];
+         const CellID cell = fileCells[index];
+         const uint64_t nValues = (blockOffsets[index+1] - blockOffsets[index])*WID3;
+         const uint64_t cellBytes = byteOffsets[index+1] - byteOffsets[index];
+         Realf* cellBlockData = mpiGrid[cell]->get_data(popID);
+         bool cellSuccess;
+         if (fileDataSize == sizeof(Realf)) {
+            cellSuccess = vcodec::decode(byteBuffer.data() + streamOffsets[i],cellBytes,nValues,fileDataSize,(char*)cellBlockData);
+         } else {
+            // A conversion happens between float and double
+            decoded.resize(nValues*fileDataSize);
+            cellSuccess = vcodec::decode(byteBuffer.data() + streamOffsets[i],cellBytes,nValues,fileDataSize,decoded.data());
+            for (uint64_t j=0; j<nValues; ++j) {
+               if (fileDataSize == sizeof(float)) cellBlockData[j] = reinterpret_cast<const float*>(decoded.data())[j];
+               else cellBlockData[j] = reinterpret_cast<const double*>(decoded.data())[j];
+            }
+         }
+         if (cellSuccess == false) {
+            #pragma omp critical
+            {
+               cerr << "ERROR, failed to decompress velocity block data of cell " << cell << " in " << __FILE__ << ":" << __LINE__ << endl;
+               decodeSuccess = false;
+            }
+         }
+      }
+   }
+   if (decodeSuccess == false) success = false;
    return success;
 }
 
@@ -415,30 +930,26 @@ bool _readBlockData(
  * @param file VLSV reader.
  * @param meshName Name of the spatial mesh.
  * @param fileCells Vector containing spatial cell IDs.
- * @param localCellStartOffset Offset into fileCells, determines where the cells belonging 
- * to this process start.
- * @param localCells Number of spatial cells assigned to this process.
+ * @param localIndices Indices of the cells belonging to this process in fileCells, in increasing order.
  * @param mpiGrid Parallel grid library.
+ * @param restartDir Directory of the restart file, full restarts of differential restarts are searched for here.
  * @return If true, velocity block data was read successfully.*/
 bool readBlockData(
         vlsv::ParallelReader& file,
+        const string& restartDir,
         const string& meshName,
         const vector<CellID>& fileCells,
-        const uint64_t localCellStartOffset,
-        const uint64_t localCells,
+        const vector<uint64_t>& localIndices,
         dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid
    ) {
    bool success = true;
 
    const uint64_t bytesReadStart = file.getBytesRead();
-   int N_processes;
-   MPI_Comm_size(MPI_COMM_WORLD,&N_processes);
 
    uint64_t arraySize;
    uint64_t vectorSize;
    vlsv::datatype::type dataType;
    uint64_t byteSize;
-   uint64_t* offsetArray = new uint64_t[N_processes];
 
    for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
       const string& popName = getObjectWrapper().particleSpecies[popID].name;
@@ -567,78 +1078,60 @@ bool readBlockData(
       }
 
       // In restart files each spatial cell has an entry in CELLSWITHBLOCKS. 
-      // Each process calculates how many velocity blocks it has for this species.
+      // Each process locates the velocity blocks of its cells for this species.
       attribs.clear();
       attribs.push_back(make_pair("mesh",meshName));
       attribs.push_back(make_pair("name",popName));
-      vmesh::LocalID* blocksPerCell = NULL;
-      
-      if (file.read("BLOCKSPERCELL",attribs,localCellStartOffset,localCells,blocksPerCell,true) == false) {
-         logFile << "(RESTART) ERROR: Failed to read BLOCKSPERCELL at " << __FILE__ << ":" << __LINE__ << endl << write;
+      vector<uint64_t> blockOffsets;
+      if (readCellOffsets(file,"BLOCKSPERCELL",attribs,blockOffsets) == false) {
          success = false;
+         continue;
       }
 
-      // Count how many velocity blocks this process gets
-      uint64_t blockSum = 0;
-      for (uint64_t i=0; i<localCells; ++i){
-         blockSum += blocksPerCell[i];
-      }
-      
-      // Gather all block sums to master process who will them broadcast 
-      // the values to everyone
-      MPI_Allgather(&blockSum,1,MPI_Type<uint64_t>(),offsetArray,1,MPI_Type<uint64_t>(),MPI_COMM_WORLD);      
-      
-      // Calculate the offset from which this process starts reading block data
-      uint64_t myOffset = 0;
-      for (int64_t i=0; i<mpiGrid.get_rank(); ++i) myOffset += offsetArray[i];
-      
       if (file.getArrayInfo("BLOCKVARIABLE",attribs,arraySize,vectorSize,dataType,byteSize) == false) {
-         logFile << "(RESTART)  ERROR: Failed to read BLOCKVARIABLE INFO" << endl << write;
-         return false;
+         // Compressed restart files have no BLOCKVARIABLE array
+         if (file.getArrayInfo(vcodec::ARRAY_NAME,attribs,arraySize,vectorSize,dataType,byteSize) == false) {
+            logFile << "(RESTART)  ERROR: Failed to read BLOCKVARIABLE INFO" << endl << write;
+            return false;
+         }
+         if (_readCompressedBlockData(file,restartDir,meshName,fileCells,localIndices,blockOffsets,
+                                      mpiGrid,blockIDremapper,popID) == false) success = false;
+         continue;
       }
 
       // Call _readBlockData
       if (dataType == vlsv::datatype::type::FLOAT) {
          switch (byteSize) {
             case sizeof(double):
-               if (_readBlockData<double>(file,meshName,fileCells,localCellStartOffset,localCells,blocksPerCell,
-                                          myOffset,blockSum,mpiGrid,blockIDremapper,popID) == false) success = false;
+               if (_readBlockData<double>(file,restartDir,meshName,fileCells,localIndices,blockOffsets,mpiGrid,blockIDremapper,popID) == false) success = false;
                break;
             case sizeof(float):
-               if (_readBlockData<float>(file,meshName,fileCells,localCellStartOffset,localCells,blocksPerCell,
-                                         myOffset,blockSum,mpiGrid,blockIDremapper,popID) == false) success = false;
+               if (_readBlockData<float>(file,restartDir,meshName,fileCells,localIndices,blockOffsets,mpiGrid,blockIDremapper,popID) == false) success = false;
                break;
          }
       } else if (dataType == vlsv::datatype::type::UINT) {
          switch (byteSize) {
             case sizeof(uint32_t):
-               if (_readBlockData<uint32_t>(file,meshName,fileCells,localCellStartOffset,localCells,blocksPerCell,
-                                            myOffset,blockSum,mpiGrid,blockIDremapper,popID) == false) success = false;
+               if (_readBlockData<uint32_t>(file,restartDir,meshName,fileCells,localIndices,blockOffsets,mpiGrid,blockIDremapper,popID) == false) success = false;
                break;
             case sizeof(uint64_t):
-               if (_readBlockData<uint64_t>(file,meshName,fileCells,localCellStartOffset,localCells,blocksPerCell,
-                                            myOffset,blockSum,mpiGrid,blockIDremapper,popID) == false) success = false;
+               if (_readBlockData<uint64_t>(file,restartDir,meshName,fileCells,localIndices,blockOffsets,mpiGrid,blockIDremapper,popID) == false) success = false;
                break;
          }
       } else if (dataType == vlsv::datatype::type::INT) {
          switch (byteSize) {
             case sizeof(int32_t):
-               if (_readBlockData<int32_t>(file,meshName,fileCells,localCellStartOffset,localCells,blocksPerCell,
-                                           myOffset,blockSum,mpiGrid,blockIDremapper,popID) == false) success = false;
+               if (_readBlockData<int32_t>(file,restartDir,meshName,fileCells,localIndices,blockOffsets,mpiGrid,blockIDremapper,popID) == false) success = false;
                break;
             case sizeof(int64_t):
-               if (_readBlockData<int64_t>(file,meshName,fileCells,localCellStartOffset,localCells,blocksPerCell,
-                                           myOffset,blockSum,mpiGrid,blockIDremapper,popID) == false) success = false;
+               if (_readBlockData<int64_t>(file,restartDir,meshName,fileCells,localIndices,blockOffsets,mpiGrid,blockIDremapper,popID) == false) success = false;
                break;
          }
       } else {
          logFile << "(RESTART) ERROR: Failed to read data type at readCellParamsVariable" << endl << write;
          success = false;
       }
-      delete [] blocksPerCell; blocksPerCell = NULL;
    } // for-loop over particle species
-
-   delete [] offsetArray; offsetArray = NULL;
    
    const uint64_t bytesReadEnd = file.getBytesRead() - bytesReadStart;
    logFile << "Velocity meshes and data read, approximate data rate is ";
@@ -650,8 +1143,7 @@ bool readBlockData(
 /*! Reads cell parameters from the file and saves them in the right place in mpiGrid
  \param file Some parallel vlsv reader with a file open
  \param fileCells List of all cell ids
- \param localCellStartOffset Offset in the fileCells list for this process ( calculated so that the amount of blocks is distributed somewhat evenly between processes)
- \param localCells The amount of cells to read in this process after localCellStartOffset
+ \param localIndices Indices of the cells of this process in the fileCells list, in increasing order
  \param cellParamsIndex The parameter of the cell index e.g. CellParams::RHOM
  \param expectedVectorSize The amount of elements in the parameter (parameter can be a scalar or a vector of size N)
  \param mpiGrid Vlasiator's grid (the parameters are saved here)
@@ -661,8 +1153,7 @@ template <typename fileReal>
 static bool _readCellParamsVariable(
                                     vlsv::ParallelReader& file,
                                     const vector<uint64_t>& fileCells,
-                                    const uint64_t localCellStartOffset,
-                                    const uint64_t localCells,
+                                    const vector<uint64_t>& localIndices,
                                     const string& variableName,
                                     const size_t cellParamsIndex,
                                     const size_t expectedVectorSize,
@@ -689,14 +1180,17 @@ static bool _readCellParamsVariable(
       return false;
    }
    
-   buffer=new fileReal[vectorSize*localCells];
-   if(file.readArray("VARIABLE",attribs,localCellStartOffset,localCells,(char *)buffer) == false ) {
+   ReadRanges ranges;
+   getReadRanges(localIndices,NULL,ranges);
+   buffer=new fileReal[vectorSize*localIndices.size()];
+   if(readRanges(file,"VARIABLE",attribs,ranges,vectorSize*sizeof(fileReal),(char *)buffer) == false ) {
       logFile << "(RESTART)  ERROR: Failed to read " << variableName << endl << write;
+      delete[] buffer;
       return false;
    }
    
-   for(uint i=0;i<localCells;i++){
-     uint cell=fileCells[localCellStartOffset+i];
+   for(uint i=0;i<localIndices.size();i++){
+     CellID cell=fileCells[localIndices[i]];
      for(uint j=0;j<vectorSize;j++){
         mpiGrid[cell]->parameters[cellParamsIndex+j]=buffer[i*vectorSize+j];
      }
@@ -709,8 +1203,7 @@ static bool _readCellParamsVariable(
 /*! Reads cell parameters from the file and saves them in the right place in mpiGrid
  \param file Some parallel vlsv reader with a file open
  \param fileCells List of all cell ids
- \param localCellStartOffset Offset in the fileCells list for this process ( calculated so that the amount of blocks is distributed somewhat evenly between processes)
- \param localCells The amount of cells to read in this process after localCellStartOffset
+ \param localIndices Indices of the cells of this process in the fileCells list, in increasing order
  \param cellParamsIndex The parameter of the cell index e.g. CellParams::RHOM
  \param expectedVectorSize The amount of elements in the parameter (parameter can be a scalar or a vector of size N)
  \param mpiGrid Vlasiator's grid (the parameters are saved here)
@@ -719,8 +1212,7 @@ static bool _readCellParamsVariable(
 bool readCellParamsVariable(
    vlsv::ParallelReader& file,
    const vector<CellID>& fileCells,
-   const uint64_t localCellStartOffset,
-   const uint64_t localCells,
+   const vector<uint64_t>& localIndices,
    const string& variableName,
    const size_t cellParamsIndex,
    const size_t expectedVectorSize,
@@ -744,29 +1236,29 @@ bool readCellParamsVariable(
    if( dataType == vlsv::datatype::type::FLOAT ) {
       switch (byteSize) {
          case sizeof(double):
-            return _readCellParamsVariable<double>( file, fileCells, localCellStartOffset, localCells, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
+            return _readCellParamsVariable<double>( file, fileCells, localIndices, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
             break;
          case sizeof(float):
-            return _readCellParamsVariable<float>( file, fileCells, localCellStartOffset, localCells, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
+            return _readCellParamsVariable<float>( file, fileCells, localIndices, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
             break;
       }
    } else if( dataType == vlsv::datatype::type::UINT ) {
       switch (byteSize) {
 
          case sizeof(uint32_t):
-            return _readCellParamsVariable<uint32_t>( file, fileCells, localCellStartOffset, localCells, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
+            return _readCellParamsVariable<uint32_t>( file, fileCells, localIndices, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
             break;
          case sizeof(uint64_t):
-            return _readCellParamsVariable<uint64_t>( file, fileCells, localCellStartOffset, localCells, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
+            return _readCellParamsVariable<uint64_t>( file, fileCells, localIndices, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
             break;
       }
    } else if( dataType == vlsv::datatype::type::INT ) {
       switch (byteSize) {
          case sizeof(int32_t):
-            return _readCellParamsVariable<int32_t>( file, fileCells, localCellStartOffset, localCells, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
+            return _readCellParamsVariable<int32_t>( file, fileCells, localIndices, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
             break;
          case sizeof(int64_t):
-            return _readCellParamsVariable<int64_t>( file, fileCells, localCellStartOffset, localCells, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
+            return _readCellParamsVariable<int64_t>( file, fileCells, localIndices, variableName, cellParamsIndex, expectedVectorSize, mpiGrid );
             break;
       }
    } else {
@@ -1103,6 +1595,7 @@ bool exec_readGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    if (success == true) {
       success = readNBlocks(file,meshName,nBlocks,MASTER_RANK,MPI_COMM_WORLD);
    }
+   exitOnError(success,"(RESTART) Failed to read number of velocity blocks",MPI_COMM_WORLD);
 
    //make sure all cells are empty, we will anyway overwrite everything and 
    // in that case moving cells is easier...
@@ -1114,36 +1607,51 @@ bool exec_readGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
         }
      }
 
-   uint64_t totalNumberOfBlocks=0;
-   unsigned int numberOfBlocksPerProcess;
-   for(uint i=0; i<nBlocks.size(); ++i){
-      totalNumberOfBlocks += nBlocks[i];
-   }
-   numberOfBlocksPerProcess= 1 + totalNumberOfBlocks/processes;
-
-   uint64_t localCellStartOffset=0; // This is where local cells start in file-list after migration.
-   uint64_t localCells=0;
-   uint64_t numberOfBlocksCount=0;
-   
-   // Pin local cells to remote processes, we try to balance number of blocks so that 
-   // each process has the same amount of blocks, more or less.
-   for (size_t i=0; i<fileCells.size(); ++i) {
-      numberOfBlocksCount += nBlocks[i];
-      int newCellProcess = numberOfBlocksCount/numberOfBlocksPerProcess;
-      if (newCellProcess == myRank) {
-         if (localCells == 0)
-            localCellStartOffset=i; //here local cells start
-         ++localCells;
+   // Compute the partition used after restart before reading any data, so that each process
+   // reads the data of its own cells and no data is moved afterwards. Cells are weighted with
+   // the load balance weights stored in the file, as in balanceLoad, or with the number of
+   // blocks in files without them. Cells are still empty, so moving them is cheap.
+   unordered_map<CellID,uint64_t> fileIndices;
+   for (uint64_t i=0; i<fileCells.size(); ++i) fileIndices[fileCells[i]] = i;
+
+   Real* fileWeights = NULL;
+   {
+      uint64_t arraySize;
+      uint64_t vectorSize;
+      vlsv::datatype::type dataType;
+      uint64_t byteSize;
+      list<pair<string,string> > attribs;
+      attribs.push_back(make_pair("name","LB_weight"));
+      attribs.push_back(make_pair("mesh",meshName));
+      if (file.getArrayInfo("VARIABLE",attribs,arraySize,vectorSize,dataType,byteSize) == true
+          && arraySize == fileCells.size() && vectorSize == 1) {
+         if (file.read("VARIABLE",attribs,0,arraySize,fileWeights,true) == false) {
+            delete [] fileWeights; fileWeights = NULL;
+         }
       }
-      if (mpiGrid.is_local(fileCells[i])) {
-         mpiGrid.pin(fileCells[i],newCellProcess);
+   }
+   if (fileWeights == NULL) {
+      logFile << "(RESTART) No load balance weights in restart file, partitioning by number of blocks" << endl << writeVerbose;
+   }
+   {
+      const vector<CellID>& gridCells = getLocalCells();
+      for (size_t i=0; i<gridCells.size(); ++i) {
+         unordered_map<CellID,uint64_t>::const_iterator it = fileIndices.find(gridCells[i]);
+         if (it == fileIndices.end()) {
+            success = false;
+            continue;
+         }
+         const Real weight = (fileWeights == NULL) ? nBlocks[it->second] : fileWeights[it->second];
+         mpiGrid.set_cell_weight(gridCells[i],weight);
       }
    }
+   delete [] fileWeights; fileWeights = NULL;
+   exitOnError(success,"(RESTART) Cell not found in restart file",MPI_COMM_WORLD);
 
    SpatialCell::set_mpi_transfer_type(Transfer::ALL_SPATIAL_DATA);
 
-   //Do initial load balance based on pins. Need to transfer at least sysboundaryflags
-   mpiGrid.balance_load(false);
+   //Move empty cells to their final processes. Need to transfer at least sysboundaryflags
+   mpiGrid.balance_load(true);
 
    //update list of local gridcells
    recalculateLocalCellsCache();
@@ -1151,25 +1659,13 @@ bool exec_readGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    //get new list of local gridcells
    const vector<CellID>& gridCells = getLocalCells();
 
-   // Unpin cells, otherwise we will never change this initial bad balance
+   // Indices of local cells in the file, in file order so that consecutive cells are read together
+   vector<uint64_t> localIndices(gridCells.size());
    for (size_t i=0; i<gridCells.size(); ++i) {
-      mpiGrid.unpin(gridCells[i]);
-   }
-
-   // Check for errors, has migration succeeded
-   if (localCells != gridCells.size() ) {
-      success=false;
-   } 
-
-   if (success == true) {
-      for (uint64_t i=localCellStartOffset; i<localCellStartOffset+localCells; ++i) {
-         if(mpiGrid.is_local(fileCells[i]) == false) {
-            success = false;
-         }
-      }
+      localIndices[i] = fileIndices[gridCells[i]];
    }
-
-   exitOnError(success,"(RESTART) Cell migration failed",MPI_COMM_WORLD);
+   sort(localIndices.begin(),localIndices.end());
+   unordered_map<CellID,uint64_t>().swap(fileIndices);
 
    // Set cell coordinates based on cfg (mpigrid) information
    for (size_t i=0; i<gridCells.size(); ++i) {
@@ -1184,33 +1680,30 @@ bool exec_readGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
       mpiGrid[gridCells[i]]->parameters[CellParams::DZ  ] = cell_length[2];
    }
 
-   // Where local data start in the blocklists
-   //uint64_t localBlocks=0;
-   //for(uint64_t i=localCellStartOffset; i<localCellStartOffset+localCells; ++i) {
-   //  localBlocks += nBlocks[i];
-   //}
    phiprof::stop("readDatalayout");
 
    //todo, check file datatype, and do not just use double
    phiprof::start("readCellParameters");
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"moments",CellParams::RHOM,5,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"moments_dt2",CellParams::RHOM_DT2,5,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"moments_r",CellParams::RHOM_R,5,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"moments_v",CellParams::RHOM_V,5,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"pressure",CellParams::P_11,3,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"pressure_dt2",CellParams::P_11_DT2,3,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"pressure_r",CellParams::P_11_R,3,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"pressure_v",CellParams::P_11_V,3,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"LB_weight",CellParams::LBWEIGHTCOUNTER,1,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"max_v_dt",CellParams::MAXVDT,1,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"max_r_dt",CellParams::MAXRDT,1,mpiGrid); }
-   if(success) { success=readCellParamsVariable(file,fileCells,localCellStartOffset,localCells,"max_fields_dt",CellParams::MAXFDT,1,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"moments",CellParams::RHOM,5,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"moments_dt2",CellParams::RHOM_DT2,5,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"moments_r",CellParams::RHOM_R,5,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"moments_v",CellParams::RHOM_V,5,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"pressure",CellParams::P_11,3,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"pressure_dt2",CellParams::P_11_DT2,3,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"pressure_r",CellParams::P_11_R,3,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"pressure_v",CellParams::P_11_V,3,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"LB_weight",CellParams::LBWEIGHTCOUNTER,1,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"max_v_dt",CellParams::MAXVDT,1,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"max_r_dt",CellParams::MAXRDT,1,mpiGrid); }
+   if(success) { success=readCellParamsVariable(file,fileCells,localIndices,"max_fields_dt",CellParams::MAXFDT,1,mpiGrid); }
 // Backround B has to be set, there are also the derivatives that should be written/read if we wanted to only read in background field
    phiprof::stop("readCellParameters");
 
    phiprof::start("readBlockData");
    if (success == true) {
-      success = readBlockData(file,meshName,fileCells,localCellStartOffset,localCells,mpiGrid); 
+      const size_t lastSlash = name.find_last_of('/');
+      const string restartDir = (lastSlash == string::npos) ? string(".") : name.substr(0,lastSlash);
+      success = readBlockData(file,restartDir,meshName,fileCells,localIndices,mpiGrid); 
    }
    phiprof::stop("readBlockData");
 
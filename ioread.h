@@ -25,6 +25,8 @@
 #include <dccrg.hpp>
 #include <dccrg_cartesian_geometry.hpp>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "definitions.h"
 #include "spatial_cell.hpp"
@@ -44,6 +46,21 @@ bool readGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
               const std::string& name);
 
 
+/*! Velocity block ID lists of spatial cells.*/
+typedef std::unordered_map<CellID,std::vector<vmesh::GlobalID> > BlockIdMap;
+
+/*!
+
+\brief Read velocity block ID lists of a full restart file for the local cells, used by differential restarts
+\param fileName Name of the full restart file
+\param popID ID of the particle species
+\param mpiGrid Vlasiator's grid, lists are sent to the processes that currently own the cells
+\param baseBlockIds Block ID lists of local cells that exist in the file
+*/
+bool readBaseBlockIds(const std::string& fileName,const uint popID,
+                      dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                      BlockIdMap& baseBlockIds);
+
 /*!
  * \brief Check in local directory for external commands passed to the simulation. Only executed by MASTER_RANK
  */
@@ -34,14 +34,22 @@
 #include <array>
 #include <algorithm>
 #include <limits>
+#include <deque>
+#include <future>
+#include <memory>
+#include <thread>
+#include <unistd.h>
 
 #include "iowrite.h"
+#include "ioread.h"
 #include "grid.h"
 #include "phiprof.hpp"
 #include "parameters.h"
 #include "logger.h"
 #include "vlasovmover.h"
 #include "object_wrapper.h"
+#include "velocity_block_codec.h"
+#include "memoryallocation.h"
 
 using namespace std;
 using namespace phiprof;
@@ -51,9 +59,103 @@ extern Logger logFile, diagnostic;
 
 typedef Parameters P;
 
+/*! Variable array computed by writeDataReducer, waiting to be written into the file by a background thread.*/
+struct StagedArray {
+   map<string,string> attribs;
+   string dataType;
+   uint64_t arraySize;
+   uint64_t vectorSize;
+   uint64_t dataSize;
+   vector<char> data;
+};
+
+/*! Bulk file whose variable arrays are written by a background thread. Up to
+ * ASYNC_WRITE_BUFFERS files are in flight at a time, each one is written only after
+ * the previous one has been written, see waitForAsyncWrites().*/
+struct AsyncOutputFile {
+   std::unique_ptr<Writer> vlsvWriter;
+   string fileName;
+   vector<StagedArray> arrays;
+   uint64_t stagedBytes;
+   double startTime;
+   bool success;
+   std::promise<void> written;                   /*!< Set by the writer thread when the file has been closed.*/
+   std::shared_future<void> previousWritten;     /*!< Written state of the previous file in flight, if any.*/
+   std::thread writerThread;
+};
+
+/*! Number of files whose variables can be staged for the background writer at the
+ * same time, so that the next file can be staged while the previous one is written.*/
+static const size_t ASYNC_WRITE_BUFFERS = 2;
+
+static std::deque<std::unique_ptr<AsyncOutputFile> > asyncOutputFiles;
+
+/*! Body of the background writer thread. writeArray calls are collective, so all
+ * processes run this for the same files in the same order. Must not use phiprof or
+ * logFile, which are only touched by the main thread.*/
+static void writeStagedArrays(AsyncOutputFile* file) {
+   if (file->previousWritten.valid()) file->previousWritten.wait();
+   for (size_t i=0; i<file->arrays.size(); ++i) {
+      StagedArray& array = file->arrays[i];
+      if (file->vlsvWriter->writeArray("VARIABLE",array.attribs,array.dataType,array.arraySize,
+                                       array.vectorSize,array.dataSize,array.data.data()) == false) {
+         file->success = false;
+      }
+      vector<char>().swap(array.data);
+   }
+   if (file->vlsvWriter->close() == false) file->success = false;
+   file->written.set_value();
+}
+
+/*! Writes the amount of data written and the achieved data rate into logFile.*/
+static void logWriteRate(const uint64_t bytesWritten,const double writeTime) {
+   if (bytesWritten > 1.0e9) logFile << bytesWritten/1.0e9 << " GB in ";
+   else if (bytesWritten > 1e6) logFile << bytesWritten/1.0e6 << " MB in ";
+   else if (bytesWritten > 1e3) logFile << bytesWritten/1.0e3 << " kB in ";
+   else logFile << bytesWritten << " B in ";
+
+   logFile << writeTime << " seconds, approximate data rate is ";
+
+   if (bytesWritten/writeTime > 1e9) logFile << bytesWritten/writeTime/1e9 << " GB/s";
+   else if (bytesWritten/writeTime > 1e6) logFile << bytesWritten/writeTime/1e6 << " MB/s";
+   else if (bytesWritten/writeTime > 1e3) logFile << bytesWritten/writeTime/1e3 << " kB/s";
+   else logFile << bytesWritten/writeTime << " B/s";
+   logFile << endl;
+}
+
+/*! Waits until the oldest file in flight has been written and closed.
+ * \return Returns true if the background write of the file was successful*/
+static bool finishOldestAsyncWrite() {
+   AsyncOutputFile* file = asyncOutputFiles.front().get();
+
+   phiprof::start("waitForAsyncWrites");
+   file->writerThread.join();
+   phiprof::stop("waitForAsyncWrites");
+
+   const bool success = file->success;
+   if (success) {
+      logFile << "(writeGrid) Background write of " << file->fileName << " finished, wrote ";
+      logWriteRate(file->vlsvWriter->getBytesWritten(),file->vlsvWriter->getWriteTime());
+      logFile << "(writeGrid) Time from hand-off to completion " << MPI_Wtime() - file->startTime << " s" << endl;
+   } else {
+      logFile << "(writeGrid) ERROR: background write of " << file->fileName << " failed!" << endl << writeVerbose;
+   }
+   asyncOutputFiles.pop_front();
+   return success;
+}
+
+bool waitForAsyncWrites() {
+   bool success = true;
+   while (asyncOutputFiles.empty() == false) {
+      if (finishOldestAsyncWrite() == false) success = false;
+   }
+   return success;
+}
+
 bool writeVelocityDistributionData(const uint popID,Writer& vlsvWriter,
                                    dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
-                                   const std::vector<CellID>& cells,MPI_Comm comm);
+                                   const std::vector<CellID>& cells,MPI_Comm comm,const bool allowLossy,
+                                   const std::string& restartBase);
 
 /*! Updates local ids across MPI to let other processes know in which order this process saves the local cell ids
  \param mpiGrid Vlasiator's MPI grid
@@ -116,13 +218,248 @@ bool globalSuccess(bool success,string errorMessage,MPI_Comm comm){
  @param mpiGrid Vlasiator's grid.
  @param cells Vector of local cells within this process (no ghost cells).
  @param comm The MPI communicator.
+ @param allowLossy If true, populations configured with the lossy codec are compressed lossily,
+ otherwise they are compressed losslessly. Restart files must not be lossy.
+ @param restartBase If not empty, name of the full restart in the restart directory that velocity block
+ lists are written relative to.
  @return Returns true if operation was successful.*/
 bool writeVelocityDistributionData(Writer& vlsvWriter,
                                    dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
-                                   const vector<CellID>& cells,MPI_Comm comm) {
+                                   const vector<CellID>& cells,MPI_Comm comm,const bool allowLossy,
+                                   const string& restartBase) {
    bool success = true;
    for (size_t p=0; p<getObjectWrapper().particleSpecies.size(); ++p) {
-      if (writeVelocityDistributionData(p,vlsvWriter,mpiGrid,cells,comm) == false) success = false;
+      if (writeVelocityDistributionData(p,vlsvWriter,mpiGrid,cells,comm,allowLossy,restartBase) == false) success = false;
+   }
+   return success;
+}
+
+static vector<BlockIdMap> fullRestartBlockIds; /**< Velocity block lists of local cells in the last full restart, per population.*/
+
+/** Stores the velocity block lists of the local cells written into a full restart,
+ * differential restarts written after it are encoded against these.
+ @param mpiGrid Vlasiator's grid.
+ @param cells Vector of local cells within this process (no ghost cells).*/
+static void storeFullRestartBlockIds(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                                     const std::vector<CellID>& cells) {
+   fullRestartBlockIds.assign(getObjectWrapper().particleSpecies.size(),BlockIdMap());
+   for (uint popID=0; popID<fullRestartBlockIds.size(); ++popID) {
+      for (size_t cell=0; cell<cells.size(); ++cell) {
+         SpatialCell* SC = mpiGrid[cells[cell]];
+         vector<vmesh::GlobalID>& blockIds = fullRestartBlockIds[popID][cells[cell]];
+         blockIds.resize(SC->get_number_of_velocity_blocks(popID));
+         for (vmesh::LocalID block_i=0; block_i<blockIds.size(); ++block_i) {
+            blockIds[block_i] = SC->get_velocity_block_global_id(block_i,popID);
+         }
+      }
+   }
+}
+
+/** Returns the velocity block lists of the local cells in the full restart. The lists stored when
+ * the full restart was written are used if they cover all local cells. Otherwise cells have changed
+ * process since, and the lists are read from the full restart once and stored for later differential restarts.
+ * This function must be called simultaneously by all processes.
+ @param popID ID of the particle species.
+ @param restartBase Name of the full restart in the restart directory.
+ @param mpiGrid Vlasiator's grid.
+ @param cells Vector of local cells within this process (no ghost cells).
+ @return Pointer to the block lists, or NULL if they could not be read.*/
+static const BlockIdMap* getBaseBlockIds(const uint popID,const string& restartBase,
+                                         dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                                         const std::vector<CellID>& cells) {
+   if (fullRestartBlockIds.size() <= popID) fullRestartBlockIds.resize(popID+1);
+   BlockIdMap& baseBlockIds = fullRestartBlockIds[popID];
+   int missing = 0;
+   for (size_t cell=0; cell<cells.size(); ++cell) {
+      if (baseBlockIds.find(cells[cell]) == baseBlockIds.end()) {
+         missing = 1;
+         break;
+      }
+   }
+   MPI_Allreduce(MPI_IN_PLACE,&missing,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+   if (missing == 0) return &baseBlockIds;
+
+   logFile << "(IO): Cells have moved since " << restartBase << " was written, reading its velocity block lists" << endl << writeVerbose;
+   if (readBaseBlockIds(P::restartWritePath + "/" + restartBase,popID,mpiGrid,baseBlockIds) == false) {
+      baseBlockIds.clear();
+      return NULL;
+   }
+   // Cells that are not in the full restart, e.g. created by refinement, have no blocks there
+   for (size_t cell=0; cell<cells.size(); ++cell) baseBlockIds[cells[cell]];
+   return &baseBlockIds;
+}
+
+/** Writes velocity block IDs of specified population relative to the block lists in a full restart.
+ * The block list of each cell is split into segments. A segment either copies consecutive block
+ * IDs of the cell in the full restart, in which case it is stored as (start index, length), or
+ * contains block IDs that are not found there, stored as (INVALID_GLOBALID, length) with the IDs
+ * in BLOCKIDLITERALS. Block lists change slowly, so most cells need a few segments only.
+ * The number of segments and literals of each cell are stored in SEGMENTSPERCELL and LITERALSPERCELL.
+ @param popID ID of the particle species.
+ @param restartBase Name of the full restart in the restart directory.
+ @param vlsvWriter Some vlsv writer with a file open.
+ @param mpiGrid Vlasiator's grid.
+ @param cells Vector of local cells within this process (no ghost cells).
+ @return Returns true if operation was successful.*/
+static bool writeBlockIdSegments(const uint popID,const string& restartBase,Writer& vlsvWriter,
+                                 dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                                 const std::vector<CellID>& cells) {
+   const BlockIdMap* base = getBaseBlockIds(popID,restartBase,mpiGrid,cells);
+   if (base == NULL) return false;
+   const BlockIdMap& baseBlockIds = *base;
+
+   vector<vector<vmesh::GlobalID> > cellSegments(cells.size());
+   vector<vector<vmesh::GlobalID> > cellLiterals(cells.size());
+   #pragma omp parallel
+   {
+      // (block ID, index in base list), sorted by block ID
+      vector<pair<vmesh::GlobalID,vmesh::GlobalID> > sortedBase;
+      #pragma omp for schedule(dynamic,1)
+      for (size_t cell=0; cell<cells.size(); ++cell) {
+         SpatialCell* SC = mpiGrid[cells[cell]];
+         sortedBase.clear();
+         BlockIdMap::const_iterator it = baseBlockIds.find(cells[cell]);
+         if (it != baseBlockIds.end()) {
+            for (size_t b=0; b<it->second.size(); ++b) sortedBase.push_back(make_pair(it->second[b],(vmesh::GlobalID)b));
+            sort(sortedBase.begin(),sortedBase.end());
+         }
+
+         vector<vmesh::GlobalID>& segments = cellSegments[cell];
+         for (vmesh::LocalID block_i=0; block_i<SC->get_number_of_velocity_blocks(popID); ++block_i) {
+            const vmesh::GlobalID blockGID = SC->get_velocity_block_global_id(block_i,popID);
+            vector<pair<vmesh::GlobalID,vmesh::GlobalID> >::const_iterator found
+               = lower_bound(sortedBase.begin(),sortedBase.end(),make_pair(blockGID,(vmesh::GlobalID)0));
+            vmesh::GlobalID start = vmesh::INVALID_GLOBALID;
+            if (found != sortedBase.end() && found->first == blockGID) start = found->second;
+            if (start == vmesh::INVALID_GLOBALID) cellLiterals[cell].push_back(blockGID);
+
+            // Extend the last segment if this block continues it
+            const size_t N = segments.size();
+            if (N > 0 && segments[N-2] == vmesh::INVALID_GLOBALID && start == vmesh::INVALID_GLOBALID) {
+               ++segments[N-1];
+            } else if (N > 0 && segments[N-2] != vmesh::INVALID_GLOBALID && start != vmesh::INVALID_GLOBALID
+                       && segments[N-2] + segments[N-1] == start) {
+               ++segments[N-1];
+            } else {
+               segments.push_back(start);
+               segments.push_back(1);
+            }
+         }
+      }
+   }
+
+   bool success = true;
+   vector<uint64_t> segmentsPerCell(cells.size());
+   vector<uint64_t> literalsPerCell(cells.size());
+   uint64_t totalSegments = 0;
+   uint64_t totalLiterals = 0;
+   uint64_t totalBlocks = 0;
+   for (size_t cell=0; cell<cells.size(); ++cell) {
+      segmentsPerCell[cell] = cellSegments[cell].size()/2;
+      totalSegments += segmentsPerCell[cell];
+      literalsPerCell[cell] = cellLiterals[cell].size();
+      totalLiterals += literalsPerCell[cell];
+      totalBlocks += mpiGrid[cells[cell]]->get_number_of_velocity_blocks(popID);
+   }
+
+   map<string,string> attribs;
+   attribs["mesh"] = "SpatialGrid";
+   attribs["name"] = getObjectWrapper().particleSpecies[popID].name;
+   if (vlsvWriter.writeArray("SEGMENTSPERCELL",attribs,segmentsPerCell.size(),1,segmentsPerCell.data()) == false) success = false;
+   if (vlsvWriter.writeArray("LITERALSPERCELL",attribs,literalsPerCell.size(),1,literalsPerCell.data()) == false) success = false;
+
+   vlsvWriter.startMultiwrite("uint",totalLiterals,1,sizeof(vmesh::GlobalID));
+   for (size_t cell=0; cell<cells.size(); ++cell) {
+      vlsvWriter.addMultiwriteUnit(reinterpret_cast<char*>(cellLiterals[cell].data()),cellLiterals[cell].size());
+   }
+   if (cells.size() == 0) {
+      vlsvWriter.addMultiwriteUnit(NULL, 0); //Dummy write to avoid hang in end multiwrite
+   }
+   if (vlsvWriter.endMultiwrite("BLOCKIDLITERALS",attribs) == false) success = false;
+
+   attribs["base"] = restartBase;
+   vlsvWriter.startMultiwrite("uint",totalSegments,2,sizeof(vmesh::GlobalID));
+   for (size_t cell=0; cell<cells.size(); ++cell) {
+      vlsvWriter.addMultiwriteUnit(reinterpret_cast<char*>(cellSegments[cell].data()),segmentsPerCell[cell]);
+   }
+   if (cells.size() == 0) {
+      vlsvWriter.addMultiwriteUnit(NULL, 0); //Dummy write to avoid hang in end multiwrite
+   }
+   if (vlsvWriter.endMultiwrite("BLOCKIDSEGMENTS",attribs) == false) success = false;
+
+   uint64_t counts[2] = {totalBlocks,2*totalSegments+totalLiterals};
+   uint64_t globalCounts[2];
+   MPI_Allreduce(counts,globalCounts,2,MPI_UINT64_T,MPI_SUM,MPI_COMM_WORLD);
+   logFile << "(IO): Block lists of " << attribs["name"] << " written relative to " << restartBase << ", ";
+   logFile << globalCounts[1] << " IDs instead of " << globalCounts[0] << endl << writeVerbose;
+   return success;
+}
+
+/** Writes the compressed velocity distribution of specified population into the file.
+ * Each cell is compressed into an independent stream. The streams are written into
+ * COMPRESSEDBLOCKVARIABLE and their lengths into COMPRESSEDBYTESPERCELL, in the same
+ * order as CELLSWITHBLOCKS.
+ @param popID ID of the particle species.
+ @param codec Codec used, either vcodec::LOSSLESS or vcodec::LOSSY.
+ @param vlsvWriter Some vlsv writer with a file open.
+ @param mpiGrid Vlasiator's grid.
+ @param cells Vector of local cells within this process (no ghost cells).
+ @return Returns true if operation was successful.*/
+static bool writeCompressedBlockData(const uint popID,const vcodec::Codec codec,Writer& vlsvWriter,
+                                     dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                                     const std::vector<CellID>& cells) {
+   const species::Species& species = getObjectWrapper().particleSpecies[popID];
+   bool success = true;
+
+   // Absolute error of quantization is at most half the step
+   double quantizationStep = 0;
+   if (codec == vcodec::LOSSY) quantizationStep = 2*species.velocityCodecErrorBound*species.sparseMinValue;
+
+   vector<vector<unsigned char> > cellStreams(cells.size());
+   vector<uint64_t> bytesPerCell(cells.size());
+   #pragma omp parallel for schedule(dynamic,1)
+   for (size_t cell=0; cell<cells.size(); ++cell) {
+      SpatialCell* SC = mpiGrid[cells[cell]];
+      const uint64_t nValues = (uint64_t)SC->get_number_of_velocity_blocks(popID)*WID3;
+      vcodec::encode(reinterpret_cast<const char*>(SC->get_data(popID)),nValues,sizeof(Realf),
+                     quantizationStep,cellStreams[cell]);
+      bytesPerCell[cell] = cellStreams[cell].size();
+   }
+
+   uint64_t bytes[2] = {0,0}; // Uncompressed and compressed bytes
+   for (size_t cell=0; cell<cells.size(); ++cell) {
+      bytes[0] += (uint64_t)mpiGrid[cells[cell]]->get_number_of_velocity_blocks(popID)*WID3*sizeof(Realf);
+      bytes[1] += bytesPerCell[cell];
+   }
+
+   map<string,string> attribs;
+   attribs["mesh"] = "SpatialGrid";
+   attribs["name"] = species.name;
+   if (vlsvWriter.writeArray(vcodec::BYTES_ARRAY_NAME,attribs,bytesPerCell.size(),1,bytesPerCell.data()) == false) success = false;
+
+   stringstream ss;
+   ss << setprecision(17) << quantizationStep;
+   attribs["codec"] = vcodec::codecName(codec);
+   attribs["original_datatype"] = "float";
+   attribs["original_datasize"] = to_string(sizeof(Realf));
+   attribs["original_vectorsize"] = to_string(WID3);
+   attribs["quantization_step"] = ss.str();
+
+   vlsvWriter.startMultiwrite("uint",bytes[1],1,1);
+   for (size_t cell=0; cell<cells.size(); ++cell) {
+      vlsvWriter.addMultiwriteUnit(reinterpret_cast<char*>(cellStreams[cell].data()),cellStreams[cell].size());
+   }
+   if (cells.size() == 0) {
+      vlsvWriter.addMultiwriteUnit(NULL, 0); //Dummy write to avoid hang in end multiwrite
+   }
+   if (vlsvWriter.endMultiwrite(vcodec::ARRAY_NAME,attribs) == false) success = false;
+
+   uint64_t globalBytes[2];
+   MPI_Allreduce(bytes,globalBytes,2,MPI_UINT64_T,MPI_SUM,MPI_COMM_WORLD);
+   if (globalBytes[1] > 0) {
+      logFile << "(IO): Velocity distribution of " << species.name << " compressed (" << vcodec::codecName(codec);
+      logFile << ") from " << globalBytes[0] << " to " << globalBytes[1] << " bytes, ratio ";
+      logFile << (double)globalBytes[0]/globalBytes[1] << endl << writeVerbose;
    }
    return success;
 }
@@ -132,10 +469,13 @@ bool writeVelocityDistributionData(Writer& vlsvWriter,
  @param mpiGrid Vlasiator's grid.
  @param cells Vector of local cells within this process (no ghost cells).
  @param comm The MPI communicator.
+ @param allowLossy If false, the lossy codec is replaced with the lossless one.
+ @param restartBase If not empty, name of the full restart that block lists are written relative to.
  @return Returns true if operation was successful.*/
 bool writeVelocityDistributionData(const uint popID,Writer& vlsvWriter,
                                    dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
-                                   const std::vector<CellID>& cells,MPI_Comm comm) {
+                                   const std::vector<CellID>& cells,MPI_Comm comm,const bool allowLossy,
+                                   const std::string& restartBase) {
    // Write velocity blocks and related data. 
    // In restart we just write velocity grids for all cells.
    // First write global Ids of those cells which write velocity blocks (here: all cells):
@@ -217,38 +557,57 @@ bool writeVelocityDistributionData(const uint popID,Writer& vlsvWriter,
       if (vlsvWriter.writeArray("MESH_NODE_CRDS_Z",attribs,0,1,crds) == false) success = false;
    }
 
-   // Write velocity block IDs
-   vector<vmesh::GlobalID> velocityBlockIds;
-   try {
-      velocityBlockIds.reserve( totalBlocks );
-      // gather data for writing
-      for (size_t cell=0; cell<cells.size(); ++cell) {
-         SpatialCell* SC = mpiGrid[cells[cell]];
-         for (vmesh::LocalID block_i=0; block_i<SC->get_number_of_velocity_blocks(popID); ++block_i) {
-            vmesh::GlobalID block = SC->get_velocity_block_global_id(block_i,popID);
-            velocityBlockIds.push_back( block );
+   // Write velocity block IDs, differential restarts write them relative to the full restart
+   if (restartBase.size() > 0) {
+      if (writeBlockIdSegments(popID,restartBase,vlsvWriter,mpiGrid,cells) == false) success = false;
+      if (globalSuccess(success,"(MAIN) writeGrid: ERROR: Failed to write velocity block ID segments",MPI_COMM_WORLD) == false) {
+         vlsvWriter.close();
+         return false;
+      }
+   } else {
+      vector<vmesh::GlobalID> velocityBlockIds;
+      try {
+         velocityBlockIds.reserve( totalBlocks );
+         // gather data for writing
+         for (size_t cell=0; cell<cells.size(); ++cell) {
+            SpatialCell* SC = mpiGrid[cells[cell]];
+            for (vmesh::LocalID block_i=0; block_i<SC->get_number_of_velocity_blocks(popID); ++block_i) {
+               vmesh::GlobalID block = SC->get_velocity_block_global_id(block_i,popID);
+               velocityBlockIds.push_back( block );
+            }
          }
+      } catch (...) {
+         cerr << "FAILED TO WRITE VELOCITY BLOCK IDS AT: " << __FILE__ << " " << __LINE__ << endl;
+         success=false;
       }
-   } catch (...) {
-      cerr << "FAILED TO WRITE VELOCITY BLOCK IDS AT: " << __FILE__ << " " << __LINE__ << endl;
-      success=false;
-   }
 
-   if (globalSuccess(success,"(MAIN) writeGrid: ERROR: Failed to fill temporary array velocityBlockIds",MPI_COMM_WORLD) == false) {
-      vlsvWriter.close();
-      return false;
+      if (globalSuccess(success,"(MAIN) writeGrid: ERROR: Failed to fill temporary array velocityBlockIds",MPI_COMM_WORLD) == false) {
+         vlsvWriter.close();
+         return false;
+      }
+
+      attribs.clear();
+      attribs["mesh"] = spatMeshName;
+      attribs["name"] = popName;
+      if (vlsvWriter.writeArray("BLOCKIDS", attribs, totalBlocks, vectorSize, velocityBlockIds.data()) == false) success = false;
+      if (success == false) logFile << "(MAIN) writeGrid: ERROR failed to write BLOCKIDS to file!" << endl << writeVerbose;
+      {
+         vector<vmesh::GlobalID>().swap(velocityBlockIds);
+      }
    }
 
-   attribs.clear();
-   attribs["mesh"] = spatMeshName;
-   attribs["name"] = popName;
-   if (vlsvWriter.writeArray("BLOCKIDS", attribs, totalBlocks, vectorSize, velocityBlockIds.data()) == false) success = false;
-   if (success == false) logFile << "(MAIN) writeGrid: ERROR failed to write BLOCKIDS to file!" << endl << writeVerbose;
-   {
-      vector<vmesh::GlobalID>().swap(velocityBlockIds);
+   // Write the velocity space data, compressed if so configured
+   vcodec::Codec codec = getObjectWrapper().particleSpecies[popID].velocityCodec;
+   if (codec == vcodec::LOSSY && allowLossy == false) codec = vcodec::LOSSLESS;
+   if (codec != vcodec::NONE) {
+      if (writeCompressedBlockData(popID,codec,vlsvWriter,mpiGrid,cells) == false) success = false;
+      if (globalSuccess(success,"(MAIN) writeGrid: ERROR: Failed to write compressed velocity distribution",MPI_COMM_WORLD) == false) {
+         vlsvWriter.close();
+         return false;
+      }
+      return success;
    }
 
-   // Write the velocity space data
    // set everything that is needed for writing in data such as the array name, size, datatype, etc..
    attribs.clear();
    attribs["mesh"] = spatMeshName; // Name of the spatial mesh
@@ -293,6 +652,122 @@ bool writeVelocityDistributionData(const uint popID,Writer& vlsvWriter,
    return success;
 }
 
+/*! Output of a data reduction operator for all local cells, in the data type that is written into the file.*/
+struct ReducedVariable {
+   uint operatorID;
+   string dataType;
+   uint64_t vectorSize;
+   uint64_t reducedDataSize; /*!< Data size returned by the operator.*/
+   uint64_t dataSize;        /*!< Data size in the file, sizeof(float) if doubles are written as floats.*/
+   bool success;             /*!< False if reduceData failed for some cell, e.g. for fsgrid operators.*/
+   vector<char> data;
+};
+
+/*! Reduces the data of the given operators for all cells. Thread-safe operators are evaluated
+ together in one OpenMP parallel pass over the cells, the others serially one operator at a time,
+ as some of them are threaded within. Doubles written as floats are converted per cell, so no
+ full size double buffer is needed for them.
+ \param mpiGrid The Vlasiator's grid
+ \param cells List of local cells (no ghost cells included)
+ \param dataReducer The data reducer which contains the operators
+ \param writeAsFloat If true, double variables are converted to float
+ \param variables Variables to reduce, operatorID has to be set by the caller
+ \return Returns false if memory allocation failed
+ */
+static bool reduceVariables(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                            const vector<CellID>& cells,DataReducer& dataReducer,const bool writeAsFloat,
+                            vector<ReducedVariable>& variables) {
+   vector<const SpatialCell*> cellPointers(cells.size());
+   for (size_t c=0; c<cells.size(); ++c) cellPointers[c] = mpiGrid[cells[c]];
+
+   vector<size_t> threadSafe;
+   vector<size_t> serial;
+   uint64_t maxReducedBytes = 0;
+   try {
+      for (size_t v=0; v<variables.size(); ++v) {
+         ReducedVariable& variable = variables[v];
+         uint dataSize,vectorSize;
+         dataReducer.getDataVectorInfo(variable.operatorID,variable.dataType,dataSize,vectorSize);
+         variable.vectorSize = vectorSize;
+         variable.reducedDataSize = dataSize;
+         variable.dataSize = dataSize;
+         if (writeAsFloat == true && variable.dataType.compare("float") == 0 && dataSize == sizeof(double)) {
+            variable.dataSize = sizeof(float);
+         }
+         variable.success = true;
+         variable.data.resize(cells.size()*variable.vectorSize*variable.dataSize);
+         maxReducedBytes = max(maxReducedBytes,variable.vectorSize*variable.reducedDataSize);
+         if (dataReducer.isThreadSafe(variable.operatorID)) threadSafe.push_back(v);
+         else serial.push_back(v);
+      }
+   } catch( bad_alloc& ) {
+      cerr << "ERROR, FAILED TO ALLOCATE MEMORY AT: " << __FILE__ << " " << __LINE__ << endl;
+      logFile << "(MAIN) writeGrid: ERROR FAILED TO ALLOCATE MEMORY AT: " << __FILE__ << " " << __LINE__ << endl << writeVerbose;
+      return false;
+   }
+
+   // Reduces the data of one variable in one cell, converting doubles to floats via scratch if needed
+   auto reduceCell = [&](ReducedVariable& variable,const size_t c,vector<char>& scratch) -> bool {
+      char* output = variable.data.data() + c*variable.vectorSize*variable.dataSize;
+      if (variable.dataSize == variable.reducedDataSize) {
+         return dataReducer.reduceData(cellPointers[c],variable.operatorID,output);
+      }
+      if (dataReducer.reduceData(cellPointers[c],variable.operatorID,scratch.data()) == false) return false;
+      const double* reduced = reinterpret_cast<const double*>(scratch.data());
+      float* converted = reinterpret_cast<float*>(output);
+      for (uint64_t i=0; i<variable.vectorSize; ++i) converted[i] = (float)reduced[i];
+      return true;
+   };
+
+   if (threadSafe.size() > 0) {
+      #pragma omp parallel
+      {
+         vector<char> scratch(maxReducedBytes);
+         vector<char> failed(threadSafe.size(),0);
+         #pragma omp for schedule(dynamic,64)
+         for (size_t c=0; c<cells.size(); ++c) {
+            for (size_t t=0; t<threadSafe.size(); ++t) {
+               if (reduceCell(variables[threadSafe[t]],c,scratch) == false) failed[t] = 1;
+            }
+         }
+         #pragma omp critical
+         {
+            for (size_t t=0; t<threadSafe.size(); ++t) {
+               if (failed[t] != 0) variables[threadSafe[t]].success = false;
+            }
+         }
+      }
+   }
+
+   vector<char> scratch(maxReducedBytes);
+   for (size_t s=0; s<serial.size(); ++s) {
+      ReducedVariable& variable = variables[serial[s]];
+      for (size_t c=0; c<cells.size(); ++c) {
+         // Note that this is not an error (anymore), since fsgrid reducers will return false here.
+         if (reduceCell(variable,c,scratch) == false) variable.success = false;
+      }
+   }
+   return true;
+}
+
+/*! Writes a variable array into the file, or moves it into stagedArrays if the file is written in the background.*/
+static bool writeOrStageArray(Writer& vlsvWriter,vector<StagedArray>* stagedArrays,const map<string,string>& attribs,
+                              const string& dataType,const uint64_t arraySize,const uint64_t vectorSize,
+                              const uint64_t dataSize,vector<char>& data) {
+   if (stagedArrays == NULL) {
+      return vlsvWriter.writeArray("VARIABLE",attribs,dataType,arraySize,vectorSize,dataSize,data.data());
+   }
+   stagedArrays->push_back(StagedArray());
+   StagedArray& array = stagedArrays->back();
+   array.attribs = attribs;
+   array.dataType = dataType;
+   array.arraySize = arraySize;
+   array.vectorSize = vectorSize;
+   array.dataSize = dataSize;
+   array.data.swap(data);
+   return true;
+}
+
 /*! Writes info received from data reducer. This function writes out the variable arrays into the file
  \param mpiGrid The Vlasiator's grid
  \param cells List of local cells (no ghost cells included)
@@ -300,6 +775,8 @@ bool writeVelocityDistributionData(const uint popID,Writer& vlsvWriter,
  \param dataReducer The data reducer which contains the necessary functions for calculating variables
  \param dataReducerIndex Index in the data reducer (determines which variable to read) Note: size of the data reducer can be retrieved with dataReducer.size()
  \param vlsvWriter Some vlsv writer with a file open
+ \param stagedArrays If not NULL, buffered variable arrays are moved here to be written later by a background thread instead of being written into vlsvWriter
+ \param reducedVariable If not NULL, the data of this operator already reduced with reduceVariables, its buffer is released here
  \return Returns true if operation was successful
  */
 bool writeDataReducer(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
@@ -317,7 +794,9 @@ bool writeDataReducer(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
                       const bool writeAsFloat,
                       DataReducer& dataReducer,
                       int dataReducerIndex,
-                      Writer& vlsvWriter){
+                      Writer& vlsvWriter,
+                      vector<StagedArray>* stagedArrays=NULL,
+                      ReducedVariable* reducedVariable=NULL){
    map<string,string> attribs;
    string variableName,dataType,unitString,unitStringLaTeX, variableStringLaTeX, unitConversionFactor;
    bool success=true;
@@ -361,72 +840,27 @@ bool writeDataReducer(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
       return true;
    }
 
-   const uint64_t varBufferArraySize = cells.size()*vectorSize*dataSize;
-   
-   //Request DataReductionOperator to calculate the reduced data for all local cells:
-   char* varBuffer = NULL;
-   try {
-      varBuffer = new char[varBufferArraySize];
-   } catch( bad_alloc& ) {
-      cerr << "ERROR, FAILED TO ALLOCATE MEMORY AT: " << __FILE__ << " " << __LINE__ << endl;
-      logFile << "(MAIN) writeGrid: ERROR FAILED TO ALLOCATE MEMORY AT: " << __FILE__ << " " << __LINE__ << endl << writeVerbose;
-      phiprof::stop("DRO_"+variableName);
-      return false;
+   //Request DataReductionOperator to calculate the reduced data for all local cells, unless already done:
+   vector<ReducedVariable> localVariable;
+   if (reducedVariable == NULL) {
+      localVariable.resize(1);
+      localVariable[0].operatorID = dataReducerIndex;
+      if (reduceVariables(mpiGrid,cells,dataReducer,writeAsFloat,localVariable) == false) {
+         phiprof::stop("DRO_"+variableName);
+         return false;
+      }
+      reducedVariable = &localVariable[0];
    }
 
-   for (size_t cell=0; cell<cells.size(); ++cell) {
-      //Reduce data ( return false if the operation fails )
-      if (dataReducer.reduceData(mpiGrid[cells[cell]],dataReducerIndex,varBuffer + cell*vectorSize*dataSize) == false){
+   if (reducedVariable->success) {
+      // Write reduced data to file if DROP was successful:
+      phiprof::start("writeArray");
+      if (writeOrStageArray(vlsvWriter, stagedArrays, attribs, reducedVariable->dataType, cells.size(),
+                            reducedVariable->vectorSize, reducedVariable->dataSize, reducedVariable->data) == false) {
          success = false;
-         // Note that this is not an error (anymore), since fsgrid reducers will return false here.
-      }
-   }
-   if( success ) {
-
-      if( (writeAsFloat == true && dataType.compare("float") == 0) && dataSize == sizeof(double) ) {
-         double * varBuffer_double = reinterpret_cast<double*>(varBuffer);
-         //Declare smaller varbuffer:
-         const uint64_t arraySize_smaller = cells.size();
-         const uint32_t vectorSize_smaller = vectorSize;
-         const uint32_t dataSize_smaller = sizeof(float);
-         const string dataType_smaller = dataType;
-         float * varBuffer_smaller = NULL;
-         try {
-            varBuffer_smaller = new float[arraySize_smaller * vectorSize_smaller];
-         } catch( bad_alloc& ) {
-            cerr << "ERROR, FAILED TO ALLOCATE MEMORY AT: " << __FILE__ << " " << __LINE__ << endl;
-            logFile << "(MAIN) writeGrid: ERROR FAILED TO ALLOCATE MEMORY AT: " << __FILE__ << " " << __LINE__ << endl << writeVerbose;
-            delete[] varBuffer;
-            varBuffer = NULL;
-            phiprof::stop("DRO_"+variableName);
-            return false;
-         }
-         //Input varBuffer_double into varBuffer_smaller:
-         for( uint64_t i = 0; i < arraySize_smaller * vectorSize_smaller; ++i ) {
-            const double value = varBuffer_double[i];
-            varBuffer_smaller[i] = (float)(value);
-         }
-         //Cast the varBuffer to char:
-         char * varBuffer_smaller_char = reinterpret_cast<char*>(varBuffer_smaller);
-         //Write the array:
-         phiprof::start("writeArray");
-         if (vlsvWriter.writeArray("VARIABLE", attribs, dataType_smaller, arraySize_smaller, vectorSize_smaller, dataSize_smaller, varBuffer_smaller_char) == false) {
-            success = false;
-            logFile << "(MAIN) writeGrid: ERROR failed to write datareductionoperator data to file!" << endl << writeVerbose;
-         }
-         phiprof::stop("writeArray");
-         delete[] varBuffer_smaller;
-         varBuffer_smaller = NULL;
-      } else {
-         // Write  reduced data to file if DROP was successful:
-         phiprof::start("writeArray");
-         if (vlsvWriter.writeArray("VARIABLE",attribs, dataType, cells.size(), vectorSize, dataSize, varBuffer) == false) {
-            success = false;
-            logFile << "(MAIN) writeGrid: ERROR failed to write datareductionoperator data to file!" << endl << writeVerbose;
-         }
-         phiprof::stop("writeArray");
+         logFile << "(MAIN) writeGrid: ERROR failed to write datareductionoperator data to file!" << endl << writeVerbose;
       }
-
+      phiprof::stop("writeArray");
    } else {
       // If the data reducer didn't want to write dccrg data, maybe it will be happy
       // dumping data straight from fsgrid into our file.
@@ -440,8 +874,7 @@ bool writeDataReducer(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
       success = dataReducer.writeParameters(dataReducerIndex,vlsvWriter);
    }
 
-   delete[] varBuffer;
-   varBuffer = NULL;
+   vector<char>().swap(reducedVariable->data);
    phiprof::stop("DRO_"+variableName);
    return success;
 }
@@ -1020,7 +1453,7 @@ bool writeVelocitySpace(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpi
       localNumVelSpaceCells=velSpaceCells.size();
       MPI_Allreduce(&localNumVelSpaceCells,&numVelSpaceCells,1,MPI_UINT64_T,MPI_SUM,MPI_COMM_WORLD);
       //write out velocity space data NOTE: There is mpi communication in writeVelocityDistributionData
-      if (writeVelocityDistributionData(vlsvWriter, mpiGrid, velSpaceCells, MPI_COMM_WORLD ) == false ) {
+      if (writeVelocityDistributionData(vlsvWriter, mpiGrid, velSpaceCells, MPI_COMM_WORLD, true) == false ) {
          cerr << "ERROR, FAILED TO WRITE VELOCITY DISTRIBUTION DATA AT " << __FILE__ << " " << __LINE__ << endl;
          logFile << "(MAIN) writeGrid: ERROR FAILED TO WRITE VELOCITY DISTRIBUTION DATA AT: " << __FILE__ << " " << __LINE__ << endl << writeVerbose;
       }
@@ -1087,6 +1520,8 @@ bool writeGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
 
    MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
    phiprof::start("writeGrid-reduced");
+   // Make room for the write buffers
+   block_pool::releaseCachedMemory();
    // Create a name for the output file and open it with VLSVWriter:
    stringstream fname;
    fname << P::systemWritePath.at(index) << "/" << P::systemWriteName.at(index) << ".";
@@ -1095,8 +1530,10 @@ bool writeGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    fname << P::systemWrites.at(index) << ".vlsv";
 
 
-   //Open the file with vlsvWriter:
-   Writer vlsvWriter;
+   //Open the file with vlsvWriter. The writer is heap allocated, as with
+   //io.async_write it is handed over to the background writer thread:
+   std::unique_ptr<Writer> vlsvWriterPtr(new Writer());
+   Writer& vlsvWriter = *vlsvWriterPtr;
    const int masterProcessId = 0;
 
    MPI_Info MPIinfo;
@@ -1191,17 +1628,100 @@ bool writeGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    phiprof::stop("velocityspaceIO");
 
    phiprof::start("reduceddataIO");
+   //Decide whether the variable arrays are written in the background. This requires
+   //MPI_THREAD_MULTIPLE and that the staged arrays fit into io.async_staging_memory.
+   //The decision is collective as writeArray calls are collective.
+   vector<StagedArray>* stagedArrays = NULL;
+   vector<StagedArray> stagedArrayStorage;
+   uint64_t stagedBytes = 0;
+   if (P::asyncWrite == true && dataReducer != NULL) {
+      int threadLevel;
+      MPI_Query_thread(&threadLevel);
+      for (uint i = 0; i < dataReducer->size(); ++i) {
+         string dataType;
+         uint dataSize,vectorSize;
+         if (dataReducer->handlesWriting(i) == true) continue;
+         if (dataReducer->getDataVectorInfo(i,dataType,dataSize,vectorSize) == false) continue;
+         if (P::writeAsFloat == 1 && dataType.compare("float") == 0 && dataSize == sizeof(double)) dataSize = sizeof(float);
+         stagedBytes += local_cells.size()*vectorSize*dataSize;
+      }
+      // If the files still in flight do not leave room for this one, finish the oldest ones first
+      uint64_t inFlightBytes = 0;
+      for (size_t f=0; f<asyncOutputFiles.size(); ++f) inFlightBytes += asyncOutputFiles[f]->stagedBytes;
+      while (asyncOutputFiles.empty() == false && stagedBytes + inFlightBytes > P::asyncWriteStagingMemory) {
+         inFlightBytes -= asyncOutputFiles.front()->stagedBytes;
+         finishOldestAsyncWrite();
+      }
+      const int canStage = (threadLevel >= MPI_THREAD_MULTIPLE && stagedBytes <= P::asyncWriteStagingMemory) ? 1 : 0;
+      int allCanStage;
+      MPI_Allreduce(&canStage,&allCanStage,1,MPI_INT,MPI_MIN,MPI_COMM_WORLD);
+      if (allCanStage == 1) {
+         stagedArrays = &stagedArrayStorage;
+      } else if (threadLevel < MPI_THREAD_MULTIPLE) {
+         logFile << "(writeGrid) WARNING: io.async_write requires MPI_THREAD_MULTIPLE, writing synchronously" << endl << writeVerbose;
+      } else {
+         logFile << "(writeGrid) io.async_staging_memory exceeded, writing " << fname.str() << " synchronously" << endl << writeVerbose;
+      }
+   }
+
+   //Reduce all thread-safe buffered variables together in one threaded pass over the cells,
+   //the rest are reduced one at a time in writeDataReducer:
+   vector<ReducedVariable> batchedVariables;
+   vector<int> batchIndex;
+   if (dataReducer != NULL) {
+      phiprof::start("reduceVariables");
+      batchIndex.assign(dataReducer->size(),-1);
+      for (uint i = 0; i < dataReducer->size(); ++i) {
+         string dataType;
+         uint dataSize,vectorSize;
+         if (dataReducer->handlesWriting(i) == true || dataReducer->isThreadSafe(i) == false) continue;
+         if (dataReducer->getDataVectorInfo(i,dataType,dataSize,vectorSize) == false || vectorSize == 0) continue;
+         batchIndex[i] = batchedVariables.size();
+         batchedVariables.push_back(ReducedVariable());
+         batchedVariables.back().operatorID = i;
+      }
+      const bool reduced = reduceVariables(mpiGrid,local_cells,*dataReducer,(P::writeAsFloat==1),batchedVariables);
+      phiprof::stop("reduceVariables");
+      if (reduced == false) return false;
+   }
+
    //Write necessary variables:
    //Determines whether we write in floats or doubles
    phiprof::start("writeDataReducer");
    if (dataReducer != NULL) for( uint i = 0; i < dataReducer->size(); ++i ) {
+      ReducedVariable* reducedVariable = (batchIndex[i] >= 0) ? &batchedVariables[batchIndex[i]] : NULL;
       if( writeDataReducer( mpiGrid, local_cells,
                perBGrid, EGrid, EHallGrid, EGradPeGrid, momentsGrid, dPerBGrid, dMomentsGrid,
                BgBGrid, volGrid, technicalGrid,
-               (P::writeAsFloat==1), *dataReducer, i, vlsvWriter ) == false ) return false;
+               (P::writeAsFloat==1), *dataReducer, i, vlsvWriter, stagedArrays, reducedVariable ) == false ) return false;
    }
    phiprof::stop("writeDataReducer");
-   
+
+   if (stagedArrays != NULL) {
+      // With all buffers in flight, the oldest file is finished before handing over this one
+      while (asyncOutputFiles.size() >= ASYNC_WRITE_BUFFERS) {
+         finishOldestAsyncWrite();
+      }
+      const uint64_t bytesWritten = vlsvWriter.getBytesWritten();
+      std::unique_ptr<AsyncOutputFile> file(new AsyncOutputFile());
+      file->vlsvWriter = std::move(vlsvWriterPtr);
+      file->fileName = fname.str();
+      file->arrays.swap(stagedArrayStorage);
+      file->stagedBytes = stagedBytes;
+      file->startTime = MPI_Wtime();
+      file->success = true;
+      if (asyncOutputFiles.empty() == false) {
+         file->previousWritten = asyncOutputFiles.back()->written.get_future().share();
+      }
+      file->writerThread = std::thread(writeStagedArrays,file.get());
+      asyncOutputFiles.push_back(std::move(file));
+      logFile << "(writeGrid) Handed " << stagedBytes/1.0e6 << " MB of variables in " << fname.str()
+              << " to the background writer" << endl << writeVerbose;
+      phiprof::stop("reduceddataIO");
+      phiprof::stop("writeGrid-reduced",bytesWritten*1e-9,"GB");
+      return success;
+   }
+
    phiprof::initializeTimer("Barrier","MPI","Barrier");
    phiprof::start("Barrier");
    MPI_Barrier(MPI_COMM_WORLD);
@@ -1210,19 +1730,7 @@ bool writeGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    const uint64_t bytesWritten = vlsvWriter.getBytesWritten();
    const double writeTime = vlsvWriter.getWriteTime();
    logFile << "(writeGrid) Wrote ";
-
-   if (bytesWritten > 1.0e9) logFile << bytesWritten/1.0e9 << " GB in ";
-   else if (bytesWritten > 1e6) logFile << bytesWritten/1.0e6 << " MB in ";
-   else if (bytesWritten > 1e3) logFile << bytesWritten/1.0e3 << " kB in ";
-   else logFile << bytesWritten << " B in ";
-
-   logFile << writeTime << " seconds, approximate data rate is ";
-
-   if (bytesWritten/writeTime > 1e9) logFile << bytesWritten/writeTime/1e9 << " GB/s";
-   else if (bytesWritten/writeTime > 1e6) logFile << bytesWritten/writeTime/1e6 << " MB/s";
-   else if (bytesWritten/writeTime > 1e3) logFile << bytesWritten/writeTime/1e3 << " kB/s";
-   else logFile << bytesWritten/writeTime << " B/s";
-   logFile << endl;
+   logWriteRate(bytesWritten,writeTime);
 
    phiprof::stop("reduceddataIO");
 
@@ -1233,10 +1741,17 @@ bool writeGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    return success;
 }
 
+static string fullRestartName;          /**< Name of the last full restart in the restart directory.*/
+static uint restartsSinceFull = 0;      /**< Number of differential restarts written since fullRestartName.*/
+
 /*!
 
 \brief Write out a restart of the simulation into a vlsv file. All block data in remote cells will be reset.
 
+If io.restart_full_interval is larger than one, only every io.restart_full_interval:th restart is
+a full one. The others store the velocity block lists relative to the last full restart, which has
+to be kept in the same directory.
+
 \param mpiGrid   The DCCRG grid with spatial cells
 \param dataReducer Contains datareductionoperators that are used to compute data that is added into file
 \param name       File name prefix, file will be called "name.index.vlsv"
@@ -1272,6 +1787,7 @@ bool writeRestart(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    phiprof::start("DeallocateRemoteBlocks");
    //deallocate blocks in remote cells to decrease memory load
    deallocateRemoteCellBlocks(mpiGrid);
+   block_pool::releaseCachedMemory();
    phiprof::stop("DeallocateRemoteBlocks");
    
    // Get the current time.
@@ -1285,11 +1801,28 @@ bool writeRestart(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    MPI_Bcast(&currentDate,80,MPI_CHAR,MASTER_RANK,MPI_COMM_WORLD);
    
    // Create a name for the output file and open it with VLSVWriter:
+   stringstream restartName;
+   restartName << name << ".";
+   restartName.width(7);
+   restartName.fill('0');
+   restartName << fileIndex << "." << currentDate << ".vlsv";
    stringstream fname;
-   fname << P::restartWritePath << "/" << name << ".";
-   fname.width(7);
-   fname.fill('0');
-   fname << fileIndex << "." << currentDate << ".vlsv";
+   fname << P::restartWritePath << "/" << restartName.str();
+
+   // Write a differential restart if the full restart it refers to still exists
+   string restartBase;
+   if (P::restartFullInterval > 1 && fullRestartName.size() > 0 && restartsSinceFull+1 < P::restartFullInterval) {
+      int baseExists = 0;
+      if (myRank == MASTER_RANK) {
+         baseExists = (access((P::restartWritePath + "/" + fullRestartName).c_str(), R_OK) == 0);
+      }
+      MPI_Bcast(&baseExists,1,MPI_INT,MASTER_RANK,MPI_COMM_WORLD);
+      if (baseExists == 1) {
+         restartBase = fullRestartName;
+      } else {
+         logFile << "(IO): Full restart " << fullRestartName << " not found, writing a full restart" << endl << writeVerbose;
+      }
+   }
 
    phiprof::start("open");
    //Open the file with vlsvWriter:
@@ -1437,7 +1970,7 @@ bool writeRestart(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    // Note: restart should always write double values to ensure the accuracy of the restart runs. 
    // In case of distribution data it is not as important as they are mainly used for visualization purpose
    phiprof::start("velocityspaceIO");
-   writeVelocityDistributionData(vlsvWriter, mpiGrid, local_cells, MPI_COMM_WORLD);
+   if (writeVelocityDistributionData(vlsvWriter, mpiGrid, local_cells, MPI_COMM_WORLD, false, restartBase) == false) success = false;
    phiprof::stop("velocityspaceIO");
 
    phiprof::start("close");
@@ -1467,6 +2000,22 @@ bool writeRestart(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
    else if (bytesWritten/writeTime > 1e3) logFile << bytesWritten/writeTime/1e3 << " kB/s";
    else logFile << bytesWritten/writeTime << " B/s";
    logFile << endl;
+
+   // All processes must agree on the base of the next restart, as it selects
+   // which collective arrays are written, so only a restart written
+   // successfully by all processes is counted
+   int localSuccess = success ? 1 : 0;
+   int globalSuccess;
+   MPI_Allreduce(&localSuccess,&globalSuccess,1,MPI_INT,MPI_LAND,MPI_COMM_WORLD);
+   if (globalSuccess == 1) {
+      if (restartBase.size() > 0) {
+         ++restartsSinceFull;
+      } else {
+         fullRestartName = restartName.str();
+         restartsSinceFull = 0;
+         if (P::restartFullInterval > 1) storeFullRestartBlockIds(mpiGrid,local_cells);
+      }
+   }
    
    phiprof::stop("writeRestart",bytesWritten*1e-9,"GB");
    return success;
@@ -1562,3 +2111,242 @@ bool writeDiagnostic(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
    return true;
 }
 
+
+/*! A plane, line segment or point of the cut output.*/
+struct Cut {
+   map<string,string> attribs; /*!< Mesh name and geometry of the cut in output files.*/
+   array<Real,3> start;        /*!< Start point of a line, the point, or a point on a plane.*/
+   array<Real,3> end;          /*!< End point of a line, equal to start otherwise.*/
+   int normal;                 /*!< Normal direction of a plane, -1 for lines and points.*/
+};
+
+/*! Processes sending their cut output data to the same writer process, the writer has rank 0.*/
+static MPI_Comm cutGroupComm = MPI_COMM_NULL;
+/*! Writer processes of the cut output, MPI_COMM_NULL on other processes.*/
+static MPI_Comm cutWriterComm = MPI_COMM_NULL;
+/*! Local cells intersecting each cut, valid for P::meshRepartitionEpoch cutCellsEpoch.*/
+static vector<vector<CellID> > cutCells;
+static uint cutCellsEpoch = numeric_limits<uint>::max();
+
+/*! Cuts configured with the io.cut_* parameters, planes first, then lines and points.*/
+static vector<Cut> getCuts() {
+   vector<Cut> cuts;
+   const string directions = "xyz";
+   for (size_t i=0; i<P::cutPlaneNormal.size(); ++i) {
+      Cut cut;
+      cut.normal = directions.find(P::cutPlaneNormal[i]);
+      cut.start.fill(0.0);
+      cut.start[cut.normal] = P::cutPlanePosition[i];
+      cut.end = cut.start;
+      cut.attribs["mesh"] = "plane" + to_string(i);
+      cut.attribs["normal"] = P::cutPlaneNormal[i];
+      cut.attribs["position"] = to_string(P::cutPlanePosition[i]);
+      cuts.push_back(cut);
+   }
+   for (size_t i=0; i<P::cutLineStart[0].size(); ++i) {
+      Cut cut;
+      cut.normal = -1;
+      for (int d=0; d<3; ++d) {
+         cut.start[d] = P::cutLineStart[d][i];
+         cut.end[d] = P::cutLineEnd[d][i];
+      }
+      cut.attribs["mesh"] = "line" + to_string(i);
+      cut.attribs["start"] = to_string(cut.start[0]) + " " + to_string(cut.start[1]) + " " + to_string(cut.start[2]);
+      cut.attribs["end"] = to_string(cut.end[0]) + " " + to_string(cut.end[1]) + " " + to_string(cut.end[2]);
+      cuts.push_back(cut);
+   }
+   for (size_t i=0; i<P::cutPoint[0].size(); ++i) {
+      Cut cut;
+      cut.normal = -1;
+      for (int d=0; d<3; ++d) cut.start[d] = P::cutPoint[d][i];
+      cut.end = cut.start;
+      cut.attribs["mesh"] = "point" + to_string(i);
+      cut.attribs["point"] = to_string(cut.start[0]) + " " + to_string(cut.start[1]) + " " + to_string(cut.start[2]);
+      cuts.push_back(cut);
+   }
+   return cuts;
+}
+
+/*! Check if a cut intersects a spatial cell. Cells are taken half-open, so that a
+ * point or a plane at a cell face belongs to one cell only.*/
+static bool cutIntersectsCell(const Cut& cut,const array<double,3>& cellMin,const array<double,3>& cellLength) {
+   if (cut.normal >= 0) {
+      const int d = cut.normal;
+      return cut.start[d] >= cellMin[d] && cut.start[d] < cellMin[d] + cellLength[d];
+   }
+   // Clip the segment start + s*(end-start), 0 <= s <= 1, to the cell
+   Real sMin = 0.0;
+   Real sMax = 1.0;
+   for (int d=0; d<3; ++d) {
+      const Real direction = cut.end[d] - cut.start[d];
+      if (direction == 0.0) {
+         if (cut.start[d] < cellMin[d] || cut.start[d] >= cellMin[d] + cellLength[d]) return false;
+         continue;
+      }
+      Real s0 = (cellMin[d] - cut.start[d]) / direction;
+      Real s1 = (cellMin[d] + cellLength[d] - cut.start[d]) / direction;
+      if (s0 > s1) swap(s0,s1);
+      sMin = max(sMin,s0);
+      sMax = min(sMax,s1);
+   }
+   return sMin < sMax;
+}
+
+/*! Gather data of all processes in a cut output group to the group's writer process.
+ \param data Data of this process
+ \param gathered Data of the group in rank order, only on the writer process
+ */
+static void gatherCutData(const vector<char>& data,vector<char>& gathered) {
+   int groupRank,groupSize;
+   MPI_Comm_rank(cutGroupComm,&groupRank);
+   MPI_Comm_size(cutGroupComm,&groupSize);
+   int bytes = data.size();
+   vector<int> counts(groupSize),offsets(groupSize);
+   MPI_Gather(&bytes,1,MPI_INT,counts.data(),1,MPI_INT,0,cutGroupComm);
+   int total = 0;
+   for (int p=0; p<groupSize && groupRank == 0; ++p) {
+      offsets[p] = total;
+      total += counts[p];
+   }
+   gathered.resize(total);
+   MPI_Gatherv(data.data(),bytes,MPI_BYTE,gathered.data(),counts.data(),offsets.data(),MPI_BYTE,0,cutGroupComm);
+}
+
+/*!
+
+\brief Write selected variables on cells intersecting planes, lines and points
+
+The variables are evaluated with the operators of the cut data reducer, built from
+io.cut_variable, on the cells intersecting the cuts only, and gathered to P::cutWriteRanks writer processes,
+which write them into a small file. Each cut is a separate mesh name in the file.
+
+\param mpiGrid The DCCRG grid with spatial cells
+\param dataReducer Data reducer containing the operators of the cut variables
+\param fileIndex File index, file will be called "name.index.vlsv"
+\return Returns true if operation was successful
+*/
+bool writeCuts(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+               DataReducer& dataReducer,
+               const uint& fileIndex) {
+   int myRank,N_processes;
+   MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
+   MPI_Comm_size(MPI_COMM_WORLD,&N_processes);
+
+   if (cutGroupComm == MPI_COMM_NULL) {
+      const int writers = min(P::cutWriteRanks,N_processes);
+      const int group = ((int64_t)myRank*writers)/N_processes;
+      MPI_Comm_split(MPI_COMM_WORLD,group,myRank,&cutGroupComm);
+      int groupRank;
+      MPI_Comm_rank(cutGroupComm,&groupRank);
+      MPI_Comm_split(MPI_COMM_WORLD,(groupRank == 0) ? 0 : MPI_UNDEFINED,myRank,&cutWriterComm);
+   }
+
+   const vector<Cut> cuts = getCuts();
+   if (cutCellsEpoch != P::meshRepartitionEpoch) {
+      const vector<CellID>& cells = getLocalCells();
+      cutCells.assign(cuts.size(),vector<CellID>());
+      for (size_t i=0; i<cells.size(); ++i) {
+         const array<double,3> cellMin = mpiGrid.geometry.get_min(cells[i]);
+         const array<double,3> cellLength = mpiGrid.geometry.get_length(cells[i]);
+         for (size_t c=0; c<cuts.size(); ++c) {
+            if (cutIntersectsCell(cuts[c],cellMin,cellLength)) cutCells[c].push_back(cells[i]);
+         }
+      }
+      cutCellsEpoch = P::meshRepartitionEpoch;
+   }
+
+   // Operators that write their own data cannot be evaluated on the cut cells only
+   vector<uint> operators;
+   for (uint i=0; i<dataReducer.size(); ++i) {
+      if (dataReducer.handlesWriting(i) == false) operators.push_back(i);
+   }
+
+   // Reduce the variables of all cuts. Variables that failed on any process, e.g. fsgrid
+   // variables, are left out.
+   phiprof::start("reduceData");
+   vector<vector<ReducedVariable> > reduced(cuts.size(),vector<ReducedVariable>(operators.size()));
+   vector<int> variableSuccess(cuts.size()*operators.size());
+   bool success = true;
+   for (size_t c=0; c<cuts.size(); ++c) {
+      for (size_t v=0; v<operators.size(); ++v) reduced[c][v].operatorID = operators[v];
+      if (reduceVariables(mpiGrid,cutCells[c],dataReducer,P::writeAsFloat,reduced[c]) == false) success = false;
+      for (size_t v=0; v<operators.size(); ++v) {
+         variableSuccess[c*operators.size()+v] = (reduced[c][v].success && reduced[c][v].vectorSize > 0) ? 1 : 0;
+      }
+   }
+   MPI_Allreduce(MPI_IN_PLACE,variableSuccess.data(),variableSuccess.size(),MPI_INT,MPI_MIN,MPI_COMM_WORLD);
+   phiprof::stop("reduceData");
+   if (globalSuccess(success,"(MAIN) writeCuts: ERROR failed to reduce cut variables",MPI_COMM_WORLD) == false) return false;
+
+   Writer vlsvWriter;
+   if (cutWriterComm != MPI_COMM_NULL) {
+      stringstream fname;
+      fname << P::cutWritePath << "/" << P::cutWriteName << ".";
+      fname.width(7);
+      fname.fill('0');
+      fname << fileIndex << ".vlsv";
+      if (vlsvWriter.open(fname.str(),cutWriterComm,0,MPI_INFO_NULL) == false) success = false;
+      if (vlsvWriter.writeParameter("time", &P::t) == false) success = false;
+      if (vlsvWriter.writeParameter("dt", &P::dt) == false) success = false;
+      if (vlsvWriter.writeParameter("timestep", &P::tstep) == false) success = false;
+      if (vlsvWriter.writeParameter("fileIndex", &fileIndex) == false) success = false;
+   }
+
+   phiprof::start("gatherAndWrite");
+   vector<char> localData,gathered;
+   for (size_t c=0; c<cuts.size(); ++c) {
+      const vector<CellID>& cells = cutCells[c];
+      map<string,string> attribs = cuts[c].attribs;
+
+      localData.resize(cells.size()*sizeof(CellID));
+      if (cells.size() > 0) memcpy(localData.data(),cells.data(),localData.size());
+      gatherCutData(localData,gathered);
+      attribs["name"] = "CellID";
+      if (cutWriterComm != MPI_COMM_NULL
+          && vlsvWriter.writeArray("VARIABLE",attribs,"uint",gathered.size()/sizeof(CellID),1,sizeof(CellID),gathered.data()) == false) {
+         success = false;
+      }
+
+      // Cell centres, so that line cuts can be ordered along the line
+      vector<Real> centres(3*cells.size());
+      for (size_t i=0; i<cells.size(); ++i) {
+         const array<double,3> centre = mpiGrid.geometry.get_center(cells[i]);
+         for (int d=0; d<3; ++d) centres[3*i+d] = centre[d];
+      }
+      localData.resize(centres.size()*sizeof(Real));
+      if (centres.size() > 0) memcpy(localData.data(),centres.data(),localData.size());
+      gatherCutData(localData,gathered);
+      attribs["name"] = "vg_coordinates";
+      attribs["unit"] = "m";
+      if (cutWriterComm != MPI_COMM_NULL
+          && vlsvWriter.writeArray("VARIABLE",attribs,"float",gathered.size()/(3*sizeof(Real)),3,sizeof(Real),gathered.data()) == false) {
+         success = false;
+      }
+
+      for (size_t v=0; v<operators.size(); ++v) {
+         ReducedVariable& variable = reduced[c][v];
+         if (variableSuccess[c*operators.size()+v] == 0) continue;
+         string unitString,unitStringLaTeX,variableStringLaTeX,unitConversionFactor;
+         dataReducer.getMetadata(variable.operatorID,unitString,unitStringLaTeX,variableStringLaTeX,unitConversionFactor);
+         attribs["name"] = dataReducer.getName(variable.operatorID);
+         attribs["unit"] = unitString;
+         attribs["unitLaTeX"] = unitStringLaTeX;
+         attribs["unitConversion"] = unitConversionFactor;
+         attribs["variableLaTeX"] = variableStringLaTeX;
+         gatherCutData(variable.data,gathered);
+         vector<char>().swap(variable.data);
+         const uint64_t elementBytes = variable.vectorSize*variable.dataSize;
+         if (cutWriterComm != MPI_COMM_NULL
+             && vlsvWriter.writeArray("VARIABLE",attribs,variable.dataType,gathered.size()/elementBytes,
+                                      variable.vectorSize,variable.dataSize,gathered.data()) == false) {
+            success = false;
+         }
+      }
+   }
+   phiprof::stop("gatherAndWrite");
+
+   if (cutWriterComm != MPI_COMM_NULL) {
+      if (vlsvWriter.close() == false) success = false;
+   }
+   return globalSuccess(success,"(MAIN) writeCuts: ERROR failed to write cut output",MPI_COMM_WORLD);
+}
@@ -60,6 +60,14 @@ bool writeGrid(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
 
 /*!
 
+\brief Wait until all bulk files handed to the background writer (io.async_write) have been written and closed.
+
+\return Returns true if all background writes were successful, or if there was nothing to wait for
+*/
+bool waitForAsyncWrites();
+
+/*!
+
 \brief Write out a restart of the simulation into a vlsv file. All block data in remote cells will be reset.
 
 \param mpiGrid   The DCCRG grid with spatial cells
@@ -93,10 +101,23 @@ bool writeRestart(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
 */
 bool writeDiagnostic(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,DataReducer& dataReducer);
 
+/*!
+
+\brief Write selected variables on cells intersecting the planes, lines and points given with io.cut_* parameters
+
+@param mpiGrid   The DCCRG grid with spatial cells
+@param dataReducer Contains the datareductionoperators of the cut variables
+@param fileIndex File index, file will be called "name.index.vlsv"
+*/
+bool writeCuts(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+               DataReducer& dataReducer,
+               const uint& fileIndex);
+
 bool writeVelocitySpace(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
                         vlsv::Writer& vlsvWriter,int index,const std::vector<uint64_t>& cells);
 
 bool writeVelocityDistributionData(vlsv::Writer& vlsvWriter,dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
-                                   const std::vector<uint64_t>& cells,MPI_Comm comm);
+                                   const std::vector<uint64_t>& cells,MPI_Comm comm,const bool allowLossy=false,
+                                   const std::string& restartBase="");
 
 #endif
@@ -25,6 +25,11 @@
 #include <math.h>
 #include <unordered_map> // for hasher
 #include <limits>
+#include <map>
+#include <vector>
+#ifdef _OPENMP
+   #include <omp.h>
+#endif
 #include "logger.h"
 #include "memoryallocation.h"
 #include "common.h"
@@ -184,5 +189,187 @@ void report_process_memory_consumption(){
 
 }
 
+namespace block_pool {
+
+   /*! Free chunks indexed by (size in bytes, alignment).*/
+   typedef std::map<std::pair<size_t,size_t>,std::vector<void*> > FreeChunks;
+
+   struct ThreadCache {
+      FreeChunks freeChunks;
+      Statistics stats;
+      char padding[64];                      /*!< Keeps the statistics of threads on different cache lines.*/
+   };
+
+   static int getMaxThreads() {
+      #ifdef _OPENMP
+         return omp_get_max_threads();
+      #else
+         return 1;
+      #endif
+   }
+
+   struct Pool {
+      std::vector<ThreadCache> threadCaches;
+      FreeChunks sharedChunks;               /*!< Chunks that did not fit in the thread caches, protected by omp critical(block_pool).*/
+      Statistics sharedStats;                /*!< Statistics of sharedChunks and of threads without a thread cache.*/
+      uint64_t maxCachedBytes;
+
+      Pool(): threadCaches(getMaxThreads()),maxCachedBytes(256*1024*1024) {
+         sharedStats.bytesInUse = 0;
+         sharedStats.bytesCached = 0;
+         sharedStats.allocations = 0;
+         sharedStats.systemAllocations = 0;
+      }
+   };
+
+   /*! The pool is never destroyed, so that block containers of global objects
+    *  (the spatial grid) can still return their memory at program exit.*/
+   static Pool& getPool() {
+      static Pool* pool = new Pool();
+      return *pool;
+   }
+
+   /*! Get the cache of the calling thread, or NULL if the thread
+    *  number is larger than the number of threads at startup.*/
+   static ThreadCache* getThreadCache(Pool& pool) {
+      #ifdef _OPENMP
+         const size_t thread = omp_get_thread_num();
+      #else
+         const size_t thread = 0;
+      #endif
+      if (thread < pool.threadCaches.size()) return &(pool.threadCaches[thread]);
+      return NULL;
+   }
+
+   static void* popChunk(FreeChunks& chunks,const std::pair<size_t,size_t>& key) {
+      FreeChunks::iterator it = chunks.find(key);
+      if (it == chunks.end() || it->second.empty()) return NULL;
+      void* p = it->second.back();
+      it->second.pop_back();
+      return p;
+   }
+
+   /*! Round the capacity of a block container up to a size class. Classes
+    *  are spaced by 1/16 of the next lower power of two, so at most 6.25%
+    *  of the capacity is lost to the rounding.
+    *  \param nBlocks Requested capacity in velocity blocks.
+    *  \return Capacity in velocity blocks.*/
+   size_t getSizeClass(const size_t& nBlocks) {
+      size_t step = 1;
+      while ((step << 4) <= nBlocks) step <<= 1;
+      return ((nBlocks + step - 1) / step) * step;
+   }
+
+   /*! Allocate an aligned chunk, reusing a cached chunk of the same size if possible.
+    *  This function is thread-safe.*/
+   void* allocate(const size_t& bytes,const size_t& alignment) {
+      const std::pair<size_t,size_t> key(bytes,alignment);
+      Pool& pool = getPool();
+      ThreadCache* cache = getThreadCache(pool);
+
+      void* p = NULL;
+      if (cache != NULL) {
+         p = popChunk(cache->freeChunks,key);
+         if (p != NULL) cache->stats.bytesCached -= bytes;
+      }
+      if (p == NULL) {
+         #pragma omp critical(block_pool)
+         {
+            p = popChunk(pool.sharedChunks,key);
+            if (p != NULL) pool.sharedStats.bytesCached -= bytes;
+         }
+      }
+
+      bool fromSystem = false;
+      if (p == NULL) {
+         p = aligned_malloc(bytes,alignment);
+         if (p == NULL) return NULL;
+         fromSystem = true;
+      }
+
+      if (cache != NULL) {
+         cache->stats.bytesInUse += bytes;
+         ++cache->stats.allocations;
+         if (fromSystem) ++cache->stats.systemAllocations;
+      } else {
+         #pragma omp critical(block_pool)
+         {
+            pool.sharedStats.bytesInUse += bytes;
+            ++pool.sharedStats.allocations;
+            if (fromSystem) ++pool.sharedStats.systemAllocations;
+         }
+      }
+      return p;
+   }
+
+   /*! Return a chunk to the pool. The chunk is cached in the calling thread's
+    *  cache, or in the shared cache if that one is full, and freed if both
+    *  caches are full. This function is thread-safe.*/
+   void deallocate(void* p,const size_t& bytes,const size_t& alignment) {
+      if (p == NULL) return;
+      const std::pair<size_t,size_t> key(bytes,alignment);
+      Pool& pool = getPool();
+      ThreadCache* cache = getThreadCache(pool);
+
+      // Half of the cached memory is divided between the thread caches, the other half is shared
+      const int64_t maxThreadCachedBytes = pool.maxCachedBytes / (2 * pool.threadCaches.size());
+      bool cached = false;
+      if (cache != NULL) {
+         cache->stats.bytesInUse -= bytes;
+         if (cache->stats.bytesCached + (int64_t)bytes <= maxThreadCachedBytes) {
+            cache->freeChunks[key].push_back(p);
+            cache->stats.bytesCached += bytes;
+            cached = true;
+         }
+      }
+      if (cached == false) {
+         #pragma omp critical(block_pool)
+         {
+            if (cache == NULL) pool.sharedStats.bytesInUse -= bytes;
+            if (pool.sharedStats.bytesCached + bytes <= pool.maxCachedBytes/2) {
+               pool.sharedChunks[key].push_back(p);
+               pool.sharedStats.bytesCached += bytes;
+               cached = true;
+            }
+         }
+      }
+      if (cached == false) aligned_free(p);
+   }
+
+   /*! Sum of the statistics of all threads. Must not be called from a parallel region.*/
+   Statistics getStatistics() {
+      const Pool& pool = getPool();
+      Statistics total = pool.sharedStats;
+      for (size_t i=0; i<pool.threadCaches.size(); ++i) {
+         total.bytesInUse += pool.threadCaches[i].stats.bytesInUse;
+         total.bytesCached += pool.threadCaches[i].stats.bytesCached;
+         total.allocations += pool.threadCaches[i].stats.allocations;
+         total.systemAllocations += pool.threadCaches[i].stats.systemAllocations;
+      }
+      return total;
+   }
 
+   static void freeChunks(FreeChunks& chunks) {
+      for (FreeChunks::iterator it=chunks.begin(); it!=chunks.end(); ++it) {
+         for (size_t i=0; i<it->second.size(); ++i) aligned_free(it->second[i]);
+      }
+      FreeChunks().swap(chunks);
+   }
 
+   /*! Return all cached chunks to the system. Must not be called from a parallel region.*/
+   void releaseCachedMemory() {
+      Pool& pool = getPool();
+      for (size_t i=0; i<pool.threadCaches.size(); ++i) {
+         freeChunks(pool.threadCaches[i].freeChunks);
+         pool.threadCaches[i].stats.bytesCached = 0;
+      }
+      freeChunks(pool.sharedChunks);
+      pool.sharedStats.bytesCached = 0;
+   }
+
+   /*! Set the maximum number of bytes kept in the caches. Chunks already
+    *  cached are not freed.*/
+   void setMaxCachedBytes(const uint64_t& bytes) {
+      getPool().maxCachedBytes = bytes;
+   }
+}
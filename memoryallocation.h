@@ -25,6 +25,7 @@
 #include <cstdlib>
 #include <cstddef>
 #include <stdexcept>
+#include <stdint.h>
 #ifdef USE_JEMALLOC
 #include "jemalloc/jemalloc.h"
 #endif
@@ -228,5 +229,84 @@ private:
    aligned_allocator& operator=(const aligned_allocator&);
 };
 
+/*! Pool of aligned memory chunks used for velocity block data. Freed chunks
+ *  are kept in per-thread free lists (overflowing to a list shared by all
+ *  threads) and reused by the next allocation of the same size, so that the
+ *  capacity released by one spatial cell is reused when another cell on the
+ *  same process grows, instead of returning it to the system and allocating
+ *  it again. Chunk sizes are kept to a small set by rounding container
+ *  capacities to size classes with getSizeClass.
+ */
+namespace block_pool {
+   struct Statistics {
+      int64_t bytesInUse;          /*!< Bytes allocated from the pool and not yet returned.*/
+      int64_t bytesCached;         /*!< Bytes in free chunks kept for reuse.*/
+      uint64_t allocations;        /*!< Number of allocations, i.e. block container reallocations.*/
+      uint64_t systemAllocations;  /*!< Number of allocations that did not find a cached chunk.*/
+   };
+
+   size_t getSizeClass(const size_t& nBlocks);
+   void* allocate(const size_t& bytes,const size_t& alignment);
+   void deallocate(void* p,const size_t& bytes,const size_t& alignment);
+   Statistics getStatistics();
+   void releaseCachedMemory();
+   void setMaxCachedBytes(const uint64_t& bytes);
+}
+
+/**
+ * Allocator for aligned data that allocates from block_pool.
+ */
+template <typename T, std::size_t Alignment>
+class pool_allocator: public aligned_allocator<T,Alignment>
+{
+public:
+   template <typename U>
+   struct rebind
+   {
+      typedef pool_allocator<U, Alignment> other;
+   } ;
+
+   pool_allocator() { }
+
+   pool_allocator(const pool_allocator&): aligned_allocator<T,Alignment>() { }
+
+   template <typename U> pool_allocator(const pool_allocator<U, Alignment>&) { }
+
+   bool operator==(const pool_allocator& other) const
+      {
+         return true;
+      }
+
+   bool operator!=(const pool_allocator& other) const
+      {
+         return false;
+      }
+
+   T * allocate(const std::size_t n) const
+      {
+         if (n == 0) {
+            return NULL;
+         }
+         if (n > this->max_size())
+         {
+            throw std::length_error("pool_allocator<T>::allocate() - Integer overflow.");
+         }
+         void * const pv = block_pool::allocate(n * sizeof(T), Alignment);
+         if (pv == NULL)
+         {
+            throw std::bad_alloc();
+         }
+         return static_cast<T *>(pv);
+      }
+
+   void deallocate(T * const p, const std::size_t n) const
+      {
+         block_pool::deallocate(p, n * sizeof(T), Alignment);
+      }
+
+private:
+   pool_allocator& operator=(const pool_allocator&);
+};
+
 
 #endif
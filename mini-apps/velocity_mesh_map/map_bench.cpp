@@ -0,0 +1,130 @@
+/*
+ * Benchmark for velocity block global ID -> local ID maps. Compares
+ * std::unordered_map, which is used by the default velocity mesh, against
+ * vmesh::OpenHashMap used when vlasiator is compiled with MESH=FLAT.
+ *
+ * Block IDs are generated like in a real velocity mesh: a block grid of
+ * size^3 blocks, global ID = i + j*size + k*size*size, and the blocks kept are
+ * those within a Maxwellian-like sphere plus a thin shell (e.g. a ring
+ * distribution). Lookups are done for the neighbors of all existing blocks,
+ * which gives a mix of hits and misses similar to adjust_velocity_blocks.
+ *
+ * Usage: map_bench [blocks per dimension] [repetitions]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "open_hash_map.h"
+
+typedef uint32_t GID;
+typedef uint32_t LID;
+
+using namespace std;
+
+/*Generate block global IDs of a sphere of radius 0.3*size and a shell at radius
+  0.45*size centered in the block grid. IDs are shuffled, as in vlasiator
+  the block insertion order depends on the content of neighboring blocks.*/
+vector<GID> generate_blocks(const int size) {
+   vector<GID> blocks;
+   const double center = 0.5*size;
+   for (int k=0; k<size; ++k) for (int j=0; j<size; ++j) for (int i=0; i<size; ++i) {
+      const double r = sqrt((i+0.5-center)*(i+0.5-center)
+                            + (j+0.5-center)*(j+0.5-center)
+                            + (k+0.5-center)*(k+0.5-center));
+      if (r < 0.3*size || fabs(r-0.45*size) < 1.0) {
+         blocks.push_back(i + j*size + k*size*size);
+      }
+   }
+   mt19937 rng(12345);
+   shuffle(blocks.begin(),blocks.end(),rng);
+   return blocks;
+}
+
+/*Face neighbors of all blocks, roughly a fifth of these do not exist in the mesh.*/
+vector<GID> generate_queries(const vector<GID>& blocks,const int size) {
+   vector<GID> queries;
+   queries.reserve(6*blocks.size());
+   const int offsets[3] = {1,size,size*size};
+   for (size_t b=0; b<blocks.size(); ++b) {
+      for (int d=0; d<3; ++d) {
+         queries.push_back(blocks[b] + offsets[d]);
+         queries.push_back(blocks[b] - offsets[d]);
+      }
+   }
+   return queries;
+}
+
+template<typename MAP>
+void benchmark(const char* name,const vector<GID>& blocks,const vector<GID>& queries,const int repetitions) {
+   double insertTime = 0;
+   double lookupTime = 0;
+   double eraseTime = 0;
+   size_t hits = 0;
+   size_t buckets = 0;
+
+   for (int r=0; r<repetitions; ++r) {
+      MAP map;
+      auto t0 = chrono::high_resolution_clock::now();
+      for (size_t b=0; b<blocks.size(); ++b) {
+         map.insert(make_pair(blocks[b],(LID)b));
+      }
+      auto t1 = chrono::high_resolution_clock::now();
+
+      hits = 0;
+      for (size_t q=0; q<queries.size(); ++q) {
+         typename MAP::const_iterator it = map.find(queries[q]);
+         if (it != map.end() && it->second < blocks.size()) ++hits;
+      }
+      auto t2 = chrono::high_resolution_clock::now();
+      buckets = map.bucket_count();
+
+      // Remove every second block, as is done when blocks without content are removed
+      for (size_t b=0; b<blocks.size(); b+=2) {
+         map.erase(map.find(blocks[b]));
+      }
+      auto t3 = chrono::high_resolution_clock::now();
+      if (map.size() != blocks.size()/2) {
+         cerr << name << ": map has wrong size after erase" << endl;
+         exit(1);
+      }
+      for (size_t b=0; b<blocks.size(); ++b) {
+         typename MAP::const_iterator it = map.find(blocks[b]);
+         if ((b % 2 == 0) != (it == map.end()) || (b % 2 == 1 && it->second != b)) {
+            cerr << name << ": wrong entry for block " << blocks[b] << " after erase" << endl;
+            exit(1);
+         }
+      }
+
+      insertTime += chrono::duration<double>(t1-t0).count();
+      lookupTime += chrono::duration<double>(t2-t1).count();
+      eraseTime  += chrono::duration<double>(t3-t2).count();
+   }
+
+   const double nsPerInsert = 1e9*insertTime/(repetitions*blocks.size());
+   const double nsPerLookup = 1e9*lookupTime/(repetitions*queries.size());
+   const double nsPerErase  = 1e9*eraseTime/(repetitions*(blocks.size()/2));
+   cout << name << ": insert " << nsPerInsert << " ns, find " << nsPerLookup
+        << " ns, erase " << nsPerErase << " ns, hit rate " << (double)hits/queries.size()
+        << ", buckets " << buckets << endl;
+}
+
+int main(int argc,char* argv[]) {
+   const int size = (argc > 1) ? atoi(argv[1]) : 50;
+   const int repetitions = (argc > 2) ? atoi(argv[2]) : 20;
+
+   const vector<GID> blocks = generate_blocks(size);
+   const vector<GID> queries = generate_queries(blocks,size);
+   cout << "blocks " << blocks.size() << ", queries " << queries.size() << endl;
+
+   benchmark<unordered_map<GID,LID> >("std::unordered_map  ",blocks,queries,repetitions);
+   benchmark<vmesh::OpenHashMap<GID,LID> >("vmesh::OpenHashMap  ",blocks,queries,repetitions);
+   return 0;
+}
@@ -82,6 +82,10 @@ bool ObjectWrapper::addPopulationParameters() {
      Readparameters::add(pop + "_energydensity.limit2", "Lower limit of third bin for energy density, given in units of solar wind ram energy.", 10.0);
      Readparameters::add(pop + "_energydensity.solarwindspeed", "Incoming solar wind velocity magnitude in m/s. Used for calculating energy densities.", 0.0);
      Readparameters::add(pop + "_energydensity.solarwindenergy", "Incoming solar wind ram energy in eV. Used for calculating energy densities.", 0.0);
+
+     // Output compression parameters
+     Readparameters::add(pop + "_io.velocity_codec", "Compression of velocity distribution output: 'none', 'lossless' or 'lossy'. Restart files use 'lossless' instead of 'lossy'.", std::string("none"));
+     Readparameters::add(pop + "_io.velocity_codec_error", "Maximum absolute error of the lossy velocity distribution codec, in units of sparse.minValue.", 0.1);
   }
 
   return true;
@@ -189,6 +193,19 @@ bool ObjectWrapper::getParameters() {
       // Convert from eV to SI units
       species.precipitationEmin = species.precipitationEmin*physicalconstants::CHARGE;
       species.precipitationEmax = species.precipitationEmax*physicalconstants::CHARGE;
+
+      // Get output compression parameters
+      std::string velocityCodec;
+      Readparameters::get(pop + "_io.velocity_codec", velocityCodec);
+      if (vcodec::parseCodec(velocityCodec, species.velocityCodec) == false) {
+         std::cerr << "Invalid velocity codec for species " << pop << ": '" << velocityCodec << "'" << std::endl;
+         return false;
+      }
+      Readparameters::get(pop + "_io.velocity_codec_error", species.velocityCodecErrorBound);
+      if (species.velocityCodec == vcodec::LOSSY && species.velocityCodecErrorBound <= 0) {
+         std::cerr << "Invalid velocity codec error bound for species " << pop << ": " << species.velocityCodecErrorBound << std::endl;
+         return false;
+      }
    }
 
    return true;
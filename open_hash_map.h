@@ -0,0 +1,312 @@
+/*
+ * This file is part of Vlasiator.
+ * Copyright 2010-2016 Finnish Meteorological Institute
+ *
+ * For details of usage, see the COPYING file and read the "Rules of the Road"
+ * at http://www.physics.helsinki.fi/vlasiator/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPEN_HASH_MAP_H
+#define OPEN_HASH_MAP_H
+
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace vmesh {
+
+   /** Hash map with open addressing and linear probing, used for velocity block
+    * global ID to local ID lookups. All entries are stored in one contiguous
+    * array whose size is a power of two, so that a lookup usually touches a
+    * single cache line. Erased entries are removed with backward shift deletion,
+    * no tombstones are used.
+    *
+    * The interface follows std::unordered_map for the functions used by VelocityMesh.
+    * The key emptyKey is reserved for marking empty buckets and cannot be inserted,
+    * by default it is the invalid global ID (max value of the key type).
+    * Iterators and references are invalidated by insertions and erasures.*/
+   template<typename KEY,typename VALUE>
+   class OpenHashMap {
+    public:
+      struct value_type {
+         KEY first;
+         VALUE second;
+      };
+
+      template<typename MAP,typename ENTRY>
+      class Iterator {
+       public:
+         typedef std::forward_iterator_tag iterator_category;
+         typedef ENTRY value_type;
+         typedef std::ptrdiff_t difference_type;
+         typedef ENTRY* pointer;
+         typedef ENTRY& reference;
+
+         Iterator(): map(NULL),index(0) { }
+         Iterator(MAP* map,const size_t& index): map(map),index(index) { }
+         template<typename M,typename E>
+         Iterator(const Iterator<M,E>& it): map(it.map),index(it.index) { }
+
+         ENTRY& operator*() const {return map->buckets[index];}
+         ENTRY* operator->() const {return &(map->buckets[index]);}
+         Iterator& operator++() {
+            ++index;
+            while (index < map->buckets.size() && map->buckets[index].first == map->emptyKey) ++index;
+            return *this;
+         }
+         Iterator operator++(int) {Iterator it(*this); ++(*this); return it;}
+         template<typename M,typename E>
+         bool operator==(const Iterator<M,E>& it) const {return index == it.index;}
+         template<typename M,typename E>
+         bool operator!=(const Iterator<M,E>& it) const {return index != it.index;}
+
+         MAP* map;
+         size_t index;
+      };
+      typedef Iterator<OpenHashMap,value_type> iterator;
+      typedef Iterator<const OpenHashMap,const value_type> const_iterator;
+
+      OpenHashMap(const KEY& emptyKey=std::numeric_limits<KEY>::max());
+
+      VALUE& at(const KEY& key);
+      const VALUE& at(const KEY& key) const;
+      iterator begin();
+      const_iterator begin() const;
+      size_t bucket_count() const;
+      void clear();
+      size_t count(const KEY& key) const;
+      bool empty() const;
+      iterator end();
+      const_iterator end() const;
+      void erase(iterator it);
+      size_t erase(const KEY& key);
+      iterator find(const KEY& key);
+      const_iterator find(const KEY& key) const;
+      std::pair<iterator,bool> insert(const std::pair<KEY,VALUE>& entry);
+      void rehash(size_t nBuckets);
+      void reserve(const size_t& nEntries);
+      size_t size() const;
+      void swap(OpenHashMap& map);
+
+    private:
+      static const size_t MIN_BUCKETS = 16;
+
+      /** Maximum number of entries before the table is grown, the load factor is kept at or below 3/4.*/
+      size_t maxEntries() const {return buckets.size() - buckets.size()/4;}
+      /** Fibonacci hashing, velocity block global IDs are consecutive along vx and
+       * would cluster badly if the low bits of the key were used directly.*/
+      size_t bucketOf(const KEY& key) const {
+         return (static_cast<uint64_t>(key) * UINT64_C(11400714819323198485)) >> shift;
+      }
+      size_t findIndex(const KEY& key) const;
+      void eraseIndex(size_t index);
+
+      KEY emptyKey;
+      size_t nEntries;
+      int shift;                            /**< 64 - log2(number of buckets).*/
+      std::vector<value_type> buckets;
+   };
+
+   template<typename KEY,typename VALUE> inline
+   OpenHashMap<KEY,VALUE>::OpenHashMap(const KEY& emptyKey): emptyKey(emptyKey),nEntries(0),shift(64) { }
+
+   template<typename KEY,typename VALUE> inline
+   VALUE& OpenHashMap<KEY,VALUE>::at(const KEY& key) {
+      const size_t index = findIndex(key);
+      if (index == buckets.size()) throw std::out_of_range("OpenHashMap::at");
+      return buckets[index].second;
+   }
+
+   template<typename KEY,typename VALUE> inline
+   const VALUE& OpenHashMap<KEY,VALUE>::at(const KEY& key) const {
+      const size_t index = findIndex(key);
+      if (index == buckets.size()) throw std::out_of_range("OpenHashMap::at");
+      return buckets[index].second;
+   }
+
+   template<typename KEY,typename VALUE> inline
+   typename OpenHashMap<KEY,VALUE>::iterator OpenHashMap<KEY,VALUE>::begin() {
+      iterator it(this,0);
+      if (buckets.size() > 0 && buckets[0].first == emptyKey) ++it;
+      return it;
+   }
+
+   template<typename KEY,typename VALUE> inline
+   typename OpenHashMap<KEY,VALUE>::const_iterator OpenHashMap<KEY,VALUE>::begin() const {
+      const_iterator it(this,0);
+      if (buckets.size() > 0 && buckets[0].first == emptyKey) ++it;
+      return it;
+   }
+
+   template<typename KEY,typename VALUE> inline
+   size_t OpenHashMap<KEY,VALUE>::bucket_count() const {
+      return buckets.size();
+   }
+
+   template<typename KEY,typename VALUE> inline
+   void OpenHashMap<KEY,VALUE>::clear() {
+      for (size_t i=0; i<buckets.size(); ++i) buckets[i].first = emptyKey;
+      nEntries = 0;
+   }
+
+   template<typename KEY,typename VALUE> inline
+   size_t OpenHashMap<KEY,VALUE>::count(const KEY& key) const {
+      return (findIndex(key) == buckets.size()) ? 0 : 1;
+   }
+
+   template<typename KEY,typename VALUE> inline
+   bool OpenHashMap<KEY,VALUE>::empty() const {
+      return nEntries == 0;
+   }
+
+   template<typename KEY,typename VALUE> inline
+   typename OpenHashMap<KEY,VALUE>::iterator OpenHashMap<KEY,VALUE>::end() {
+      return iterator(this,buckets.size());
+   }
+
+   template<typename KEY,typename VALUE> inline
+   typename OpenHashMap<KEY,VALUE>::const_iterator OpenHashMap<KEY,VALUE>::end() const {
+      return const_iterator(this,buckets.size());
+   }
+
+   template<typename KEY,typename VALUE> inline
+   void OpenHashMap<KEY,VALUE>::erase(iterator it) {
+      eraseIndex(it.index);
+   }
+
+   template<typename KEY,typename VALUE> inline
+   size_t OpenHashMap<KEY,VALUE>::erase(const KEY& key) {
+      const size_t index = findIndex(key);
+      if (index == buckets.size()) return 0;
+      eraseIndex(index);
+      return 1;
+   }
+
+   /** Remove the entry at the given bucket and shift the following entries of
+    * the probe sequence back so that no lookup chain is broken.*/
+   template<typename KEY,typename VALUE> inline
+   void OpenHashMap<KEY,VALUE>::eraseIndex(size_t index) {
+      const size_t mask = buckets.size()-1;
+      size_t next = index;
+      while (true) {
+         next = (next+1) & mask;
+         if (buckets[next].first == emptyKey) break;
+
+         // Entry at next can be moved to index if its home bucket is not
+         // cyclically in the range (index,next]
+         const size_t home = bucketOf(buckets[next].first);
+         if (((next - home) & mask) >= ((next - index) & mask)) {
+            buckets[index] = buckets[next];
+            index = next;
+         }
+      }
+      buckets[index].first = emptyKey;
+      --nEntries;
+   }
+
+   template<typename KEY,typename VALUE> inline
+   typename OpenHashMap<KEY,VALUE>::iterator OpenHashMap<KEY,VALUE>::find(const KEY& key) {
+      return iterator(this,findIndex(key));
+   }
+
+   template<typename KEY,typename VALUE> inline
+   typename OpenHashMap<KEY,VALUE>::const_iterator OpenHashMap<KEY,VALUE>::find(const KEY& key) const {
+      return const_iterator(this,findIndex(key));
+   }
+
+   /** Get the bucket containing the key, or the number of buckets if the key does not exist.*/
+   template<typename KEY,typename VALUE> inline
+   size_t OpenHashMap<KEY,VALUE>::findIndex(const KEY& key) const {
+      if (nEntries == 0 || key == emptyKey) return buckets.size();
+      const size_t mask = buckets.size()-1;
+      size_t index = bucketOf(key);
+      while (true) {
+         if (buckets[index].first == key) return index;
+         if (buckets[index].first == emptyKey) return buckets.size();
+         index = (index+1) & mask;
+      }
+   }
+
+   template<typename KEY,typename VALUE> inline
+   std::pair<typename OpenHashMap<KEY,VALUE>::iterator,bool> OpenHashMap<KEY,VALUE>::insert(const std::pair<KEY,VALUE>& entry) {
+      if (entry.first == emptyKey) {
+         throw std::invalid_argument("OpenHashMap::insert: key is reserved for empty buckets");
+      }
+      if (nEntries+1 > maxEntries()) rehash(2*buckets.size());
+
+      const size_t mask = buckets.size()-1;
+      size_t index = bucketOf(entry.first);
+      while (buckets[index].first != emptyKey) {
+         if (buckets[index].first == entry.first) return std::make_pair(iterator(this,index),false);
+         index = (index+1) & mask;
+      }
+      buckets[index].first = entry.first;
+      buckets[index].second = entry.second;
+      ++nEntries;
+      return std::make_pair(iterator(this,index),true);
+   }
+
+   /** Set the number of buckets, rounded up to a power of two and so that all
+    * current entries fit.*/
+   template<typename KEY,typename VALUE> inline
+   void OpenHashMap<KEY,VALUE>::rehash(size_t nBuckets) {
+      size_t newSize = MIN_BUCKETS;
+      int newShift = 64 - 4;
+      while (newSize < nBuckets || newSize - newSize/4 < nEntries) {
+         newSize *= 2;
+         --newShift;
+      }
+      if (newSize == buckets.size()) return;
+
+      std::vector<value_type> oldBuckets(newSize);
+      oldBuckets.swap(buckets);
+      for (size_t i=0; i<buckets.size(); ++i) buckets[i].first = emptyKey;
+      shift = newShift;
+
+      const size_t mask = buckets.size()-1;
+      for (size_t i=0; i<oldBuckets.size(); ++i) {
+         if (oldBuckets[i].first == emptyKey) continue;
+         size_t index = bucketOf(oldBuckets[i].first);
+         while (buckets[index].first != emptyKey) index = (index+1) & mask;
+         buckets[index] = oldBuckets[i];
+      }
+   }
+
+   template<typename KEY,typename VALUE> inline
+   void OpenHashMap<KEY,VALUE>::reserve(const size_t& nEntries) {
+      rehash(nEntries + nEntries/3 + 1);
+   }
+
+   template<typename KEY,typename VALUE> inline
+   size_t OpenHashMap<KEY,VALUE>::size() const {
+      return nEntries;
+   }
+
+   template<typename KEY,typename VALUE> inline
+   void OpenHashMap<KEY,VALUE>::swap(OpenHashMap& map) {
+      std::swap(emptyKey,map.emptyKey);
+      std::swap(nEntries,map.nEntries);
+      std::swap(shift,map.shift);
+      buckets.swap(map.buckets);
+   }
+
+} // namespace vmesh
+
+#endif
@@ -69,6 +69,7 @@ Real P::fieldSolverMinCFL = NAN;
 uint P::fieldSolverSubcycles = 1;
 
 bool P::transShortPencils = true;
+bool P::overlapTranslationCommunication = false;
 
 uint P::tstep = 0;
 uint P::tstep_min = 0;
@@ -77,6 +78,7 @@ uint P::diagnosticInterval = numeric_limits<uint>::max();
 bool P::writeInitialState = true;
 
 bool P::meshRepartitioned = true;
+uint P::meshRepartitionEpoch = 0;
 bool P::prepareForRebalance = false;
 std::vector<CellID> P::localCells;
 
@@ -91,13 +93,28 @@ vector<Real> P::systemWriteDistributionWriteShellRadius;
 vector<int> P::systemWriteDistributionWriteShellStride;
 vector<int> P::systemWrites;
 std::vector<std::pair<std::string,std::string>> P::systemWriteHints;
+Real P::cutWriteTimeInterval = -1.0;
+string P::cutWriteName = string("cuts");
+string P::cutWritePath = string("./");
+int P::cutWriteRanks = 1;
+uint P::cutWrites = 0;
+vector<string> P::cutVariableList;
+vector<string> P::cutPlaneNormal;
+vector<Real> P::cutPlanePosition;
+vector<Real> P::cutLineStart[3];
+vector<Real> P::cutLineEnd[3];
+vector<Real> P::cutPoint[3];
 
 Real P::saveRestartWalltimeInterval = -1.0;
 uint P::exitAfterRestarts = numeric_limits<uint>::max();
 uint64_t P::vlsvBufferSize = 0;
+bool P::asyncWrite = false;
+uint64_t P::asyncWriteStagingMemory = 0;
 int P::restartStripeFactor = -1;
 int P::bulkStripeFactor = -1;
 string P::restartWritePath = string("");
+uint P::restartFullInterval = 0;
+uint64_t P::restartReadChunkSize = 0;
 
 uint P::transmit = 0;
 
@@ -111,8 +128,11 @@ bool P::dynamicTimestep = true;
 Real P::maxWaveVelocity = 0.0;
 uint P::maxFieldSolverSubcycles = 0.0;
 int P::maxSlAccelerationSubcycles = 0.0;
+bool P::decoupledAccelerationSubcycles = false;
+uint64_t P::blockPoolCachedBytes = 0;
 Real P::resistivity = NAN;
 bool P::fieldSolverDiffusiveEterms = true;
+int P::fieldSolverGhostComputeDepth = -1;
 uint P::ohmHallTerm = 0;
 uint P::ohmGradPeTerm = 0;
 Real P::electronTemperature = 0.0;
@@ -126,6 +146,13 @@ int P::writeRestartAsFloat = false;
 string P::loadBalanceAlgorithm = string("");
 string P::loadBalanceTolerance = string("");
 uint P::rebalanceInterval = numeric_limits<uint>::max();
+string P::loadBalanceWeight = string("blocks");
+Real P::loadBalanceWeightSmoothing = 0.5;
+bool P::loadBalanceMultiConstraint = false;
+Real P::loadBalanceMemoryCap = 0.0;
+uint64_t P::loadBalanceTransferBudget = 0;
+Real P::loadBalancePredictedLoad = 1.0;
+Real P::loadBalanceMeasuredLoad = 1.0;
 
 vector<string> P::outputVariableList;
 vector<string> P::diagnosticVariableList;
@@ -171,16 +198,36 @@ bool Parameters::addParameters(){
    Readparameters::addComposing("io.system_write_distribution_shell_stride", "Every this many cells for those on selected shells write out their velocity space. 0 is none.");
    Readparameters::addComposing("io.system_write_mpiio_hint_key", "MPI-IO hint key passed to the non-restart IO. Has to be matched by io.system_write_mpiio_hint_value.");
    Readparameters::addComposing("io.system_write_mpiio_hint_value", "MPI-IO hint value passed to the non-restart IO. Has to be matched by io.system_write_mpiio_hint_key.");
+   Readparameters::add("io.cut_write_t_interval", "Write selected variables on cells intersecting planes, lines and points every arg simulated seconds. Negative values disable cut output.", -1.0);
+   Readparameters::add("io.cut_write_file_name", "Save cut output to this file name series.", string("cuts"));
+   Readparameters::add("io.cut_write_path", "Save cut output in this location.", string("./"));
+   Readparameters::add("io.cut_write_ranks", "Number of processes the cut output is gathered to and written by.", 1);
+   Readparameters::addComposing("io.cut_variable", "Variable written in cut output, named as in variables.output (e.g. vg_rhom).");
+   Readparameters::addComposing("io.cut_plane_normal", "Normal direction (x, y or z) of a plane in cut output. [Define io.cut_plane_position for each.]");
+   Readparameters::addComposing("io.cut_plane_position", "Position of a plane in cut output along its normal (m).");
+   Readparameters::addComposing("io.cut_line_start_x", "X coordinate of the start of a line segment in cut output (m). [Define all six coordinates for each line.]");
+   Readparameters::addComposing("io.cut_line_start_y", "Y coordinate of the start of a line segment in cut output (m).");
+   Readparameters::addComposing("io.cut_line_start_z", "Z coordinate of the start of a line segment in cut output (m).");
+   Readparameters::addComposing("io.cut_line_end_x", "X coordinate of the end of a line segment in cut output (m).");
+   Readparameters::addComposing("io.cut_line_end_y", "Y coordinate of the end of a line segment in cut output (m).");
+   Readparameters::addComposing("io.cut_line_end_z", "Z coordinate of the end of a line segment in cut output (m).");
+   Readparameters::addComposing("io.cut_point_x", "X coordinate of a point in cut output (m). [Define all three coordinates for each point.]");
+   Readparameters::addComposing("io.cut_point_y", "Y coordinate of a point in cut output (m).");
+   Readparameters::addComposing("io.cut_point_z", "Z coordinate of a point in cut output (m).");
 
    Readparameters::add("io.write_initial_state","Write initial state, not even the 0.5 dt propagation is done. Do not use for restarting. ",false);
 
    Readparameters::add("io.restart_walltime_interval","Save the complete simulation in given walltime intervals. Negative values disable writes.",-1.0);
    Readparameters::add("io.number_of_restarts","Exit the simulation after certain number of walltime-based restarts.",numeric_limits<uint>::max());
    Readparameters::add("io.vlsv_buffer_size", "Buffer size passed to VLSV writer (bytes, up to uint64_t), default 0 as this is sensible on sisu", 0);
+   Readparameters::add("io.async_write", "If true, variables of bulk files are written in a background thread while the simulation continues. MPI_THREAD_MULTIPLE is then requested at start-up, if it is not provided files are written synchronously. Must be given on the command line or in a configuration file, not in an environment variable.", false);
+   Readparameters::add("io.async_staging_memory", "Maximum memory per process (MB) for variables waiting to be written in the background. Files that do not fit are written synchronously.", 1024);
    Readparameters::add("io.write_restart_stripe_factor","Stripe factor for restart writing.", -1);
    Readparameters::add("io.write_bulk_stripe_factor","Stripe factor for bulk file and initial grid writing.", -1);
    Readparameters::add("io.write_as_float","If true, write in floats instead of doubles", false);
    Readparameters::add("io.restart_write_path", "Path to the location where restart files should be written. Defaults to the local directory, also if the specified destination is not writeable.", string("./"));
+   Readparameters::add("io.restart_full_interval", "Every Nth restart file is a full one, the others are differential and store velocity block lists relative to the last full restart. The full restart must be kept next to its differential restarts. Values below 2 write only full restarts.", 0);
+   Readparameters::add("io.restart_read_chunk_size", "Maximum amount of data (MB) read from a restart file array in one collective call. Each process reads the data of its own cells, split into calls of at most this size.", 64);
 
    Readparameters::add("transShortPencils", "if true, use one-cell pencils", true);
    
@@ -222,17 +269,26 @@ bool Parameters::addParameters(){
    Readparameters::add("fieldsolver.electronPTindex", "Polytropic index for electron pressure gradient term. 0 is isobaric, 1 is isothermal, 1.667 is adiabatic electrons, ", 0.0);
    Readparameters::add("fieldsolver.maxCFL","The maximum CFL limit for field propagation. Used to set timestep if dynamic_timestep is true.",0.5);
    Readparameters::add("fieldsolver.minCFL","The minimum CFL limit for field propagation. Used to set timestep if dynamic_timestep is true.",0.4);
+   Readparameters::add("fieldsolver.ghostComputeDepth","Number of ghost cell layers on which the magnetic field is propagated redundantly, each layer saves one ghost exchange in the boundary update. 0: always exchange, 1: one layer, 2: two layers (needs FS_STENCIL_WIDTH of at least 3), -1: choose automatically from measured exchange and compute times.",-1);
 
    // Vlasov solver parameters
    Readparameters::add("vlasovsolver.maxSlAccelerationRotation","Maximum rotation angle (degrees) allowed by the Semi-Lagrangian solver (Use >25 values with care)",25.0);
    Readparameters::add("vlasovsolver.maxSlAccelerationSubcycles","Maximum number of subcycles for acceleration",1);
+   Readparameters::add("vlasovsolver.decoupledAccelerationSubcycles","If true, cells whose nearest spatial neighbors are all local and not subcycled run their acceleration subcycles back-to-back, without the block adjustment and communication of all cells between subcycles.",false);
+   Readparameters::add("vlasovsolver.blockPoolCache","Maximum amount of freed velocity block storage (MB) each process keeps for reuse instead of returning it to the system.",256);
    Readparameters::add("vlasovsolver.maxCFL","The maximum CFL limit for vlasov propagation in ordinary space. Used to set timestep if dynamic_timestep is true.",0.99);
    Readparameters::add("vlasovsolver.minCFL","The minimum CFL limit for vlasov propagation in ordinary space. Used to set timestep if dynamic_timestep is true.",0.8);
+   Readparameters::add("vlasovsolver.overlapTranslationCommunication","If true, the ghost block transfer of spatial translation is overlapped with the setup of the mapping (only without spatial AMR).",false);
 
    // Load balancing parameters
    Readparameters::add("loadBalance.algorithm", "Load balancing algorithm to be used", string("RCB"));
    Readparameters::add("loadBalance.tolerance", "Load imbalance tolerance", string("1.05"));
    Readparameters::add("loadBalance.rebalanceInterval", "Load rebalance interval (steps)", 10);
+   Readparameters::add("loadBalance.weight", "Load balance cell weights: blocks (velocity block count) or time (measured acceleration, translation and boundary compute time)", string("blocks"));
+   Readparameters::add("loadBalance.weightSmoothing", "Weight of the latest measurement in the exponential average of the time-based load balance weights, between 0 and 1", 0.5);
+   Readparameters::add("loadBalance.multiConstraint", "Balance the cell weights and the resident memory of the cells as two separate constraints", false);
+   Readparameters::add("loadBalance.memoryCap", "With loadBalance.multiConstraint, fraction of the memory available to a process (its cell data and its share of the free node memory) that the new partition may use, 0 for no cap", 0.0);
+   Readparameters::add("loadBalance.transferBudget", "Maximum amount of cell data (MB) a process sends or receives in one round of cell migration. Cells are migrated in as many rounds as needed to stay within this budget.", 1024);
    
 // Output variable parameters
    // NOTE Do not remove the : before the list of variable names as this is parsed by tools/check_vlasiator_cfg.sh
@@ -247,7 +303,7 @@ bool Parameters::addParameters(){
 				"populations_vg_energydensity populations_vg_precipitationdifferentialflux "+
 				"vg_maxdt_acceleration vg_maxdt_translation populations_vg_maxdt_acceleration populations_vg_maxdt_translation "+
 				"fg_maxdt_fieldsolver "+
-				"vg_rank fg_rank fg_amr_level vg_loadbalance_weight "+
+				"vg_rank fg_rank fg_amr_level vg_loadbalance_weight vg_loadbalance_cost vg_loadbalance_imbalance "+
 				"vg_boundarytype fg_boundarytype vg_boundarylayer fg_boundarylayer "+
 				"populations_vg_blocks vg_f_saved "+
 				"populations_vg_acceleration_subcycles "+
@@ -284,7 +340,7 @@ bool Parameters::addParameters(){
 				"Available (20201111): "+
 				"populations_vg_blocks "+
 				"vg_rhom populations_vg_rho_loss_adjust "+
-				"vg_loadbalance_weight "+
+				"vg_loadbalance_weight vg_loadbalance_cost "+
 				"vg_maxdt_acceleration vg_maxdt_translation "+
 				"fg_maxdt_fieldsolver "+
                                 "populations_vg_maxdt_acceleration populations_vg_maxdt_translation "+
@@ -341,9 +397,17 @@ bool Parameters::getParameters(){
    Readparameters::get("io.restart_walltime_interval", P::saveRestartWalltimeInterval);
    Readparameters::get("io.number_of_restarts", P::exitAfterRestarts);
    Readparameters::get("io.vlsv_buffer_size", P::vlsvBufferSize);
+   Readparameters::get("io.async_write", P::asyncWrite);
+   uint asyncStagingMegabytes;
+   Readparameters::get("io.async_staging_memory", asyncStagingMegabytes);
+   P::asyncWriteStagingMemory = (uint64_t)asyncStagingMegabytes * 1024 * 1024;
    Readparameters::get("io.write_restart_stripe_factor", P::restartStripeFactor);
    Readparameters::get("io.write_bulk_stripe_factor", P::bulkStripeFactor);
    Readparameters::get("io.restart_write_path", P::restartWritePath);
+   Readparameters::get("io.restart_full_interval", P::restartFullInterval);
+   uint restartReadChunkMegabytes;
+   Readparameters::get("io.restart_read_chunk_size", restartReadChunkMegabytes);
+   P::restartReadChunkSize = max((uint64_t)1,(uint64_t)restartReadChunkMegabytes) * 1024 * 1024;
    Readparameters::get("io.write_as_float", P::writeAsFloat);
    Readparameters::get("transShortPencils", P::transShortPencils);
    
@@ -443,6 +507,64 @@ bool Parameters::getParameters(){
       }
    }
 
+   Readparameters::get("io.cut_write_t_interval", P::cutWriteTimeInterval);
+   Readparameters::get("io.cut_write_file_name", P::cutWriteName);
+   Readparameters::get("io.cut_write_path", P::cutWritePath);
+   Readparameters::get("io.cut_write_ranks", P::cutWriteRanks);
+   Readparameters::get("io.cut_variable", P::cutVariableList);
+   Readparameters::get("io.cut_plane_normal", P::cutPlaneNormal);
+   Readparameters::get("io.cut_plane_position", P::cutPlanePosition);
+   Readparameters::get("io.cut_line_start_x", P::cutLineStart[0]);
+   Readparameters::get("io.cut_line_start_y", P::cutLineStart[1]);
+   Readparameters::get("io.cut_line_start_z", P::cutLineStart[2]);
+   Readparameters::get("io.cut_line_end_x", P::cutLineEnd[0]);
+   Readparameters::get("io.cut_line_end_y", P::cutLineEnd[1]);
+   Readparameters::get("io.cut_line_end_z", P::cutLineEnd[2]);
+   Readparameters::get("io.cut_point_x", P::cutPoint[0]);
+   Readparameters::get("io.cut_point_y", P::cutPoint[1]);
+   Readparameters::get("io.cut_point_z", P::cutPoint[2]);
+
+   if (P::cutPlaneNormal.size() != P::cutPlanePosition.size()) {
+      if(myRank == MASTER_RANK) {
+         cerr << "ERROR io.cut_plane_normal and io.cut_plane_position should be defined for all planes." << endl;
+      }
+      return false;
+   }
+   for (uint i=0; i<P::cutPlaneNormal.size(); i++) {
+      if (P::cutPlaneNormal[i] != "x" && P::cutPlaneNormal[i] != "y" && P::cutPlaneNormal[i] != "z") {
+         if(myRank == MASTER_RANK) {
+            cerr << "ERROR io.cut_plane_normal should be x, y or z, not " << P::cutPlaneNormal[i] << "." << endl;
+         }
+         return false;
+      }
+   }
+   for (int d=0; d<3; d++) {
+      if (P::cutLineStart[d].size() != P::cutLineStart[0].size() || P::cutLineEnd[d].size() != P::cutLineStart[0].size()) {
+         if(myRank == MASTER_RANK) {
+            cerr << "ERROR io.cut_line_start_[xyz] and io.cut_line_end_[xyz] should be defined for all lines." << endl;
+         }
+         return false;
+      }
+      if (P::cutPoint[d].size() != P::cutPoint[0].size()) {
+         if(myRank == MASTER_RANK) {
+            cerr << "ERROR io.cut_point_[xyz] should be defined for all points." << endl;
+         }
+         return false;
+      }
+   }
+   if (P::cutWriteRanks < 1) {
+      if(myRank == MASTER_RANK) {
+         cerr << "ERROR io.cut_write_ranks should be at least 1." << endl;
+      }
+      return false;
+   }
+   if (access(&(P::cutWritePath[0]), W_OK) != 0) {
+      if(myRank == MASTER_RANK) {
+         cerr << "ERROR cut output write path " << P::cutWritePath << " not writeable, defaulting to local directory." << endl;
+      }
+      P::cutWritePath = prefix;
+   }
+
    Readparameters::get("propagate_field",P::propagateField);
    Readparameters::get("propagate_vlasov_acceleration",P::propagateVlasovAcceleration);
    Readparameters::get("propagate_vlasov_translation",P::propagateVlasovTranslation);
@@ -600,17 +722,46 @@ bool Parameters::getParameters(){
    Readparameters::get("fieldsolver.electronPTindex", P::electronPTindex);
    Readparameters::get("fieldsolver.maxCFL",P::fieldSolverMaxCFL);
    Readparameters::get("fieldsolver.minCFL",P::fieldSolverMinCFL);
+   Readparameters::get("fieldsolver.ghostComputeDepth",P::fieldSolverGhostComputeDepth);
+   if(P::fieldSolverGhostComputeDepth < -1 || P::fieldSolverGhostComputeDepth > 2) {
+      if(myRank == MASTER_RANK) cerr << "ERROR fieldsolver.ghostComputeDepth has to be -1, 0, 1 or 2." << endl;
+      return false;
+   }
    // Get Vlasov solver parameters
    Readparameters::get("vlasovsolver.maxSlAccelerationRotation",P::maxSlAccelerationRotation);
    Readparameters::get("vlasovsolver.maxSlAccelerationSubcycles",P::maxSlAccelerationSubcycles);
+   Readparameters::get("vlasovsolver.decoupledAccelerationSubcycles",P::decoupledAccelerationSubcycles);
+   uint blockPoolCacheMegabytes;
+   Readparameters::get("vlasovsolver.blockPoolCache",blockPoolCacheMegabytes);
+   P::blockPoolCachedBytes = (uint64_t)blockPoolCacheMegabytes * 1024 * 1024;
    Readparameters::get("vlasovsolver.maxCFL",P::vlasovSolverMaxCFL);
    Readparameters::get("vlasovsolver.minCFL",P::vlasovSolverMinCFL);
+   Readparameters::get("vlasovsolver.overlapTranslationCommunication",P::overlapTranslationCommunication);
 
    
    // Get load balance parameters
    Readparameters::get("loadBalance.algorithm", P::loadBalanceAlgorithm);
    Readparameters::get("loadBalance.tolerance", P::loadBalanceTolerance);
    Readparameters::get("loadBalance.rebalanceInterval", P::rebalanceInterval);
+   Readparameters::get("loadBalance.weight", P::loadBalanceWeight);
+   if(P::loadBalanceWeight != "blocks" && P::loadBalanceWeight != "time") {
+      if(myRank == MASTER_RANK) cerr << "ERROR loadBalance.weight has to be blocks or time." << endl;
+      return false;
+   }
+   Readparameters::get("loadBalance.weightSmoothing", P::loadBalanceWeightSmoothing);
+   if(P::loadBalanceWeightSmoothing <= 0.0 || P::loadBalanceWeightSmoothing > 1.0) {
+      if(myRank == MASTER_RANK) cerr << "ERROR loadBalance.weightSmoothing has to be in ]0,1]." << endl;
+      return false;
+   }
+   Readparameters::get("loadBalance.multiConstraint", P::loadBalanceMultiConstraint);
+   Readparameters::get("loadBalance.memoryCap", P::loadBalanceMemoryCap);
+   if(P::loadBalanceMemoryCap < 0.0 || P::loadBalanceMemoryCap > 1.0) {
+      if(myRank == MASTER_RANK) cerr << "ERROR loadBalance.memoryCap has to be in [0,1]." << endl;
+      return false;
+   }
+   uint transferBudgetMegabytes;
+   Readparameters::get("loadBalance.transferBudget", transferBudgetMegabytes);
+   P::loadBalanceTransferBudget = max((uint64_t)1,(uint64_t)transferBudgetMegabytes) * 1024 * 1024;
    
    // Get output variable parameters
    Readparameters::get("variables.output", P::outputVariableList);
@@ -625,6 +776,11 @@ bool Parameters::getParameters(){
    dummy.insert(P::diagnosticVariableList.begin(),P::diagnosticVariableList.end());
    P::diagnosticVariableList.clear();
    P::diagnosticVariableList.insert(P::diagnosticVariableList.end(),dummy.begin(),dummy.end());
+   dummy.clear();
+   
+   dummy.insert(P::cutVariableList.begin(),P::cutVariableList.end());
+   P::cutVariableList.clear();
+   P::cutVariableList.insert(P::cutVariableList.end(),dummy.begin(),dummy.end());
    
    // Get parameters related to bailout
    Readparameters::get("bailout.write_restart", P::bailout_write_restart);
@@ -59,12 +59,14 @@ struct Parameters {
    static Real fieldSolverMaxCFL;     /*!< The maximum CFL limit for propagation of fields. Used to set timestep if useCFLlimit is true.*/
    static uint fieldSolverSubcycles;     /*!< The number of field solver subcycles to compute.*/
    static bool transShortPencils;        /*!< Use short or longpencils in AMR translation.*/
+   static bool overlapTranslationCommunication; /*!< Overlap ghost block transfers with translation setup (non-AMR translation only).*/
   
    static uint tstep_min;           /*!< Timestep when simulation starts, needed for restarts.*/
    static uint tstep_max;           /*!< Maximum timestep. */
    static uint tstep;               /*!< The number of the current timestep. 0=initial state. */
 
    static bool meshRepartitioned;         /*!< If true, mesh was repartitioned on this time step.*/
+   static uint meshRepartitionEpoch;      /*!< Incremented every time the mesh is repartitioned.*/
    static std::vector<CellID> localCells; /*!< Cached copy of spatial cell IDs on this process.*/
 
    static uint diagnosticInterval;
@@ -79,14 +81,29 @@ struct Parameters {
    static std::vector<int> systemWriteDistributionWriteShellStride; /*!< Every this many cells for those on selected shells write out their velocity space in each class. */
    static std::vector<int> systemWrites; /*!< How many files have been written of each class*/
    static std::vector<std::pair<std::string,std::string>> systemWriteHints; /*!< Collection of MPI-IO hints passed for non-restart IO. Pairs of key-value strings. */
+   static Real cutWriteTimeInterval;        /*!< Interval in simulated seconds for cut output (planes, lines and points), negative values disable it.*/
+   static std::string cutWriteName;         /*!< Save cut output to this file name series.*/
+   static std::string cutWritePath;         /*!< Save cut output in this location.*/
+   static int cutWriteRanks;                /*!< Number of processes the cut output is gathered to and written by.*/
+   static uint cutWrites;                   /*!< How many cut output files have been written.*/
+   static std::vector<std::string> cutVariableList; /*!< Output variables written in cut output.*/
+   static std::vector<std::string> cutPlaneNormal;  /*!< Normal directions (x, y or z) of planes in cut output.*/
+   static std::vector<Real> cutPlanePosition;       /*!< Positions of planes in cut output along their normals.*/
+   static std::vector<Real> cutLineStart[3];        /*!< Start points of line segments in cut output.*/
+   static std::vector<Real> cutLineEnd[3];          /*!< End points of line segments in cut output.*/
+   static std::vector<Real> cutPoint[3];            /*!< Points in cut output, e.g. virtual spacecraft.*/
    
    static bool writeInitialState;           /*!< If true, initial state is written. This is useful for debugging as the restarts are always written out after propagation of 0.5dt in real space.*/
    static Real saveRestartWalltimeInterval; /*!< Interval in walltime seconds for restart data*/
    static uint exitAfterRestarts;           /*!< Exit after this many restarts*/
    static uint64_t vlsvBufferSize;          /*!< Buffer size in bytes passed to VLSV writer. */
+   static bool asyncWrite;                  /*!< If true, bulk file variables are written in a background thread.*/
+   static uint64_t asyncWriteStagingMemory; /*!< Maximum memory in bytes per process for variables waiting to be written in the background.*/
    static int restartStripeFactor;          /*!< stripe_factor for restart writing*/
    static int bulkStripeFactor;          /*!< stripe_factor for bulk and initial grid writing*/
    static std::string restartWritePath;          /*!< Path to the location where restart files should be written. Defaults to the local directory, also if the specified destination is not writeable. */
+   static uint restartFullInterval;         /*!< Every restartFullInterval:th restart is a full one, the others store velocity block lists relative to the last full restart. Values below 2 disable differential restarts.*/
+   static uint64_t restartReadChunkSize;    /*!< Maximum number of bytes read from a restart file array in one collective call.*/
    
    static uint transmit;
    /*!< Indicates the data that needs to be transmitted to remote nodes.
@@ -109,9 +126,12 @@ struct Parameters {
    static Real electronPTindex; /*!> Polytropic index for electron pressure gradient term. 0 is isobaric, 1 is isothermal, 1.667 is adiabatic electrons */
 
    static bool fieldSolverDiffusiveEterms; /*!< Enable resistive terms in the computation of E*/
+   static int fieldSolverGhostComputeDepth; /*!< Ghost cell layers on which the magnetic field is propagated redundantly instead of exchanged during the boundary update, -1 to choose automatically.*/
    
    static Real maxSlAccelerationRotation; /*!< Maximum rotation in acceleration for semilagrangian solver*/
    static int maxSlAccelerationSubcycles; /*!< Maximum number of subcycles in acceleration*/
+   static bool decoupledAccelerationSubcycles; /*!< Subcycle cells whose spatial neighbors are local and not subcycled without global synchronization.*/
+   static uint64_t blockPoolCachedBytes; /*!< Maximum number of bytes of freed velocity block storage kept for reuse by each process.*/
    
    static Real hallMinimumRhom;  /*!< Minimum mass density value used in the field solver.*/
    static Real hallMinimumRhoq;  /*!< Minimum charge density value used for the Hall and electron pressure gradient terms in the Lorentz force and in the field solver.*/
@@ -119,6 +139,13 @@ struct Parameters {
    static std::string loadBalanceAlgorithm; /*!< Algorithm to be used for load balance.*/
    static std::string loadBalanceTolerance; /*!< Load imbalance tolerance. */ 
    static uint rebalanceInterval; /*!< Load rebalance interval (steps). */
+   static std::string loadBalanceWeight; /*!< Load balance weights, "blocks" for velocity block counts or "time" for measured compute time. */
+   static Real loadBalanceWeightSmoothing; /*!< Weight of the latest measurement in the exponentially averaged time weights. */
+   static bool loadBalanceMultiConstraint; /*!< If true, cells are balanced by compute weight and resident memory as two constraints. */
+   static Real loadBalanceMemoryCap; /*!< Fraction of the memory available to a process that the memory constraint may use, 0 for no cap. */
+   static uint64_t loadBalanceTransferBudget; /*!< Maximum number of bytes of cell data a process sends or receives in one round of cell migration. */
+   static Real loadBalancePredictedLoad; /*!< Load of this process relative to the mean, predicted from the weights of the current partition. */
+   static Real loadBalanceMeasuredLoad; /*!< Measured load of this process relative to the mean before the last load balance. */
    static bool prepareForRebalance; /**< If true, propagators should measure their time consumption in preparation
                                      * for mesh repartitioning.*/
 
@@ -30,6 +30,7 @@
 
 #include <omp.h>
 #include "definitions.h"
+#include "velocity_block_codec.h"
 #include <array>
 
 namespace species {
@@ -70,6 +71,9 @@ namespace species {
       Real precipitationEmax;                  /*!< Highest energy channel (in keV) for precipitation differential flux evaluation. Default 100. */
       Real precipitationLossConeAngle;         /*!< Fixed loss cone opening angle (in deg) for precipitation differential flux evaluation. Default 10. */
 
+      vcodec::Codec velocityCodec;     /*!< Compression of the velocity distribution in output files. Restart files are never compressed lossily. Default none. */
+      Real velocityCodecErrorBound;    /*!< Maximum absolute error of the lossy codec, in units of sparseMinValue. Default 0.1. */
+
       Species();
       Species(const Species& other);
       ~Species();
@@ -269,6 +269,46 @@ bool Readparameters::addDefaultParameters() {
     
 
 
+/** Read a boolean option from the command line and the configuration files
+ * before MPI and Readparameters have been initialized, e.g. for options that
+ * select the requested MPI thread level. Every process reads the files itself.
+ * Options given in environment variables are not seen here.
+ * @param argc Command line argc.
+ * @param argv Command line argv.
+ * @param name Name of the option.
+ * @param value Value of the option, unchanged if the option is not given.
+ * @return If true, the option was read successfully or was not given.
+ */
+bool Readparameters::getBeforeInit(int argc, char* argv[],const string& name,bool& value) {
+   const bool ALLOW_UNKNOWN = true;
+   string globalConfig,userConfig,runConfig,sval;
+   PO::options_description earlyDescriptions;
+   earlyDescriptions.add_options()
+      ("global_config", PO::value<string>(&globalConfig)->default_value(""), "")
+      ("user_config", PO::value<string>(&userConfig)->default_value(""), "")
+      ("run_config", PO::value<string>(&runConfig)->default_value(""), "")
+      (name.c_str(), PO::value<string>(&sval), "");
+   PO::variables_map earlyVariables;
+   try {
+      // Same precedence as in parse: command line, run, user and global config file
+      PO::store(PO::command_line_parser(argc, argv).options(earlyDescriptions).allow_unregistered().run(), earlyVariables);
+      PO::notify(earlyVariables);
+      const string configFiles[3] = {runConfig,userConfig,globalConfig};
+      for (int i=0; i<3; ++i) {
+         if (configFiles[i].size() == 0) continue;
+         ifstream configFile(configFiles[i].c_str(), fstream::in);
+         if (configFile.good() == false) continue;
+         PO::store(PO::parse_config_file(configFile, earlyDescriptions, ALLOW_UNKNOWN), earlyVariables);
+      }
+      PO::notify(earlyVariables);
+      if (earlyVariables.count(name) > 0) value = boost::lexical_cast<bool>(sval);
+   }
+   catch (...) {
+      return false;
+   }
+   return true;
+}
+
 /** Deallocate memory reserved by Parameters.
  * @return If true, class Parameters finalized successfully.
  */
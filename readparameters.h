@@ -56,6 +56,8 @@ struct Readparameters {
     static bool get(const std::string& name,std::vector<double>& value);
 
     
+    static bool getBeforeInit(int argc, char* argv[],const std::string& name,bool& value);
+
     static bool finalize();
     static void helpMessage();
     static bool versionMessage();
@@ -25,6 +25,8 @@
 #include "spatial_cell.hpp"
 #include "velocity_blocks.h"
 #include "object_wrapper.h"
+#include "vlasovsolver/vec.h"
+#include "block_bitmap.h"
 
 #ifndef NDEBUG
    #define DEBUG_SPATIAL_CELL
@@ -33,6 +35,20 @@
 using namespace std;
 
 namespace spatial_cell {
+   #ifndef AMR
+   /** Scratch memory of adjust_velocity_blocks, one per thread.*/
+   struct AdjustBlocksScratch {
+      vmesh::BlockBitmap neighborsHaveContent;
+      std::vector<vmesh::GlobalID> blocksToAdd;
+   };
+
+   static AdjustBlocksScratch& getAdjustBlocksScratch() {
+      static thread_local AdjustBlocksScratch scratch;
+      return scratch;
+   }
+   #endif
+
+
    int SpatialCell::activePopID = 0;
    uint64_t SpatialCell::mpi_transfer_type = 0;
    bool SpatialCell::mpiTransferAtSysBoundaries = false;
@@ -118,43 +134,52 @@ namespace spatial_cell {
       }
       #endif
       
-      //  This set contains all those cellids which have neighbors in any
-      //  of the 6-dimensions Actually, we would only need to add
-      //  local blocks with no content here, as blocks with content
-      //  do not need to be created and also will not be removed as
-      //  we only check for removal for blocks with no content
-      std::unordered_set<vmesh::GlobalID> neighbors_have_content;
-
-      //add neighbor content info for velocity space neighbors to map. We loop over blocks
-      //with content and raise the neighbors_have_content for
-      //itself, and for all its neighbors
+      // Bitmap of all those block global IDs which have content or have neighbors
+      // with content in any of the 6 dimensions. Actually, we would only need
+      // to flag local blocks with no content here, as blocks with content do
+      // not need to be created and also will not be removed as we only check
+      // for removal for blocks with no content. The bitmap and the list of
+      // blocks to add are per-thread scratch memory reused between calls.
+      AdjustBlocksScratch& scratch = getAdjustBlocksScratch();
+      vmesh::BlockBitmap& neighbors_have_content = scratch.neighborsHaveContent;
+      std::vector<vmesh::GlobalID>& blocksToAdd = scratch.blocksToAdd;
+
+      const vmesh::LocalID* gridLength = populations[popID].vmesh.getGridLength(0);
+      const size_t nx = gridLength[0];
+      const size_t nxy = gridLength[0]*gridLength[1];
+      neighbors_have_content.clear(nxy*gridLength[2]);
+
+      //add neighbor content info for velocity space neighbors to the bitmap. We loop over
+      //blocks with content and set the bits of the block itself and of all its
+      //neighbors. Neighbors along vx have consecutive global IDs, so each row of
+      //neighbors is set as one range of bits.
+      const int addWidthV = getObjectWrapper().particleSpecies[popID].sparseBlockAddWidthV;
       for (vmesh::LocalID block_index=0; block_index<velocity_block_with_content_list.size(); ++block_index) {
-         vmesh::GlobalID block = velocity_block_with_content_list[block_index];
-
-         const uint8_t refLevel=0;
+         const vmesh::GlobalID block = velocity_block_with_content_list[block_index];
          const velocity_block_indices_t indices = SpatialCell::get_velocity_block_indices(popID,block);
-         neighbors_have_content.insert(block); //also add the cell itself
 
-         int addWidthV = getObjectWrapper().particleSpecies[popID].sparseBlockAddWidthV;
-         for (int offset_vx=-addWidthV;offset_vx<=addWidthV;offset_vx++) {
+         const size_t i_min = (indices[0] >= (vmesh::LocalID)addWidthV) ? indices[0]-addWidthV : 0;
+         const size_t i_max = min((size_t)indices[0]+addWidthV,nx-1);
+         for (int offset_vz=-addWidthV;offset_vz<=addWidthV;offset_vz++) {
+            const int64_t k = (int64_t)indices[2] + offset_vz;
+            if (k < 0 || k >= gridLength[2]) continue;
             for (int offset_vy=-addWidthV;offset_vy<=addWidthV;offset_vy++) {
-               for (int offset_vz=-addWidthV;offset_vz<=addWidthV;offset_vz++) {
-                  const vmesh::GlobalID neighbor_block 
-                     = get_velocity_block(popID,{{indices[0]+offset_vx,indices[1]+offset_vy,indices[2]+offset_vz}},refLevel);
-                  neighbors_have_content.insert(neighbor_block); //add all potential ngbrs of this block with content
-               }
+               const int64_t j = (int64_t)indices[1] + offset_vy;
+               if (j < 0 || j >= gridLength[1]) continue;
+               const size_t rowStart = j*nx + k*nxy;
+               neighbors_have_content.setRange(rowStart+i_min,rowStart+i_max+1);
             }
          }
       }
 
-      //add neighbor content info for spatial space neighbors to map. We loop over
+      //add neighbor content info for spatial space neighbors to the bitmap. We loop over
       //neighbor cell lists with existing blocks, and raise the
       //flag for the local block with same block id
       for (std::vector<SpatialCell*>::const_iterator neighbor=spatial_neighbors.begin();
            neighbor != spatial_neighbors.end(); ++neighbor) {
          for (vmesh::LocalID block_index=0; block_index<(*neighbor)->velocity_block_with_content_list.size(); ++block_index) {
-            vmesh::GlobalID block = (*neighbor)->velocity_block_with_content_list[block_index];
-            neighbors_have_content.insert(block);
+            const vmesh::GlobalID block = (*neighbor)->velocity_block_with_content_list[block_index];
+            neighbors_have_content.setRange(block,block+1);
          }
       }
 
@@ -170,6 +195,8 @@ namespace spatial_cell {
                exit(1);
             }             
             #endif
+            if (neighbors_have_content.test(blockGID)) continue;
+
             const vmesh::LocalID blockLID = get_velocity_block_local_id(blockGID,popID);            
             #ifdef DEBUG_SPATIAL_CELL
             if (blockLID == invalid_local_id()) {
@@ -177,31 +204,36 @@ namespace spatial_cell {
                exit(1);
             }
             #endif
-            
-            bool removeBlock = false;
-            std::unordered_set<vmesh::GlobalID>::iterator it = neighbors_have_content.find(blockGID);
-            if (it == neighbors_have_content.end()) removeBlock = true;
 
-            if (removeBlock == true) {
-               //No content, and also no neighbor have content -> remove
-               //and increment rho loss counters
-               const Real* block_parameters = get_block_parameters(popID)+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS;
-               const Real DV3 = block_parameters[BlockParams::DVX]
-                 * block_parameters[BlockParams::DVY]
-                 * block_parameters[BlockParams::DVZ];
-               Real sum=0;
-               for (unsigned int i=0; i<WID3; ++i) sum += get_data(popID)[blockLID*SIZE_VELBLOCK+i];
-               this->populations[popID].RHOLOSSADJUST += DV3*sum;
-	       
-               // and finally remove block
-               this->remove_velocity_block(blockGID,popID);
-            }
+            //No content, and also no neighbor have content -> remove
+            //and increment rho loss counters
+            const Real* block_parameters = get_block_parameters(popID)+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS;
+            const Real DV3 = block_parameters[BlockParams::DVX]
+              * block_parameters[BlockParams::DVY]
+              * block_parameters[BlockParams::DVZ];
+            Real sum=0;
+            for (unsigned int i=0; i<WID3; ++i) sum += get_data(popID)[blockLID*SIZE_VELBLOCK+i];
+            this->populations[popID].RHOLOSSADJUST += DV3*sum;
+
+            // and finally remove block
+            this->remove_velocity_block(blockGID,popID);
          }
       }
 
-      // ADD all blocks with neighbors in spatial or velocity space (if it exists then the block is unchanged)
-      for (std::unordered_set<vmesh::GlobalID>::iterator it=neighbors_have_content.begin(); it != neighbors_have_content.end(); ++it) {
-         this->add_velocity_block(*it,popID);
+      // ADD all blocks with neighbors in spatial or velocity space that do not exist
+      // yet. Blocks are added in one go in global ID order.
+      blocksToAdd.clear();
+      const vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>& blockMesh = populations[popID].vmesh;
+      neighbors_have_content.forEachSetBit([&](const size_t& blockGID) {
+            if (blockMesh.getLocalID(blockGID) == invalid_local_id()) blocksToAdd.push_back(blockGID);
+         });
+      if (blocksToAdd.size() == 0) return;
+
+      if (blockMesh.size() + blocksToAdd.size() <= blockMesh.getMaxVelocityBlocks()) {
+         this->add_velocity_blocks(blocksToAdd,popID);
+      } else {
+         // Add as many blocks as fit in the mesh
+         for (size_t b=0; b<blocksToAdd.size(); ++b) this->add_velocity_block(blocksToAdd[b],popID);
       }
    }
 
@@ -507,6 +539,23 @@ namespace spatial_cell {
       }
    }
 
+   /** Check if any value of a velocity block is at or above the sparsity threshold.
+    * The whole block is compared without early exit, the comparison results
+    * are combined with vector or operations.
+    * @param data Pointer to the block data, WID3 values.
+    * @param minValue Sparsity threshold.
+    * @return True if the block has content.*/
+   static inline bool blockDataHasContent(const Realf* data,const Vec& minValue) {
+      Vec values;
+      load_realv(values,data);
+      Vecb hasContent = values >= minValue;
+      for (uint i=VECL; i<WID3; i+=VECL) {
+         load_realv(values,data+i);
+         hasContent = hasContent || (values >= minValue);
+      }
+      return horizontal_or(hasContent);
+   }
+
    /*!
     Returns true if given velocity block has enough of a distribution function.
     Returns false if the value of the distribution function is too low in every
@@ -526,17 +575,8 @@ namespace spatial_cell {
       const vmesh::LocalID blockLID = get_velocity_block_local_id(blockGID,popID);
       if (blockLID == invalid_local_id()) return false;
             
-      bool has_content = false;
-      const Real velocity_block_min_value = getVelocityBlockMinValue(popID);
-      const Realf* block_data = populations[popID].blockContainer.getData(blockLID);
-      for (unsigned int i=0; i<VELOCITY_BLOCK_LENGTH; ++i) {
-         if (block_data[i] >= velocity_block_min_value) {
-            has_content = true;
-            break;
-         }
-      }
-      
-      return has_content;
+      const Vec velocity_block_min_value(getVelocityBlockMinValue(popID));
+      return blockDataHasContent(populations[popID].blockContainer.getData(blockLID),velocity_block_min_value);
    }
    
    /** Get maximum translation timestep for the given species.
@@ -1394,6 +1434,9 @@ namespace spatial_cell {
    }
 
    /** Update the two lists containing blocks with content, and blocks without content.
+    * Blocks are processed in local ID order directly from the block container,
+    * so no global to local ID lookups are needed. The content of 64 blocks is
+    * first collected into a bitmask, which is then expanded into the two lists.
     * @see adjustVelocityBlocks */
    void SpatialCell::update_velocity_block_content_lists(const uint popID) {
       #ifdef DEBUG_SPATIAL_CELL
@@ -1406,13 +1449,27 @@ namespace spatial_cell {
       
       velocity_block_with_content_list.clear();
       velocity_block_with_no_content_list.clear();
-      
-      for (vmesh::LocalID block_index=0; block_index<populations[popID].vmesh.size(); ++block_index) {
-         const vmesh::GlobalID globalID = populations[popID].vmesh.getGlobalID(block_index);
-         if (compute_block_has_content(globalID,popID)){
-            velocity_block_with_content_list.push_back(globalID);
-         } else {
-            velocity_block_with_no_content_list.push_back(globalID);
+
+      const vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>& blockMesh = populations[popID].vmesh;
+      const vmesh::LocalID nBlocks = blockMesh.size();
+      const Realf* data = populations[popID].blockContainer.getData();
+      const Vec velocity_block_min_value(getVelocityBlockMinValue(popID));
+
+      for (vmesh::LocalID startLID=0; startLID<nBlocks; startLID+=64) {
+         const vmesh::LocalID endLID = min(startLID+64,nBlocks);
+         uint64_t contentMask = 0;
+         for (vmesh::LocalID blockLID=startLID; blockLID<endLID; ++blockLID) {
+            const uint64_t hasContent = blockDataHasContent(data+blockLID*WID3,velocity_block_min_value);
+            contentMask |= hasContent << (blockLID-startLID);
+         }
+
+         for (vmesh::LocalID blockLID=startLID; blockLID<endLID; ++blockLID) {
+            const vmesh::GlobalID globalID = blockMesh.getGlobalID(blockLID);
+            if ((contentMask >> (blockLID-startLID)) & 1) {
+               velocity_block_with_content_list.push_back(globalID);
+            } else {
+               velocity_block_with_no_content_list.push_back(globalID);
+            }
          }
       }
    }
@@ -682,7 +682,11 @@ void SysBoundary::applySysBoundaryVlasovConditions(
       #pragma omp parallel for
       for (uint i=0; i<localCells.size(); i++) {
          cuint sysBoundaryType = mpiGrid[localCells[i]]->sysBoundaryFlag;
+         const double t1 = P::prepareForRebalance ? MPI_Wtime() : 0.0;
          this->getSysBoundary(sysBoundaryType)->vlasovBoundaryCondition(mpiGrid,localCells[i],popID,calculate_V_moments);
+         if (P::prepareForRebalance) {
+            mpiGrid[localCells[i]]->parameters[CellParams::LBCOSTCOUNTER] += MPI_Wtime() - t1;
+         }
       }
       if (calculate_V_moments) {
          calculateMoments_V(mpiGrid, localCells, true);
@@ -704,7 +708,11 @@ void SysBoundary::applySysBoundaryVlasovConditions(
       #pragma omp parallel for
       for (uint i=0; i<boundaryCells.size(); i++) {
          cuint sysBoundaryType = mpiGrid[boundaryCells[i]]->sysBoundaryFlag;
+         const double t1 = P::prepareForRebalance ? MPI_Wtime() : 0.0;
          this->getSysBoundary(sysBoundaryType)->vlasovBoundaryCondition(mpiGrid, boundaryCells[i],popID,calculate_V_moments);
+         if (P::prepareForRebalance) {
+            mpiGrid[boundaryCells[i]]->parameters[CellParams::LBCOSTCOUNTER] += MPI_Wtime() - t1;
+         }
       }
       if (calculate_V_moments) {
          calculateMoments_V(mpiGrid, boundaryCells, true);
@@ -102,9 +102,16 @@ do
     then
 ##Compare test case with right solutions
         echo "--------------------------------------------------------------------------------------------" 
-        echo "${test_name[$run]}  -  Verifying ${revision}_$solveropts against $reference_revision"    
-        echo "--------------------------------------------------------------------------------------------" 
-        result_dir=${reference_dir}/${reference_revision}/${test_name[$run]}
+        if [[ ${comparison_test[$run]} ]]; then
+            # Compare against another test of this run
+            echo "${test_name[$run]}  -  Verifying ${revision}_$solveropts against ${comparison_test[$run]}"
+            echo "--------------------------------------------------------------------------------------------" 
+            result_dir=${run_dir}/${comparison_test[$run]}
+        else
+            echo "${test_name[$run]}  -  Verifying ${revision}_$solveropts against $reference_revision"    
+            echo "--------------------------------------------------------------------------------------------" 
+            result_dir=${reference_dir}/${reference_revision}/${test_name[$run]}
+        fi
 
      #print header
 
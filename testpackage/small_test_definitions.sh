@@ -16,7 +16,7 @@ run_dir="run"
 test_dir="tests"
 
 # choose tests to run
-run_tests=( 1 2 3 4 5 6 7 8 9 10 11 12 13 14 17)
+run_tests=( 1 2 3 4 5 6 7 8 9 10 11 12 13 14 17 19)
 
 # acceleration test
 test_name[1]="acctest_2_maxw_500k_100k_20kms_10deg"
@@ -144,3 +144,12 @@ comparison_vlsv[18]="bulk.0000001.vlsv"
 comparison_phiprof[18]="phiprof_0.txt"
 variable_names[18]="proton/vg_rho proton/vg_v proton/vg_v proton/vg_v fg_b fg_b fg_b fg_e fg_e fg_e"
 variable_components[18]="0 0 1 2 0 1 2 0 1 2"
+
+# Polar magnetosphere with decoupled acceleration subcycles, compared against
+# test 9 (same setup, global subcycle loop) of this run instead of a reference
+test_name[19]="Magnetosphere_polar_small_decoupled"
+comparison_test[19]="Magnetosphere_polar_small"
+comparison_vlsv[19]="bulk.0000001.vlsv"
+comparison_phiprof[19]="phiprof_0.txt"
+variable_names[19]="proton/vg_rho proton/vg_v proton/vg_v proton/vg_v fg_b fg_b fg_b fg_e fg_e fg_e proton/vg_v_nonthermal proton/vg_v_nonthermal proton/vg_v_nonthermal proton/vg_ptensor_nonthermal_diagonal proton/vg_ptensor_nonthermal_diagonal proton/vg_ptensor_nonthermal_diagonal proton"
+variable_components[19]="0 0 1 2 0 1 2 0 1 2 0 1 2 0 1 2"
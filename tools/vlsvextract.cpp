@@ -155,7 +155,7 @@ bool convertSlicedVelocityMesh(vlsvinterface::Reader& vlsvReader,const string& f
    // Get the names of velocity mesh variables
    set<string> blockVarNames;
    const string attributeName = "name";
-   if (vlsvReader.getUniqueAttributeValues("BLOCKVARIABLE",attributeName,blockVarNames) == false) {
+   if (vlsvReader.getBlockVariableNames(attributeName,blockVarNames) == false) {
       cerr << "ERROR, FAILED TO GET UNIQUE ATTRIBUTE VALUES AT " << __FILE__ << " " << __LINE__ << endl;
    }
 
@@ -201,13 +201,9 @@ bool convertSlicedVelocityMesh(vlsvinterface::Reader& vlsvReader,const string& f
       // Store block variable info, we need this to write the variable data
       varInfo.clear();
       for (set<string>::const_iterator var=blockVarNames.begin(); var!=blockVarNames.end(); ++var) {
-         list<pair<string,string> > attribs;
-         attribs.push_back(make_pair("name",*var));
-         attribs.push_back(make_pair("mesh",meshName));
-         uint64_t arraySize;
          BlockVarInfo vinfo;
          vinfo.name = *var;
-         if (vlsvReader.getArrayInfo("BLOCKVARIABLE",attribs,arraySize,vinfo.vectorSize,vinfo.dataType,vinfo.dataSize) == false) {
+         if (vlsvReader.getBlockVariableInfo(*var,vinfo.vectorSize,vinfo.dataType,vinfo.dataSize) == false) {
             cerr << "Could not read BLOCKVARIABLE array info" << endl;
          }
          varInfo.push_back(vinfo);
@@ -869,7 +865,7 @@ bool convertVelocityBlocks2(
    // which are stored in their separate meshes.
    set<string> blockVarNames;
    const string attributeName = "name";
-   if (vlsvReader.getUniqueAttributeValues( "BLOCKVARIABLE", attributeName, blockVarNames) == false) {
+   if (vlsvReader.getBlockVariableNames(attributeName, blockVarNames) == false) {
       cerr << "ERROR, FAILED TO GET UNIQUE ATTRIBUTE VALUES AT " << __FILE__ << " " << __LINE__ << endl;
    }
 
@@ -879,20 +875,17 @@ bool convertVelocityBlocks2(
          // Only accept the population that belongs to this mesh
          if (*it != popName) continue;
 
-         list<pair<string, string> > attribs;
-         attribs.push_back(make_pair("name", *it));
-         attribs.push_back(make_pair("mesh", meshName));
          datatype::type dataType;
-         uint64_t arraySize, vectorSize, dataSize;
-         if (vlsvReader.getArrayInfo("BLOCKVARIABLE", attribs, arraySize, vectorSize, dataType, dataSize) == false) {
+         uint64_t vectorSize, dataSize;
+         if (vlsvReader.getBlockVariableInfo(*it, vectorSize, dataType, dataSize) == false) {
             cerr << "Could not read BLOCKVARIABLE array info in " << __FILE__ << ":" << __LINE__ << endl;
             return false;
          }
-	 
-         char* buffer = new char[N_blocks * vectorSize * dataSize];
-         if (vlsvReader.readArray("BLOCKVARIABLE", attribs, vlsvReader.getBlockOffset(cellID), N_blocks, buffer) == false) {
+
+         // Reads BLOCKVARIABLE, or decompresses COMPRESSEDBLOCKVARIABLE
+         char* buffer = NULL;
+         if (vlsvReader.getVelocityBlockVariables(*it, cellID, buffer, true) == false) {
             cerr << "ERROR could not read block variable in " << __FILE__ << ":" << __LINE__ << endl;
-            delete[] buffer;
             return success;
          }
 
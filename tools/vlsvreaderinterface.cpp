@@ -20,7 +20,9 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 #include <iostream>
+#include <cstdlib>
 #include "vlsvreaderinterface.h"
+#include "../velocity_block_codec.h"
 
 using namespace std;
 
@@ -207,6 +209,7 @@ namespace vlsvinterface {
       if(cellsWithBlocksLocations.empty() == false) {
          cellsWithBlocksLocations.clear();
       }
+      compressedBlockLocations.clear();
       vlsv::datatype::type cwb_dataType;
       uint64_t cwb_arraySize, cwb_vectorSize, cwb_dataSize;
       list<pair<string, string> > attribs;
@@ -279,6 +282,34 @@ namespace vlsvinterface {
          blockOffset += N_blocks;
       }
    
+      // Compressed velocity block data has the length of each cell in an array of its own
+      vlsv::datatype::type cb_dataType;
+      uint64_t cb_arraySize, cb_vectorSize, cb_dataSize;
+      if (getArrayInfo(vcodec::BYTES_ARRAY_NAME, attribs, cb_arraySize, cb_vectorSize, cb_dataType, cb_dataSize) == true) {
+         if (cb_arraySize != cwb_arraySize || cb_dataType != vlsv::datatype::type::UINT) {
+            cerr << "ERROR, BAD " << vcodec::BYTES_ARRAY_NAME << " AT " << __FILE__ << " " << __LINE__ << endl;
+            delete[] cwb_buffer;
+            delete[] nb_buffer;
+            return false;
+         }
+         char* cb_buffer = new char[cb_arraySize * cb_vectorSize * cb_dataSize];
+         if (readArray(vcodec::BYTES_ARRAY_NAME, attribs, startingPoint, cb_arraySize, cb_buffer) == false) {
+            cerr << "Failed to read compressed block lengths for mesh '" << meshName << "'" << endl;
+            delete[] cb_buffer;
+            delete[] nb_buffer;
+            delete[] cwb_buffer;
+            return false;
+         }
+         uint64_t byteOffset = 0;
+         for (uint64_t cell = 0; cell < cwb_arraySize; ++cell) {
+            const uint64_t readCellID = convUInt(cwb_buffer + cell*cwb_dataSize, cwb_dataType, cwb_dataSize);
+            const uint64_t N_bytes = convUInt(cb_buffer + cell*cb_dataSize, cb_dataType, cb_dataSize);
+            compressedBlockLocations.insert( make_pair(readCellID, make_pair(byteOffset, N_bytes)) );
+            byteOffset += N_bytes;
+         }
+         delete[] cb_buffer;
+      }
+
       delete[] cwb_buffer;
       delete[] nb_buffer;
       cellsWithBlocksSet = true;
@@ -357,8 +388,11 @@ namespace vlsvinterface {
       vlsv::datatype::type dataType;
       uint64_t arraySize, vectorSize, dataSize;
       if (getArrayInfo("BLOCKVARIABLE", attribs, arraySize, vectorSize, dataType, dataSize) == false) {
-         cerr << "Could not read BLOCKVARIABLE array info" << endl;
-         return false;
+         if (getArrayInfo(vcodec::ARRAY_NAME, attribs, arraySize, vectorSize, dataType, dataSize) == false) {
+            cerr << "Could not read BLOCKVARIABLE array info" << endl;
+            return false;
+         }
+         return getCompressedBlockVariables(variableName, cellId, get<1>(it->second), buffer, allocateMemory);
       }
    
       //Get offset and number of blocks
@@ -380,4 +414,74 @@ namespace vlsvinterface {
       return true;
    }
 
+   bool Reader::getCompressedBlockVariables(const string & variableName,const uint64_t & cellId,const uint32_t N_blocks,
+                                            char*& buffer,bool allocateMemory ) {
+      unordered_map<uint64_t, pair<uint64_t, uint64_t>>::const_iterator it = compressedBlockLocations.find( cellId );
+      if( it == compressedBlockLocations.end() ) {
+         cerr << "COULDNT FIND COMPRESSED DATA OF CELL ID " << cellId << " AT " << __FILE__ << " " << __LINE__ << endl;
+         return false;
+      }
+
+      vlsv::datatype::type dataType;
+      uint64_t vectorSize, dataSize;
+      if (getBlockVariableInfo(variableName, vectorSize, dataType, dataSize) == false) return false;
+
+      list<pair<string, string> > attribs;
+      attribs.push_back(make_pair("name", variableName));
+      attribs.push_back(make_pair("mesh", "SpatialGrid"));
+      const uint64_t byteOffset = get<0>(it->second);
+      const uint64_t N_bytes = get<1>(it->second);
+      char* streamBuffer = new char[N_bytes];
+      if (readArray(vcodec::ARRAY_NAME, attribs, byteOffset, N_bytes, streamBuffer) == false) {
+         cerr << "ERROR could not read compressed block variable" << endl;
+         delete[] streamBuffer;
+         return false;
+      }
+
+      if( allocateMemory == true ) {
+         buffer = new char[N_blocks * vectorSize * dataSize];
+      }
+      const bool success = vcodec::decode(reinterpret_cast<unsigned char*>(streamBuffer), N_bytes,
+                                          (uint64_t)N_blocks * vectorSize, dataSize, buffer);
+      delete[] streamBuffer;
+      if (success == false) {
+         cerr << "ERROR could not decompress block variable of cell " << cellId << endl;
+         if( allocateMemory == true ) {
+            delete[] buffer; buffer = NULL;
+         }
+      }
+      return success;
+   }
+
+   bool Reader::getBlockVariableInfo(const string & variableName,uint64_t & vectorSize,vlsv::datatype::type & dataType,uint64_t & dataSize ) {
+      list<pair<string, string> > attribs;
+      attribs.push_back(make_pair("name", variableName));
+      attribs.push_back(make_pair("mesh", "SpatialGrid"));
+      uint64_t arraySize;
+      if (getArrayInfo("BLOCKVARIABLE", attribs, arraySize, vectorSize, dataType, dataSize) == true) return true;
+
+      // Compressed data, the original layout is stored in the attributes
+      map<string, string> attribsOut;
+      if (getArrayAttributes(vcodec::ARRAY_NAME, attribs, attribsOut) == false) {
+         cerr << "Could not read BLOCKVARIABLE array info" << endl;
+         return false;
+      }
+      if (attribsOut["original_datatype"] != "float") {
+         cerr << "ERROR, unsupported compressed datatype '" << attribsOut["original_datatype"] << "'" << endl;
+         return false;
+      }
+      dataType = vlsv::datatype::type::FLOAT;
+      dataSize = atoi(attribsOut["original_datasize"].c_str());
+      vectorSize = atoi(attribsOut["original_vectorsize"].c_str());
+      return true;
+   }
+
+   bool Reader::getBlockVariableNames(const string & attributeName,set<string> & names ) {
+      set<string> compressedNames;
+      const bool found = getUniqueAttributeValues("BLOCKVARIABLE", attributeName, names);
+      const bool foundCompressed = getUniqueAttributeValues(vcodec::ARRAY_NAME, attributeName, compressedNames);
+      names.insert(compressedNames.begin(), compressedNames.end());
+      return found || foundCompressed;
+   }
+
 } // namespace vlsvinterface
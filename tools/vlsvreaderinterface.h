@@ -40,8 +40,10 @@ namespace vlsvinterface {
    private:
       std::unordered_map<uint64_t, uint64_t> cellIdLocations;
       std::unordered_map<uint64_t, std::pair<uint64_t, uint32_t> > cellsWithBlocksLocations;
+      std::unordered_map<uint64_t, std::pair<uint64_t, uint64_t> > compressedBlockLocations; /**< Byte offset and length of compressed cells.*/
       bool cellIdsSet;
       bool cellsWithBlocksSet;
+      bool getCompressedBlockVariables( const std::string & variableName, const uint64_t & cellId, const uint32_t N_blocks, char*& buffer, bool allocateMemory );
    public:
       Reader();
       virtual ~Reader();
@@ -62,9 +64,15 @@ namespace vlsvinterface {
       bool setCellsWithBlocks(const std::string& meshName,const std::string& popName);
       inline void clearCellsWithBlocks() {
          cellsWithBlocksLocations.clear();
+         compressedBlockLocations.clear();
          cellsWithBlocksSet = false;
       }
+      //Reads in velocity block data of a cell, compressed data is decompressed transparently:
       bool getVelocityBlockVariables( const std::string & variableName, const uint64_t & cellId, char*& buffer, bool allocateMemory = true );
+      //Info of velocity block data as returned by getVelocityBlockVariables:
+      bool getBlockVariableInfo( const std::string & variableName, uint64_t & vectorSize, vlsv::datatype::type & dataType, uint64_t & dataSize );
+      //Names of all populations with velocity block data, compressed or not:
+      bool getBlockVariableNames( const std::string & attributeName, std::set<std::string> & names );
 
       inline uint64_t getBlockOffset( const uint64_t & cellId ) {
          //Check if the cell id can be found:
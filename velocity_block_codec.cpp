@@ -0,0 +1,310 @@
+/*
+ * This file is part of Vlasiator.
+ * Copyright 2010-2016 Finnish Meteorological Institute
+ *
+ * For details of usage, see the COPYING file and read the "Rules of the Road"
+ * at http://www.physics.helsinki.fi/vlasiator/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <cmath>
+#include <cstring>
+
+#include "velocity_block_codec.h"
+
+using namespace std;
+
+namespace vcodec {
+
+   // Stream layout of one cell:
+   //   uint8 cell mode (CELL_SHUFFLED or CELL_QUANTIZED)
+   //   [double quantization step, if CELL_QUANTIZED]
+   //   one plane per byte of the (possibly quantized) element, each plane:
+   //     uint8 plane mode
+   //     PLANE_RAW:      nValues bytes
+   //     PLANE_CONSTANT: one byte
+   //     PLANE_RANS:     32 byte symbol bitmap, uint16 frequency of each present symbol,
+   //                     uint32 payload length, payload
+   // Multi-byte integers are little-endian.
+   enum CellMode {CELL_SHUFFLED=0,CELL_QUANTIZED=1};
+   enum PlaneMode {PLANE_RAW=0,PLANE_CONSTANT=1,PLANE_RANS=2};
+
+   const uint32_t PROB_BITS  = 12;
+   const uint32_t PROB_SCALE = 1 << PROB_BITS;
+   const uint32_t RANS_L     = 1u << 23;      /**< Lower bound of the normalized rANS state.*/
+
+   static void appendBytes(vector<unsigned char>& output,const uint64_t value,const int nBytes) {
+      for (int i=0; i<nBytes; ++i) output.push_back((value >> (8*i)) & 0xFF);
+   }
+
+   /** Bounds checked reading of a compressed stream.*/
+   struct StreamReader {
+      const unsigned char* data;
+      uint64_t size;
+      uint64_t position;
+
+      bool read(uint64_t& value,const int nBytes) {
+         if (position + nBytes > size) return false;
+         value = 0;
+         for (int i=0; i<nBytes; ++i) value |= (uint64_t)data[position+i] << (8*i);
+         position += nBytes;
+         return true;
+      }
+   };
+
+   /** Normalize symbol counts of a plane to frequencies summing to PROB_SCALE, each present
+    * symbol gets at least frequency one.*/
+   static void normalizeFrequencies(const uint64_t counts[256],const uint64_t n,uint32_t freqs[256]) {
+      uint32_t nSymbols = 0;
+      for (int s=0; s<256; ++s) if (counts[s] > 0) ++nSymbols;
+
+      uint32_t sum = 0;
+      int mostFrequent = 0;
+      for (int s=0; s<256; ++s) {
+         freqs[s] = 0;
+         if (counts[s] == 0) continue;
+         freqs[s] = 1 + (counts[s]*(PROB_SCALE-nSymbols))/n;
+         sum += freqs[s];
+         if (counts[s] > counts[mostFrequent]) mostFrequent = s;
+      }
+      // sum is at most PROB_SCALE, rounding remainder goes to the most frequent symbol
+      freqs[mostFrequent] += PROB_SCALE - sum;
+   }
+
+   static void encodePlane(const unsigned char* plane,const uint64_t n,vector<unsigned char>& output) {
+      // Planes of cells without blocks are empty raw planes, plane may be NULL
+      if (n == 0) {
+         output.push_back(PLANE_RAW);
+         return;
+      }
+      uint64_t counts[256] = {0};
+      for (uint64_t i=0; i<n; ++i) ++counts[plane[i]];
+
+      uint32_t nSymbols = 0;
+      for (int s=0; s<256; ++s) if (counts[s] > 0) ++nSymbols;
+      if (nSymbols == 1) {
+         output.push_back(PLANE_CONSTANT);
+         output.push_back(plane[0]);
+         return;
+      }
+
+      uint32_t freqs[256];
+      uint32_t cumFreqs[256];
+      normalizeFrequencies(counts,n,freqs);
+      uint32_t cum = 0;
+      for (int s=0; s<256; ++s) {
+         cumFreqs[s] = cum;
+         cum += freqs[s];
+      }
+
+      // rANS encodes backwards, the payload is reversed afterwards so that the decoder reads forwards
+      vector<unsigned char> payload;
+      payload.reserve(n/2 + 16);
+      uint32_t x = RANS_L;
+      for (uint64_t i=n; i>0; --i) {
+         const unsigned char s = plane[i-1];
+         const uint32_t freq = freqs[s];
+         const uint32_t xMax = ((RANS_L >> PROB_BITS) << 8) * freq;
+         while (x >= xMax) {
+            payload.push_back(x & 0xFF);
+            x >>= 8;
+         }
+         x = ((x / freq) << PROB_BITS) + (x % freq) + cumFreqs[s];
+      }
+      for (int i=0; i<4; ++i) {
+         payload.push_back(x & 0xFF);
+         x >>= 8;
+      }
+
+      const uint64_t headerBytes = 1 + 32 + 2*nSymbols + 4;
+      if (headerBytes + payload.size() >= n + 1) {
+         output.push_back(PLANE_RAW);
+         output.insert(output.end(),plane,plane+n);
+         return;
+      }
+
+      output.push_back(PLANE_RANS);
+      unsigned char bitmap[32] = {0};
+      for (int s=0; s<256; ++s) if (freqs[s] > 0) bitmap[s/8] |= 1 << (s%8);
+      output.insert(output.end(),bitmap,bitmap+32);
+      for (int s=0; s<256; ++s) if (freqs[s] > 0) appendBytes(output,freqs[s],2);
+      appendBytes(output,payload.size(),4);
+      output.insert(output.end(),payload.rbegin(),payload.rend());
+   }
+
+   static bool decodePlane(StreamReader& stream,const uint64_t n,unsigned char* plane) {
+      uint64_t mode;
+      if (stream.read(mode,1) == false) return false;
+
+      if (mode == PLANE_RAW) {
+         if (stream.position + n > stream.size) return false;
+         if (n > 0) memcpy(plane,stream.data + stream.position,n);
+         stream.position += n;
+         return true;
+      }
+      if (mode == PLANE_CONSTANT) {
+         uint64_t value;
+         if (stream.read(value,1) == false) return false;
+         if (n > 0) memset(plane,(int)value,n);
+         return true;
+      }
+      if (mode != PLANE_RANS) return false;
+
+      if (stream.position + 32 > stream.size) return false;
+      const unsigned char* bitmap = stream.data + stream.position;
+      stream.position += 32;
+      uint32_t freqs[256];
+      uint32_t cumFreqs[256];
+      uint32_t cum = 0;
+      for (int s=0; s<256; ++s) {
+         uint64_t freq = 0;
+         if (bitmap[s/8] & (1 << (s%8))) {
+            if (stream.read(freq,2) == false) return false;
+         }
+         freqs[s] = freq;
+         cumFreqs[s] = cum;
+         cum += freq;
+      }
+      if (cum != PROB_SCALE) return false;
+
+      vector<unsigned char> slotToSymbol(PROB_SCALE);
+      for (int s=0; s<256; ++s) {
+         for (uint32_t slot=cumFreqs[s]; slot<cumFreqs[s]+freqs[s]; ++slot) slotToSymbol[slot] = s;
+      }
+
+      uint64_t payloadBytes;
+      if (stream.read(payloadBytes,4) == false) return false;
+      if (payloadBytes < 4 || stream.position + payloadBytes > stream.size) return false;
+      const unsigned char* payload = stream.data + stream.position;
+      const unsigned char* payloadEnd = payload + payloadBytes;
+      stream.position += payloadBytes;
+
+      uint32_t x = ((uint32_t)payload[0] << 24) | ((uint32_t)payload[1] << 16) | ((uint32_t)payload[2] << 8) | payload[3];
+      payload += 4;
+      for (uint64_t i=0; i<n; ++i) {
+         const uint32_t slot = x & (PROB_SCALE-1);
+         const unsigned char s = slotToSymbol[slot];
+         plane[i] = s;
+         x = freqs[s] * (x >> PROB_BITS) + slot - cumFreqs[s];
+         while (x < RANS_L) {
+            if (payload == payloadEnd) return false;
+            x = (x << 8) | *payload++;
+         }
+      }
+      return true;
+   }
+
+   /** Shuffle the bytes of nValues elements of elementSize bytes into planes and code each plane.*/
+   static void encodeShuffled(const unsigned char* data,const uint64_t nValues,const uint32_t elementSize,
+                              vector<unsigned char>& output) {
+      vector<unsigned char> plane(nValues);
+      for (uint32_t b=0; b<elementSize; ++b) {
+         for (uint64_t i=0; i<nValues; ++i) plane[i] = data[i*elementSize + b];
+         encodePlane(plane.data(),nValues,output);
+      }
+   }
+
+   static bool decodeShuffled(StreamReader& stream,const uint64_t nValues,const uint32_t elementSize,
+                              unsigned char* data) {
+      vector<unsigned char> plane(nValues);
+      for (uint32_t b=0; b<elementSize; ++b) {
+         if (decodePlane(stream,nValues,plane.data()) == false) return false;
+         for (uint64_t i=0; i<nValues; ++i) data[i*elementSize + b] = plane[i];
+      }
+      return true;
+   }
+
+   template<typename T>
+   static bool quantize(const T* values,const uint64_t nValues,const double step,vector<uint32_t>& quantized) {
+      const double maxQ = 2147483647.0;
+      quantized.resize(nValues);
+      for (uint64_t i=0; i<nValues; ++i) {
+         const double q = nearbyint(values[i] / step);
+         if (!(fabs(q) <= maxQ)) return false; // also catches nan and inf
+         const int32_t qi = (int32_t)q;
+         // Zigzag encoding keeps small negative values small
+         quantized[i] = ((uint32_t)qi << 1) ^ (uint32_t)(qi >> 31);
+      }
+      return true;
+   }
+
+   template<typename T>
+   static void dequantize(const uint32_t* quantized,const uint64_t nValues,const double step,T* values) {
+      for (uint64_t i=0; i<nValues; ++i) {
+         const int32_t qi = (int32_t)((quantized[i] >> 1) ^ (0u - (quantized[i] & 1)));
+         values[i] = (T)(qi * step);
+      }
+   }
+
+   bool parseCodec(const string& name,Codec& codec) {
+      if (name == "none") codec = NONE;
+      else if (name == "lossless") codec = LOSSLESS;
+      else if (name == "lossy") codec = LOSSY;
+      else return false;
+      return true;
+   }
+
+   string codecName(const Codec codec) {
+      switch (codec) {
+       case LOSSLESS: return "lossless";
+       case LOSSY: return "lossy";
+       default: return "none";
+      }
+   }
+
+   void encode(const char* data,const uint64_t nValues,const uint32_t dataSize,
+               const double quantizationStep,vector<unsigned char>& output) {
+      if (quantizationStep > 0) {
+         vector<uint32_t> quantized;
+         bool fits = false;
+         if (dataSize == sizeof(float)) fits = quantize(reinterpret_cast<const float*>(data),nValues,quantizationStep,quantized);
+         else if (dataSize == sizeof(double)) fits = quantize(reinterpret_cast<const double*>(data),nValues,quantizationStep,quantized);
+         if (fits) {
+            output.push_back(CELL_QUANTIZED);
+            uint64_t stepBits;
+            memcpy(&stepBits,&quantizationStep,sizeof(double));
+            appendBytes(output,stepBits,8);
+            encodeShuffled(reinterpret_cast<const unsigned char*>(quantized.data()),nValues,sizeof(uint32_t),output);
+            return;
+         }
+      }
+      output.push_back(CELL_SHUFFLED);
+      encodeShuffled(reinterpret_cast<const unsigned char*>(data),nValues,dataSize,output);
+   }
+
+   bool decode(const unsigned char* input,const uint64_t inputBytes,const uint64_t nValues,
+               const uint32_t dataSize,char* output) {
+      StreamReader stream = {input,inputBytes,0};
+      uint64_t mode;
+      if (stream.read(mode,1) == false) return false;
+
+      if (mode == CELL_SHUFFLED) {
+         return decodeShuffled(stream,nValues,dataSize,reinterpret_cast<unsigned char*>(output));
+      }
+      if (mode != CELL_QUANTIZED) return false;
+
+      uint64_t stepBits;
+      if (stream.read(stepBits,8) == false) return false;
+      double step;
+      memcpy(&step,&stepBits,sizeof(double));
+      vector<uint32_t> quantized(nValues);
+      if (decodeShuffled(stream,nValues,sizeof(uint32_t),reinterpret_cast<unsigned char*>(quantized.data())) == false) return false;
+      if (dataSize == sizeof(float)) dequantize(quantized.data(),nValues,step,reinterpret_cast<float*>(output));
+      else if (dataSize == sizeof(double)) dequantize(quantized.data(),nValues,step,reinterpret_cast<double*>(output));
+      else return false;
+      return true;
+   }
+
+} // namespace vcodec
@@ -0,0 +1,81 @@
+/*
+ * This file is part of Vlasiator.
+ * Copyright 2010-2016 Finnish Meteorological Institute
+ *
+ * For details of usage, see the COPYING file and read the "Rules of the Road"
+ * at http://www.physics.helsinki.fi/vlasiator/
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef VELOCITY_BLOCK_CODEC_H
+#define VELOCITY_BLOCK_CODEC_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** Compression of velocity distribution function data in output files.
+ *
+ * The distribution function of each spatial cell is compressed into an independent
+ * byte stream, so that cells can be decoded separately (restart reading, vlsvextract).
+ * The streams of all cells are written into the array COMPRESSEDBLOCKVARIABLE, and the
+ * stream lengths, in CELLSWITHBLOCKS order, into COMPRESSEDBYTESPERCELL.
+ *
+ * Lossless: the bytes of the values are shuffled into byte planes (all first bytes,
+ * all second bytes, ...) and each plane is entropy coded with an order-0 rANS coder.
+ * Exponent planes of f are very compressible, the lowest mantissa bytes are stored
+ * as is if coding does not pay off.
+ *
+ * Lossy: values are quantized to integer multiples of a step, the absolute error is at
+ * most step/2. The quantized integers are then coded as in the lossless codec. Cells
+ * with values that do not fit into the quantization range are coded losslessly.
+ *
+ * The codec does not depend on Vlasiator types, it is also linked into the tools.*/
+namespace vcodec {
+
+   enum Codec {
+      NONE,                             /**< Raw BLOCKVARIABLE array, no compression.*/
+      LOSSLESS,                         /**< Byte-plane shuffle and rANS coding.*/
+      LOSSY                             /**< Error-bounded quantization, then as LOSSLESS.*/
+   };
+
+   const std::string ARRAY_NAME = "COMPRESSEDBLOCKVARIABLE";
+   const std::string BYTES_ARRAY_NAME = "COMPRESSEDBYTESPERCELL";
+
+   bool parseCodec(const std::string& name,Codec& codec);
+   std::string codecName(const Codec codec);
+
+   /** Compress the distribution function of one spatial cell and append the stream to output.
+    * @param data Values to compress, float or double.
+    * @param nValues Number of values.
+    * @param dataSize Size of one value in bytes, sizeof(float) or sizeof(double).
+    * @param quantizationStep If larger than zero, values are quantized with this step.
+    * @param output Compressed stream is appended here.*/
+   void encode(const char* data,const uint64_t nValues,const uint32_t dataSize,
+               const double quantizationStep,std::vector<unsigned char>& output);
+
+   /** Decompress a stream created by encode.
+    * @param input Compressed stream of one spatial cell.
+    * @param inputBytes Length of the compressed stream.
+    * @param nValues Number of values in the stream.
+    * @param dataSize Size of one value in bytes, same as given to encode.
+    * @param output Buffer of nValues*dataSize bytes for the decompressed values.
+    * @return If true, the stream was decoded successfully.*/
+   bool decode(const unsigned char* input,const uint64_t inputBytes,const uint64_t nValues,
+               const uint32_t dataSize,char* output);
+
+} // namespace vcodec
+
+#endif
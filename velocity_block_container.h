@@ -74,11 +74,11 @@ namespace vmesh {
       void exitInvalidLocalID(const LID& localID,const std::string& funcName) const;
       void resize();
       
-      std::vector<Realf,aligned_allocator<Realf,WID3> > block_data;
+      std::vector<Realf,pool_allocator<Realf,WID3> > block_data;
       Realf null_block_data[WID3];
       LID currentCapacity;
       LID numberOfBlocks;
-      std::vector<Real,aligned_allocator<Real,BlockParams::N_VELOCITY_BLOCK_PARAMS> > parameters;
+      std::vector<Real,pool_allocator<Real,BlockParams::N_VELOCITY_BLOCK_PARAMS> > parameters;
    };
    
    template<typename LID> inline
@@ -101,8 +101,8 @@ namespace vmesh {
     * reserved for velocity blocks.*/
    template<typename LID> inline
    void VelocityBlockContainer<LID>::clear() {
-      std::vector<Realf,aligned_allocator<Realf,WID3> > dummy_data;
-      std::vector<Real,aligned_allocator<Real,BlockParams::N_VELOCITY_BLOCK_PARAMS> > dummy_parameters;
+      std::vector<Realf,pool_allocator<Realf,WID3> > dummy_data;
+      std::vector<Real,pool_allocator<Real,BlockParams::N_VELOCITY_BLOCK_PARAMS> > dummy_parameters;
       
       block_data.swap(dummy_data);
       parameters.swap(dummy_parameters);
@@ -268,17 +268,18 @@ namespace vmesh {
    template<typename LID> inline
    bool VelocityBlockContainer<LID>::recapacitate(const LID& newCapacity) {
       if (newCapacity < numberOfBlocks) return false;
+      const LID capacity = block_pool::getSizeClass(newCapacity);
       {
-         std::vector<Realf,aligned_allocator<Realf,WID3> > dummy_data(newCapacity*WID3);
+         std::vector<Realf,pool_allocator<Realf,WID3> > dummy_data(capacity*WID3);
          for (size_t i=0; i<numberOfBlocks*WID3; ++i) dummy_data[i] = block_data[i];
          dummy_data.swap(block_data);
       }
       {
-         std::vector<Real,aligned_allocator<Real,BlockParams::N_VELOCITY_BLOCK_PARAMS> > dummy_parameters(newCapacity*BlockParams::N_VELOCITY_BLOCK_PARAMS);
+         std::vector<Real,pool_allocator<Real,BlockParams::N_VELOCITY_BLOCK_PARAMS> > dummy_parameters(capacity*BlockParams::N_VELOCITY_BLOCK_PARAMS);
          for (size_t i=0; i<numberOfBlocks*BlockParams::N_VELOCITY_BLOCK_PARAMS; ++i) dummy_parameters[i] = parameters[i];
          dummy_parameters.swap(parameters);
       }
-      currentCapacity = newCapacity;
+      currentCapacity = capacity;
       return true;
    }
 
@@ -288,8 +289,13 @@ namespace vmesh {
          // Resize so that free space is block_allocation_chunk blocks, 
          // and at least two in case of having zero blocks.
          // The order of velocity blocks is unaltered.
-         currentCapacity = 2 + numberOfBlocks * BLOCK_ALLOCATION_FACTOR;
+         // Capacity is rounded up to a size class of the block pool so that freed
+         // storage can be reused by other containers. Storage is reserved explicitly,
+         // as resize alone would let std::vector grow it geometrically.
+         currentCapacity = block_pool::getSizeClass(2 + numberOfBlocks * BLOCK_ALLOCATION_FACTOR);
+         block_data.reserve(currentCapacity*WID3);
          block_data.resize(currentCapacity*WID3);
+         parameters.reserve(currentCapacity*BlockParams::N_VELOCITY_BLOCK_PARAMS);
          parameters.resize(currentCapacity*BlockParams::N_VELOCITY_BLOCK_PARAMS);
       }
    }
@@ -32,6 +32,9 @@
 #include <cmath>
 
 #include "velocity_mesh_parameters.h"
+#ifdef VMESH_FLAT_MAP
+   #include "open_hash_map.h"
+#endif
 
 namespace vmesh {
 
@@ -102,11 +105,17 @@ namespace vmesh {
       void swap(VelocityMesh& vm);
 
     private:
+      #ifdef VMESH_FLAT_MAP
+      typedef vmesh::OpenHashMap<GID,LID> GlobalToLocalMap;
+      #else
+      typedef std::unordered_map<GID,LID> GlobalToLocalMap;
+      #endif
+
       static std::vector<vmesh::MeshParameters> meshParameters;
       size_t meshID;
 
       std::vector<GID> localToGlobalMap;
-      std::unordered_map<GID,LID> globalToLocalMap;
+      GlobalToLocalMap globalToLocalMap;
    };
 
    // ***** INITIALIZERS FOR STATIC MEMBER VARIABLES ***** //
@@ -140,7 +149,7 @@ namespace vmesh {
 
       for (size_t b=0; b<size(); ++b) {
          const LID globalID = localToGlobalMap[b];
-         typename std::unordered_map<GID,LID>::const_iterator it = globalToLocalMap.find(globalID);
+         typename GlobalToLocalMap::const_iterator it = globalToLocalMap.find(globalID);
          const GID localID = it->second;
          if (localID != b) {
             ok = false;
@@ -156,7 +165,7 @@ namespace vmesh {
    template<typename GID,typename LID> inline
    void VelocityMesh<GID,LID>::clear() {
       std::vector<GID>().swap(localToGlobalMap);
-      std::unordered_map<GID,LID>().swap(globalToLocalMap);
+      GlobalToLocalMap().swap(globalToLocalMap);
    }
    
    template<typename GID,typename LID> inline
@@ -376,7 +385,7 @@ namespace vmesh {
 
    template<typename GID,typename LID> inline
    LID VelocityMesh<GID,LID>::getLocalID(const GID& globalID) const {
-      typename std::unordered_map<GID,LID>::const_iterator it = globalToLocalMap.find(globalID);
+      typename GlobalToLocalMap::const_iterator it = globalToLocalMap.find(globalID);
       if (it != globalToLocalMap.end()) return it->second;
       return invalidLocalID();
    }
@@ -448,7 +457,7 @@ namespace vmesh {
       getIndices(globalID,refLevel,i,j,k);
       
       // Return the requested neighbor if it exists:
-      typename std::unordered_map<GID,LID>::const_iterator nbr;
+      typename GlobalToLocalMap::const_iterator nbr;
       GID nbrGlobalID = getGlobalID(0,i+i_off,j+j_off,k+k_off);
       if (nbrGlobalID == invalidGlobalID()) return;
 
@@ -581,7 +590,7 @@ namespace vmesh {
 
       const LID lastLID = size()-1;
       const GID lastGID = localToGlobalMap[lastLID];
-      typename std::unordered_map<GID,LID>::iterator last = globalToLocalMap.find(lastGID);
+      typename GlobalToLocalMap::iterator last = globalToLocalMap.find(lastGID);
 
       globalToLocalMap.erase(last);
       localToGlobalMap.pop_back();
@@ -592,7 +601,7 @@ namespace vmesh {
       if (size() >= meshParameters[meshID].max_velocity_blocks) return false;
       if (globalID == invalidGlobalID()) return false;
 
-      std::pair<typename std::unordered_map<GID,LID>::iterator,bool> position
+      std::pair<typename GlobalToLocalMap::iterator,bool> position
         = globalToLocalMap.insert(std::make_pair(globalID,localToGlobalMap.size()));
 
       if (position.second == true) {
@@ -627,6 +636,7 @@ namespace vmesh {
    template<typename GID,typename LID> inline
    void VelocityMesh<GID,LID>::setGrid() {
       globalToLocalMap.clear();
+      globalToLocalMap.reserve(localToGlobalMap.size());
       for (size_t i=0; i<localToGlobalMap.size(); ++i) {
          globalToLocalMap.insert(std::make_pair(localToGlobalMap[i],i));
       }
@@ -635,6 +645,7 @@ namespace vmesh {
    template<typename GID,typename LID> inline
    bool VelocityMesh<GID,LID>::setGrid(const std::vector<GID>& globalIDs) {
       globalToLocalMap.clear();
+      globalToLocalMap.reserve(globalIDs.size());
       for (LID i=0; i<globalIDs.size(); ++i) {
          globalToLocalMap.insert(std::make_pair(globalIDs[i],i));
       }
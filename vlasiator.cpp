@@ -289,9 +289,13 @@ int main(int argn,char* args[]) {
    bool dtIsChanged;
    
 // Init MPI:
+   // FUNNELED is required, MULTIPLE is only requested for the background writer of io.async_write
+   bool asyncWrite = false;
+   Readparameters::getBeforeInit(argn,args,"io.async_write",asyncWrite);
    int required=MPI_THREAD_FUNNELED;
+   int requested=asyncWrite ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED;
    int provided;
-   MPI_Init_thread(&argn,&args,required,&provided);
+   MPI_Init_thread(&argn,&args,requested,&provided);
    if (required > provided){
       MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
       if(myRank==MASTER_RANK)
@@ -473,8 +477,8 @@ int main(int argn,char* args[]) {
    // Initialize data reduction operators. This should be done elsewhere in order to initialize 
    // user-defined operators:
    phiprof::start("Init DROs");
-   DataReducer outputReducer, diagnosticReducer;
-   initializeDataReducers(&outputReducer, &diagnosticReducer);
+   DataReducer outputReducer, diagnosticReducer, cutReducer;
+   initializeDataReducers(&outputReducer, &diagnosticReducer, &cutReducer);
    phiprof::stop("Init DROs");  
    
    // Free up memory:
@@ -610,9 +614,14 @@ int main(int argn,char* args[]) {
       }
       P::systemWrites.push_back(index);
    }
+   if (P::cutWriteTimeInterval > 0.0) {
+      P::cutWrites = (uint)(P::t_min/P::cutWriteTimeInterval);
+      if (P::t_min > (P::cutWrites+0.01)*P::cutWriteTimeInterval) P::cutWrites++;
+   }
 
    // Invalidate cached cell lists just to be sure (might not be needed)
    P::meshRepartitioned = true;
+   ++P::meshRepartitionEpoch;
 
    unsigned int wallTimeRestartCounter=1;
 
@@ -666,7 +675,7 @@ int main(int argn,char* args[]) {
          beforeTime = MPI_Wtime();
          beforeSimulationTime=P::t;
          beforeStep=P::tstep;
-         //report_grid_memory_consumption(mpiGrid);
+         report_grid_memory_consumption(mpiGrid);
          report_process_memory_consumption();
       }
       logFile << writeVerbose;
@@ -722,6 +731,22 @@ int main(int argn,char* args[]) {
          }
       }
 
+      // write cuts (planes, lines and points) with selected variables
+      if (P::cutWriteTimeInterval >= 0.0 &&
+          P::t >= P::cutWrites * P::cutWriteTimeInterval - DT_EPSILON) {
+         phiprof::start("write-cuts");
+         if (writeCuts(mpiGrid, cutReducer, P::cutWrites) == false) {
+            cerr << "FAILED TO WRITE CUTS AT " << __FILE__ << " " << __LINE__ << endl;
+         }
+         P::cutWrites++;
+         // Special case for large timesteps
+         if (P::cutWriteTimeInterval > 0.0) {
+            const uint index2 = (uint)((P::t+P::dt)/P::cutWriteTimeInterval);
+            if (index2 > P::cutWrites) P::cutWrites = index2;
+         }
+         phiprof::stop("write-cuts");
+      }
+
       // Reduce globalflags::bailingOut from all processes
       phiprof::start("Bailout-allreduce");
       MPI_Allreduce(&(globalflags::bailingOut), &(doBailout), 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
@@ -769,6 +794,8 @@ int main(int argn,char* args[]) {
          
          if (myRank == MASTER_RANK)
             logFile << "(IO): Writing restart data to disk, tstep = " << P::tstep << " t = " << P::t << endl << writeVerbose;
+         // Do not compete for file system bandwidth and memory with a bulk file still being written
+         waitForAsyncWrites();
          //Write the restart:
          if( writeRestart(mpiGrid,
                   perBGrid, // TODO: Merge all the fsgrids passed here into one meta-object
@@ -862,9 +889,14 @@ int main(int argn,char* args[]) {
          } else {
             P::prepareForRebalance = true;
          }
+         // Time weights keep their running average, block weights are recounted
+         const bool resetWeights = (P::loadBalanceWeight == "blocks");
          #pragma omp parallel for
          for (size_t c=0; c<cells.size(); ++c) {
-            mpiGrid[cells[c]]->get_cell_parameters()[CellParams::LBWEIGHTCOUNTER] = 0;
+            if (resetWeights) {
+               mpiGrid[cells[c]]->get_cell_parameters()[CellParams::LBWEIGHTCOUNTER] = 0;
+            }
+            mpiGrid[cells[c]]->get_cell_parameters()[CellParams::LBCOSTCOUNTER] = 0;
          }
       }
       
@@ -999,6 +1031,7 @@ int main(int argn,char* args[]) {
 
    phiprof::stop("Simulation");
    phiprof::start("Finalization");
+   waitForAsyncWrites();
    if (P::propagateField ) { 
       finalizeFieldPropagator();
    }
@@ -24,6 +24,7 @@
 #include <cmath>
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "vec.h"
 #include "cpu_acc_sort_blocks.hpp"
@@ -74,6 +75,82 @@ vmesh::LocalID addVelocityBlock(const vmesh::GlobalID& blockGID,
     return newBlockLID;
 }
 
+/** Add the given velocity blocks, none of which may exist yet, to the given 
+ * velocity mesh in one batch. Data of the added blocks is set to zero values and 
+ * velocity block parameters are calculated. If the mesh cannot hold all of the 
+ * blocks, they are added one at a time until the mesh is full.
+ * @param blockGIDs Global IDs of the added velocity blocks.
+ * @param vmesh Velocity mesh where the blocks are added.
+ * @param blockContainer Velocity block data container.*/
+void addVelocityBlocks(const std::vector<vmesh::GlobalID>& blockGIDs,
+        vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>& vmesh,
+        vmesh::VelocityBlockContainer<vmesh::LocalID>& blockContainer) {
+    if (blockGIDs.size() == 0) return;
+
+    // Check the capacity here, the bulk push_back would complain on overflow
+    if (vmesh.size()+blockGIDs.size() > vmesh.getMaxVelocityBlocks()) {
+        for (size_t b=0; b<blockGIDs.size(); ++b) addVelocityBlock(blockGIDs[b], vmesh, blockContainer);
+        return;
+    }
+
+    const vmesh::LocalID oldSize = vmesh.size();
+    vmesh.push_back(blockGIDs);
+    const vmesh::LocalID nAdded = vmesh.size() - oldSize;
+
+    // Insert velocity block data, this will set values to 0.
+    blockContainer.push_back(nAdded);
+
+    #ifdef DEBUG_ACC
+        if (vmesh.size() != blockContainer.size()) {
+            stringstream ss;
+            ss << "ERROR in acc: sizes " << vmesh.size() << ' ' << blockContainer.size() << " after adding " << nAdded << " blocks" << endl;
+            cerr << ss.str();
+            exit(1);
+        }
+    #endif
+
+    // Set block parameters:
+    for (vmesh::LocalID blockLID=oldSize; blockLID<vmesh.size(); ++blockLID) {
+        const vmesh::GlobalID blockGID = vmesh.getGlobalID(blockLID);
+        Real* parameters = blockContainer.getParameters(blockLID);
+        vmesh.getBlockCoordinates(blockGID,parameters+BlockParams::VXCRD);
+        vmesh.getCellSize(blockGID,parameters+BlockParams::DVX);
+    }
+}
+
+/** Column data of map_1d. It is kept per thread, so that its storage is 
+ * reused between calls instead of being allocated for every mapping.*/
+struct ColumnScratch {
+   std::vector<vmesh::LocalID> blocks;                                    /**< Block global IDs sorted into columns.*/
+   std::vector<std::pair<vmesh::GlobalID,vmesh::GlobalID> > blockPairs;  /**< Sort keys of the blocks.*/
+   std::vector<uint> columnBlockOffsets;
+   std::vector<uint> columnNumBlocks;
+   std::vector<uint> setColumnOffsets;
+   std::vector<uint> setNumColumns;
+   std::vector<int> columnMinBlockK;
+   std::vector<int> columnMaxBlockK;
+   std::vector<vmesh::GlobalID> addedBlocks;                              /**< Target blocks that do not exist yet.*/
+   std::vector<vmesh::GlobalID> removedBlocks;                            /**< Source blocks that are not target blocks.*/
+
+   void clear() {
+      blocks.clear();
+      blockPairs.clear();
+      columnBlockOffsets.clear();
+      columnNumBlocks.clear();
+      setColumnOffsets.clear();
+      setNumColumns.clear();
+      columnMinBlockK.clear();
+      columnMaxBlockK.clear();
+      addedBlocks.clear();
+      removedBlocks.clear();
+   }
+};
+
+static ColumnScratch& getColumnScratch() {
+   static thread_local ColumnScratch scratch;
+   return scratch;
+}
+
 
 
 
@@ -107,10 +184,10 @@ void inline swapBlockIndices(velocity_block_indices_t &blockIndices, const uint
    is the lagrangian departure grid (so th grid at timestep +dt,
    tracked backwards by -dt)
 
-   TODO: parallelize with openMP over block-columns. If one also
-   pre-creates new blocks in a separate loop first (serial operation),
-   then the openmp parallization would scale well (better than over
-   spatial cells), and would not need synchronization.
+   TODO: parallelize with openMP over block-columns. New blocks are
+   already created in a separate pass before the mapping, so the openmp
+   parallization would scale well (better than over spatial cells), and
+   would not need synchronization.
    
 */
 bool map_1d(SpatialCell* spatial_cell,
@@ -194,17 +271,21 @@ bool map_1d(SpatialCell* spatial_cell,
    const Realv i_dv=1.0/dv;
 
    // sort blocks according to dimension, and divide them into columns
-   vmesh::LocalID* blocks = new vmesh::LocalID[vmesh.size()];
-   std::vector<uint> columnBlockOffsets;
-   std::vector<uint> columnNumBlocks;
-   std::vector<uint> setColumnOffsets;
-   std::vector<uint> setNumColumns;
-   std::vector<int> columnMinBlockK;
-   std::vector<int> columnMaxBlockK;
+   ColumnScratch& scratch = getColumnScratch();
+   scratch.clear();
+   scratch.blocks.resize(vmesh.size());
+   vmesh::LocalID* blocks = scratch.blocks.data();
+   std::vector<uint>& columnBlockOffsets = scratch.columnBlockOffsets;
+   std::vector<uint>& columnNumBlocks = scratch.columnNumBlocks;
+   std::vector<uint>& setColumnOffsets = scratch.setColumnOffsets;
+   std::vector<uint>& setNumColumns = scratch.setNumColumns;
+   std::vector<int>& columnMinBlockK = scratch.columnMinBlockK;
+   std::vector<int>& columnMaxBlockK = scratch.columnMaxBlockK;
    
    sortBlocklistByDimension(vmesh, dimension, blocks,
                             columnBlockOffsets, columnNumBlocks,
-                            setColumnOffsets, setNumColumns);
+                            setColumnOffsets, setNumColumns,
+                            scratch.blockPairs);
    
    // loop over block column sets  (all columns along the dimension with the other dimensions being equal )
       
@@ -220,24 +301,15 @@ bool map_1d(SpatialCell* spatial_cell,
    bool isTargetBlock[MAX_BLOCKS_PER_DIM];
    bool isSourceBlock[MAX_BLOCKS_PER_DIM];
 
+   /*first find the target blocks of all columns, so that the missing ones
+     can be created in one batch before any data is mapped*/
    for( uint setIndex=0; setIndex< setColumnOffsets.size(); ++setIndex) {
       uint8_t refLevel = 0;
       //init 
       for (uint blockK = 0; blockK < MAX_BLOCKS_PER_DIM; blockK++){
-         blockIndexToBlockData[blockK] =  NULL;
          isTargetBlock[blockK] = false;
          isSourceBlock[blockK] = false;
       }
-      
-      //Load data into values array (this also zeroes the original data)
-      uint valuesColumnOffset = 0; //offset to values array for data in a column in this set
-      for(uint columnIndex = setColumnOffsets[setIndex]; columnIndex < setColumnOffsets[setIndex] + setNumColumns[setIndex] ; columnIndex ++){
-         const vmesh::LocalID n_cblocks = columnNumBlocks[columnIndex];
-         vmesh::GlobalID* cblocks = blocks + columnBlockOffsets[columnIndex]; //column blocks
-         loadColumnBlockData(vmesh, blockContainer, cblocks, n_cblocks, dimension, values + valuesColumnOffset);
-         valuesColumnOffset += (n_cblocks + 2) * (WID3/VECL); // there are WID3/VECL elements of type Vec per block
-      }
-
 
       /*need x,y coordinate of this column set of blocks, take it from first
         block in first column*/
@@ -335,44 +407,58 @@ bool map_1d(SpatialCell* spatial_cell,
          columnMaxBlockK.push_back(lastBlockIndexK);
       }
 
-      //now add target blocks that do not yet exist and remove source blocks
+      //now record target blocks that do not yet exist and source blocks
       //that are not target blocks
       for (uint blockK = 0; blockK < MAX_BLOCKS_PER_DIM; blockK++){
-         if(isTargetBlock[blockK] && !isSourceBlock[blockK] )  {
-            const int targetBlock =
+         if(isTargetBlock[blockK] != isSourceBlock[blockK]) {
+            const vmesh::GlobalID targetBlock =
                setFirstBlockIndices[0] * block_indices_to_id[0] +
                setFirstBlockIndices[1] * block_indices_to_id[1] +
                blockK                  * block_indices_to_id[2];
-            addVelocityBlock(targetBlock, vmesh, blockContainer);
-            
+            if (isTargetBlock[blockK]) scratch.addedBlocks.push_back(targetBlock);
+            else scratch.removedBlocks.push_back(targetBlock);
          }
-         if(!isTargetBlock[blockK] && isSourceBlock[blockK] )  {
-            const int targetBlock =
-               setFirstBlockIndices[0] * block_indices_to_id[0] +
-               setFirstBlockIndices[1] * block_indices_to_id[1] +
-               blockK                  * block_indices_to_id[2];
+      }
+   }
 
-            spatial_cell->remove_velocity_block(targetBlock, popID);
-         }
+   /*add all new target blocks at once. Source blocks that are not target
+     blocks are removed only after the mapping, so block data does not move
+     while pointers to it are held below*/
+   addVelocityBlocks(scratch.addedBlocks, vmesh, blockContainer);
+
+   for( uint setIndex=0; setIndex< setColumnOffsets.size(); ++setIndex) {
+      //Load data into values array (this also zeroes the original data)
+      uint valuesColumnOffset = 0; //offset to values array for data in a column in this set
+      for(uint columnIndex = setColumnOffsets[setIndex]; columnIndex < setColumnOffsets[setIndex] + setNumColumns[setIndex] ; columnIndex ++){
+         const vmesh::LocalID n_cblocks = columnNumBlocks[columnIndex];
+         vmesh::GlobalID* cblocks = blocks + columnBlockOffsets[columnIndex]; //column blocks
+         loadColumnBlockData(vmesh, blockContainer, cblocks, n_cblocks, dimension, values + valuesColumnOffset);
+         valuesColumnOffset += (n_cblocks + 2) * (WID3/VECL); // there are WID3/VECL elements of type Vec per block
       }
 
-     /*now store pointer to blocks, cannot do it at the same time as adding
-      them since they might move due to re-allocations or migrated when
-      removing blocks*/
-      for (int blockK = 0; blockK < MAX_BLOCKS_PER_DIM; blockK++){
-         if(isTargetBlock[blockK])  {
-            const int targetBlock =
+      /*store pointers to target blocks, the target blocks of the set are
+        those in the target range of any of its columns*/
+      velocity_block_indices_t setFirstBlockIndices;
+      uint8_t refLevel = 0;
+      vmesh.getIndices(blocks[columnBlockOffsets[setColumnOffsets[setIndex]]],
+                       refLevel, 
+                       setFirstBlockIndices[0], setFirstBlockIndices[1], setFirstBlockIndices[2]);
+      swapBlockIndices(setFirstBlockIndices, dimension);
+      for (uint blockK = 0; blockK < MAX_BLOCKS_PER_DIM; blockK++){
+         blockIndexToBlockData[blockK] =  NULL;
+      }
+      for(uint columnIndex = setColumnOffsets[setIndex]; columnIndex < setColumnOffsets[setIndex] + setNumColumns[setIndex] ; columnIndex ++){
+         for (int blockK = columnMinBlockK[columnIndex]; blockK <= columnMaxBlockK[columnIndex]; blockK++){
+            if (blockIndexToBlockData[blockK] != NULL) continue;
+            const vmesh::GlobalID targetBlock =
                setFirstBlockIndices[0] * block_indices_to_id[0] +
                setFirstBlockIndices[1] * block_indices_to_id[1] +
                blockK                  * block_indices_to_id[2];
-            const vmesh::LocalID tblockLID = vmesh.getLocalID(targetBlock);
             // Get pointer to target block data.
-            blockIndexToBlockData[blockK] = blockContainer.getData(tblockLID);
+            blockIndexToBlockData[blockK] = blockContainer.getData(vmesh.getLocalID(targetBlock));
          }
       }
       
-      
-      
       // loop over columns in set and do the mapping
       valuesColumnOffset = 0; //offset to values array for data in a column in this set
       for(uint columnIndex = setColumnOffsets[setIndex]; columnIndex < setColumnOffsets[setIndex] + setNumColumns[setIndex] ; columnIndex ++){
@@ -573,7 +659,10 @@ bool map_1d(SpatialCell* spatial_cell,
       } //for loop over columns
       
    }
-   delete [] blocks;
+
+   for (size_t b=0; b<scratch.removedBlocks.size(); ++b) {
+      spatial_cell->remove_velocity_block(scratch.removedBlocks[b], popID);
+   }
    return true;
 }
 
@@ -85,8 +85,6 @@ void cpu_accelerate_cell(SpatialCell* spatial_cell,
                          const uint popID,     
                          const uint map_order,
                          const Real& dt) {
-   double t1 = MPI_Wtime();
-
    vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>& vmesh    = spatial_cell->get_velocity_mesh(popID);
    vmesh::VelocityBlockContainer<vmesh::LocalID>& blockContainer = spatial_cell->get_velocity_blocks(popID);
 
@@ -155,8 +153,4 @@ void cpu_accelerate_cell(SpatialCell* spatial_cell,
           phiprof::stop("compute-mapping");
           break;
    }
-
-   if (Parameters::prepareForRebalance == true) {
-//       spatial_cell->parameters[CellParams::LBWEIGHTCOUNTER] += (MPI_Wtime() - t1);
-   }
 }
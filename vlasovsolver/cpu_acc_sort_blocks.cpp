@@ -50,7 +50,8 @@ void sortBlocklistByDimension( //const spatial_cell::SpatialCell* spatial_cell,
                                std::vector<uint> & columnBlockOffsets,
                                std::vector<uint> & columnNumBlocks,
                                std::vector<uint> & setColumnOffsets,
-                               std::vector<uint> & setNumColumns) {
+                               std::vector<uint> & setNumColumns,
+                               std::vector<std::pair<vmesh::GlobalID,vmesh::GlobalID> > & block_pairs) {
    //const uint nBlocks = spatial_cell->get_number_of_velocity_blocks(); // Number of blocks
    const vmesh::LocalID nBlocks = vmesh.size();
 
@@ -58,8 +59,7 @@ void sortBlocklistByDimension( //const spatial_cell::SpatialCell* spatial_cell,
    // but is needed in some vmesh::VelocityMesh function calls.
    const uint8_t REFLEVEL = 0;
    
-   // Copy block data to vector
-   std::vector<std::pair<vmesh::GlobalID,vmesh::GlobalID> > block_pairs;
+   // Copy block data to vector, block_pairs is scratch space provided by the caller
    block_pairs.resize( nBlocks );
    for (vmesh::LocalID i = 0; i < nBlocks; ++i ) {
       //const vmesh::GlobalID block = spatial_cell->get_velocity_block_global_id(i);
@@ -20,14 +20,265 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <cmath>
 #include <phiprof.hpp>
 #include "cpu_moments.h"
+#include "vec.h"
 #include "../vlasovmover.h"
 #include "../object_wrapper.h"
 #include "../fieldsolver/fs_common.h" // divideIfNonZero()
 
 using namespace std;
 
+namespace {
+
+   /** Set of moments that is calculated, selects the CellParams and Population variables.*/
+   enum MomentSet {
+      MOMENTS,                             /**< RHOM, VX, ..., P_33 and Population::RHO, V, P.*/
+      MOMENTS_R,                           /**< RHOM_R, VX_R, ..., P_33_R and Population::RHO_R, V_R, P_R.*/
+      MOMENTS_V                            /**< RHOM_V, VX_V, ..., P_33_V and Population::RHO_V, V_V, P_V.*/
+   };
+
+   /** Cell center indices i+1/2, j+1/2 and k+1/2 of the velocity cells of a block,
+    * in the same order as the block data.*/
+   struct CellCenters {
+      Real i[WID3];
+      Real j[WID3];
+      Real k[WID3];
+
+      CellCenters() {
+         for (uint kk=0; kk<WID; ++kk) for (uint jj=0; jj<WID; ++jj) for (uint ii=0; ii<WID; ++ii) {
+            i[cellIndex(ii,jj,kk)] = ii+0.5;
+            j[cellIndex(ii,jj,kk)] = jj+0.5;
+            k[cellIndex(ii,jj,kk)] = kk+0.5;
+         }
+      }
+   };
+
+   const CellCenters& getCellCenters() {
+      static const CellCenters cellCenters;
+      return cellCenters;
+   }
+
+   /** Number of independent partial sums per moment in blockShiftedMoments.*/
+   const uint SUM_LANES = VECL;
+
+   inline Real laneSum(const Real* lanes) {
+      Real sum = 0.0;
+      for (uint l=0; l<SUM_LANES; ++l) sum += lanes[l];
+      return sum;
+   }
+
+   /** Add the moment sums of one velocity block to 'sums'. Velocities are taken
+    * relative to a shift velocity s, which keeps the second moments accurate when
+    * the bulk velocity is large compared to the thermal velocity. After this function
+    * returns sums[0]=n, sums[1..3]=n(V-s) and, if SECOND is true, sums[4..6]=n(V-s)^2
+    * for the x,y,z components. This function is AMR safe.
+    * 
+    * The sums are accumulated in Real rather than in Vec, which is single precision
+    * in the VEC*F builds, as the second moments about the bulk velocity are obtained
+    * by subtracting nearly equal sums when the shift is far from the bulk velocity.
+    * SUM_LANES independent partial sums per moment let the compiler vectorize the loop.
+    * @param avgs Distribution function.
+    * @param blockParams Parameters of the velocity block.
+    * @param shift Shift velocity.
+    * @param sums Array of size seven where the sums are added.*/
+   template<bool SECOND> inline
+   void blockShiftedMoments(const Realf* avgs,const Real* blockParams,const Real shift[3],Real sums[7]) {
+      const CellCenters& centers = getCellCenters();
+      const Real offsetX = blockParams[BlockParams::VXCRD]-shift[0];
+      const Real offsetY = blockParams[BlockParams::VYCRD]-shift[1];
+      const Real offsetZ = blockParams[BlockParams::VZCRD]-shift[2];
+      const Real dvx = blockParams[BlockParams::DVX];
+      const Real dvy = blockParams[BlockParams::DVY];
+      const Real dvz = blockParams[BlockParams::DVZ];
+
+      Real n_sum[SUM_LANES] = {};
+      Real nvx_sum[SUM_LANES] = {}, nvy_sum[SUM_LANES] = {}, nvz_sum[SUM_LANES] = {};
+      Real nvx2_sum[SUM_LANES] = {}, nvy2_sum[SUM_LANES] = {}, nvz2_sum[SUM_LANES] = {};
+      for (uint c=0; c<WID3; c+=SUM_LANES) {
+         for (uint l=0; l<SUM_LANES; ++l) {
+            const Real f = avgs[c+l];
+            const Real VX = offsetX + centers.i[c+l]*dvx;
+            const Real VY = offsetY + centers.j[c+l]*dvy;
+            const Real VZ = offsetZ + centers.k[c+l]*dvz;
+
+            n_sum[l] += f;
+            const Real fVX = f*VX;
+            const Real fVY = f*VY;
+            const Real fVZ = f*VZ;
+            nvx_sum[l] += fVX;
+            nvy_sum[l] += fVY;
+            nvz_sum[l] += fVZ;
+            if (SECOND) {
+               nvx2_sum[l] += fVX*VX;
+               nvy2_sum[l] += fVY*VY;
+               nvz2_sum[l] += fVZ*VZ;
+            }
+         }
+      }
+
+      const Real DV3 = dvx*dvy*dvz;
+      sums[0] += laneSum(n_sum)*DV3;
+      sums[1] += laneSum(nvx_sum)*DV3;
+      sums[2] += laneSum(nvy_sum)*DV3;
+      sums[3] += laneSum(nvz_sum)*DV3;
+      if (SECOND) {
+         sums[4] += laneSum(nvx2_sum)*DV3;
+         sums[5] += laneSum(nvy2_sum)*DV3;
+         sums[6] += laneSum(nvz2_sum)*DV3;
+      }
+   }
+
+   /** Moment sums of one population, see blockShiftedMoments.*/
+   struct PopulationSums {
+      Real shift[3];
+      Real sums[7];
+   };
+
+   /** Calculate zeroth, first, and (possibly) second velocity moments of a
+    * spatial cell with a single pass over the velocity blocks of each population.
+    * Each population is summed relative to its bulk velocity from the previous
+    * call, and the second moments about the bulk velocity of the cell are
+    * obtained from the shifted sums afterwards. This function is AMR safe.
+    * @param cell Spatial cell.
+    * @param set Which moment variables are calculated.
+    * @param computeFirst If false, zeroth and first moments of the cell are not
+    * updated and the second moments are calculated about the existing bulk velocity.
+    * @param computeSecond If true, second velocity moments are calculated.
+    * @param popSums Work array, at least the size of the number of populations.*/
+   void computeMoments(SpatialCell* cell,const MomentSet set,const bool& computeFirst,
+                       const bool& computeSecond,PopulationSums* popSums) {
+      uint rhom,p11;
+      switch (set) {
+       case MOMENTS_R:
+         rhom = CellParams::RHOM_R;
+         p11 = CellParams::P_11_R;
+         break;
+       case MOMENTS_V:
+         rhom = CellParams::RHOM_V;
+         p11 = CellParams::P_11_V;
+         break;
+       default:
+         rhom = CellParams::RHOM;
+         p11 = CellParams::P_11;
+         break;
+      }
+      // VX,VY,VZ,RHOQ follow RHOM, and P_22,P_33 follow P_11 in all sets
+      const uint vx = rhom+1;
+      const uint rhoq = rhom+4;
+
+      const uint nPops = getObjectWrapper().particleSpecies.size();
+      if (computeFirst) {
+         for (uint i=0; i<5; ++i) cell->parameters[rhom+i] = 0.0;
+      }
+      if (computeFirst || computeSecond) {
+         for (uint i=0; i<3; ++i) cell->parameters[p11+i] = 0.0;
+      }
+
+      // Single pass over the velocity blocks of each population
+      for (uint popID=0; popID<nPops; ++popID) {
+         Population& pop = cell->get_population(popID);
+         Real* sums = popSums[popID].sums;
+         Real* shift = popSums[popID].shift;
+         const Real* previousV = (set == MOMENTS_R) ? pop.V_R : ((set == MOMENTS_V) ? pop.V_V : pop.V);
+         for (int i=0; i<3; ++i) shift[i] = std::isfinite(previousV[i]) ? previousV[i] : 0.0;
+         for (int i=0; i<7; ++i) sums[i] = 0.0;
+
+         vmesh::VelocityBlockContainer<vmesh::LocalID>& blockContainer = cell->get_velocity_blocks(popID);
+         if (blockContainer.size() == 0) continue;
+         const Realf* data       = blockContainer.getData();
+         const Real* blockParams = blockContainer.getParameters();
+
+         #ifdef DEBUG_MOMENTS
+         if (data == NULL || blockParams == NULL) {
+            stringstream ss;
+            ss << "ERROR in moment calculation in " << __FILE__ << ":" << __LINE__ << endl;
+            ss << "\t &data = " << data << "\t &blockParams = " << blockParams << endl;
+            ss << "\t size = " << blockContainer.size() << endl;
+            cerr << ss.str();
+            exit(1);
+         }
+         #endif
+
+         if (computeSecond) {
+            for (vmesh::LocalID blockLID=0; blockLID<blockContainer.size(); ++blockLID) {
+               blockShiftedMoments<true>(data+blockLID*WID3,
+                                         blockParams+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS,
+                                         shift,sums);
+            }
+         } else {
+            for (vmesh::LocalID blockLID=0; blockLID<blockContainer.size(); ++blockLID) {
+               blockShiftedMoments<false>(data+blockLID*WID3,
+                                          blockParams+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS,
+                                          shift,sums);
+            }
+         }
+
+         if (computeFirst == false) continue;
+
+         // Store species' contribution to bulk velocity moments
+         const Real mass = getObjectWrapper().particleSpecies[popID].mass;
+         const Real charge = getObjectWrapper().particleSpecies[popID].charge;
+         Real* popV = (set == MOMENTS_R) ? pop.V_R : ((set == MOMENTS_V) ? pop.V_V : pop.V);
+         Real& popRho = (set == MOMENTS_R) ? pop.RHO_R : ((set == MOMENTS_V) ? pop.RHO_V : pop.RHO);
+         popRho = sums[0];
+         for (int i=0; i<3; ++i) {
+            const Real nV = sums[1+i] + shift[i]*sums[0];
+            popV[i] = divideIfNonZero(nV, sums[0]);
+            cell->parameters[vx+i] += nV*mass;
+         }
+         cell->parameters[rhom] += sums[0]*mass;
+         cell->parameters[rhoq] += sums[0]*charge;
+      } // for-loop over particle species
+
+      if (computeFirst) {
+         for (int i=0; i<3; ++i) {
+            cell->parameters[vx+i] = divideIfNonZero(cell->parameters[vx+i], cell->parameters[rhom]);
+         }
+      }
+
+      // Compute second moments only if requested
+      if (computeSecond == false) return;
+
+      // Sum of n(V-V0)^2 = sum of n(V-s)^2 - 2(V0-s) sum of n(V-s) + (V0-s)^2 n
+      for (uint popID=0; popID<nPops; ++popID) {
+         Population& pop = cell->get_population(popID);
+         const Real* sums = popSums[popID].sums;
+         const Real* shift = popSums[popID].shift;
+         const Real mass = getObjectWrapper().particleSpecies[popID].mass;
+         Real* popP = (set == MOMENTS_R) ? pop.P_R : ((set == MOMENTS_V) ? pop.P_V : pop.P);
+         for (int i=0; i<3; ++i) {
+            const Real dV = cell->parameters[vx+i] - shift[i];
+            popP[i] = mass*(sums[4+i] - 2*dV*sums[1+i] + dV*dV*sums[0]);
+            cell->parameters[p11+i] += popP[i];
+         }
+      }
+   }
+
+   /** Calculate the moments of the given cells, see computeMoments.*/
+   void computeMoments(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                       const std::vector<CellID>& cells,
+                       const MomentSet set,
+                       const bool& computeSecond) {
+      const size_t nPops = getObjectWrapper().particleSpecies.size();
+      #pragma omp parallel
+      {
+         std::vector<PopulationSums> popSums(nPops);
+
+         #pragma omp for schedule(dynamic,1)
+         for (size_t c=0; c<cells.size(); ++c) {
+            SpatialCell* cell = mpiGrid[cells[c]];
+            if (cell->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
+               continue;
+            }
+            computeMoments(cell,set,true,computeSecond,popSums.data());
+         }
+      }
+   }
+
+} // namespace
+
 /** Calculate zeroth, first, and (possibly) second bulk velocity moments for the 
  * given spatial cell. The calculated moments include contributions from 
  * all existing particle populations. This function is AMR safe.
@@ -44,96 +295,10 @@ void calculateCellMoments(spatial_cell::SpatialCell* cell,
     if (!doNotSkip && cell->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
         skipMoments = true;
     }
+    if (skipMoments && computeSecond == false) return;
 
-    // Clear old moments to zero value
-    if (skipMoments == false) {
-        cell->parameters[CellParams::RHOM  ] = 0.0;
-        cell->parameters[CellParams::VX] = 0.0;
-        cell->parameters[CellParams::VY] = 0.0;
-        cell->parameters[CellParams::VZ] = 0.0;
-        cell->parameters[CellParams::RHOQ  ] = 0.0;
-        cell->parameters[CellParams::P_11] = 0.0;
-        cell->parameters[CellParams::P_22] = 0.0;
-        cell->parameters[CellParams::P_33] = 0.0;
-    }
-
-    // Loop over all particle species
-    if (skipMoments == false) {
-       for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
-          vmesh::VelocityBlockContainer<vmesh::LocalID>& blockContainer = cell->get_velocity_blocks(popID);
-          if (blockContainer.size() == 0) continue;
-          
-          const Realf* data       = blockContainer.getData();
-          const Real* blockParams = blockContainer.getParameters();
-          const Real mass = getObjectWrapper().particleSpecies[popID].mass;
-          const Real charge = getObjectWrapper().particleSpecies[popID].charge;
-          
-          // Temporary array for storing moments
-          Real array[4];
-          for (int i=0; i<4; ++i) array[i] = 0.0;
-
-          // Calculate species' contribution to first velocity moments
-          for (vmesh::LocalID blockLID=0; blockLID<blockContainer.size(); ++blockLID) {
-             blockVelocityFirstMoments(data+blockLID*WID3,
-                                       blockParams+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS,
-                                       array);
-          }
-          
-          Population & pop = cell->get_population(popID);
-          pop.RHO = array[0];
-          pop.V[0] = divideIfNonZero(array[1], array[0]);
-          pop.V[1] = divideIfNonZero(array[2], array[0]);
-          pop.V[2] = divideIfNonZero(array[3], array[0]);
-          
-          // Store species' contribution to bulk velocity moments
-          cell->parameters[CellParams::RHOM  ] += array[0]*mass;
-          cell->parameters[CellParams::VX] += array[1]*mass;
-          cell->parameters[CellParams::VY] += array[2]*mass;
-          cell->parameters[CellParams::VZ] += array[3]*mass;
-          cell->parameters[CellParams::RHOQ  ] += array[0]*charge;
-       } // for-loop over particle species
-       
-       cell->parameters[CellParams::VX] = divideIfNonZero(cell->parameters[CellParams::VX], cell->parameters[CellParams::RHOM]);
-       cell->parameters[CellParams::VY] = divideIfNonZero(cell->parameters[CellParams::VY], cell->parameters[CellParams::RHOM]);
-       cell->parameters[CellParams::VZ] = divideIfNonZero(cell->parameters[CellParams::VZ], cell->parameters[CellParams::RHOM]);
-    }
-
-    // Compute second moments only if requested
-    if (computeSecond == false) return;
-            
-    // Loop over all particle species
-    for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
-       vmesh::VelocityBlockContainer<vmesh::LocalID>& blockContainer = cell->get_velocity_blocks(popID);
-       if (blockContainer.size() == 0) continue;
-       
-       const Realf* data       = blockContainer.getData();
-       const Real* blockParams = blockContainer.getParameters();
-       const Real mass = getObjectWrapper().particleSpecies[popID].mass;
-       
-       // Temporary array for storing moments
-       Real array[3];
-       for (int i=0; i<3; ++i) array[i] = 0.0;
-
-       // Calculate species' contribution to second velocity moments
-       Population & pop = cell->get_population(popID);
-       for (vmesh::LocalID blockLID=0; blockLID<blockContainer.size(); ++blockLID) {
-          blockVelocitySecondMoments(data+blockLID*WID3,
-                                     blockParams+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS,
-                                     cell->parameters[CellParams::VX],
-                                     cell->parameters[CellParams::VY],
-                                     cell->parameters[CellParams::VZ],
-                                     array);
-       }
-       
-       // Store species' contribution to bulk velocity moments
-       pop.P[0] = mass*array[0];
-       pop.P[1] = mass*array[1];
-       pop.P[2] = mass*array[2];
-       
-       cell->parameters[CellParams::P_11] += pop.P[0];
-       cell->parameters[CellParams::P_22] += pop.P[1];
-       cell->parameters[CellParams::P_33] += pop.P[2];
-    } // for-loop over particle species
+    std::vector<PopulationSums> popSums(getObjectWrapper().particleSpecies.size());
+    computeMoments(cell,MOMENTS,!skipMoments,computeSecond,popSums.data());
 }
 
 /** Calculate zeroth, first, and (possibly) second bulk velocity moments for the 
@@ -148,147 +313,15 @@ void calculateMoments_R(
         const std::vector<CellID>& cells,
         const bool& computeSecond) {
  
-    phiprof::start("compute-moments-n");
-    creal HALF = 0.5;
-
-    for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
-       #pragma omp parallel for
-       for (size_t c=0; c<cells.size(); ++c) {
-          SpatialCell* cell = mpiGrid[cells[c]];
-          
-          if (cell->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
-             continue;
-          }
-          
-          // Clear old moments to zero value
-          if (popID == 0) {
-             cell->parameters[CellParams::RHOM_R  ] = 0.0;
-             cell->parameters[CellParams::VX_R] = 0.0;
-             cell->parameters[CellParams::VY_R] = 0.0;
-             cell->parameters[CellParams::VZ_R] = 0.0;
-             cell->parameters[CellParams::RHOQ_R  ] = 0.0;
-             cell->parameters[CellParams::P_11_R] = 0.0;
-             cell->parameters[CellParams::P_22_R] = 0.0;
-             cell->parameters[CellParams::P_33_R] = 0.0;
-          }
-
-          const Real dx = cell->parameters[CellParams::DX];
-          const Real dy = cell->parameters[CellParams::DY];
-          const Real dz = cell->parameters[CellParams::DZ];
-
-          vmesh::VelocityBlockContainer<vmesh::LocalID>& blockContainer = cell->get_velocity_blocks(popID);
-          if (blockContainer.size() == 0) continue;
-          const Realf* data       = blockContainer.getData();
-          const Real* blockParams = blockContainer.getParameters();
-          const Real mass = getObjectWrapper().particleSpecies[popID].mass;
-          const Real charge = getObjectWrapper().particleSpecies[popID].charge;
-
-          #ifdef DEBUG_MOMENTS
-          bool ok = true;
-          if (data == NULL && blockContainer.size() > 0) ok = false;
-          if (blockParams == NULL && blockContainer.size() > 0) ok = false;
-          if (ok == false) {
-             stringstream ss;
-             ss << "ERROR in moment calculation in " << __FILE__ << ":" << __LINE__ << endl;
-             ss << "\t &data = " << data << "\t &blockParams = " << blockParams << endl;
-             ss << "\t size = " << blockContainer.size() << endl;
-             cerr << ss.str();
-             exit(1);
-          }
-          #endif
-
-          // Temporary array where the moments for this species are accumulated
-          Real array[4];
-          for (int i=0; i<4; ++i) array[i] = 0.0;
-
-          // Calculate species' contribution to first velocity moments
-          for (vmesh::LocalID blockLID=0; blockLID<blockContainer.size(); ++blockLID) {
-            blockVelocityFirstMoments(data+blockLID*WID3,
-                                      blockParams+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS,
-                                      array);
-          } // for-loop over velocity blocks
-
-          // Store species' contribution to bulk velocity moments
-          Population & pop = cell->get_population(popID);
-          pop.RHO_R = array[0];
-          pop.V_R[0] = divideIfNonZero(array[1], array[0]);
-          pop.V_R[1] = divideIfNonZero(array[2], array[0]);
-          pop.V_R[2] = divideIfNonZero(array[3], array[0]);
-          
-          cell->parameters[CellParams::RHOM_R  ] += array[0]*mass;
-          cell->parameters[CellParams::VX_R] += array[1]*mass;
-          cell->parameters[CellParams::VY_R] += array[2]*mass;
-          cell->parameters[CellParams::VZ_R] += array[3]*mass;
-          cell->parameters[CellParams::RHOQ_R  ] += array[0]*charge;
-       } // for-loop over spatial cells
-    } // for-loop over particle species
-    
-    #pragma omp parallel for
-    for (size_t c=0; c<cells.size(); ++c) {
-       SpatialCell* cell = mpiGrid[cells[c]];
-       if (cell->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
-          continue;
-       }
-       cell->parameters[CellParams::VX_R] = divideIfNonZero(cell->parameters[CellParams::VX_R], cell->parameters[CellParams::RHOM_R]);
-       cell->parameters[CellParams::VY_R] = divideIfNonZero(cell->parameters[CellParams::VY_R], cell->parameters[CellParams::RHOM_R]);
-       cell->parameters[CellParams::VZ_R] = divideIfNonZero(cell->parameters[CellParams::VZ_R], cell->parameters[CellParams::RHOM_R]);
-    }
-
-   // Compute second moments only if requested.
-   if (computeSecond == false) {
-      phiprof::stop("compute-moments-n");
-      return;
-   }
-
-   for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
-      #pragma omp parallel for
-      for (size_t c=0; c<cells.size(); ++c) {
-         SpatialCell* cell = mpiGrid[cells[c]];
-         
-         if (cell->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
-            continue;
-         }
-         
-         vmesh::VelocityBlockContainer<vmesh::LocalID>& blockContainer = cell->get_velocity_blocks(popID);
-         if (blockContainer.size() == 0) continue;
-         const Realf* data       = blockContainer.getData();
-         const Real* blockParams = blockContainer.getParameters();
-         const Real mass = getObjectWrapper().particleSpecies[popID].mass;
-
-         // Temporary array where species' contribution to 2nd moments is accumulated
-         Real array[3];
-         for (int i=0; i<3; ++i) array[i] = 0.0;
-
-         // Calculate species' contribution to second velocity moments
-         Population & pop = cell->get_population(popID);
-         for (vmesh::LocalID blockLID=0; blockLID<blockContainer.size(); ++blockLID) {
-            blockVelocitySecondMoments(data+blockLID*WID3,
-                                       blockParams+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS,
-                                       cell->parameters[CellParams::VX_R],
-                                       cell->parameters[CellParams::VY_R],
-                                       cell->parameters[CellParams::VZ_R],
-                                       array);
-         } // for-loop over velocity blocks
-
-         // Store species' contribution to 2nd bulk velocity moments
-         pop.P_R[0] = mass*array[0];
-         pop.P_R[1] = mass*array[1];
-         pop.P_R[2] = mass*array[2];
-         
-         cell->parameters[CellParams::P_11_R] += pop.P_R[0];
-         cell->parameters[CellParams::P_22_R] += pop.P_R[1];
-         cell->parameters[CellParams::P_33_R] += pop.P_R[2];
-      } // for-loop over spatial cells
-   } // for-loop over particle species
-
+   phiprof::start("compute-moments-n");
+   computeMoments(mpiGrid,cells,MOMENTS_R,computeSecond);
    phiprof::stop("compute-moments-n");
 }
 
 /** Calculate zeroth, first, and (possibly) second bulk velocity moments for the 
- * given spatial cell. Additionally, for each species, calculate the maximum 
- * spatial time step so that CFL(spatial)=1. The calculated moments include 
- * contributions from all existing particle populations. The calculated moments 
- * are stored to SpatialCell::parameters in _V variables. This function is AMR safe.
+ * given spatial cell. The calculated moments include contributions from all
+ * existing particle populations. The calculated moments are stored to
+ * SpatialCell::parameters in _V variables. This function is AMR safe.
  * @param mpiGrid Parallel grid library.
  * @param cells Vector containing the spatial cells to be calculated.
  * @param computeSecond If true, second velocity moments are calculated.*/
@@ -298,121 +331,18 @@ void calculateMoments_V(
         const bool& computeSecond) {
  
    phiprof::start("Compute _V moments");
-   
-   // Loop over all particle species
-   for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
-      #pragma omp parallel for
-      for (size_t c=0; c<cells.size(); ++c) {
-         SpatialCell* cell = mpiGrid[cells[c]];
-         
-         if (cell->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
-            continue;
-         }
-         
-         // Clear old moments to zero value
-         if (popID == 0) {
-             cell->parameters[CellParams::RHOM_V  ] = 0.0;
-             cell->parameters[CellParams::VX_V] = 0.0;
-             cell->parameters[CellParams::VY_V] = 0.0;
-             cell->parameters[CellParams::VZ_V] = 0.0;
-             cell->parameters[CellParams::RHOQ_V  ] = 0.0;
-             cell->parameters[CellParams::P_11_V] = 0.0;
-             cell->parameters[CellParams::P_22_V] = 0.0;
-             cell->parameters[CellParams::P_33_V] = 0.0;
-         }
-
-         vmesh::VelocityBlockContainer<vmesh::LocalID>& blockContainer = cell->get_velocity_blocks(popID);
-         if (blockContainer.size() == 0) continue;
-         const Realf* data       = blockContainer.getData();
-         const Real* blockParams = blockContainer.getParameters();
-         const Real mass = getObjectWrapper().particleSpecies[popID].mass;
-         const Real charge = getObjectWrapper().particleSpecies[popID].charge;
-
-         // Temporary array for storing moments
-         Real array[4];
-         for (int i=0; i<4; ++i) array[i] = 0.0;
-
-         // Calculate species' contribution to first velocity moments
-         for (vmesh::LocalID blockLID=0; blockLID<blockContainer.size(); ++blockLID) {
-            blockVelocityFirstMoments(data+blockLID*WID3,
-                                      blockParams+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS,
-                                      array);
-         }
-         
-         // Store species' contribution to bulk velocity moments
-         Population & pop = cell->get_population(popID);
-         pop.RHO_V = array[0];
-         pop.V_V[0] = divideIfNonZero(array[1], array[0]);
-         pop.V_V[1] = divideIfNonZero(array[2], array[0]);
-         pop.V_V[2] = divideIfNonZero(array[3], array[0]);
-         
-         cell->parameters[CellParams::RHOM_V  ] += array[0]*mass;
-         cell->parameters[CellParams::VX_V] += array[1]*mass;
-         cell->parameters[CellParams::VY_V] += array[2]*mass;
-         cell->parameters[CellParams::VZ_V] += array[3]*mass;
-         cell->parameters[CellParams::RHOQ_V  ] += array[0]*charge;
-      } // for-loop over spatial cells
-   } // for-loop over particle species
-   
-   #pragma omp parallel for
-   for (size_t c=0; c<cells.size(); ++c) {
-      SpatialCell* cell = mpiGrid[cells[c]];
-      if (cell->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
-         continue;
-      }
-      cell->parameters[CellParams::VX_V] = divideIfNonZero(cell->parameters[CellParams::VX_V], cell->parameters[CellParams::RHOM_V]);
-      cell->parameters[CellParams::VY_V] = divideIfNonZero(cell->parameters[CellParams::VY_V], cell->parameters[CellParams::RHOM_V]);
-      cell->parameters[CellParams::VZ_V] = divideIfNonZero(cell->parameters[CellParams::VZ_V], cell->parameters[CellParams::RHOM_V]);
-   }
-
-   // Compute second moments only if requested
-   if (computeSecond == false) {
-      phiprof::stop("Compute _V moments");
-      return;
-   }
-
-   for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
-      #pragma omp parallel for
-      for (size_t c=0; c<cells.size(); ++c) {
-         SpatialCell* cell = mpiGrid[cells[c]];
-         
-         if (cell->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) {
-            continue;
-         }
-
-         vmesh::VelocityBlockContainer<vmesh::LocalID>& blockContainer = cell->get_velocity_blocks(popID);
-         if (blockContainer.size() == 0) continue;
-         const Realf* data       = blockContainer.getData();
-         const Real* blockParams = blockContainer.getParameters();
-         const Real mass = getObjectWrapper().particleSpecies[popID].mass;
-
-         // Temporary array where moments are stored
-         Real array[3];
-         for (int i=0; i<3; ++i) array[i] = 0.0;
-
-         // Calculate species' contribution to second velocity moments
-         Population & pop = cell->get_population(popID);
-         for (vmesh::LocalID blockLID=0; blockLID<blockContainer.size(); ++blockLID) {
-            blockVelocitySecondMoments(
-                                       data+blockLID*WID3,
-                                       blockParams+blockLID*BlockParams::N_VELOCITY_BLOCK_PARAMS,
-                                       cell->parameters[CellParams::VX_V],
-                                       cell->parameters[CellParams::VY_V],
-                                       cell->parameters[CellParams::VZ_V],
-                                       array);
-         } // for-loop over velocity blocks
-         
-         // Store species' contribution to 2nd bulk velocity moments
-         pop.P_V[0] = mass*array[0];
-         pop.P_V[1] = mass*array[1];
-         pop.P_V[2] = mass*array[2];
-         
-         cell->parameters[CellParams::P_11_V] += pop.P_V[0];
-         cell->parameters[CellParams::P_22_V] += pop.P_V[1];
-         cell->parameters[CellParams::P_33_V] += pop.P_V[2];
-         
-      } // for-loop over spatial cells
-   } // for-loop over particle species
-
+   computeMoments(mpiGrid,cells,MOMENTS_V,computeSecond);
    phiprof::stop("Compute _V moments");
 }
+
+/** Calculate zeroth, first, and (possibly) second bulk velocity moments of one
+ * spatial cell into the _V variables, as calculateMoments_V does for a list of
+ * cells. DO_NOT_COMPUTE cells are skipped. This function is AMR safe.
+ * @param cell Spatial cell.
+ * @param computeSecond If true, second velocity moments are calculated.*/
+void calculateCellMoments_V(SpatialCell* cell,
+                            const bool& computeSecond) {
+   if (cell->sysBoundaryFlag == sysboundarytype::DO_NOT_COMPUTE) return;
+   std::vector<PopulationSums> popSums(getObjectWrapper().particleSpecies.size());
+   computeMoments(cell,MOMENTS_V,true,computeSecond,popSums.data());
+}
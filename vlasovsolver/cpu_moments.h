@@ -53,6 +53,9 @@ void calculateMoments_V(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpi
                         const std::vector<CellID>& cells,
                         const bool& computeSecond);
 
+void calculateCellMoments_V(SpatialCell* cell,
+                            const bool& computeSecond);
+
 
 
 // ***** TEMPLATE FUNCTION DEFINITIONS ***** //
@@ -22,6 +22,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iterator>
+#include <limits>
+#include <unordered_map>
 #include <utility>
 
 #ifdef _OPENMP
@@ -37,6 +40,13 @@
 #include "cpu_1d_pqm.hpp"
 #include "cpu_trans_map.hpp"
 
+#ifndef NDEBUG
+   #define DEBUG_TRANS
+#endif
+#ifdef DEBUG_SOLVERS
+   #define DEBUG_TRANS
+#endif
+
 using namespace std;
 using namespace spatial_cell;
 
@@ -229,33 +239,25 @@ void compute_spatial_target_neighbors(const dccrg::Dccrg<SpatialCell,dccrg::Cart
 }
 
 /* Copy the data to the temporary values array, so that the
- * dimensions are correctly swapped. Also, copy the same block for
- * then neighboring spatial cells (in the dimension). neighbors
- * generated with compute_spatial_neighbors_wboundcond).
+ * dimensions are correctly swapped. Data of the same block in the 
+ * neighboring spatial cells (in the dimension) is given by blockDatas, 
+ * NULL if the block does not exist in that cell.
  * 
  * This function must be thread-safe.
  *
- * @param source_neighbors Array containing the VLASOV_STENCIL_WIDTH closest 
- * spatial neighbors of this cell in the propagated dimension.
- * @param blockGID Global ID of the velocity block.
+ * @param blockDatas Pointers to the block data in the 2*VLASOV_STENCIL_WIDTH+1
+ * source stencil cells.
  * @param values Vector where loaded data is stored.
  * @param cellid_transpose
- * @param popID ID of the particle species.
  */
-void copy_trans_block_data(
-    SpatialCell** source_neighbors,
-    const vmesh::GlobalID blockGID,
+static void load_trans_block_data(
+    Realf* const* blockDatas,
     Vec* values,
-    const unsigned char* const cellid_transpose,
-    const uint popID) { 
+    const unsigned char* const cellid_transpose) { 
 
-   /*load pointers to blocks and prefetch them to L1*/
-   Realf* blockDatas[VLASOV_STENCIL_WIDTH * 2 + 1];
+   /*prefetch block data to L1*/
    for (int b = -VLASOV_STENCIL_WIDTH; b <= VLASOV_STENCIL_WIDTH; ++b) {
-      SpatialCell* srcCell = source_neighbors[b + VLASOV_STENCIL_WIDTH];
-      const vmesh::LocalID blockLID = srcCell->get_velocity_block_local_id(blockGID,popID);
-      if (blockLID != srcCell->invalid_local_id()) {
-         blockDatas[b + VLASOV_STENCIL_WIDTH] = srcCell->get_data(blockLID,popID);
+      if (blockDatas[b + VLASOV_STENCIL_WIDTH] != NULL) {
          //prefetch storage pointers to L1
          _mm_prefetch((char *)(blockDatas[b + VLASOV_STENCIL_WIDTH]), _MM_HINT_T0);
          _mm_prefetch((char *)(blockDatas[b + VLASOV_STENCIL_WIDTH]) + 64, _MM_HINT_T0);
@@ -269,9 +271,6 @@ void copy_trans_block_data(
             _mm_prefetch((char *)(blockDatas[b + VLASOV_STENCIL_WIDTH]) + 448, _MM_HINT_T0);
          }
       }
-      else{
-         blockDatas[b + VLASOV_STENCIL_WIDTH] = NULL;
-      }
    }
  
    //  Copy volume averages of this block from all spatial cells:
@@ -309,37 +308,103 @@ void copy_trans_block_data(
    }
 }
 
-/* 
-   Here we map from the current time step grid, to a target grid which
-   is the lagrangian departure grid (so th grid at timestep +dt,
-   tracked backwards by -dt). This is done in ordinary space in the translation step
+/* Copy the data to the temporary values array, so that the
+ * dimensions are correctly swapped. Also, copy the same block for
+ * then neighboring spatial cells (in the dimension). neighbors
+ * generated with compute_spatial_neighbors_wboundcond).
+ * 
+ * This function must be thread-safe.
+ *
+ * @param source_neighbors Array containing the VLASOV_STENCIL_WIDTH closest 
+ * spatial neighbors of this cell in the propagated dimension.
+ * @param blockGID Global ID of the velocity block.
+ * @param values Vector where loaded data is stored.
+ * @param cellid_transpose
+ * @param popID ID of the particle species.
+ */
+void copy_trans_block_data(
+    SpatialCell* const* source_neighbors,
+    const vmesh::GlobalID blockGID,
+    Vec* values,
+    const unsigned char* const cellid_transpose,
+    const uint popID) { 
 
-   This function can, and should be, safely called in a parallel
-   OpenMP region (as long as it does only one dimension per parallel
-   refion). It is safe as each thread only computes certain blocks (blockID%tnum_threads = thread_num */
+   /*load pointers to blocks*/
+   Realf* blockDatas[VLASOV_STENCIL_WIDTH * 2 + 1];
+   for (int b = -VLASOV_STENCIL_WIDTH; b <= VLASOV_STENCIL_WIDTH; ++b) {
+      SpatialCell* srcCell = source_neighbors[b + VLASOV_STENCIL_WIDTH];
+      const vmesh::LocalID blockLID = srcCell->get_velocity_block_local_id(blockGID,popID);
+      if (blockLID != srcCell->invalid_local_id()) {
+         blockDatas[b + VLASOV_STENCIL_WIDTH] = srcCell->get_data(blockLID,popID);
+      }
+      else{
+         blockDatas[b + VLASOV_STENCIL_WIDTH] = NULL;
+      }
+   }
+   load_trans_block_data(blockDatas, values, cellid_transpose);
+}
 
-bool trans_map_1d(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
-                  const vector<CellID>& localPropagatedCells,
-                  const vector<CellID>& remoteTargetCells,
-                  const uint dimension,
-                  const Realv dt,
-                  const uint popID) {
-   // values used with an stencil in 1 dimension, initialized to 0. 
-   // Contains a block, and its spatial neighbours in one dimension.
-   Realv dz,z_min, dvz,vz_min;
-   uint cell_indices_to_id[3]; /*< used when computing id of target cell in block*/
-   unsigned char  cellid_transpose[WID3]; /*< defines the transpose for the solver internal (transposed) id: i + j*WID + k*WID2 to actual one*/
+/* Sort the velocity blocks of a cell by global ID.
+ * 
+ * @param spatial_cell Spatial cell whose velocity mesh is sorted.
+ * @param popID ID of the particle species.
+ * @param blockList Filled with the sorted global IDs and matching local IDs.
+ */
+static void sort_block_list(SpatialCell* spatial_cell,const uint popID,SortedBlockList& blockList) {
+   const vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>& vmesh = spatial_cell->get_velocity_mesh(popID);
+   std::vector<std::pair<vmesh::GlobalID,vmesh::LocalID> > blocks(vmesh.size());
+   for (vmesh::LocalID block_i=0; block_i<vmesh.size(); ++block_i) {
+      blocks[block_i] = std::make_pair(vmesh.getGlobalID(block_i),block_i);
+   }
+   std::sort(blocks.begin(),blocks.end());
+   
+   blockList.blockGIDs.resize(blocks.size());
+   blockList.blockLIDs.resize(blocks.size());
+   for (size_t b=0; b<blocks.size(); ++b) {
+      blockList.blockGIDs[b] = blocks[b].first;
+      blockList.blockLIDs[b] = blocks[b].second;
+   }
+}
 
-   if(localPropagatedCells.size() == 0) 
-      return true; 
-//vector with all cells
-   vector<CellID> allCells(localPropagatedCells);
+/* Compute the parts of trans_map_1d that do not depend on the
+   distribution function values: spatial neighbor pointers of all
+   propagated cells, the velocity blocks of all stencil cells sorted by
+   global ID, and the sorted union of velocity blocks. Only the velocity
+   block lists and cell types of remote cells are used, so this can be
+   called while the ghost block data is still being transferred.
+
+   \param blockListCache Sorted block lists of cells, reused between
+   dimensions. Block lists do not change during translation, so a cache
+   can be shared by all dimensions of one population.
+   \param setup Filled with the neighbor and block lists.
+*/
+void trans_map_1d_setup(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                        const vector<CellID>& localPropagatedCells,
+                        const vector<CellID>& remoteTargetCells,
+                        const uint dimension,
+                        const uint popID,
+                        TransBlockListCache& blockListCache,
+                        TransMapSetup& setup) {
+   const uint nSourceNeighborsPerCell = 1 + 2 * VLASOV_STENCIL_WIDTH;
+   const uint invalidIndex = numeric_limits<uint>::max();
+   vector<CellID>& allCells = setup.allCells;
+   std::vector<SpatialCell*>& allCellsPointer = setup.allCellsPointer;
+   std::vector<SpatialCell*>& stencilCells = setup.stencilCells;
+
+   allCells.clear();
+   stencilCells.clear();
+   setup.unionOfBlocks.clear();
+   if(localPropagatedCells.size() == 0)
+      return;
+
+   //vector with all cells
+   allCells.insert(allCells.end(), localPropagatedCells.begin(), localPropagatedCells.end());
    allCells.insert(allCells.end(), remoteTargetCells.begin(), remoteTargetCells.end());
    
-   const uint nSourceNeighborsPerCell = 1 + 2 * VLASOV_STENCIL_WIDTH;
-   std::vector<SpatialCell*> allCellsPointer(allCells.size());
+   allCellsPointer.resize(allCells.size());
    std::vector<SpatialCell*> sourceNeighbors(localPropagatedCells.size() * nSourceNeighborsPerCell);
-   std::vector<SpatialCell*> targetNeighbors(3 * localPropagatedCells.size() );
+   std::vector<SpatialCell*> targetNeighbors(3 * localPropagatedCells.size());
+   setup.isTranslated.resize(localPropagatedCells.size());
    
 #pragma omp parallel for
    for(uint celli = 0; celli < allCells.size(); celli++){
@@ -356,32 +421,150 @@ bool trans_map_1d(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpi
          // INVALID_CELLIDs at boundaries).
       compute_spatial_source_neighbors(mpiGrid, localPropagatedCells[celli], dimension, sourceNeighbors.data() + celli * nSourceNeighborsPerCell);
       compute_spatial_target_neighbors(mpiGrid, localPropagatedCells[celli], dimension, targetNeighbors.data() + celli * 3);
+      // only normal cells and the first boundary layer are mapped
+      setup.isTranslated[celli] = (get_spatial_neighbor(mpiGrid, localPropagatedCells[celli], true, 0, 0, 0) != INVALID_CELLID);
    }
    
-    
-   //Get a unique sorted list of blockids that are in any of the
-   // propagated cells. First use set for this, then add to vector (may not
-   // be the most nice way to do this and in any case we could do it along
-   // dimension for data locality reasons => copy acc map column code, TODO: FIXME
-   std::unordered_set<vmesh::GlobalID> unionOfBlocksSet;
+   // Index all cells in the source and target stencils. The first
+   // cells are allCells in the same order, followed by the source cells
+   // further away that are not in allCells.
+   std::unordered_map<SpatialCell*,uint> stencilIndex;
+   stencilCells = allCellsPointer;
+   for(uint celli = 0; celli < allCellsPointer.size(); celli++) {
+      stencilIndex[allCellsPointer[celli]] = celli;
+   }
+   setup.sourceNeighborIndex.resize(sourceNeighbors.size());
+   for(size_t i = 0; i < sourceNeighbors.size(); i++) {
+      auto it = stencilIndex.find(sourceNeighbors[i]);
+      if (it == stencilIndex.end()) {
+         it = stencilIndex.insert(std::make_pair(sourceNeighbors[i],(uint)stencilCells.size())).first;
+         stencilCells.push_back(sourceNeighbors[i]);
+      }
+      setup.sourceNeighborIndex[i] = it->second;
+   }
+   setup.targetNeighborIndex.resize(targetNeighbors.size());
+   for(size_t i = 0; i < targetNeighbors.size(); i++) {
+      if (targetNeighbors[i] == NULL) {
+         setup.targetNeighborIndex[i] = invalidIndex;
+         continue;
+      }
+      auto it = stencilIndex.find(targetNeighbors[i]);
+      if (it == stencilIndex.end()) {
+         it = stencilIndex.insert(std::make_pair(targetNeighbors[i],(uint)stencilCells.size())).first;
+         stencilCells.push_back(targetNeighbors[i]);
+      }
+      setup.targetNeighborIndex[i] = it->second;
+   }
    
+   // Sorted block lists of all stencil cells, sort the ones not yet in
+   // the cache. Cache entries are created serially, references to them
+   // stay valid when more entries are added.
+   std::vector<SpatialCell*> unsortedCells;
+   std::vector<SortedBlockList*> unsortedLists;
+   setup.stencilBlockLists.resize(stencilCells.size());
+   for(size_t celli = 0; celli < stencilCells.size(); celli++) {
+      auto it = blockListCache.find(stencilCells[celli]);
+      if (it == blockListCache.end()) {
+         it = blockListCache.insert(std::make_pair(stencilCells[celli],SortedBlockList())).first;
+         unsortedCells.push_back(stencilCells[celli]);
+         unsortedLists.push_back(&(it->second));
+      }
+      setup.stencilBlockLists[celli] = &(it->second);
+   }
+   
+#pragma omp parallel for schedule(dynamic,1)
+   for(size_t celli = 0; celli < unsortedCells.size(); celli++) {
+      sort_block_list(unsortedCells[celli], popID, *(unsortedLists[celli]));
+   }
 
-
-   for(uint celli = 0; celli < allCellsPointer.size(); celli++) {
-      vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>& vmesh = allCellsPointer[celli]->get_velocity_mesh(popID);
-      for (vmesh::LocalID block_i=0; block_i< vmesh.size(); ++block_i) {
-         unionOfBlocksSet.insert(vmesh.getGlobalID(block_i));
+   #ifdef DEBUG_TRANS
+   // The block lookup in trans_map_1d walks the block lists with
+   // forward-only cursors, which requires lists sorted by global ID that
+   // match the current velocity mesh of each cell.
+   for(size_t celli = 0; celli < stencilCells.size(); celli++) {
+      const SortedBlockList& blockList = *(setup.stencilBlockLists[celli]);
+      if (!std::is_sorted(blockList.blockGIDs.begin(), blockList.blockGIDs.end())
+          || blockList.blockGIDs.size() != stencilCells[celli]->get_velocity_mesh(popID).size()) {
+         cerr << __FILE__ << ":" << __LINE__ << " Block list of stencil cell " << celli
+              << " is not sorted or does not match the velocity mesh, abort" << endl;
+         abort();
       }
    }
+   #endif
    
-   std::vector<vmesh::GlobalID> unionOfBlocks;
-   unionOfBlocks.reserve(unionOfBlocksSet.size());
-   for(const auto blockGID:  unionOfBlocksSet) {
-      unionOfBlocks.push_back(blockGID);
+   // Get a unique sorted list of blockids that are in any of the
+   // cells. Each thread sorts the blocks of its share of cells, and
+   // the per-thread lists are then merged pairwise.
+   std::vector<std::vector<vmesh::GlobalID> > threadUnions;
+#pragma omp parallel
+   {
+      std::vector<vmesh::GlobalID> threadBlocks;
+#pragma omp for schedule(dynamic,1) nowait
+      for(uint celli = 0; celli < allCellsPointer.size(); celli++) {
+         const std::vector<vmesh::GlobalID>& blockGIDs = setup.stencilBlockLists[celli]->blockGIDs;
+         threadBlocks.insert(threadBlocks.end(), blockGIDs.begin(), blockGIDs.end());
+      }
+      std::sort(threadBlocks.begin(), threadBlocks.end());
+      threadBlocks.erase(std::unique(threadBlocks.begin(), threadBlocks.end()), threadBlocks.end());
+#pragma omp critical
+      {
+         threadUnions.push_back(std::vector<vmesh::GlobalID>());
+         threadUnions.back().swap(threadBlocks);
+      }
    }
    
-    
+   while(threadUnions.size() > 1) {
+      const size_t nMerged = threadUnions.size() / 2;
+      const size_t offset = threadUnions.size() - nMerged;
+#pragma omp parallel for schedule(dynamic,1)
+      for(size_t i = 0; i < nMerged; i++) {
+         std::vector<vmesh::GlobalID> merged;
+         merged.reserve(std::max(threadUnions[i].size(), threadUnions[i + offset].size()));
+         std::set_union(threadUnions[i].begin(), threadUnions[i].end(),
+                        threadUnions[i + offset].begin(), threadUnions[i + offset].end(),
+                        std::back_inserter(merged));
+         threadUnions[i].swap(merged);
+      }
+      threadUnions.resize(offset);
+   }
+   if (threadUnions.size() == 1) {
+      setup.unionOfBlocks.swap(threadUnions[0]);
+   }
+}
+
+/* 
+   Here we map from the current time step grid, to a target grid which
+   is the lagrangian departure grid (so th grid at timestep +dt,
+   tracked backwards by -dt). This is done in ordinary space in the translation step
+
+   This function can, and should be, safely called in a parallel
+   OpenMP region (as long as it does only one dimension per parallel
+   refion). It is safe as each thread only computes certain blocks (blockID%tnum_threads = thread_num 
+
+   This version uses neighbor and block lists precomputed with
+   trans_map_1d_setup. Ghost block data of the source stencil has to be
+   up to date when this is called.*/
 
+bool trans_map_1d(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                  const vector<CellID>& localPropagatedCells,
+                  const TransMapSetup& setup,
+                  const uint dimension,
+                  const Realv dt,
+                  const uint popID) {
+   // values used with an stencil in 1 dimension, initialized to 0. 
+   // Contains a block, and its spatial neighbours in one dimension.
+   Realv dz,z_min, dvz,vz_min;
+   uint cell_indices_to_id[3]; /*< used when computing id of target cell in block*/
+   unsigned char  cellid_transpose[WID3]; /*< defines the transpose for the solver internal (transposed) id: i + j*WID + k*WID2 to actual one*/
+
+   if(localPropagatedCells.size() == 0) 
+      return true; 
+
+   const uint nSourceNeighborsPerCell = 1 + 2 * VLASOV_STENCIL_WIDTH;
+   const uint invalidIndex = numeric_limits<uint>::max();
+   const std::vector<SpatialCell*>& allCellsPointer = setup.allCellsPointer;
+   const std::vector<SpatialCell*>& stencilCells = setup.stencilCells;
+   const std::vector<vmesh::GlobalID>& unionOfBlocks = setup.unionOfBlocks;
    
    const uint8_t REFLEVEL=0;
    const vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>& vmesh = allCellsPointer[0]->get_velocity_mesh(popID);
@@ -445,31 +628,52 @@ bool trans_map_1d(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpi
    {
       std::vector<Realf> targetBlockData(3 * localPropagatedCells.size() * WID3);
       std::vector<bool> targetsValid(localPropagatedCells.size());
-      std::vector<vmesh::LocalID> allCellsBlockLocalID(allCells.size());
-
-      
+      // Local IDs of the current block in all stencil cells, found by
+      // walking the sorted block lists of the cells with one cursor per
+      // cell. Within a chunk of the loop blocks are processed in
+      // increasing global ID order, so the cursors only move forward.
+      // Chunks may be handed to a thread in any order, so the search
+      // restarts from the beginning when a chunk lies before the previous one.
+      std::vector<vmesh::LocalID> stencilBlockLocalID(stencilCells.size());
+      std::vector<size_t> stencilBlockCursor(stencilCells.size(), 0);
+      uint nextBlocki = invalidIndex;
       
 #pragma omp for schedule(guided)
       for(uint blocki = 0; blocki < unionOfBlocks.size(); blocki++){
          vmesh::GlobalID blockGID = unionOfBlocks[blocki];
          phiprof::start(t1);
          
-         for(uint celli = 0; celli < allCellsPointer.size(); celli++){
-            allCellsBlockLocalID[celli] = allCellsPointer[celli]->get_velocity_block_local_id(blockGID, popID);
+         const bool jumped = (blocki != nextBlocki);
+         const bool jumpedBack = (blocki < nextBlocki);
+         nextBlocki = blocki + 1;
+         for(uint celli = 0; celli < stencilCells.size(); celli++){
+            const std::vector<vmesh::GlobalID>& blockGIDs = setup.stencilBlockLists[celli]->blockGIDs;
+            size_t& cursor = stencilBlockCursor[celli];
+            if (jumped) {
+               // blocks in between were processed by other threads
+               const size_t first = jumpedBack ? 0 : cursor;
+               cursor = std::lower_bound(blockGIDs.begin() + first, blockGIDs.end(), blockGID) - blockGIDs.begin();
+            } else {
+               while (cursor < blockGIDs.size() && blockGIDs[cursor] < blockGID) ++cursor;
+            }
+            if (cursor < blockGIDs.size() && blockGIDs[cursor] == blockGID) {
+               stencilBlockLocalID[celli] = setup.stencilBlockLists[celli]->blockLIDs[cursor];
+            } else {
+               stencilBlockLocalID[celli] = vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>::invalidLocalID();
+            }
          }
 
       
          for(uint celli = 0; celli < localPropagatedCells.size(); celli++){
             SpatialCell *spatial_cell = allCellsPointer[celli];
-            const CellID cellID =  localPropagatedCells[celli];
-            const vmesh::LocalID blockLID = allCellsBlockLocalID[celli];
+            const vmesh::LocalID blockLID = stencilBlockLocalID[celli];
             
             //Reset list of valid targets, will be set to true later for those
             //that are valid
             targetsValid[celli] = false;
             
             if (blockLID == vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>::invalidLocalID() ||
-                get_spatial_neighbor(mpiGrid, cellID, true, 0, 0, 0) == INVALID_CELLID) {
+                !setup.isTranslated[celli]) {
                //do nothing if it is not a normal cell, or a cell that is in the
                //first boundary layer, or the block does not exist in this
                //spatial cell
@@ -486,7 +690,17 @@ bool trans_map_1d(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpi
           
             // buffer where we read in source data. i index vectorized
             Vec values[(1 + 2 * VLASOV_STENCIL_WIDTH) * WID3 / VECL];
-            copy_trans_block_data(sourceNeighbors.data() + celli * nSourceNeighborsPerCell, blockGID, values, cellid_transpose, popID);
+            Realf* blockDatas[nSourceNeighborsPerCell];
+            for (uint b = 0; b < nSourceNeighborsPerCell; ++b) {
+               const uint srcIndex = setup.sourceNeighborIndex[celli * nSourceNeighborsPerCell + b];
+               const vmesh::LocalID srcLID = stencilBlockLocalID[srcIndex];
+               if (srcLID != vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>::invalidLocalID()) {
+                  blockDatas[b] = stencilCells[srcIndex]->get_data(srcLID, popID);
+               } else {
+                  blockDatas[b] = NULL;
+               }
+            }
+            load_trans_block_data(blockDatas, values, cellid_transpose);
             velocity_block_indices_t block_indices;
             uint8_t refLevel;
             vmesh.getIndices(blockGID,refLevel, block_indices[0], block_indices[1], block_indices[2]);
@@ -581,7 +795,7 @@ bool trans_map_1d(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpi
          for(uint celli = 0; celli < allCellsPointer.size(); celli++){
             SpatialCell* spatial_cell = allCellsPointer[celli];
             if(spatial_cell->sysBoundaryFlag == sysboundarytype::NOT_SYSBOUNDARY) {
-               const vmesh::LocalID blockLID = allCellsBlockLocalID[celli];
+               const vmesh::LocalID blockLID = stencilBlockLocalID[celli];
                if (blockLID != vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>::invalidLocalID()) {
                   Realf* blockData = spatial_cell->get_data(blockLID, popID);
                   for(int i = 0; i < WID3; i++) {
@@ -595,13 +809,14 @@ bool trans_map_1d(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpi
          for(uint celli = 0; celli < localPropagatedCells.size(); celli++){
             if(targetsValid[celli]) {
                for(uint ti = 0; ti < 3; ti++) {
-                  SpatialCell* spatial_cell = targetNeighbors[celli * 3 + ti];
-                  if(spatial_cell ==NULL) {
+                  const uint targetIndex = setup.targetNeighborIndex[celli * 3 + ti];
+                  if(targetIndex == invalidIndex) {
                      //invalid target spatial cell
                      continue;
                   }
+                  SpatialCell* spatial_cell = stencilCells[targetIndex];
                
-                  const vmesh::LocalID blockLID = spatial_cell->get_velocity_block_local_id(blockGID, popID);
+                  const vmesh::LocalID blockLID = stencilBlockLocalID[targetIndex];
                   if (blockLID == vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>::invalidLocalID()) {
                      // block does not exist. If so, we do not create it and add stuff to it here.
                      // We have already created blocks around blocks with content in
@@ -627,6 +842,27 @@ bool trans_map_1d(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpi
    return true;
 }
 
+/* 
+   Here we map from the current time step grid, to a target grid which
+   is the lagrangian departure grid (so th grid at timestep +dt,
+   tracked backwards by -dt). This is done in ordinary space in the translation step
+
+   Convenience version which computes the neighbor and block lists
+   before mapping. Ghost block data of the source stencil has to be up
+   to date when this is called.*/
+
+bool trans_map_1d(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                  const vector<CellID>& localPropagatedCells,
+                  const vector<CellID>& remoteTargetCells,
+                  const uint dimension,
+                  const Realv dt,
+                  const uint popID) {
+   TransBlockListCache blockListCache;
+   TransMapSetup setup;
+   trans_map_1d_setup(mpiGrid, localPropagatedCells, remoteTargetCells, dimension, popID, blockListCache, setup);
+   return trans_map_1d(mpiGrid, localPropagatedCells, setup, dimension, dt, popID);
+}
+
 /*!
 
   This function communicates the mapping on process boundaries, and then updates the data to their correct values.
@@ -732,22 +968,25 @@ void update_remote_mapping_contribution(
    }
 
    // Do communication
-   SpatialCell::setCommunicatedSpecies(popID);
-   SpatialCell::set_mpi_transfer_type(Transfer::NEIGHBOR_VEL_BLOCK_DATA);
+   int neighborhood = 0;
    switch(dimension) {
    case 0:
-      if(direction > 0) mpiGrid.update_copies_of_remote_neighbors(SHIFT_P_X_NEIGHBORHOOD_ID);
-      if(direction < 0) mpiGrid.update_copies_of_remote_neighbors(SHIFT_M_X_NEIGHBORHOOD_ID);
+      neighborhood = (direction > 0) ? SHIFT_P_X_NEIGHBORHOOD_ID : SHIFT_M_X_NEIGHBORHOOD_ID;
       break;
    case 1:
-      if(direction > 0) mpiGrid.update_copies_of_remote_neighbors(SHIFT_P_Y_NEIGHBORHOOD_ID);
-      if(direction < 0) mpiGrid.update_copies_of_remote_neighbors(SHIFT_M_Y_NEIGHBORHOOD_ID);
+      neighborhood = (direction > 0) ? SHIFT_P_Y_NEIGHBORHOOD_ID : SHIFT_M_Y_NEIGHBORHOOD_ID;
       break;
    case 2:
-      if(direction > 0) mpiGrid.update_copies_of_remote_neighbors(SHIFT_P_Z_NEIGHBORHOOD_ID);
-      if(direction < 0) mpiGrid.update_copies_of_remote_neighbors(SHIFT_M_Z_NEIGHBORHOOD_ID);
+      neighborhood = (direction > 0) ? SHIFT_P_Z_NEIGHBORHOOD_ID : SHIFT_M_Z_NEIGHBORHOOD_ID;
       break;
    }
+   SpatialCell::setCommunicatedSpecies(popID);
+   SpatialCell::set_mpi_transfer_type(Transfer::NEIGHBOR_VEL_BLOCK_DATA);
+   mpiGrid.start_remote_neighbor_copy_updates(neighborhood);
+
+   // Receives are summed up while sends may still be in progress. The
+   // send cells can only be zeroed once their data has left.
+   mpiGrid.wait_remote_neighbor_copy_update_receives(neighborhood);
    
 #pragma omp parallel
    {
@@ -762,7 +1001,12 @@ void update_remote_mapping_contribution(
             blockData[cell] += receiveBuffers[c][cell];
          }
       }
-       
+   }
+
+   mpiGrid.wait_remote_neighbor_copy_update_sends(neighborhood);
+
+#pragma omp parallel
+   {
       // send cell data is set to zero. This is to avoid double copy if
       // one cell is the neighbor on bot + and - side to the same
       // process
@@ -22,6 +22,7 @@
 #ifndef CPU_TRANS_MAP_H
 #define CPU_TRANS_MAP_H
 
+#include <unordered_map>
 #include <vector>
 
 #include "vec.h"
@@ -32,7 +33,7 @@ void compute_spatial_source_neighbors(const dccrg::Dccrg<SpatialCell,dccrg::Cart
                                       const CellID& cellID,const uint dimension,SpatialCell **neighbors);
 void compute_spatial_target_neighbors(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
                                       const CellID& cellID,const uint dimension,SpatialCell **neighbors);
-void copy_trans_block_data(SpatialCell** source_neighbors,const vmesh::GlobalID blockGID,
+void copy_trans_block_data(SpatialCell* const* source_neighbors,const vmesh::GlobalID blockGID,
                            Vec* values,const unsigned char* const cellid_transpose,const uint popID);
 CellID get_spatial_neighbor(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
                             const CellID& cellID,const bool include_first_boundary_layer,
@@ -44,7 +45,45 @@ void store_trans_block_data(SpatialCell** target_neighbors,const vmesh::GlobalID
                             Vec* __restrict__ target_values,
                             const unsigned char* const cellid_transpose,const uint popID);
 
+/** Velocity blocks of a spatial cell sorted by global ID, with the matching local IDs.*/
+struct SortedBlockList {
+   std::vector<vmesh::GlobalID> blockGIDs; /**< Global IDs in ascending order.*/
+   std::vector<vmesh::LocalID> blockLIDs;  /**< Local IDs of the blocks in blockGIDs.*/
+};
+
+/** Sorted block lists of spatial cells. Velocity block lists do not change during
+ * translation, so one cache can be used for all dimensions of a population.*/
+typedef std::unordered_map<spatial_cell::SpatialCell*,SortedBlockList> TransBlockListCache;
+
+/** Neighbor indices and velocity block union used by trans_map_1d. These
+ * depend only on the grid topology and on the velocity block lists, not on
+ * the block data, and can thus be computed while ghost data is in flight.*/
+struct TransMapSetup {
+   std::vector<CellID> allCells;                        /**< Local propagated cells followed by remote target cells.*/
+   std::vector<spatial_cell::SpatialCell*> allCellsPointer; /**< Pointers to cells in allCells.*/
+   std::vector<spatial_cell::SpatialCell*> stencilCells;    /**< allCells followed by the other cells in the source stencils.*/
+   std::vector<const SortedBlockList*> stencilBlockLists;  /**< Sorted block lists of stencilCells.*/
+   std::vector<uint> sourceNeighborIndex;              /**< Index to stencilCells of the source stencil of each propagated cell.*/
+   std::vector<uint> targetNeighborIndex;              /**< Index to stencilCells of the targets (-1,0,+1) of each propagated cell,
+                                                        * numeric_limits<uint>::max() if the target is not valid.*/
+   std::vector<uint8_t> isTranslated;                  /**< If nonzero, the propagated cell is mapped (not a deeper boundary layer).*/
+   std::vector<vmesh::GlobalID> unionOfBlocks;         /**< Union of velocity blocks in allCells, sorted.*/
+};
+
 bool do_translate_cell(spatial_cell::SpatialCell* SC);
+void trans_map_1d_setup(const dccrg::Dccrg<spatial_cell::SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                        const std::vector<CellID>& localPropagatedCells,
+                        const std::vector<CellID>& remoteTargetCells,
+                        const uint dimension,
+                        const uint popID,
+                        TransBlockListCache& blockListCache,
+                        TransMapSetup& setup);
+bool trans_map_1d(const dccrg::Dccrg<spatial_cell::SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                  const std::vector<CellID>& localPropagatedCells,
+                  const TransMapSetup& setup,
+                  const uint dimension,
+                  const Realv dt,
+                  const uint popID);
 bool trans_map_1d(const dccrg::Dccrg<spatial_cell::SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
                   const std::vector<CellID>& localPropagatedCells,
                   const std::vector<CellID>& remoteTargetCells,
@@ -68,7 +107,7 @@ void compute_spatial_target_neighbors(const dccrg::Dccrg<SpatialCell,
                                       const CellID& cellID,
                                       const uint dimension,
                                       SpatialCell **neighbors);
-void copy_trans_block_data(SpatialCell** source_neighbors,
+void copy_trans_block_data(SpatialCell* const* source_neighbors,
                            const vmesh::GlobalID blockGID,
                            Vec* values,
                            const unsigned char* const cellid_transpose,
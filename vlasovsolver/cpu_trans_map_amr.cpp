@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <numeric>
 #include "cpu_1d_ppm_nonuniform.hpp"
 //#include "cpu_1d_ppm_nonuniform_conserving.hpp"
 #include "vec.h"
@@ -591,18 +593,23 @@ setOfPencils buildPencilsWithNeighbors( const dccrg::Dccrg<SpatialCell,dccrg::Ca
   
 }
 
-/* Propagate a given velocity block in all spatial cells of a pencil by a time step dt using a PPM reconstruction.
+/* Propagate a given velocity block in all spatial cells of a group of pencils by a time step dt using a PPM reconstruction.
+ * All pencils of the group have the same length. The source and target data of the pencils is stored
+ * one pencil after another, so that one sweep over the cells of the pencils handles the whole group.
  *
- * @param dz Width of spatial cells in the direction of the pencil, vector datatype
- * @param values Density values of the block, vector datatype
+ * @param dz Pointers to the widths of the source cells of each pencil in the direction of the pencils, vector datatype
+ * @param values Density values of the block in the source cells of the pencils, vector datatype
+ * @param targetValues Target values of the block in the target cells of the pencils, vector datatype
  * @param dimension Satial dimension
  * @param blockGID Global ID of the velocity block.
  * @param dt Time step
  * @param vmesh Velocity mesh object
- * @param lengthOfPencil Number of cells in the pencil
+ * @param lengthOfPencil Number of cells in each pencil
+ * @param nPencils Number of pencils in the group
+ * @param threshold Sparsity threshold of each pencil, taken from the first source cell of the pencil
  */
 void propagatePencil(
-   Vec* dz,
+   const Vec* const* dz,
    Vec* values,
    Vec* targetValues, // thread-owned aligned-allocated
    const uint dimension,
@@ -610,7 +617,8 @@ void propagatePencil(
    const Realv dt,
    const vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID> &vmesh,
    const uint lengthOfPencil,
-   const Realv threshold
+   const uint nPencils,
+   const Realv* threshold
 ) {
    // Get velocity data from vmesh that we need later to calculate the translation
    velocity_block_indices_t block_indices;
@@ -623,75 +631,84 @@ void propagatePencil(
    // In fact propagating to > 1 neighbor will give an error
    // Also defined in the calling function for the allocation of targetValues
    const uint nTargetNeighborsPerPencil = 1;
-
+   const uint sourceLength = lengthOfPencil + 2 * VLASOV_STENCIL_WIDTH;
+   const uint targetLength = lengthOfPencil + 2 * nTargetNeighborsPerPencil;
    
-   for (uint i = 0; i < (lengthOfPencil + 2 * nTargetNeighborsPerPencil) * WID3 / VECL; i++) {
+   for (uint i = 0; i < nPencils * targetLength * VEC_PER_BLOCK; i++) {
       
       // init target_values
       targetValues[i] = Vec(0.0);
       
    }
+
+   // Cell centered velocities of the planes of the block, the same for all pencils
+   Realv cell_vz[WID];
+   for (uint k = 0; k < WID; ++k) {
+      cell_vz[k] = (block_indices[dimension] * WID + k + 0.5) * dvz + vz_min;
+   }
    
-   // Go from 0 to length here to propagate all the cells in the pencil
+   // Go from 0 to length here to propagate all the cells in the pencils
    for (uint i = 0; i < lengthOfPencil; i++){
       
       // The source array is padded by VLASOV_STENCIL_WIDTH on both sides.
       uint i_source   = i + VLASOV_STENCIL_WIDTH;
+
+      for (uint pencili = 0; pencili < nPencils; pencili++) {
+
+         const Vec* pencilDz = dz[pencili];
+         Vec* pencilValues = values + pencili * sourceLength * VEC_PER_BLOCK;
+         Vec* pencilTargetValues = targetValues + pencili * targetLength * VEC_PER_BLOCK;
+
+         // Ratios of cell widths used to scale the density moved to the neighbor cells
+         const Vec dzRatioPositive = pencilDz[i_source] / pencilDz[i_source + 1];
+         const Vec dzRatioNegative = pencilDz[i_source] / pencilDz[i_source - 1];
       
-      for (uint k = 0; k < WID; ++k) {
+         for (uint k = 0; k < WID; ++k) {
 
-         const Realv cell_vz = (block_indices[dimension] * WID + k + 0.5) * dvz + vz_min; //cell centered velocity
-         const Vec z_translation = cell_vz * dt / dz[i_source]; // how much it moved in time dt (reduced units)
+            const Vec z_translation = cell_vz[k] * dt / pencilDz[i_source]; // how much it moved in time dt (reduced units)
 
-         // Determine direction of translation
-         // part of density goes here (cell index change along spatial direcion)
-         Vecb positiveTranslationDirection = (z_translation > Vec(0.0));
+            // Determine direction of translation
+            // part of density goes here (cell index change along spatial direcion)
+            Vecb positiveTranslationDirection = (z_translation > Vec(0.0));
          
-         // Calculate normalized coordinates in current cell.
-         // The coordinates (scaled units from 0 to 1) between which we will
-         // integrate to put mass in the target  neighboring cell.
-         // Normalize the coordinates to the origin cell. Then we scale with the difference
-         // in volume between target and origin later when adding the integrated value.
-         Vec z_1,z_2;
-         z_1 = select(positiveTranslationDirection, 1.0 - z_translation, 0.0);
-         z_2 = select(positiveTranslationDirection, 1.0, - z_translation);
-
-         // if( horizontal_or(abs(z_1) > Vec(1.0)) || horizontal_or(abs(z_2) > Vec(1.0)) ) {
-         //    std::cout << "Error, CFL condition violated\n";
-         //    std::cout << "Exiting\n";
-         //    std::exit(1);
-         // }
-         
-         for (uint planeVector = 0; planeVector < VEC_PER_PLANE; planeVector++) {   
+            // Calculate normalized coordinates in current cell.
+            // The coordinates (scaled units from 0 to 1) between which we will
+            // integrate to put mass in the target  neighboring cell.
+            // Normalize the coordinates to the origin cell. Then we scale with the difference
+            // in volume between target and origin later when adding the integrated value.
+            Vec z_1,z_2;
+            z_1 = select(positiveTranslationDirection, 1.0 - z_translation, 0.0);
+            z_2 = select(positiveTranslationDirection, 1.0, - z_translation);
+
+            for (uint planeVector = 0; planeVector < VEC_PER_PLANE; planeVector++) {   
       
-            // Compute polynomial coefficients
-            Vec a[3];
-            // Dz: is a padded array, pointer can point to the beginning, i + VLASOV_STENCIL_WIDTH will get the right cell.
-            // values: transpose function adds VLASOV_STENCIL_WIDTH to the block index, therefore we substract it here, then
-            // i + VLASOV_STENCIL_WIDTH will point to the right cell. Complicated! Why! Sad! MVGA!
-            compute_ppm_coeff_nonuniform(dz + i,
-                                         values + i_trans_ps_blockv_pencil(planeVector, k, i-VLASOV_STENCIL_WIDTH, lengthOfPencil),
-                                         h4, VLASOV_STENCIL_WIDTH, a, threshold);
+               // Compute polynomial coefficients
+               Vec a[3];
+               // Dz: is a padded array, pointer can point to the beginning, i + VLASOV_STENCIL_WIDTH will get the right cell.
+               // values: transpose function adds VLASOV_STENCIL_WIDTH to the block index, therefore we substract it here, then
+               // i + VLASOV_STENCIL_WIDTH will point to the right cell. Complicated! Why! Sad! MVGA!
+               compute_ppm_coeff_nonuniform(pencilDz + i,
+                                            pencilValues + i_trans_ps_blockv_pencil(planeVector, k, i-VLASOV_STENCIL_WIDTH, lengthOfPencil),
+                                            h4, VLASOV_STENCIL_WIDTH, a, threshold[pencili]);
             
-            // Compute integral
-            const Vec ngbr_target_density =
-               z_2 * ( a[0] + z_2 * ( a[1] + z_2 * a[2] ) ) -
-               z_1 * ( a[0] + z_1 * ( a[1] + z_1 * a[2] ) );
+               // Compute integral
+               const Vec ngbr_target_density =
+                  z_2 * ( a[0] + z_2 * ( a[1] + z_2 * a[2] ) ) -
+                  z_1 * ( a[0] + z_1 * ( a[1] + z_1 * a[2] ) );
                                     
-            // Store mapped density in two target cells
-            // in the neighbor cell we will put this density
-            targetValues[i_trans_pt_blockv(planeVector, k, i + 1)] += select( positiveTranslationDirection,
-                                                                              ngbr_target_density
-                                                                              * dz[i_source] / dz[i_source + 1],
-                                                                              Vec(0.0));
-            targetValues[i_trans_pt_blockv(planeVector, k, i - 1 )] += select(!positiveTranslationDirection,
-                                                                              ngbr_target_density
-                                                                              * dz[i_source] / dz[i_source - 1],
-                                                                              Vec(0.0));
+               // Store mapped density in two target cells
+               // in the neighbor cell we will put this density
+               pencilTargetValues[i_trans_pt_blockv(planeVector, k, i + 1)] += select( positiveTranslationDirection,
+                                                                                       ngbr_target_density * dzRatioPositive,
+                                                                                       Vec(0.0));
+               pencilTargetValues[i_trans_pt_blockv(planeVector, k, i - 1 )] += select(!positiveTranslationDirection,
+                                                                                       ngbr_target_density * dzRatioNegative,
+                                                                                       Vec(0.0));
             
-            // in the current original cells we will put the rest of the original density
-            targetValues[i_trans_pt_blockv(planeVector, k, i)] += 
-               values[i_trans_ps_blockv_pencil(planeVector, k, i, lengthOfPencil)] - ngbr_target_density;
+               // in the current original cells we will put the rest of the original density
+               pencilTargetValues[i_trans_pt_blockv(planeVector, k, i)] += 
+                  pencilValues[i_trans_ps_blockv_pencil(planeVector, k, i, lengthOfPencil)] - ngbr_target_density;
+            }
          }
       }
    }
@@ -781,7 +798,7 @@ void getSeedIds(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGr
  * @param popID ID of the particle species.
  */
 bool copy_trans_block_data_amr(
-    SpatialCell** source_neighbors,
+    SpatialCell* const* source_neighbors,
     const vmesh::GlobalID blockGID,
     int lengthOfPencil,
     Vec* values,
@@ -1096,6 +1113,156 @@ void printPencilsFunc(const setOfPencils& pencils, const uint dimension, const i
    MPI_Barrier(MPI_COMM_WORLD);
 }
 
+/* Pencils of one spatial dimension together with the source and target cells of the pencils.
+ * The pencils only depend on the spatial mesh and its partitioning, so they are
+ * reused for all populations and time steps until the mesh is repartitioned.
+ */
+struct PencilCache {
+   bool valid;
+   uint repartitionEpoch;                     /**< Value of P::meshRepartitionEpoch when the pencils were built.*/
+   std::vector<CellID> propagatedCells;       /**< Local propagated cells the pencils were built for.*/
+   setOfPencils pencils;
+   std::vector<SpatialCell*> targetCells;     /**< Target cells of all pencils, in pencil id order.*/
+   std::vector<uint> pencilOrder;             /**< Pencil ids sorted by length.*/
+   std::vector<uint> groupStart;              /**< First index in pencilOrder of each group, terminated by pencils.N.*/
+   std::vector<uint> sourceOffset;            /**< Offsets of the pencils in sourceCells and sourceDz, in pencilOrder.*/
+   std::vector<uint> targetOffset;            /**< Offsets of the pencils in targetCells, in pencil id order.*/
+   uint maxLengthOfPencils;
+   std::vector<SpatialCell*> sourceCells;     /**< Source cells of all pencils including the stencil.*/
+   std::vector<Vec, aligned_allocator<Vec,WID3>> sourceDz; /**< Widths of the source cells in the direction of the pencils.*/
+
+   PencilCache(): valid(false),repartitionEpoch(0),maxLengthOfPencils(0) { }
+};
+
+static PencilCache pencilCache[3];
+
+/* Build the pencils of the given dimension and the source and target cell
+ * lists that trans_map_1d_amr needs for mapping them.
+ *
+ * @param [in] mpiGrid DCCRG grid object
+ * @param [in] localPropagatedCells List of local cells that get propagated
+ * @param dimension Spatial dimension
+ * @param [out] cache Pencils and cell lists, old contents are replaced
+ */
+static void buildPencilCache(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                             const vector<CellID>& localPropagatedCells,
+                             const uint dimension,
+                             PencilCache& cache) {
+
+   // compute pencils => set of pencils (shared datastructure)
+   
+   phiprof::start("getSeedIds");
+   vector<CellID> seedIds;
+   getSeedIds(mpiGrid, localPropagatedCells, dimension, seedIds);
+   phiprof::stop("getSeedIds");
+   
+   phiprof::start("buildPencils");
+
+   // Output vectors for ready pencils
+   setOfPencils pencils;
+   
+   #pragma omp parallel
+   {
+      // Empty vectors for internal use of buildPencilsWithNeighbors. Could be default values but
+      // default vectors are complicated. Should overload buildPencilsWithNeighbors like suggested here
+      // https://stackoverflow.com/questions/3147274/c-default-argument-for-vectorint
+      vector<CellID> ids;
+      vector<uint> path;
+      // thread-internal pencil set to be accumulated at the end
+      setOfPencils thread_pencils;
+      // iterators used in the accumulation
+      std::vector<CellID>::iterator ibeg, iend;
+      
+      #pragma omp for schedule(guided)
+      for (uint i=0; i<seedIds.size(); i++) {
+         cuint seedId = seedIds[i];
+         // Construct pencils from the seedIds into a set of pencils.
+         thread_pencils = buildPencilsWithNeighbors(mpiGrid, thread_pencils, seedId, ids, dimension, path, seedIds);
+      }
+      
+      // accumulate thread results in global set of pencils
+      #pragma omp critical
+      {
+	 for (uint i=0; i<thread_pencils.N; i++) {
+	    // Use vector range constructor
+            ibeg = thread_pencils.ids.begin() + thread_pencils.idsStart[i];
+            iend = ibeg + thread_pencils.lengthOfPencils[i];
+            std::vector<CellID> pencilIds(ibeg, iend);
+            pencils.addPencil(pencilIds,thread_pencils.x[i],thread_pencils.y[i],thread_pencils.periodic[i],thread_pencils.path[i]);
+         }
+      }
+   }
+   
+   phiprof::start("check_ghost_cells");
+   // Check refinement of two ghost cells on each end of each pencil
+   check_ghost_cells(mpiGrid,pencils,dimension);
+   phiprof::stop("check_ghost_cells");
+   phiprof::stop("buildPencils");
+
+   // Assuming 1 neighbor in the target array because of the CFL condition
+   // In fact propagating to > 1 neighbor will give an error
+   const uint nTargetNeighborsPerPencil = 1;
+   
+   // Compute spatial neighbors for target cells.
+   // For targets we need the local cells, plus a padding of 1 cell at both ends
+   phiprof::start("computeSpatialTargetCellsForPencils");
+   std::vector<SpatialCell*> targetCells(pencils.sumOfLengths + pencils.N * 2 * nTargetNeighborsPerPencil );
+   computeSpatialTargetCellsForPencilsWithFaces(mpiGrid, pencils, dimension, targetCells.data());
+   phiprof::stop("computeSpatialTargetCellsForPencils");
+
+   // Group pencils of equal length into groups of up to VECL pencils. The pencils of
+   // a group are loaded into one buffer and propagated together in propagatePencil.
+   phiprof::start("buildPencilGroups");
+   std::vector<uint> pencilOrder(pencils.N);
+   std::iota(pencilOrder.begin(), pencilOrder.end(), 0);
+   std::stable_sort(pencilOrder.begin(), pencilOrder.end(),
+                    [&pencils](const uint a, const uint b) {return pencils.lengthOfPencils[a] < pencils.lengthOfPencils[b];});
+   std::vector<uint> groupStart;
+   for (uint i = 0; i < pencils.N; ++i) {
+      if (i == 0 || i - groupStart.back() == VECL ||
+          pencils.lengthOfPencils[pencilOrder[i]] != pencils.lengthOfPencils[pencilOrder[i-1]]) {
+         groupStart.push_back(i);
+      }
+   }
+   groupStart.push_back(pencils.N);
+
+   std::vector<uint> sourceOffset(pencils.N + 1, 0);
+   for (uint i = 0; i < pencils.N; ++i) {
+      sourceOffset[i+1] = sourceOffset[i] + pencils.lengthOfPencils[pencilOrder[i]] + 2 * VLASOV_STENCIL_WIDTH;
+   }
+   std::vector<uint> targetOffset(pencils.N, 0);
+   for (uint pencili = 1; pencili < pencils.N; ++pencili) {
+      targetOffset[pencili] = targetOffset[pencili-1] + pencils.lengthOfPencils[pencili-1] + 2 * nTargetNeighborsPerPencil;
+   }
+
+   // Compute spatial neighbors for the source cells of the pencils. In
+   // source cells we have a wider stencil and take into account boundaries.
+   // dz is the cell size in the direction of the pencil
+   std::vector<SpatialCell*> sourceCells(sourceOffset[pencils.N]);
+   std::vector<Vec, aligned_allocator<Vec,WID3>> sourceDz(sourceOffset[pencils.N]);
+   #pragma omp parallel for schedule(guided)
+   for (uint i = 0; i < pencils.N; ++i) {
+      computeSpatialSourceCellsForPencil(mpiGrid, pencils, pencilOrder[i], dimension, sourceCells.data() + sourceOffset[i]);
+      for (uint celli = sourceOffset[i]; celli < sourceOffset[i+1]; ++celli) {
+         sourceDz[celli] = sourceCells[celli]->parameters[CellParams::DX+dimension];
+      }
+   }
+   phiprof::stop("buildPencilGroups");
+
+   cache.maxLengthOfPencils = (pencils.N > 0) ? pencils.lengthOfPencils[pencilOrder.back()] : 0;
+   cache.pencils = pencils;
+   cache.targetCells.swap(targetCells);
+   cache.pencilOrder.swap(pencilOrder);
+   cache.groupStart.swap(groupStart);
+   cache.sourceOffset.swap(sourceOffset);
+   cache.targetOffset.swap(targetOffset);
+   cache.sourceCells.swap(sourceCells);
+   cache.sourceDz.swap(sourceDz);
+   cache.propagatedCells = localPropagatedCells;
+   cache.repartitionEpoch = P::meshRepartitionEpoch;
+   cache.valid = true;
+}
+
 /* Map velocity blocks in all local cells forward by one time step in one spatial dimension.
  * This function uses 1-cell wide pencils to update cells in-place to avoid allocating large
  * temporary buffers.
@@ -1172,70 +1339,42 @@ bool trans_map_1d_amr(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
       break;
    }
            
-   // ****************************************************************************
-
-   // compute pencils => set of pencils (shared datastructure)
-   
-   phiprof::start("getSeedIds");
-   vector<CellID> seedIds;
-   getSeedIds(mpiGrid, localPropagatedCells, dimension, seedIds);
-   phiprof::stop("getSeedIds");
-   
-   phiprof::start("buildPencils");
-
-   // Output vectors for ready pencils
-   setOfPencils pencils;
-   
-   #pragma omp parallel
-   {
-      // Empty vectors for internal use of buildPencilsWithNeighbors. Could be default values but
-      // default vectors are complicated. Should overload buildPencilsWithNeighbors like suggested here
-      // https://stackoverflow.com/questions/3147274/c-default-argument-for-vectorint
-      vector<CellID> ids;
-      vector<uint> path;
-      // thread-internal pencil set to be accumulated at the end
-      setOfPencils thread_pencils;
-      // iterators used in the accumulation
-      std::vector<CellID>::iterator ibeg, iend;
-      
-      #pragma omp for schedule(guided)
-      for (uint i=0; i<seedIds.size(); i++) {
-         cuint seedId = seedIds[i];
-         // Construct pencils from the seedIds into a set of pencils.
-         thread_pencils = buildPencilsWithNeighbors(mpiGrid, thread_pencils, seedId, ids, dimension, path, seedIds);
-      }
-      
-      // accumulate thread results in global set of pencils
-      #pragma omp critical
-      {
-	 for (uint i=0; i<thread_pencils.N; i++) {
-	    // Use vector range constructor
-            ibeg = thread_pencils.ids.begin() + thread_pencils.idsStart[i];
-            iend = ibeg + thread_pencils.lengthOfPencils[i];
-            std::vector<CellID> pencilIds(ibeg, iend);
-            pencils.addPencil(pencilIds,thread_pencils.x[i],thread_pencils.y[i],thread_pencils.periodic[i],thread_pencils.path[i]);
+   // init cellid_transpose
+   for (uint k=0; k<WID; ++k) {
+      for (uint j=0; j<WID; ++j) {
+         for (uint i=0; i<WID; ++i) {
+            const uint cell =
+               i * cell_indices_to_id[0] +
+               j * cell_indices_to_id[1] +
+               k * cell_indices_to_id[2];
+            cellid_transpose[ i + j * WID + k * WID2] = cell;
          }
       }
+   }
+           
+   // ****************************************************************************
 
-      // init cellid_transpose (moved here to take advantage of the omp parallel region)
-      #pragma omp for collapse(3)
-      for (uint k=0; k<WID; ++k) {
-         for (uint j=0; j<WID; ++j) {
-            for (uint i=0; i<WID; ++i) {
-               const uint cell =
-                  i * cell_indices_to_id[0] +
-                  j * cell_indices_to_id[1] +
-                  k * cell_indices_to_id[2];
-               cellid_transpose[ i + j * WID + k * WID2] = cell;
-            }
-         }
-      }
+   // Pencils are rebuilt only if the mesh has been repartitioned or the
+   // propagated cells have changed since they were last built.
+   // The call count of this timer relative to that of setup gives the miss
+   // rate of the cache.
+   PencilCache& cache = pencilCache[dimension];
+   if (!cache.valid ||
+       cache.repartitionEpoch != P::meshRepartitionEpoch ||
+       cache.propagatedCells != localPropagatedCells) {
+      phiprof::start("pencilCache-miss");
+      buildPencilCache(mpiGrid, localPropagatedCells, dimension, cache);
+      phiprof::stop("pencilCache-miss");
    }
-   
-   phiprof::start("check_ghost_cells");
-   // Check refinement of two ghost cells on each end of each pencil
-   check_ghost_cells(mpiGrid,pencils,dimension);
-   phiprof::stop("check_ghost_cells");
+   const setOfPencils& pencils = cache.pencils;
+   const std::vector<SpatialCell*>& targetCells = cache.targetCells;
+   const std::vector<uint>& pencilOrder = cache.pencilOrder;
+   const std::vector<uint>& groupStart = cache.groupStart;
+   const std::vector<uint>& sourceOffset = cache.sourceOffset;
+   const std::vector<uint>& targetOffset = cache.targetOffset;
+   const uint maxLengthOfPencils = cache.maxLengthOfPencils;
+   const std::vector<SpatialCell*>& sourceCells = cache.sourceCells;
+   const std::vector<Vec, aligned_allocator<Vec,WID3>>& sourceDz = cache.sourceDz;
 
    // ****************************************************************************   
 
@@ -1254,7 +1393,6 @@ bool trans_map_1d_amr(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
          nPencils[nPencils.size()-1] += myPencilCount;
       }
    }
-   phiprof::stop("buildPencils");
    
    // Get a pointer to the velocity mesh of the first spatial cell
    const vmesh::VelocityMesh<vmesh::GlobalID,vmesh::LocalID>& vmesh = allCellsPointer[0]->get_velocity_mesh(popID);
@@ -1296,14 +1434,6 @@ bool trans_map_1d_amr(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
    // In fact propagating to > 1 neighbor will give an error
    const uint nTargetNeighborsPerPencil = 1;
    
-   // Compute spatial neighbors for target cells.
-   // For targets we need the local cells, plus a padding of 1 cell at both ends
-   phiprof::start("computeSpatialTargetCellsForPencils");
-   std::vector<SpatialCell*> targetCells(pencils.sumOfLengths + pencils.N * 2 * nTargetNeighborsPerPencil );
-   computeSpatialTargetCellsForPencilsWithFaces(mpiGrid, pencils, dimension, targetCells.data());
-   phiprof::stop("computeSpatialTargetCellsForPencils");
-   
-   
    phiprof::stop("setup");
    
    int t1 = phiprof::initializeTimer("mapping");
@@ -1313,39 +1443,14 @@ bool trans_map_1d_amr(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
    {
       // declarations for variables needed by the threads
       std::vector<Realf, aligned_allocator<Realf, WID3>> targetBlockData((pencils.sumOfLengths + 2 * nTargetNeighborsPerPencil * pencils.N) * WID3);
-      std::vector<std::vector<SpatialCell*>> pencilSourceCells;
-      
-      // Allocate aligned vectors which are needed once per pencil to avoid reallocating once per block loop + pencil loop iteration
-      std::vector<std::vector<Vec, aligned_allocator<Vec,WID3>>> pencilTargetValues;
-      std::vector<std::vector<Vec, aligned_allocator<Vec,WID3>>> pencilSourceVecData;
-      std::vector<std::vector<Vec, aligned_allocator<Vec,WID3>>> pencildz;
-      
-      for(uint pencili = 0; pencili < pencils.N; ++pencili) {
-         
-         cint L = pencils.lengthOfPencils[pencili];
-         cuint sourceLength = L + 2 * VLASOV_STENCIL_WIDTH;
-         
-         // Vector buffer where we write data, initialized to 0*/
-         std::vector<Vec, aligned_allocator<Vec,WID3>> targetValues((L + 2 * nTargetNeighborsPerPencil) * WID3 / VECL);
-         pencilTargetValues.push_back(targetValues);
-         // Allocate source data: sourcedata<length of pencil * WID3)
-         // Add padding by 2 * VLASOV_STENCIL_WIDTH
-         std::vector<Vec, aligned_allocator<Vec,WID3>> sourceVecData(sourceLength * WID3 / VECL);
-         pencilSourceVecData.push_back(sourceVecData);
-
-         // Compute spatial neighbors for the source cells of the pencil. In
-         // source cells we have a wider stencil and take into account boundaries.
-         std::vector<SpatialCell*> sourceCells(sourceLength);
-         computeSpatialSourceCellsForPencil(mpiGrid, pencils, pencili, dimension, sourceCells.data());
-         pencilSourceCells.push_back(sourceCells);
-
-         // dz is the cell size in the direction of the pencil
-         std::vector<Vec, aligned_allocator<Vec,WID3>> dz(sourceLength);
-         for(uint i = 0; i < sourceCells.size(); ++i) {
-            dz[i] = sourceCells[i]->parameters[CellParams::DX+dimension];
-         }
-         pencildz.push_back(dz);
-      }
+      std::vector<uint8_t> pencilHasData(pencils.N, false);
+
+      // Aligned source and target buffers for one group of pencils, allocated once per thread
+      std::vector<Vec, aligned_allocator<Vec,WID3>> groupSourceVecData(VECL * (maxLengthOfPencils + 2 * VLASOV_STENCIL_WIDTH) * VEC_PER_BLOCK);
+      std::vector<Vec, aligned_allocator<Vec,WID3>> groupTargetValues(VECL * (maxLengthOfPencils + 2 * nTargetNeighborsPerPencil) * VEC_PER_BLOCK);
+      uint groupPencils[VECL];
+      const Vec* groupDz[VECL];
+      Realv groupThreshold[VECL];
       
       // Loop over velocity space blocks. Thread this loop (over vspace blocks) with OpenMP.
       #pragma omp for schedule(guided)
@@ -1356,56 +1461,68 @@ bool trans_map_1d_amr(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
 
             phiprof::start(t1);
             
-            // Loop over pencils
-            uint totalTargetLength = 0;
-            for(uint pencili = 0; pencili < pencils.N; ++pencili){
-//             for ( auto pencili : unionOfBlocksMapToPencilIds.at(blockGID) ) {
-               
-               int L = pencils.lengthOfPencils[pencili];
-               uint targetLength = L + 2 * nTargetNeighborsPerPencil;
-               uint sourceLength = L + 2 * VLASOV_STENCIL_WIDTH;
-                              
+            // Loop over groups of pencils
+            for (uint groupi = 0; groupi + 1 < groupStart.size(); ++groupi) {
+
+               const uint L = pencils.lengthOfPencils[pencilOrder[groupStart[groupi]]];
+               const uint targetLength = L + 2 * nTargetNeighborsPerPencil;
+               const uint sourceLength = L + 2 * VLASOV_STENCIL_WIDTH;
+
                // load data(=> sourcedata) / (proper xy reconstruction in future)
-               bool pencil_has_data = copy_trans_block_data_amr(pencilSourceCells[pencili].data(), blockGID, L, pencilSourceVecData[pencili].data(),
-                                         cellid_transpose, popID);
+               // Only pencils that have the block are packed into the group buffer.
+               uint nPencilsWithData = 0;
+               for (uint i = groupStart[groupi]; i < groupStart[groupi+1]; ++i) {
+                  const uint pencili = pencilOrder[i];
+                  pencilHasData[pencili] = copy_trans_block_data_amr(sourceCells.data() + sourceOffset[i], blockGID, L,
+                                                                     groupSourceVecData.data() + nPencilsWithData * sourceLength * VEC_PER_BLOCK,
+                                                                     cellid_transpose, popID);
+                  if (pencilHasData[pencili]) {
+                     groupPencils[nPencilsWithData] = pencili;
+                     groupDz[nPencilsWithData] = sourceDz.data() + sourceOffset[i];
+                     groupThreshold[nPencilsWithData] = sourceCells[sourceOffset[i]]->getVelocityBlockMinValue(popID);
+                     nPencilsWithData++;
+                  }
+               }
 
-               if(!pencil_has_data) {
-                  totalTargetLength += targetLength;
+               if(nPencilsWithData == 0) {
                   continue;
                }
 
                // Dz and sourceVecData are both padded by VLASOV_STENCIL_WIDTH
                // Dz has 1 value/cell, sourceVecData has WID3 values/cell
-               propagatePencil(pencildz[pencili].data(), pencilSourceVecData[pencili].data(), pencilTargetValues[pencili].data(), dimension, blockGID, dt, vmesh, L, pencilSourceCells[pencili][0]->getVelocityBlockMinValue(popID));
-
-               // sourceVecData => targetBlockData[this pencil])
-
-               // Loop over cells in pencil
-               for (uint icell = 0; icell < targetLength; icell++) {
-                  // Loop over 1st vspace dimension
-                  for (uint k=0; k<WID; k++) {
-                     // Loop over 2nd vspace dimension
-                     for(uint planeVector = 0; planeVector < VEC_PER_PLANE; planeVector++){
-
-                        // Unpack the vector data
-                        Realf vector[VECL];
-                        //pencilSourceVecData[pencili][i_trans_ps_blockv_pencil(planeVector, k, icell - 1, L)].store(vector);
-                        pencilTargetValues[pencili][i_trans_pt_blockv(planeVector, k, icell - 1)].store(vector);
-
-                        // Loop over 3rd (vectorized) vspace dimension
-                        for (uint iv = 0; iv < VECL; iv++) {
-
-                           // Store vector data in target data array.
-                           targetBlockData[(totalTargetLength + icell) * WID3 +
-                                           cellid_transpose[iv + planeVector * VECL + k * WID2]]
-                              = vector[iv];
+               propagatePencil(groupDz, groupSourceVecData.data(), groupTargetValues.data(), dimension, blockGID, dt, vmesh, L, nPencilsWithData,
+                               groupThreshold);
+
+               // groupTargetValues => targetBlockData[pencils of this group])
+               for (uint p = 0; p < nPencilsWithData; ++p) {
+                  const Vec* pencilTargetValues = groupTargetValues.data() + p * targetLength * VEC_PER_BLOCK;
+                  const uint totalTargetLength = targetOffset[groupPencils[p]];
+
+                  // Loop over cells in pencil
+                  for (uint icell = 0; icell < targetLength; icell++) {
+                     // Loop over 1st vspace dimension
+                     for (uint k=0; k<WID; k++) {
+                        // Loop over 2nd vspace dimension
+                        for(uint planeVector = 0; planeVector < VEC_PER_PLANE; planeVector++){
+
+                           // Unpack the vector data
+                           Realf vector[VECL];
+                           pencilTargetValues[i_trans_pt_blockv(planeVector, k, icell - 1)].store(vector);
+
+                           // Loop over 3rd (vectorized) vspace dimension
+                           for (uint iv = 0; iv < VECL; iv++) {
+
+                              // Store vector data in target data array.
+                              targetBlockData[(totalTargetLength + icell) * WID3 +
+                                              cellid_transpose[iv + planeVector * VECL + k * WID2]]
+                                 = vector[iv];
+                           }
                         }
                      }
                   }
                }
-               totalTargetLength += targetLength;
                
-            } // Closes loop over pencils. SourceVecData gets implicitly deallocated here.
+            } // Closes loop over groups of pencils.
 
             phiprof::stop(t1);
             phiprof::start(t2);
@@ -1436,11 +1553,17 @@ bool trans_map_1d_amr(const dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
 
             // store_data(target_data => targetCells)  :Aggregate data for blockid to original location 
             // Loop over pencils again
-            totalTargetLength = 0;
+            uint totalTargetLength = 0;
             for(uint pencili = 0; pencili < pencils.N; pencili++){
                
                uint targetLength = pencils.lengthOfPencils[pencili] + 2 * nTargetNeighborsPerPencil;
-               
+
+               // Pencils whose source cells do not have the block contribute nothing
+               if (!pencilHasData[pencili]) {
+                  totalTargetLength += targetLength;
+                  continue;
+               }
+
                // store values from targetBlockData array to the actual blocks
                // Loop over cells in the pencil, including the padded cells of the target array
                for ( uint celli = 0; celli < targetLength; celli++ ) {
@@ -200,6 +200,19 @@ const Vec one_twelfth(1.0/12.0);
 const Vec seven_twelfth(7.0/12.0);
 const Vec one_third(1.0/3.0);
 
+/*! Load VECL values into a vector. Values of other types than Realv,
+ * e.g. distribution function values when Realf and Realv differ, are
+ * converted through a temporary array.*/
+template<typename T> inline void load_realv(Vec& v,const T* p) {
+   Realv values[VECL];
+   for (int i=0; i<VECL; ++i) values[i] = p[i];
+   v.load(values);
+}
+
+inline void load_realv(Vec& v,const Realv* p) {
+   v.load(p);
+}
+
 
 
 
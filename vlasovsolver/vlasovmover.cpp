@@ -20,6 +20,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <vector>
@@ -55,6 +56,91 @@ creal ONE     = 1.0;
 creal TWO     = 2.0;
 creal EPSILON = 1.0e-25;
 
+/** Translate the distribution function of one population along one dimension,
+ * including the transfer of ghost block data before and the transfer of
+ * mapped contributions to remote cells after the mapping.
+ *
+ * If Parameters::overlapTranslationCommunication is set (and the spatial mesh is not
+ * refined), the ghost block data transfer is only started before trans_map_1d_setup
+ * computes neighbor and block lists, and is waited for before the actual mapping.
+ * The mapping itself cannot start earlier for interior cells, as the update is done
+ * in place and cells near process boundaries read data that interior cells write.
+ * @param dimension 0,1,2 for x,y,z.
+ * @param blockListCache Sorted velocity block lists, shared by all dimensions of the population.
+ * @param time Time spent in the mapping is added to this value.*/
+static void translateDimension(
+        dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+        const vector<CellID>& local_propagated_cells,
+        const vector<CellID>& remoteTargetCells,
+        vector<uint>& nPencils,
+        const uint dimension,
+        creal dt,
+        const uint popID,
+        TransBlockListCache& blockListCache,
+        Real &time
+) {
+   const bool overlapCommunication = P::overlapTranslationCommunication && P::amrMaxSpatialRefLevel == 0;
+   const string dimensionName(1, "xyz"[dimension]);
+   int neighborhood = VLASOV_SOLVER_X_NEIGHBORHOOD_ID;
+   if (dimension == 1) neighborhood = VLASOV_SOLVER_Y_NEIGHBORHOOD_ID;
+   if (dimension == 2) neighborhood = VLASOV_SOLVER_Z_NEIGHBORHOOD_ID;
+   double t1;
+   
+   int trans_timer=phiprof::initializeTimer("transfer-stencil-data-"+dimensionName,"MPI");
+   phiprof::start(trans_timer);
+   SpatialCell::set_mpi_transfer_type(Transfer::VEL_BLOCK_DATA);
+   mpiGrid.set_send_single_cells(false);
+   if (overlapCommunication) {
+      mpiGrid.start_remote_neighbor_copy_updates(neighborhood);
+   } else {
+      mpiGrid.update_copies_of_remote_neighbors(neighborhood);
+   }
+   phiprof::stop(trans_timer);
+   
+   int mapping_timer=phiprof::initializeTimer("compute-mapping-"+dimensionName);
+   if (P::amrMaxSpatialRefLevel == 0) {
+      // Neighbor and block lists only depend on block lists of remote
+      // cells, which are up to date. Block data may still be in flight.
+      TransMapSetup setup;
+      t1 = MPI_Wtime();
+      phiprof::start(mapping_timer);
+      trans_map_1d_setup(mpiGrid,local_propagated_cells, remoteTargetCells, dimension, popID, blockListCache, setup);
+      phiprof::stop(mapping_timer);
+      time += MPI_Wtime() - t1;
+      
+      if (overlapCommunication) {
+         // Sends have to be complete too, as mapping modifies the local block data
+         phiprof::start(trans_timer);
+         mpiGrid.wait_remote_neighbor_copy_update_receives(neighborhood);
+         mpiGrid.wait_remote_neighbor_copy_update_sends(neighborhood);
+         phiprof::stop(trans_timer);
+      }
+      
+      t1 = MPI_Wtime();
+      phiprof::start(mapping_timer);
+      trans_map_1d(mpiGrid,local_propagated_cells, setup, dimension, dt,popID);
+      phiprof::stop(mapping_timer);
+      time += MPI_Wtime() - t1;
+   } else {
+      t1 = MPI_Wtime();
+      phiprof::start(mapping_timer);
+      trans_map_1d_amr(mpiGrid,local_propagated_cells, remoteTargetCells, nPencils, dimension, dt,popID);
+      phiprof::stop(mapping_timer);
+      time += MPI_Wtime() - t1;
+   }
+   
+   trans_timer=phiprof::initializeTimer("update_remote-"+dimensionName,"MPI");
+   phiprof::start(trans_timer);
+   if(P::amrMaxSpatialRefLevel == 0) {
+      update_remote_mapping_contribution(mpiGrid, dimension,+1,popID);
+      update_remote_mapping_contribution(mpiGrid, dimension,-1,popID);
+   } else {
+      update_remote_mapping_contribution_amr(mpiGrid, dimension,+1,popID);
+      update_remote_mapping_contribution_amr(mpiGrid, dimension,-1,popID);
+   }
+   phiprof::stop(trans_timer);
+}
+
 /** Propagates the distribution function in spatial space. 
     
     Based on SLICE-3D algorithm: Zerroukat, M., and T. Allen. "A
@@ -76,166 +162,23 @@ void calculateSpatialTranslation(
         const uint popID,
         Real &time
 ) {
-
-    int trans_timer;
-    bool localTargetGridGenerated = false;
-    
-    double t1;
-    
-    int myRank;
-    MPI_Comm_rank(MPI_COMM_WORLD,&myRank);
+   // Block lists do not change during translation, sort them only once
+   TransBlockListCache blockListCache;
    
-   // int bt=phiprof::initializeTimer("barrier-trans-pre-z","Barriers","MPI");
-   // phiprof::start(bt);
-   // MPI_Barrier(MPI_COMM_WORLD);
-   // phiprof::stop(bt);
- 
-    // ------------- SLICE - map dist function in Z --------------- //
+   // ------------- SLICE - map dist function in Z --------------- //
    if(P::zcells_ini > 1){
-      trans_timer=phiprof::initializeTimer("transfer-stencil-data-z","MPI");
-      phiprof::start(trans_timer);
-      SpatialCell::set_mpi_transfer_type(Transfer::VEL_BLOCK_DATA);
-      mpiGrid.update_copies_of_remote_neighbors(VLASOV_SOLVER_Z_NEIGHBORHOOD_ID);
-      phiprof::stop(trans_timer);
-
-      // bt=phiprof::initializeTimer("barrier-trans-pre-trans_map_1d-z","Barriers","MPI");
-      // phiprof::start(bt);
-      // MPI_Barrier(MPI_COMM_WORLD);
-      // phiprof::stop(bt);
-
-      t1 = MPI_Wtime();
-      phiprof::start("compute-mapping-z");
-      if(P::amrMaxSpatialRefLevel == 0) {
-         trans_map_1d(mpiGrid,local_propagated_cells, remoteTargetCellsz, 2, dt,popID); // map along z//
-      } else {
-         trans_map_1d_amr(mpiGrid,local_propagated_cells, remoteTargetCellsz, nPencils, 2, dt,popID); // map along z//
-      }
-      phiprof::stop("compute-mapping-z");
-      time += MPI_Wtime() - t1;
-
-      // bt=phiprof::initializeTimer("barrier-trans-pre-update_remote-z","Barriers","MPI");
-      // phiprof::start(bt);
-      // MPI_Barrier(MPI_COMM_WORLD);
-      // phiprof::stop(bt);
-
-      trans_timer=phiprof::initializeTimer("update_remote-z","MPI");
-      phiprof::start("update_remote-z");
-      if(P::amrMaxSpatialRefLevel == 0) {
-         update_remote_mapping_contribution(mpiGrid, 2,+1,popID);
-         update_remote_mapping_contribution(mpiGrid, 2,-1,popID);
-      } else {
-         update_remote_mapping_contribution_amr(mpiGrid, 2,+1,popID);
-         update_remote_mapping_contribution_amr(mpiGrid, 2,-1,popID);
-      }
-      phiprof::stop("update_remote-z");
-
+      translateDimension(mpiGrid, local_propagated_cells, remoteTargetCellsz, nPencils, 2, dt, popID, blockListCache, time);
    }
-
-   // bt=phiprof::initializeTimer("barrier-trans-pre-x","Barriers","MPI");
-   // phiprof::start(bt);
-   // MPI_Barrier(MPI_COMM_WORLD);
-   // phiprof::stop(bt);
    
    // ------------- SLICE - map dist function in X --------------- //
    if(P::xcells_ini > 1){
-      
-      trans_timer=phiprof::initializeTimer("transfer-stencil-data-x","MPI");
-      phiprof::start(trans_timer);
-      SpatialCell::set_mpi_transfer_type(Transfer::VEL_BLOCK_DATA);
-
-      mpiGrid.set_send_single_cells(false);
-      mpiGrid.update_copies_of_remote_neighbors(VLASOV_SOLVER_X_NEIGHBORHOOD_ID);
-      phiprof::stop(trans_timer);
-      
-      // bt=phiprof::initializeTimer("barrier-trans-pre-trans_map_1d-x","Barriers","MPI");
-      // phiprof::start(bt);
-      // MPI_Barrier(MPI_COMM_WORLD);
-      // phiprof::stop(bt);
-
-      t1 = MPI_Wtime();
-      phiprof::start("compute-mapping-x");
-      if(P::amrMaxSpatialRefLevel == 0) {
-         trans_map_1d(mpiGrid,local_propagated_cells, remoteTargetCellsx, 0,dt,popID); // map along x//
-      } else {
-         trans_map_1d_amr(mpiGrid,local_propagated_cells, remoteTargetCellsx, nPencils, 0,dt,popID); // map along x//
-      }
-      phiprof::stop("compute-mapping-x");
-      time += MPI_Wtime() - t1;
-
-      // bt=phiprof::initializeTimer("barrier-trans-pre-update_remote-x","Barriers","MPI");
-      // phiprof::start(bt);
-      // MPI_Barrier(MPI_COMM_WORLD);
-      // phiprof::stop(bt);
-
-      trans_timer=phiprof::initializeTimer("update_remote-x","MPI");
-      phiprof::start("update_remote-x");
-      if(P::amrMaxSpatialRefLevel == 0) {
-         update_remote_mapping_contribution(mpiGrid, 0,+1,popID);
-         update_remote_mapping_contribution(mpiGrid, 0,-1,popID);
-      } else {
-         update_remote_mapping_contribution_amr(mpiGrid, 0,+1,popID);
-         update_remote_mapping_contribution_amr(mpiGrid, 0,-1,popID);
-      }
-      phiprof::stop("update_remote-x");
-
+      translateDimension(mpiGrid, local_propagated_cells, remoteTargetCellsx, nPencils, 0, dt, popID, blockListCache, time);
    }
-
-   // bt=phiprof::initializeTimer("barrier-trans-pre-y","Barriers","MPI");
-   // phiprof::start(bt);
-   // MPI_Barrier(MPI_COMM_WORLD);
-   // phiprof::stop(bt);
-
+   
    // ------------- SLICE - map dist function in Y --------------- //
    if(P::ycells_ini > 1) {
-      
-      trans_timer=phiprof::initializeTimer("transfer-stencil-data-y","MPI");
-      phiprof::start(trans_timer);
-      SpatialCell::set_mpi_transfer_type(Transfer::VEL_BLOCK_DATA);
-      
-      mpiGrid.set_send_single_cells(false);
-      mpiGrid.update_copies_of_remote_neighbors(VLASOV_SOLVER_Y_NEIGHBORHOOD_ID);
-      phiprof::stop(trans_timer);
-      
-      // bt=phiprof::initializeTimer("barrier-trans-pre-trans_map_1d-y","Barriers","MPI");
-      // phiprof::start(bt);
-      // MPI_Barrier(MPI_COMM_WORLD);
-      // phiprof::stop(bt);
-
-      t1 = MPI_Wtime();
-      phiprof::start("compute-mapping-y");
-      if(P::amrMaxSpatialRefLevel == 0) {
-         trans_map_1d(mpiGrid,local_propagated_cells, remoteTargetCellsy, 1,dt,popID); // map along y//
-      } else {
-         trans_map_1d_amr(mpiGrid,local_propagated_cells, remoteTargetCellsy, nPencils, 1,dt,popID); // map along y//      
-      }
-      phiprof::stop("compute-mapping-y");
-      time += MPI_Wtime() - t1;
-      
-      // bt=phiprof::initializeTimer("barrier-trans-pre-update_remote-y","Barriers","MPI");
-      // phiprof::start(bt);
-      // MPI_Barrier(MPI_COMM_WORLD);
-      // phiprof::stop(bt);
-
-      trans_timer=phiprof::initializeTimer("update_remote-y","MPI");
-      phiprof::start("update_remote-y");
-      if(P::amrMaxSpatialRefLevel == 0) {
-         update_remote_mapping_contribution(mpiGrid, 1,+1,popID);
-         update_remote_mapping_contribution(mpiGrid, 1,-1,popID);
-      } else {
-         update_remote_mapping_contribution_amr(mpiGrid, 1,+1,popID);
-         update_remote_mapping_contribution_amr(mpiGrid, 1,-1,popID);
-      }
-      phiprof::stop("update_remote-y");
-     
+      translateDimension(mpiGrid, local_propagated_cells, remoteTargetCellsy, nPencils, 1, dt, popID, blockListCache, time);
    }
-
-   // bt=phiprof::initializeTimer("barrier-trans-post-trans","Barriers","MPI");
-   // phiprof::start(bt);
-   // MPI_Barrier(MPI_COMM_WORLD);
-   // phiprof::stop(bt);
-
-   // MPI_Barrier(MPI_COMM_WORLD);
-   // bailout(true, "", __FILE__, __LINE__);
 }
 
 /*!
@@ -322,23 +265,42 @@ void calculateSpatialTranslation(
    }
    
    if (Parameters::prepareForRebalance == true) {
-      if(P::amrMaxSpatialRefLevel == 0) {
-//          const double deltat = (MPI_Wtime() - t1) / local_propagated_cells.size();
-         for (size_t c=0; c<localCells.size(); ++c) {
-//            mpiGrid[localCells[c]]->parameters[CellParams::LBWEIGHTCOUNTER] += time / localCells.size();
-            for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
-               mpiGrid[localCells[c]]->parameters[CellParams::LBWEIGHTCOUNTER] += mpiGrid[localCells[c]]->get_number_of_velocity_blocks(popID);
+      // Blocks (times pencils with AMR) are the cost model, they are also used to split the
+      // measured mapping time between the cells.
+      vector<Real> cellBlocks(local_propagated_cells.size());
+      Real totalBlocks = 0;
+      for (size_t c=0; c<local_propagated_cells.size(); ++c) {
+         Real counter = 0;
+         for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
+            counter += mpiGrid[local_propagated_cells[c]]->get_number_of_velocity_blocks(popID);
+         }
+         cellBlocks[c] = (P::amrMaxSpatialRefLevel == 0) ? counter : nPencils[c] * counter;
+         totalBlocks += cellBlocks[c];
+      }
+      
+      if (P::loadBalanceWeight == "blocks") {
+         if(P::amrMaxSpatialRefLevel == 0) {
+            for (size_t c=0; c<localCells.size(); ++c) {
+               for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
+                  mpiGrid[localCells[c]]->parameters[CellParams::LBWEIGHTCOUNTER] += mpiGrid[localCells[c]]->get_number_of_velocity_blocks(popID);
+               }
+            }
+         } else {
+            for (size_t c=0; c<local_propagated_cells.size(); ++c) {
+               mpiGrid[local_propagated_cells[c]]->parameters[CellParams::LBWEIGHTCOUNTER] += cellBlocks[c];
             }
          }
-      } else {
-//          const double deltat = MPI_Wtime() - t1;
+      }
+      
+      // The mapping runs threaded over pencils of many cells, so its time is split by blocks
+      #ifdef _OPENMP
+      const Real cpuTime = time * omp_get_max_threads();
+      #else
+      const Real cpuTime = time;
+      #endif
+      if (totalBlocks > 0) {
          for (size_t c=0; c<local_propagated_cells.size(); ++c) {
-            Real counter = 0;
-            for (uint popID=0; popID<getObjectWrapper().particleSpecies.size(); ++popID) {
-               counter += mpiGrid[local_propagated_cells[c]]->get_number_of_velocity_blocks(popID);
-            }
-            mpiGrid[local_propagated_cells[c]]->parameters[CellParams::LBWEIGHTCOUNTER] += nPencils[c] * counter;
-//            mpiGrid[localCells[c]]->parameters[CellParams::LBWEIGHTCOUNTER] += time / localCells.size();
+            mpiGrid[local_propagated_cells[c]]->parameters[CellParams::LBCOSTCOUNTER] += cpuTime * cellBlocks[c] / totalBlocks;
          }
       }
    }
@@ -356,6 +318,147 @@ momentCalculation:
   --------------------------------------------------
 */
 
+/** Accelerate the given population of one spatial cell over one subcycle.
+ * @param mpiGrid Parallel grid library.
+ * @param cellID Accelerated cell.
+ * @param popID Particle population ID.
+ * @param step The current subcycle step.
+ * @param dt Timestep.*/
+static void accelerateCellSubcycle(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                                   const CellID cellID,const uint popID,const uint step,
+                                   const Real& dt) {
+   const Real maxVdt = mpiGrid[cellID]->get_max_v_dt(popID);
+   
+   //compute subcycle dt. The length is maxVdt on all steps
+   //except the last one. This is to keep the neighboring
+   //spatial cells in sync, so that two neighboring cells with
+   //different number of subcycles have similar timesteps,
+   //except that one takes an additional short step. This keeps
+   //spatial block neighbors as much in sync as possible for
+   //adjust blocks.
+   Real subcycleDt;
+   if( (step + 1) * maxVdt > fabs(dt)) {
+	 subcycleDt = max(fabs(dt) - step * maxVdt, 0.0);
+   } else{
+      subcycleDt = maxVdt;
+   }
+   if (dt<0) subcycleDt = -subcycleDt;
+   
+   //generate pseudo-random order which is always the same irrespective of parallelization, restarts, etc.
+   char rngStateBuffer[256];
+   random_data rngDataBuffer;
+
+   // set seed, initialise generator and get value. The order is the same
+   // for all cells, but varies with timestep.
+   memset(&(rngDataBuffer), 0, sizeof(rngDataBuffer));
+   #ifdef _AIX
+      initstate_r(P::tstep, &(rngStateBuffer[0]), 256, NULL, &(rngDataBuffer));
+      int64_t rndInt;
+      random_r(&rndInt, &rngDataBuffer);
+   #else
+      initstate_r(P::tstep, &(rngStateBuffer[0]), 256, &(rngDataBuffer));
+      int32_t rndInt;
+      random_r(&rngDataBuffer, &rndInt);
+   #endif
+      
+   uint map_order=rndInt%3;
+   const double t1 = P::prepareForRebalance ? MPI_Wtime() : 0.0;
+   phiprof::start("cell-semilag-acc");
+   cpu_accelerate_cell(mpiGrid[cellID],popID,map_order,subcycleDt);
+   phiprof::stop("cell-semilag-acc");
+   if (P::prepareForRebalance) {
+      // Each cell is accelerated by one thread only, so subcycles accumulate without races
+      mpiGrid[cellID]->parameters[CellParams::LBCOSTCOUNTER] += MPI_Wtime() - t1;
+   }
+}
+
+/** Find the subcycled cells whose subcycles after the first one can run independently of all
+ * other cells. The nearest spatial neighbors of such a cell are local and are not subcycled, so
+ * their velocity blocks do not change after the first subcycle. The block adjustments between the
+ * subcycles of the cell then need no communication and no synchronization with other cells.
+ * @param mpiGrid Parallel grid library.
+ * @param propagatedCells Cells in which the population is accelerated.
+ * @param popID Particle population ID.
+ * @param dt Timestep.
+ * @return Independent cells, sorted by cell ID.*/
+static vector<CellID> findIndependentSubcycleCells(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                                                   const vector<CellID>& propagatedCells,
+                                                   const uint popID,const Real& dt) {
+   vector<CellID> independentCells;
+   for (size_t c=0; c<propagatedCells.size(); ++c) {
+      const CellID cellID = propagatedCells[c];
+      if (getAccelerationSubcycles(mpiGrid[cellID], dt, popID) < 2) continue;
+      
+      // Neighbors are checked in both directions, as at AMR refinement
+      // boundaries the neighborhood is not symmetric
+      bool independent = true;
+      for (const auto* neighbors : {mpiGrid.get_neighbors_of(cellID, NEAREST_NEIGHBORHOOD_ID),
+                                    mpiGrid.get_neighbors_to(cellID, NEAREST_NEIGHBORHOOD_ID)}) {
+         for (const auto& nbrPair : *neighbors) {
+            const CellID nbrID = nbrPair.first;
+            if (nbrID == 0 || nbrID == cellID) continue;
+            // Subcycle counts are only known for local cells
+            if (!mpiGrid.is_local(nbrID)) {
+               independent = false;
+               break;
+            }
+            SpatialCell* nbr = mpiGrid[nbrID];
+            if (nbr->sysBoundaryFlag == sysboundarytype::NOT_SYSBOUNDARY && getAccelerationSubcycles(nbr, dt, popID) > 1) {
+               independent = false;
+               break;
+            }
+         }
+         if (!independent) break;
+      }
+      if (independent) independentCells.push_back(cellID);
+   }
+   sort(independentCells.begin(), independentCells.end());
+   return independentCells;
+}
+
+/** Accelerate the independent cells over their remaining subcycles after the first one, see
+ * findIndependentSubcycleCells. The moments of each cell are recalculated before, and its blocks
+ * adjusted after, each subcycle exactly as in the global subcycle loop, but the cells proceed
+ * back-to-back without waiting for other cells.
+ * @param popID Particle population ID.
+ * @param globalMaxSubcycles Number of times acceleration is subcycled.
+ * @param mpiGrid Parallel grid library.
+ * @param independentCells Independent cells, sorted by decreasing cost.
+ * @param dt Timestep.*/
+static void accelerateIndependentSubcycleCells(const uint popID,const uint globalMaxSubcycles,
+                                               dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>& mpiGrid,
+                                               const vector<CellID>& independentCells,
+                                               const Real& dt) {
+   phiprof::start("independent-subcycles");
+   // Content lists of the neighbors after the adjustment of the first subcycle,
+   // the global loop would compute them at the start of the next adjustment
+   const vector<CellID>& cells = getLocalCells();
+   #pragma omp parallel for
+   for (size_t c=0; c<cells.size(); ++c) {
+      mpiGrid[cells[c]]->updateSparseMinValue(popID);
+      mpiGrid[cells[c]]->update_velocity_block_content_lists(popID);
+   }
+   
+   #pragma omp parallel for schedule(dynamic,1)
+   for (size_t c=0; c<independentCells.size(); ++c) {
+      const CellID cellID = independentCells[c];
+      SpatialCell* cell = mpiGrid[cellID];
+      const uint subcycles = getAccelerationSubcycles(cell, dt, popID);
+      for (uint step=1; step<subcycles; ++step) {
+         // The global loop recalculates the "_V" moments used by the
+         // acceleration transformation before every subcycle
+         calculateCellMoments_V(cell, false);
+         accelerateCellSubcycle(mpiGrid, cellID, popID, step, dt);
+         if (step < globalMaxSubcycles - 1) {
+            cell->updateSparseMinValue(popID);
+            cell->update_velocity_block_content_lists(popID);
+            adjustCellVelocityBlocks(mpiGrid, cellID, popID);
+         }
+      }
+   }
+   phiprof::stop("independent-subcycles");
+}
+
 /** Accelerate the given population to new time t+dt.
  * This function is AMR safe.
  * @param popID Particle population ID.
@@ -379,45 +482,7 @@ void calculateAcceleration(const uint popID,const uint globalMaxSubcycles,const
    // Semi-Lagrangian acceleration for those cells which are subcycled
    #pragma omp parallel for schedule(dynamic,1)
    for (size_t c=0; c<propagatedCells.size(); ++c) {
-      const CellID cellID = propagatedCells[c];
-      const Real maxVdt = mpiGrid[cellID]->get_max_v_dt(popID);
-      
-      //compute subcycle dt. The length is maxVdt on all steps
-      //except the last one. This is to keep the neighboring
-      //spatial cells in sync, so that two neighboring cells with
-      //different number of subcycles have similar timesteps,
-      //except that one takes an additional short step. This keeps
-      //spatial block neighbors as much in sync as possible for
-      //adjust blocks.
-      Real subcycleDt;
-      if( (step + 1) * maxVdt > fabs(dt)) {
-	 subcycleDt = max(fabs(dt) - step * maxVdt, 0.0);
-      } else{
-         subcycleDt = maxVdt;
-      }
-      if (dt<0) subcycleDt = -subcycleDt;
-      
-      //generate pseudo-random order which is always the same irrespective of parallelization, restarts, etc.
-      char rngStateBuffer[256];
-      random_data rngDataBuffer;
-
-      // set seed, initialise generator and get value. The order is the same
-      // for all cells, but varies with timestep.
-      memset(&(rngDataBuffer), 0, sizeof(rngDataBuffer));
-      #ifdef _AIX
-         initstate_r(P::tstep, &(rngStateBuffer[0]), 256, NULL, &(rngDataBuffer));
-         int64_t rndInt;
-         random_r(&rndInt, &rngDataBuffer);
-      #else
-         initstate_r(P::tstep, &(rngStateBuffer[0]), 256, &(rngDataBuffer));
-         int32_t rndInt;
-         random_r(&rngDataBuffer, &rndInt);
-      #endif
-         
-      uint map_order=rndInt%3;
-      phiprof::start("cell-semilag-acc");
-      cpu_accelerate_cell(mpiGrid[cellID],popID,map_order,subcycleDt);
-      phiprof::stop("cell-semilag-acc");
+      accelerateCellSubcycle(mpiGrid, propagatedCells[c], popID, step, dt);
    }
 
    //global adjust after each subcycle to keep number of blocks managable. Even the ones not
@@ -492,13 +557,34 @@ void calculateAcceleration(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
        // Compute global maximum for number of subcycles
        MPI_Allreduce(&maxSubcycles, &globalMaxSubcycles, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
        
+       // Cells that can subcycle independently leave the global subcycle loop after the first
+       // step, the loop then only runs as long as the remaining cells are subcycled
+       vector<CellID> independentCells;
+       if (P::decoupledAccelerationSubcycles && globalMaxSubcycles > 1) {
+          independentCells = findIndependentSubcycleCells(mpiGrid, propagatedCells, popID, dt);
+       }
+       int maxCoupledSubcycles = 1;
+       for (const auto& cell: propagatedCells) {
+          if (!binary_search(independentCells.begin(), independentCells.end(), cell)) {
+             maxCoupledSubcycles = max((int)getAccelerationSubcycles(mpiGrid[cell], dt, popID), maxCoupledSubcycles);
+          }
+       }
+       int globalMaxCoupledSubcycles;
+       MPI_Allreduce(&maxCoupledSubcycles, &globalMaxCoupledSubcycles, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+       
+       // Most expensive cells first, so that the dynamic schedules do not end with a long cell
+       sort(propagatedCells.begin(), propagatedCells.end(), [&mpiGrid,popID](const CellID a,const CellID b) {
+          return mpiGrid[a]->get_number_of_velocity_blocks(popID) > mpiGrid[b]->get_number_of_velocity_blocks(popID);
+       });
+       
        // substep global max times
-       for(uint step=0; step<(uint)globalMaxSubcycles; ++step) {
+       for(uint step=0; step<(uint)globalMaxCoupledSubcycles; ++step) {
           if(step > 0) {
              // prune list of cells to propagate to only contained those which are now subcycled
              vector<CellID> temp;
              for (const auto& cell: propagatedCells) {
-                if (step < getAccelerationSubcycles(mpiGrid[cell], dt, popID) ) {
+                if (step < getAccelerationSubcycles(mpiGrid[cell], dt, popID) &&
+                    !binary_search(independentCells.begin(), independentCells.end(), cell)) {
                    temp.push_back(cell);
                 }
              }
@@ -507,6 +593,15 @@ void calculateAcceleration(dccrg::Dccrg<SpatialCell,dccrg::Cartesian_Geometry>&
           }
           // Accelerate population over one subcycle step
           calculateAcceleration(popID,(uint)globalMaxSubcycles,step,mpiGrid,propagatedCells,dt);
+          
+          if (step == 0 && independentCells.size() > 0) {
+             vector<CellID> orderedCells(independentCells);
+             sort(orderedCells.begin(), orderedCells.end(), [&mpiGrid,popID,dt](const CellID a,const CellID b) {
+                return mpiGrid[a]->get_number_of_velocity_blocks(popID) * getAccelerationSubcycles(mpiGrid[a], dt, popID)
+                     > mpiGrid[b]->get_number_of_velocity_blocks(popID) * getAccelerationSubcycles(mpiGrid[b], dt, popID);
+             });
+             accelerateIndependentSubcycleCells(popID,(uint)globalMaxSubcycles,mpiGrid,orderedCells,dt);
+          }
        } // for-loop over acceleration substeps
        
        // final adjust for all cells, also fixing remote cells.